@@ -161,6 +161,165 @@ namespace ls
 		LS_EXCEPT(InternalErrorException, message);
 	}
 
+	CommandQueue<CommandQueueLockFree>::Command::Command(Command&& other) noexcept
+		: ops(other.ops), asyncOp(std::move(other.asyncOp)), callbackId(other.callbackId)
+		, returnsValue(other.returnsValue), notifyWhenComplete(other.notifyWhenComplete)
+	{
+		if(ops != nullptr)
+			ops->move(storage, other.storage);
+
+		other.ops = nullptr;
+	}
+
+	CommandQueue<CommandQueueLockFree>::Command::~Command()
+	{
+		if(ops != nullptr)
+			ops->destroy(storage);
+	}
+
+	CommandQueue<CommandQueueLockFree>::CommandQueue(ThreadId threadId, UINT32 capacity)
+		: CommandQueueBase(threadId), mMask(capacity - 1), mTail(0), mHead(0), mNumOverflowCommands(0)
+	{
+		assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+
+		mSlots = (Slot*)ls_alloc_aligned(sizeof(Slot) * capacity, alignof(Slot));
+		for(UINT32 i = 0; i < capacity; i++)
+		{
+			new (&mSlots[i]) Slot();
+			mSlots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	CommandQueue<CommandQueueLockFree>::~CommandQueue()
+	{
+		cancelAll();
+
+		for(UINT64 i = 0; i <= mMask; i++)
+			mSlots[i].~Slot();
+
+		ls_free_aligned(mSlots);
+	}
+
+	void CommandQueue<CommandQueueLockFree>::playbackWithNotify(const std::function<void(UINT32)>& notifyCallback)
+	{
+		THROW_IF_NOT_CORE_THREAD;
+
+		consume(notifyCallback, true);
+	}
+
+	void CommandQueue<CommandQueueLockFree>::playback()
+	{
+		playbackWithNotify(std::function<void(UINT32)>());
+	}
+
+	void CommandQueue<CommandQueueLockFree>::cancelAll()
+	{
+		consume(std::function<void(UINT32)>(), false);
+	}
+
+	bool CommandQueue<CommandQueueLockFree>::isEmpty() const
+	{
+		return mTail.load() == mHead.load() && mNumOverflowCommands.load() == 0;
+	}
+
+	CommandQueue<CommandQueueLockFree>::Slot* CommandQueue<CommandQueueLockFree>::claimSlot(UINT64& position)
+	{
+		// Once a command overflows, all following commands must overflow as well until the consumer drains the overflow
+		// queue. Otherwise commands queued from the same thread could get executed out of order.
+		if(mNumOverflowCommands.load() > 0)
+			return nullptr;
+
+		position = mTail.load(std::memory_order_relaxed);
+		while(true)
+		{
+			Slot& slot = mSlots[position & mMask];
+			INT64 diff = (INT64)(slot.sequence.load(std::memory_order_acquire) - position);
+
+			if(diff == 0)
+			{
+				if(mTail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					return &slot;
+			}
+			else if(diff < 0) // Full
+				return nullptr;
+			else // Another producer claimed the slot first
+				position = mTail.load(std::memory_order_relaxed);
+		}
+	}
+
+	void CommandQueue<CommandQueueLockFree>::pushOverflow(Command&& command)
+	{
+		ScopedSpinLock lock(mOverflowLock);
+
+		mOverflowCommands.push(std::move(command));
+		mNumOverflowCommands.fetch_add(1);
+	}
+
+	void CommandQueue<CommandQueueLockFree>::consume(const std::function<void(UINT32)>& notifyCallback, bool run)
+	{
+		UINT64 head = mHead.load(std::memory_order_relaxed);
+		UINT64 tail = mTail.load(std::memory_order_acquire);
+
+		while(head != tail)
+		{
+			Slot& slot = mSlots[head & mMask];
+
+			// The slot might have been claimed, but its producer might not have finished writing the command yet
+			while(slot.sequence.load(std::memory_order_acquire) != head + 1)
+				std::this_thread::yield();
+
+			consumeCommand(slot.command, notifyCallback, run);
+			slot.sequence.store(head + mMask + 1, std::memory_order_release);
+
+			head++;
+			mHead.store(head, std::memory_order_release);
+		}
+
+		if(mNumOverflowCommands.load() == 0)
+			return;
+
+		{
+			ScopedSpinLock lock(mOverflowLock);
+
+			// Commands claimed in the ring buffer before the overflow started must execute first. They will be picked up
+			// on the next call.
+			if(mTail.load(std::memory_order_relaxed) != head)
+				return;
+
+			std::swap(mOverflowCommands, mOverflowPlayback);
+			mNumOverflowCommands.store(0);
+		}
+
+		while(!mOverflowPlayback.empty())
+		{
+			consumeCommand(mOverflowPlayback.front(), notifyCallback, run);
+			mOverflowPlayback.pop();
+		}
+	}
+
+	void CommandQueue<CommandQueueLockFree>::consumeCommand(Command& command, 
+		const std::function<void(UINT32)>& notifyCallback, bool run)
+	{
+		if(run)
+		{
+			command.ops->invoke(command.storage, command.asyncOp);
+
+			if(command.returnsValue && !command.asyncOp.hasCompleted())
+			{
+				LOGDBG("Async operation return value wasn't resolved properly. Resolving automatically to nullptr. " \
+					"Make sure to complete the operation before returning from the command callback method.");
+				command.asyncOp._completeOperation(nullptr);
+			}
+		}
+
+		command.ops->destroy(command.storage);
+		command.ops = nullptr;
+		command.asyncOp = AsyncOp(AsyncOpEmpty());
+
+		if(run && command.notifyWhenComplete && notifyCallback != nullptr)
+			notifyCallback(command.callbackId);
+	}
+
 #if DEBUG_MODE
 	Mutex CommandQueueBase::CommandQueueBreakpointMutex;
 
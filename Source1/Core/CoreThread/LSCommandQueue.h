@@ -2,6 +2,7 @@
 
 #include "LSCorePrerequisites.h"
 #include "Thread/LSAsyncOp.h"
+#include "Thread/LSSpinLock.h"
 #include <functional>
 
 namespace ls
@@ -61,6 +62,28 @@ namespace ls
 		Lock mLock;
 	};
 
+	/**
+	 * Command queue policy that allows any number of threads to queue commands without locking, while a single thread
+	 * plays them back. Should be used with command queues that receive commands from many threads at a high rate.
+	 *
+	 * @note	Only usable through the CommandQueue<CommandQueueLockFree> specialization, which replaces the locked
+	 *			Queue<QueuedCommand> storage with a ring buffer.
+	 */
+	class CommandQueueLockFree
+	{
+	public:
+		CommandQueueLockFree() {}
+		virtual ~CommandQueueLockFree() {}
+
+		bool isValidThread(ThreadId ownerThread) const
+		{
+			return true;
+		}
+
+		void lock() { }
+		void unlock() { }
+	};
+
 	/**
 	 * Represents a single queued command in the command list. Contains all the data for executing the command and checking 
 	 * up on the command status.
@@ -233,11 +256,12 @@ namespace ls
 		 */
 		void throwInvalidThreadException(const String& message) const;
 
+		SPtr<AsyncOpSyncData> mAsyncOpSyncData;
+
 	private:
 		Queue<QueuedCommand>* mCommands;
 		Stack<Queue<QueuedCommand>*> mEmptyCommandQueues; /**< List of empty queues for reuse. */
 
-		SPtr<AsyncOpSyncData> mAsyncOpSyncData;
 		ThreadId mMyThreadId;
 
 		// Various variables that allow for easier debugging by allowing us to trigger breakpoints
@@ -379,5 +403,240 @@ namespace ls
 		}
 	};
 
+	/**
+	 * @copydoc CommandQueueBase
+	 *
+	 * Command queue that any number of threads may queue commands on concurrently without taking a lock. Commands are
+	 * stored in a bounded ring buffer of fixed size slots, and callbacks small enough are stored directly in the slot
+	 * instead of being allocated. Commands that don't fit, either because the ring buffer is full or because the callback
+	 * is too large, fall back to slower paths (a locked overflow queue, and a heap allocated callback respectively).
+	 *
+	 * Commands from a single thread are always executed in the order they were queued in.
+	 *
+	 * @note	Only a single thread may call playback(), playbackWithNotify() or cancelAll() at a time.
+	 * @note	Command queue breakpoints are not supported by this queue.
+	 */
+	template<>
+	class LS_CORE_EXPORT CommandQueue<CommandQueueLockFree> : public CommandQueueBase, public CommandQueueLockFree
+	{
+		/** Size in bytes of the storage for a callback within a command. Larger callbacks are allocated on the heap. */
+		static constexpr UINT32 INLINE_CALLBACK_SIZE = 64;
+
+		/** Operations that may be performed on a callback stored in a command. */
+		struct CallbackOps
+		{
+			/** Calls the callback stored in @p storage. */
+			void(*invoke)(void* storage, AsyncOp& op);
+
+			/** Move constructs a callback stored in @p src into @p dst and destroys the callback in @p src. */
+			void(*move)(void* dst, void* src);
+
+			/** Destroys the callback stored in @p storage. */
+			void(*destroy)(void* storage);
+		};
+
+		/** Implements CallbackOps for a callback type that fits in the command storage. */
+		template<class T, bool ReturnsValue>
+		struct InlineCallbackOps
+		{
+			static void invoke(void* storage, AsyncOp& op) { call(*(T*)storage, op); }
+			static void move(void* dst, void* src) { new (dst) T(std::move(*(T*)src)); ((T*)src)->~T(); }
+			static void destroy(void* storage) { ((T*)storage)->~T(); }
+
+			static void call(T& callback, AsyncOp& op) { call(callback, op, std::integral_constant<bool, ReturnsValue>()); }
+			static void call(T& callback, AsyncOp& op, std::true_type) { callback(op); }
+			static void call(T& callback, AsyncOp& op, std::false_type) { callback(); }
+		};
+
+		/** Implements CallbackOps for a callback type that doesn't fit in the command storage. */
+		template<class T, bool ReturnsValue>
+		struct HeapCallbackOps
+		{
+			static void invoke(void* storage, AsyncOp& op) { InlineCallbackOps<T, ReturnsValue>::call(**(T**)storage, op); }
+			static void move(void* dst, void* src) { *(T**)dst = *(T**)src; }
+			static void destroy(void* storage) { ls_delete(*(T**)storage); }
+		};
+
+		/** Single command in the queue, along with its callback. */
+		struct Command
+		{
+			Command() = default;
+			Command(Command&& other) noexcept;
+			~Command();
+
+			Command(const Command&) = delete;
+			Command& operator=(const Command&) = delete;
+
+			const CallbackOps* ops = nullptr;
+			AsyncOp asyncOp = AsyncOp(AsyncOpEmpty());
+			UINT32 callbackId = 0;
+			bool returnsValue = false;
+			bool notifyWhenComplete = false;
+			alignas(16) UINT8 storage[INLINE_CALLBACK_SIZE];
+		};
+
+		/** Element of the ring buffer. */
+		struct alignas(64) Slot
+		{
+			/**
+			 * Equals the slot's index when the slot is free, index + 1 once a command has been written to it, and
+			 * index + capacity after the command was consumed.
+			 */
+			std::atomic<UINT64> sequence;
+			Command command;
+		};
+
+	public:
+		/**
+		 * Constructor.
+		 *
+		 * @param[in]	threadId	Identifier for the thread that created the queue.
+		 * @param[in]	capacity	Number of commands the ring buffer can hold before new commands start overflowing into
+		 *							the slower locked queue. Must be a power of two.
+		 */
+		CommandQueue(ThreadId threadId, UINT32 capacity = 1024);
+		~CommandQueue();
+
+		/** @copydoc CommandQueueBase::queueReturn */
+		template<class T>
+		AsyncOp queueReturn(T&& commandCallback, bool _notifyWhenComplete = false, UINT32 _callbackId = 0)
+		{
+			AsyncOp asyncOp(mAsyncOpSyncData);
+			push<true>(std::forward<T>(commandCallback), asyncOp, _notifyWhenComplete, _callbackId);
+
+			return asyncOp;
+		}
+
+		/** @copydoc CommandQueueBase::queue */
+		template<class T>
+		void queue(T&& commandCallback, bool _notifyWhenComplete = false, UINT32 _callbackId = 0)
+		{
+			push<false>(std::forward<T>(commandCallback), AsyncOp(AsyncOpEmpty()), _notifyWhenComplete, _callbackId);
+		}
+
+		/**
+		 * Executes all commands queued so far, one by one in order. Commands queued while the playback is running might
+		 * or might not be executed.
+		 *
+		 * @param[in]	notifyCallback  	Callback that will be called if a command that has @p notifyOnComplete flag set.
+		 * 									The callback will receive @p callbackId of the command.
+		 */
+		void playbackWithNotify(const std::function<void(UINT32)>& notifyCallback);
+
+		/** Executes all commands queued so far, one by one in order. */
+		void playback();
+
+		/** @copydoc CommandQueueBase::cancelAll */
+		void cancelAll();
+
+		/**	Returns true if no commands are queued. May be called from any thread. */
+		bool isEmpty() const;
+
+	private:
+		/** Stores the provided callback in a command and makes the command visible to the consumer. */
+		template<bool ReturnsValue, class T>
+		void push(T&& callback, const AsyncOp& asyncOp, bool notifyWhenComplete, UINT32 callbackId)
+		{
+			typedef typename std::decay<T>::type CallbackType;
+
+			typedef std::integral_constant<bool, sizeof(CallbackType) <= INLINE_CALLBACK_SIZE && alignof(CallbackType) <= 16 &&
+				std::is_nothrow_move_constructible<CallbackType>::value> StoreInline;
+
+			// Storing the callback may throw, so it must happen before a slot is claimed. Otherwise the consumer would wait
+			// on the claimed slot forever.
+			Command command;
+			storeCallback<ReturnsValue>(command, std::forward<T>(callback), StoreInline());
+			command.asyncOp = asyncOp;
+			command.returnsValue = ReturnsValue;
+			command.notifyWhenComplete = notifyWhenComplete;
+			command.callbackId = callbackId;
+
+			UINT64 position = 0;
+			Slot* slot = claimSlot(position);
+
+			if(slot != nullptr)
+			{
+				// Doesn't throw, inline callbacks are only used for types with a non-throwing move constructor
+				slot->command.~Command();
+				new (&slot->command) Command(std::move(command));
+
+				slot->sequence.store(position + 1, std::memory_order_release);
+			}
+			else
+				pushOverflow(std::move(command));
+
+#if LS_FORCE_SINGLETHREADED_RENDERING
+			playback();
+#endif
+		}
+
+		/** Stores a callback directly in the command's storage. */
+		template<bool ReturnsValue, class T>
+		static void storeCallback(Command& command, T&& callback, std::true_type)
+		{
+			typedef typename std::decay<T>::type CallbackType;
+			static const CallbackOps ops =
+			{
+				&InlineCallbackOps<CallbackType, ReturnsValue>::invoke,
+				&InlineCallbackOps<CallbackType, ReturnsValue>::move,
+				&InlineCallbackOps<CallbackType, ReturnsValue>::destroy
+			};
+
+			new (command.storage) CallbackType(std::forward<T>(callback));
+			command.ops = &ops;
+		}
+
+		/** Allocates a callback on the heap, and stores a pointer to it in the command's storage. */
+		template<bool ReturnsValue, class T>
+		static void storeCallback(Command& command, T&& callback, std::false_type)
+		{
+			typedef typename std::decay<T>::type CallbackType;
+			static const CallbackOps ops =
+			{
+				&HeapCallbackOps<CallbackType, ReturnsValue>::invoke,
+				&HeapCallbackOps<CallbackType, ReturnsValue>::move,
+				&HeapCallbackOps<CallbackType, ReturnsValue>::destroy
+			};
+
+			*(CallbackType**)command.storage = ls_new<CallbackType>(std::forward<T>(callback));
+			command.ops = &ops;
+		}
+
+		/**
+		 * Attempts to reserve a free slot in the ring buffer.
+		 *
+		 * @param[out]	position	Position of the reserved slot in the queue.
+		 * @return					Reserved slot, or null if the ring buffer is full or commands are currently
+		 *							overflowing.
+		 */
+		Slot* claimSlot(UINT64& position);
+
+		/** Queues a command on the overflow queue, used when the ring buffer is full. */
+		void pushOverflow(Command&& command);
+
+		/**
+		 * Removes all commands queued so far from the queue, in order, and releases their callbacks.
+		 *
+		 * @param[in]	notifyCallback	Callback to call for executed commands that have the notify flag set.
+		 * @param[in]	run				If true the commands are executed before being removed, otherwise they are
+		 *								discarded.
+		 */
+		void consume(const std::function<void(UINT32)>& notifyCallback, bool run);
+
+		/** Executes the provided command if @p run is true, and releases its callback. */
+		void consumeCommand(Command& command, const std::function<void(UINT32)>& notifyCallback, bool run);
+
+		Slot* mSlots;
+		UINT64 mMask;
+
+		alignas(64) std::atomic<UINT64> mTail; /**< Position of the next slot to be claimed by a producer. */
+		alignas(64) std::atomic<UINT64> mHead; /**< Position of the next slot to be consumed. */
+
+		alignas(64) SpinLock mOverflowLock;
+		std::atomic<UINT32> mNumOverflowCommands;
+		Queue<Command> mOverflowCommands;
+		Queue<Command> mOverflowPlayback;
+	};
+
 	/** @} */
 }
\ No newline at end of file
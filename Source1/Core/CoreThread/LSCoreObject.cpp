@@ -9,7 +9,7 @@ namespace ls
 {
 	CoreObject::CoreObject(bool initializeOnCoreThread)
 		: mFlags(initializeOnCoreThread ? CGO_INIT_ON_CORE_THREAD : 0)
-		, mCoreDirtyFlags(0)
+		, mCoreDirtyFlags(0), mSyncingCoreDirtyFlags(0)
 		, mInternalID(CoreObjectManager::instance().generateId())
 	{
 	}
@@ -92,12 +92,22 @@ namespace ls
 
 	void CoreObject::markCoreDirty(UINT32 flags)
 	{
-		bool wasDirty = isCoreDirty();
+		// Only the first call since the last sync needs to notify the manager, marking an already dirty object is lock free
+		UINT32 oldFlags = mCoreDirtyFlags.fetch_or(flags, std::memory_order_release);
+		if (oldFlags == 0 && flags != 0)
+			CoreObjectManager::instance().notifyCoreDirty(this);
+	}
 
-		mCoreDirtyFlags |= flags;
+	CoreSyncData CoreObject::syncToCoreAndClean(FrameAlloc* allocator)
+	{
+		// A markCoreDirty() call after this sees no flags set and notifies the manager again
+		UINT32 flags = mCoreDirtyFlags.exchange(0, std::memory_order_acquire);
+		mSyncingCoreDirtyFlags.store(flags, std::memory_order_relaxed);
 
-		if (!wasDirty && isCoreDirty())
-			CoreObjectManager::instance().notifyCoreDirty(this);
+		CoreSyncData syncData = syncToCore(allocator);
+
+		mSyncingCoreDirtyFlags.store(0, std::memory_order_relaxed);
+		return syncData;
 	}
 
 	void CoreObject::markDependenciesDirty()
@@ -3,6 +3,7 @@
 #include "LSCorePrerequisites.h"
 #include "CoreThread/LSCoreObjectCore.h"
 #include "Thread/LSAsyncOp.h"
+#include <atomic>
 
 namespace ls
 {
@@ -150,7 +151,8 @@ namespace ls
 		friend class CoreObjectManager;
 
 		volatile UINT8 mFlags;
-		UINT32 mCoreDirtyFlags;
+		std::atomic<UINT32> mCoreDirtyFlags;
+		std::atomic<UINT32> mSyncingCoreDirtyFlags;
 		UINT64 mInternalID; // ID == 0 is not a valid ID
 		std::weak_ptr<CoreObject> mThis;
 
@@ -175,6 +177,12 @@ namespace ls
 		static void executeReturnGpuCommand(const SPtr<ct::CoreObject>& obj, std::function<void(AsyncOp&)> func, 
 			AsyncOp& op);
 
+		/**
+		 * Clears the dirty flags and calls syncToCore(FrameAlloc*). Flags are cleared before the data is read, so changes
+		 * made by other threads in the meantime mark the object dirty again instead of getting lost.
+		 */
+		CoreSyncData syncToCoreAndClean(FrameAlloc* allocator);
+
 	protected:
 		/************************************************************************/
 		/* 							CORE OBJECT SYNC                      		*/
@@ -197,7 +205,7 @@ namespace ls
 		void markCoreDirty(UINT32 flags = 0xFFFFFFFF);
 
 		/** Marks the core data as clean. Normally called right after syncToCore() has been called. */
-		void markCoreClean() { mCoreDirtyFlags = 0; }
+		void markCoreClean() { mCoreDirtyFlags.store(0, std::memory_order_relaxed); }
 
 		/**
 		 * Notifies the core object manager that this object is dependant on some other CoreObject(s), and the dependencies
@@ -210,12 +218,16 @@ namespace ls
 		 * Checks is the core dirty flag set. This is used by external systems to know when internal data has changed and 
 		 * core thread potentially needs to be notified.
 		 */
-		bool isCoreDirty() const { return mCoreDirtyFlags != 0; }
+		bool isCoreDirty() const { return mCoreDirtyFlags.load(std::memory_order_relaxed) != 0; }
 
 		/**
 		 * Returns the exact value of the internal flag that signals whether an object needs to be synced with the core thread.
+		 * During syncToCore() this includes the flags being synced.
 		 */
-		UINT32 getCoreDirtyFlags() const { return mCoreDirtyFlags; }
+		UINT32 getCoreDirtyFlags() const
+		{
+			return mCoreDirtyFlags.load(std::memory_order_relaxed) | mSyncingCoreDirtyFlags.load(std::memory_order_relaxed);
+		}
 
 		/**
 		 * Copy internal dirty data to a memory buffer that will be used for updating core thread version of that data.
@@ -223,6 +235,11 @@ namespace ls
 		 * @note	
 		 * This generally happens at the end of every sim thread frame. Synced data becomes available to the core thread 
 		 * the start of the next core thread frame.
+		 * @note
+		 * When many objects are dirty this is called concurrently for different objects on the TaskScheduler worker
+		 * threads, while the sim thread waits. Implementations must only read this object's own data, must only allocate
+		 * from the provided allocator, and must not call back into CoreObjectManager (e.g. by marking objects dirty or
+		 * destroying them).
 		 */
 		virtual CoreSyncData syncToCore(FrameAlloc* allocator) { return CoreSyncData(); }
 
@@ -243,7 +260,7 @@ namespace ls
 		virtual void onDependencyDirty(CoreObject* dependency, UINT32 dirtyFlags)
 		{
 			// By default any changes on a dependency mark the parent dirty as well
-			mCoreDirtyFlags |= DIRTY_DEPENDENCY_MASK;
+			mCoreDirtyFlags.fetch_or(DIRTY_DEPENDENCY_MASK, std::memory_order_relaxed);
 		}
 
 	protected:
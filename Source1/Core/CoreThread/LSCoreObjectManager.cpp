@@ -4,6 +4,7 @@
 #include "Error/LSException.h"
 #include "Math/LSMath.h"
 #include "CoreThread/LSCoreThread.h"
+#include "Thread/LSTaskScheduler.h"
 
 namespace ls
 {
@@ -16,7 +17,7 @@ namespace ls
 	CoreObjectManager::~CoreObjectManager()
 	{
 #if DEBUG_MODE
-		Lock lock(mObjectsMutex);
+		RecursiveLock lock(mObjectsMutex);
 
 		if(mObjects.size() > 0)
 		{
@@ -28,18 +29,30 @@ namespace ls
 				"engine objects before shutdown.");
 		}
 #endif
+
+		for (auto& syncData : mCoreSyncData)
+		{
+			for (auto& alloc : syncData.workerAllocs)
+				mFreeSyncAllocs.push_back(alloc);
+		}
+
+		for (auto& alloc : mFreeSyncAllocs)
+		{
+			alloc->setOwnerThread(LS_THREAD_CURRENT_ID);
+			ls_delete(alloc);
+		}
 	}
 
 	UINT64 CoreObjectManager::generateId()
 	{
-		Lock lock(mObjectsMutex);
+		RecursiveLock lock(mObjectsMutex);
 
 		return mNextAvailableID++;
 	}
 
 	void CoreObjectManager::registerObject(CoreObject* object)
 	{
-		Lock lock(mObjectsMutex);
+		RecursiveLock lock(mObjectsMutex);
 
 		UINT64 objId = object->getInternalID();
 		mObjects[objId] = object;
@@ -54,29 +67,13 @@ namespace ls
 
 		// If dirty, we generate sync data before it is destroyed
 		{
-			Lock lock(mObjectsMutex);
-			bool isDirty = object->isCoreDirty() || (mDirtyObjects.find(internalId) != mDirtyObjects.end());
+			RecursiveLock lock(mObjectsMutex);
 
-			if (isDirty)
-			{
-				SPtr<ct::CoreObject> coreObject = object->getCore();
-				if (coreObject != nullptr)
-				{
-					CoreSyncData objSyncData = object->syncToCore(gCoreThread().getFrameAlloc());
-				
-					mDestroyedSyncData.push_back(CoreStoredSyncObjData(coreObject, internalId, objSyncData));
-
-					DirtyObjectData& dirtyObjData = mDirtyObjects[internalId];
-					dirtyObjData.syncDataId = (INT32)mDestroyedSyncData.size() - 1;
-					dirtyObjData.object = nullptr;
-				}
-				else
-				{
-					DirtyObjectData& dirtyObjData = mDirtyObjects[internalId];
-					dirtyObjData.syncDataId = -1;
-					dirtyObjData.object = nullptr;
-				}
-			}
+			// Objects being serialized by syncDownload() can't be read here, they are handled once serialization is done
+			if (mSyncingObjects.find(object) != mSyncingObjects.end())
+				mDestroyedWhileSyncing.push_back(object);
+			else
+				storeDestroyedSyncData(object);
 
 			mObjects.erase(internalId);
 		}
@@ -85,7 +82,7 @@ namespace ls
 
 		// Clear dependencies from dependants
 		{
-			Lock lock(mObjectsMutex);
+			RecursiveLock lock(mObjectsMutex);
 
 			auto iterFind = mDependants.find(internalId);
 			if (iterFind != mDependants.end())
@@ -114,12 +111,39 @@ namespace ls
 		}
 	}
 
+	void CoreObjectManager::storeDestroyedSyncData(CoreObject* object)
+	{
+		UINT64 internalId = object->getInternalID();
+		bool isDirty = object->isCoreDirty() || (mDirtyObjects.find(internalId) != mDirtyObjects.end());
+
+		if (!isDirty)
+			return;
+
+		SPtr<ct::CoreObject> coreObject = object->getCore();
+		if (coreObject != nullptr)
+		{
+			FrameAlloc* allocator = gCoreThread().getFrameAlloc();
+			CoreSyncData objSyncData = object->syncToCore(allocator);
+
+			mDestroyedSyncData.push_back(CoreStoredSyncObjData(coreObject, internalId, objSyncData, allocator));
+
+			DirtyObjectData& dirtyObjData = mDirtyObjects[internalId];
+			dirtyObjData.syncDataId = (INT32)mDestroyedSyncData.size() - 1;
+			dirtyObjData.object = nullptr;
+		}
+		else
+		{
+			DirtyObjectData& dirtyObjData = mDirtyObjects[internalId];
+			dirtyObjData.syncDataId = -1;
+			dirtyObjData.object = nullptr;
+		}
+	}
+
 	void CoreObjectManager::notifyCoreDirty(CoreObject* object)
 	{
 		UINT64 id = object->getInternalID();
 
-		Lock lock(mObjectsMutex);
-
+		RecursiveLock lock(mObjectsMutex);
 		mDirtyObjects[id] = { object, -1 };
 	}
 
@@ -140,7 +164,7 @@ namespace ls
 			FrameVector<CoreObject*> toRemove;
 			FrameVector<CoreObject*> toAdd;
 
-			Lock lock(mObjectsMutex);
+			RecursiveLock lock(mObjectsMutex);
 
 			// Add dependencies and clear old dependencies from dependants
 			{
@@ -227,7 +251,7 @@ namespace ls
 			FrameAlloc* allocator;
 		};
 
-		Lock lock(mObjectsMutex);
+		RecursiveLock lock(mObjectsMutex);
 
 		FrameAlloc* allocator = gCoreThread().getFrameAlloc();
 		Vector<IndividualCoreSyncData> syncData;
@@ -237,6 +261,10 @@ namespace ls
 			if (!curObj->isCoreDirty())
 				return; // We already processed it as some other object's dependency
 
+			// Being serialized by syncDownload(), which will queue its data
+			if (mSyncingObjects.find(curObj) != mSyncingObjects.end())
+				return;
+
 			// Sync dependencies before dependants
 			// Note: I don't check for recursion. Possible infinite loop if two objects
 			// are dependent on one another.
@@ -259,14 +287,13 @@ namespace ls
 				return;
 			}
 
+			mDirtyObjects.erase(id);
+
 			syncData.push_back(IndividualCoreSyncData());
 			IndividualCoreSyncData& data = syncData.back();
 			data.allocator = allocator;
 			data.destination = objectCore;
-			data.syncData = curObj->syncToCore(allocator);
-
-			curObj->markCoreClean();
-			mDirtyObjects.erase(id);
+			data.syncData = curObj->syncToCoreAndClean(allocator);
 		};
 
 		syncObject(object);
@@ -293,107 +320,194 @@ namespace ls
 
 	void CoreObjectManager::syncDownload(FrameAlloc* allocator)
 	{
-		Lock lock(mObjectsMutex);
+		CoreStoredSyncData syncData;
 
-		mCoreSyncData.push_back(CoreStoredSyncData());
-		CoreStoredSyncData& syncData = mCoreSyncData.back();
+		// Keeps the synced objects alive until they are serialized, in case some thread releases the last reference to
+		// one while the workers are reading it
+		Vector<SPtr<CoreObject>> pinnedObjects;
 
-		syncData.alloc = allocator;
-		
-		// Add all objects dependant on the dirty objects
 		ls_frame_mark();
 		{
-			FrameSet<CoreObject*> dirtyDependants;
-			for (auto& objectData : mDirtyObjects)
+			// Dirty objects bucketed by their depth in the dependency graph, so that no object depends on another one in
+			// the same bucket
+			FrameVector<FrameVector<CoreObject*>> levels;
+			UINT32 numObjects = 0;
+
+			// Only held while collecting the dirty objects. Objects marked dirty while they are being serialized register
+			// themselves again, and objects destroyed meanwhile are handled after the workers are done.
 			{
-				auto iterFind = mDependants.find(objectData.first);
-				if (iterFind != mDependants.end())
+				RecursiveLock lock(mObjectsMutex);
+
+				// Add all objects dependant on the dirty objects
+				FrameSet<CoreObject*> dirtyDependants;
+				for (auto& objectData : mDirtyObjects)
 				{
-					const Vector<CoreObject*>& dependants = iterFind->second;
-					for (auto& dependant : dependants)
+					CoreObject* dependency = objectData.second.object;
+					if (dependency == nullptr)
+						continue;
+
+					auto iterFind = mDependants.find(objectData.first);
+					if (iterFind != mDependants.end())
 					{
-						const bool wasDirty = dependant->isCoreDirty();
+						const Vector<CoreObject*>& dependants = iterFind->second;
+						for (auto& dependant : dependants)
+						{
+							const bool wasDirty = dependant->isCoreDirty();
 
-						// Let the dependant objects know their dependency changed
-						CoreObject* dependency = objectData.second.object;
-						dependant->onDependencyDirty(dependency, dependency->getCoreDirtyFlags());
+							// Let the dependant objects know their dependency changed
+							dependant->onDependencyDirty(dependency, dependency->getCoreDirtyFlags());
 
-						if (!wasDirty && dependant->isCoreDirty())
-							dirtyDependants.insert(dependant);
+							if (!wasDirty && dependant->isCoreDirty())
+								dirtyDependants.insert(dependant);
+						}
 					}
 				}
-			}
 
-			for (auto& dirtyDependant : dirtyDependants)
-			{
-				UINT64 id = dirtyDependant->getInternalID();
+				for (auto& dirtyDependant : dirtyDependants)
+				{
+					UINT64 id = dirtyDependant->getInternalID();
 
-				mDirtyObjects[id] = { dirtyDependant, -1 };
-			}
-		}
+					mDirtyObjects[id] = { dirtyDependant, -1 };
+				}
 
-		ls_frame_clear();
-		
-		// Order in which objects are recursed in matters, ones with lower ID will have been created before
-		// ones with higher ones and should be updated first.
-		for (auto& objectData : mDirtyObjects)
-		{
-			std::function<void(CoreObject*)> syncObject = [&](CoreObject* curObj)
-			{
-				if (!curObj->isCoreDirty())
-					return; // We already processed it as some other object's dependency
-
-				// Sync dependencies before dependants
-				// Note: I don't check for recursion. Possible infinite loop if two objects
-				// are dependent on one another.
-				
-				UINT64 id = curObj->getInternalID();
-				auto iterFind = mDependencies.find(id);
+				// Depth of an object is one more than the depth of its deepest dirty dependency. Clean dependencies
+				// don't need to be synced, so they don't affect the depth.
+				// Note: I don't check for recursion. Possible infinite loop if two objects are dependent on one another.
+				FrameUnorderedMap<CoreObject*, UINT32> depths;
+				std::function<UINT32(CoreObject*)> assignDepth = [&](CoreObject* curObj)
+				{
+					auto iterFindDepth = depths.find(curObj);
+					if (iterFindDepth != depths.end())
+						return iterFindDepth->second;
 
-				if (iterFind != mDependencies.end())
+					UINT32 depth = 0;
+
+					auto iterFind = mDependencies.find(curObj->getInternalID());
+					if (iterFind != mDependencies.end())
+					{
+						const Vector<CoreObject*>& dependencies = iterFind->second;
+						for (auto& dependency : dependencies)
+						{
+							if (dependency->isCoreDirty())
+								depth = std::max(depth, assignDepth(dependency) + 1);
+						}
+					}
+
+					depths[curObj] = depth;
+
+					if (depth >= (UINT32)levels.size())
+						levels.resize(depth + 1);
+
+					levels[depth].push_back(curObj);
+					mSyncingObjects.insert(curObj);
+					numObjects++;
+
+					SPtr<CoreObject> pinnedObject = curObj->getThisPtr();
+					if (pinnedObject != nullptr)
+						pinnedObjects.push_back(std::move(pinnedObject));
+
+					return depth;
+				};
+
+				// Order in which objects are processed matters, ones with lower ID will have been created before
+				// ones with higher ones and should be updated first.
+				for (auto& objectData : mDirtyObjects)
 				{
-					const Vector<CoreObject*>& dependencies = iterFind->second;
-					for (auto& dependency : dependencies)
-						syncObject(dependency);
+					CoreObject* object = objectData.second.object;
+					if (object != nullptr)
+					{
+						if (object->isCoreDirty())
+							assignDepth(object);
+					}
+					else
+					{
+						// Object was destroyed but we still need to sync its modifications before it was destroyed
+						if (objectData.second.syncDataId != -1)
+							syncData.entries.push_back(mDestroyedSyncData[objectData.second.syncDataId]);
+					}
 				}
 
-				SPtr<ct::CoreObject> objectCore = curObj->getCore();
-				if (objectCore == nullptr)
+				mDirtyObjects.clear();
+				mDestroyedSyncData.clear();
+			}
+
+			// Serialize the objects level by level, so dependencies are always stored first
+			UINT32 offset = (UINT32)syncData.entries.size();
+			syncData.entries.resize(offset + numObjects);
+
+			// Each thread keeps using the same allocator for all of its tasks, with the calling thread using the provided one
+			ThreadId callingThread = LS_THREAD_CURRENT_ID;
+			Vector<ThreadId> workerThreads;
+			SpinLock workerAllocsLock;
+
+			auto getWorkerAlloc = [&]()
+			{
+				ThreadId threadId = LS_THREAD_CURRENT_ID;
+				if (threadId == callingThread)
+					return allocator;
+
 				{
-					curObj->markCoreClean();
-					return;
+					ScopedSpinLock lock(workerAllocsLock);
+					for (UINT32 i = 0; i < (UINT32)workerThreads.size(); i++)
+					{
+						if (workerThreads[i] == threadId)
+							return syncData.workerAllocs[i];
+					}
 				}
 
-				CoreSyncData objSyncData = curObj->syncToCore(allocator);
-				curObj->markCoreClean();
+				FrameAlloc* workerAlloc = acquireSyncAlloc();
+
+				ScopedSpinLock lock(workerAllocsLock);
+				workerThreads.push_back(threadId);
+				syncData.workerAllocs.push_back(workerAlloc);
 
-				syncData.entries.push_back(CoreStoredSyncObjData(objectCore,
-					curObj->getInternalID(), objSyncData));
+				return workerAlloc;
 			};
 
-			CoreObject* object = objectData.second.object;
-			if (object != nullptr)
-				syncObject(object);
-			else
+			for (auto& level : levels)
 			{
-				// Object was destroyed but we still need to sync its modifications before it was destroyed
-				if (objectData.second.syncDataId != -1)
-					syncData.entries.push_back(mDestroyedSyncData[objectData.second.syncDataId]);
+				UINT32 count = (UINT32)level.size();
+				CoreObject* const* objects = level.data();
+				CoreStoredSyncObjData* output = &syncData.entries[offset];
+
+				if (count < MIN_PARALLEL_SYNC_OBJECTS || !TaskScheduler::isStarted())
+					syncObjects(objects, count, output, allocator);
+				else
+				{
+					TaskScheduler::instance().parallelFor(0, count, SYNC_OBJECTS_PER_TASK,
+						[&](UINT32 begin, UINT32 end)
+					{
+						syncObjects(objects + begin, end - begin, output + begin, getWorkerAlloc());
+					});
+				}
+
+				offset += count;
 			}
-		}
 
-		mDirtyObjects.clear();
-		mDestroyedSyncData.clear();
+			RecursiveLock lock(mObjectsMutex);
+			mSyncingObjects.clear();
+
+			for (auto& object : mDestroyedWhileSyncing)
+				storeDestroyedSyncData(object);
+
+			mDestroyedWhileSyncing.clear();
+			mCoreSyncData.push_back(std::move(syncData));
+		}
+		ls_frame_clear();
 	}
 
 	void CoreObjectManager::syncUpload()
 	{
-		Lock lock(mObjectsMutex);
+		CoreStoredSyncData syncData;
+		{
+			RecursiveLock lock(mObjectsMutex);
 
-		if (mCoreSyncData.size() == 0)
-			return;
+			if (mCoreSyncData.size() == 0)
+				return;
 
-		CoreStoredSyncData& syncData = mCoreSyncData.front();
+			syncData = std::move(mCoreSyncData.front());
+			mCoreSyncData.pop_front();
+		}
 
 		for (auto& objSyncData : syncData.entries)
 		{
@@ -404,10 +518,58 @@ namespace ls
 			UINT8* data = objSyncData.syncData.getBuffer();
 
 			if (data != nullptr)
-				syncData.alloc->free(data);
+				objSyncData.alloc->free(data);
 		}
 
-		syncData.entries.clear();
-		mCoreSyncData.pop_front();
+		for (auto& alloc : syncData.workerAllocs)
+			releaseSyncAlloc(alloc);
+	}
+
+	void CoreObjectManager::syncObjects(CoreObject* const* objects, UINT32 count, CoreStoredSyncObjData* output,
+		FrameAlloc* allocator)
+	{
+		for (UINT32 i = 0; i < count; i++)
+		{
+			CoreObject* object = objects[i];
+
+			// Objects without a core counterpart leave an empty entry, which is skipped during upload
+			SPtr<ct::CoreObject> objectCore = object->getCore();
+			if (objectCore != nullptr)
+			{
+				CoreSyncData objSyncData = object->syncToCoreAndClean(allocator);
+				output[i] = CoreStoredSyncObjData(objectCore, object->getInternalID(), objSyncData, allocator);
+			}
+			else
+				object->markCoreClean();
+		}
+	}
+
+	FrameAlloc* CoreObjectManager::acquireSyncAlloc()
+	{
+		FrameAlloc* alloc = nullptr;
+		{
+			ScopedSpinLock lock(mSyncAllocLock);
+
+			if (!mFreeSyncAllocs.empty())
+			{
+				alloc = mFreeSyncAllocs.back();
+				mFreeSyncAllocs.pop_back();
+			}
+		}
+
+		if (alloc == nullptr)
+			alloc = ls_new<FrameAlloc>();
+
+		alloc->setOwnerThread(LS_THREAD_CURRENT_ID);
+		return alloc;
+	}
+
+	void CoreObjectManager::releaseSyncAlloc(FrameAlloc* alloc)
+	{
+		alloc->setOwnerThread(LS_THREAD_CURRENT_ID);
+		alloc->clear();
+
+		ScopedSpinLock lock(mSyncAllocLock);
+		mFreeSyncAllocs.push_back(alloc);
 	}
 }
\ No newline at end of file
@@ -31,23 +31,25 @@ namespace ls
 				:internalId(0)
 			{ }
 
-			CoreStoredSyncObjData(const SPtr<ct::CoreObject> destObj, UINT64 internalId, const CoreSyncData& syncData)
-				:destinationObj(destObj), syncData(syncData), internalId(internalId)
+			CoreStoredSyncObjData(const SPtr<ct::CoreObject> destObj, UINT64 internalId, const CoreSyncData& syncData,
+				FrameAlloc* alloc)
+				:destinationObj(destObj), syncData(syncData), internalId(internalId), alloc(alloc)
 			{ }
 
 			SPtr<ct::CoreObject> destinationObj;
 			CoreSyncData syncData;
 			UINT64 internalId;
+			FrameAlloc* alloc = nullptr; /**< Allocator the sync data was allocated with. */
 		};
 
 		/**
 		 * Stores dirty data that is to be transferred from sim thread to core thread part of a CoreObject, for all dirty
-		 * objects in one frame.
+		 * objects in one frame. Entries are ordered so that dependencies are always synced before their dependants.
 		 */
 		struct CoreStoredSyncData
 		{
-			FrameAlloc* alloc = nullptr;
 			Vector<CoreStoredSyncObjData> entries;
+			Vector<FrameAlloc*> workerAllocs; /**< Allocators used by the worker threads, released after the upload. */
 		};
 
 		/** Contains information about a dirty CoreObject that requires syncing to the core thread. */	
@@ -70,7 +72,10 @@ namespace ls
 		/** Unregisters a CoreObject notifying the manager the object is destroyed. */
 		void unregisterObject(CoreObject* object);
 
-		/**	Notifies the system that a CoreObject is dirty and needs to be synced with the core thread. */
+		/**
+		 * Notifies the system that a CoreObject that was clean has been marked dirty and needs to be synced with the core
+		 * thread. Not called for objects that were already dirty.
+		 */
 		void notifyCoreDirty(CoreObject* object);
 
 		/**	Notifies the system that CoreObject dependencies are dirty and should be updated. */
@@ -99,7 +104,12 @@ namespace ls
 		 * Stores all syncable data from dirty core objects into memory allocated by the provided allocator. Additional 
 		 * meta-data is stored internally to be used by call to syncUpload().
 		 *
-		 * @param[in]	allocator Allocator to use for allocating memory for stored data.
+		 * Dirty objects are grouped by their depth in the dependency graph. Objects of the same depth don't depend on one
+		 * another, so large groups are serialized in parallel by the TaskScheduler workers, each into its own allocator.
+		 * The dirty objects are collected under the lock, which is then released while they are serialized. Objects marked
+		 * dirty or destroyed during serialization are handled once all workers are done.
+		 *
+		 * @param[in]	allocator Allocator to use for allocating memory for stored data on the calling thread.
 		 *
 		 * @note	Sim thread only.
 		 * @note	Must be followed by a call to syncUpload() with the same type.
@@ -122,6 +132,36 @@ namespace ls
 		 */
 		void updateDependencies(CoreObject* object, Vector<CoreObject*>* dependencies);
 
+		/**
+		 * Stores the sync data of an object that is being destroyed, if it is dirty, so its modifications still reach the
+		 * core thread on the next sync. Must be called with the objects mutex held.
+		 */
+		void storeDestroyedSyncData(CoreObject* object);
+
+		/**
+		 * Stores the sync data of the provided objects, and clears the dirty flags that were synced. Flags raised while
+		 * an object was being serialized are kept.
+		 *
+		 * @param[in]	objects		Objects to sync.
+		 * @param[in]	count		Number of entries in @p objects.
+		 * @param[out]	output		Entries to receive the sync data, one per object.
+		 * @param[in]	allocator	Allocator to use for allocating memory for the stored data.
+		 */
+		static void syncObjects(CoreObject* const* objects, UINT32 count, CoreStoredSyncObjData* output,
+			FrameAlloc* allocator);
+
+		/** Returns an allocator for storing sync data on a worker thread, creating a new one if none are available. */
+		FrameAlloc* acquireSyncAlloc();
+
+		/** Clears an allocator returned by acquireSyncAlloc() and makes it available for reuse. */
+		void releaseSyncAlloc(FrameAlloc* alloc);
+
+		/** Minimum number of objects of the same depth needed for them to be serialized on the worker threads. */
+		static constexpr UINT32 MIN_PARALLEL_SYNC_OBJECTS = 256;
+
+		/** Number of objects serialized by a single worker task. */
+		static constexpr UINT32 SYNC_OBJECTS_PER_TASK = 64;
+
 		UINT64 mNextAvailableID;
 		Map<UINT64, CoreObject*> mObjects;
 		Map<UINT64, DirtyObjectData> mDirtyObjects;
@@ -131,7 +171,13 @@ namespace ls
 		Vector<CoreStoredSyncObjData> mDestroyedSyncData;
 		List<CoreStoredSyncData> mCoreSyncData;
 
-		Mutex mObjectsMutex;
+		UnorderedSet<CoreObject*> mSyncingObjects;
+		Vector<CoreObject*> mDestroyedWhileSyncing;
+
+		RecursiveMutex mObjectsMutex;
+
+		Vector<FrameAlloc*> mFreeSyncAllocs;
+		SpinLock mSyncAllocLock;
 	};
 
 	/** @} */
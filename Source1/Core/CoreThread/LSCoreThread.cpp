@@ -13,6 +13,7 @@ namespace ls
 	CoreThread::CoreThread()
 		: mActiveFrameAlloc(0)
 		, mCoreThreadShutdown(false)
+		, mCoreThreadWaiting(false)
 		, mCoreThreadStarted(false)
 		, mCommandQueue(nullptr)
 		, mMaxCommandNotifyId(0)
@@ -25,7 +26,7 @@ namespace ls
 
 		mSimThreadId = LS_THREAD_CURRENT_ID;
 		mCoreThreadId = mSimThreadId; // For now
-		mCommandQueue = ls_new<CommandQueue<CommandQueueSync>>(LS_THREAD_CURRENT_ID);
+		mCommandQueue = ls_new<CommandQueue<CommandQueueLockFree>>(LS_THREAD_CURRENT_ID);
 
 		initCoreThread();
 	}
@@ -88,17 +89,22 @@ namespace ls
 
 		mCoreThreadStartedCondition.notify_one();
 
+		std::function<void(UINT32)> notifyCallback = std::bind(&CoreThread::commandCompletedNotify, this, _1);
 		while(true)
 		{
 			// Wait until we get some ready commands
-			Queue<QueuedCommand>* commands = nullptr;
+			if(mCommandQueue->isEmpty())
 			{
 				Lock lock(mCommandQueueMutex);
 
+				// Must be set before checking the queue again, see notifyCommandQueued()
+				mCoreThreadWaiting = true;
+
 				while(mCommandQueue->isEmpty())
 				{
 					if(mCoreThreadShutdown)
 					{
+						mCoreThreadWaiting = false;
 						TaskScheduler::instance().addWorker();
 						return;
 					}
@@ -108,11 +114,11 @@ namespace ls
 					TaskScheduler::instance().removeWorker();
 				}
 
-				commands = mCommandQueue->flush();
+				mCoreThreadWaiting = false;
 			}
 
 			// Play commands
-			mCommandQueue->playbackWithNotify(commands, std::bind(&CoreThread::commandCompletedNotify, this, _1)); 
+			mCommandQueue->playbackWithNotify(notifyCallback);
 		}
 #endif
 	}
@@ -135,6 +141,21 @@ namespace ls
 #endif
 	}
 
+	void CoreThread::notifyCommandQueued()
+	{
+#if !LS_FORCE_SINGLETHREADED_RENDERING
+		// Either the core thread sees the new command when it checks the queue after setting mCoreThreadWaiting, or we see
+		// the flag here and wake it up. Locking the mutex ensures the notification can't arrive before it starts waiting.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if(mCoreThreadWaiting.load(std::memory_order_relaxed))
+		{
+			Lock lock(mCommandQueueMutex);
+			mCommandReadyCondition.notify_all();
+		}
+#endif
+	}
+
 	SPtr<TCoreThreadQueue<CommandQueueNoSync>> CoreThread::getQueue()
 	{
 		if(mPerThreadQueue.current == nullptr)
@@ -193,19 +214,15 @@ namespace ls
 
 			AsyncOp op;
 			UINT32 commandId = -1;
+			if (blockUntilComplete)
 			{
-				Lock lock(mCommandQueueMutex);
-
-				if (blockUntilComplete)
-				{
-					commandId = mMaxCommandNotifyId++;
-					op = mCommandQueue->queueReturn(commandCallback, true, commandId);
-				}
-				else
-					op = mCommandQueue->queueReturn(commandCallback);
+				commandId = mMaxCommandNotifyId++;
+				op = mCommandQueue->queueReturn(std::move(commandCallback), true, commandId);
 			}
+			else
+				op = mCommandQueue->queueReturn(std::move(commandCallback));
 
-			mCommandReadyCondition.notify_all();
+			notifyCommandQueued();
 
 			if (blockUntilComplete)
 				blockUntilCommandCompleted(commandId);
@@ -225,19 +242,15 @@ namespace ls
 			bool blockUntilComplete = flags.isSet(CTQF_BlockUntilComplete);
 
 			UINT32 commandId = -1;
+			if (blockUntilComplete)
 			{
-				Lock lock(mCommandQueueMutex);
-
-				if (blockUntilComplete)
-				{
-					commandId = mMaxCommandNotifyId++;
-					mCommandQueue->queue(commandCallback, true, commandId);
-				}
-				else
-					mCommandQueue->queue(commandCallback);
+				commandId = mMaxCommandNotifyId++;
+				mCommandQueue->queue(std::move(commandCallback), true, commandId);
 			}
+			else
+				mCommandQueue->queue(std::move(commandCallback));
 
-			mCommandReadyCondition.notify_all();
+			notifyCommandQueued();
 
 			if (blockUntilComplete)
 				blockUntilCommandCompleted(commandId);
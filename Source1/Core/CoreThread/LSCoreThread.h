@@ -151,6 +151,7 @@ namespace ls
 		Vector<ThreadQueueContainer*> mAllQueues;
 
 		volatile bool mCoreThreadShutdown;
+		std::atomic<bool> mCoreThreadWaiting; /**< True while the core thread is (about to start) waiting for commands. */
 
 		HThread mCoreThread;
 		bool mCoreThreadStarted;
@@ -164,9 +165,9 @@ namespace ls
 		Mutex mThreadStartedMutex;
 		Signal mCoreThreadStartedCondition;
 
-		CommandQueue<CommandQueueSync>* mCommandQueue;
+		CommandQueue<CommandQueueLockFree>* mCommandQueue;
 
-		UINT32 mMaxCommandNotifyId; /**< ID that will be assigned to the next command with a notifier callback. */
+		std::atomic<UINT32> mMaxCommandNotifyId; /**< ID that will be assigned to the next command with a notifier callback. */
 		Vector<UINT32> mCommandsCompleted; /**< Completed commands that have notifier callbacks set up */
 
 		/** Starts the core thread worker method. Should only be called once. */
@@ -178,6 +179,9 @@ namespace ls
 		/** Shutdowns the core thread. It will complete all ready commands before shutdown. */
 		void shutdownCoreThread();
 
+		/** Wakes up the core thread if it is waiting for commands. Must be called after queuing an internal command. */
+		void notifyCommandQueued();
+
 		/** Creates or retrieves a queue for the calling thread. */
 		SPtr<TCoreThreadQueue<CommandQueueNoSync>> getQueue();
 
@@ -5,6 +5,7 @@
 #include "General/LSDynLibManager.h"
 #include "Thread/LSThreadPool.h"
 #include "Thread/LSTaskScheduler.h"
+#include "Logger/LSLogger.h"
 #include "CoreThread/LSCoreThread.h"
 #include "CoreThread/LSCoreObjectManager.h"
 
@@ -23,6 +24,7 @@ namespace ls
         Time::shutDown();
         
         CoreThread::shutDown();
+		gLogger()._stopAsync(); // Must stop before the thread pool, writes out any queued log entries
 		TaskScheduler::shutDown();
 		ThreadPool::shutDown();
 		MessageHandler::shutDown();
@@ -44,6 +46,7 @@ namespace ls
 		ThreadPool::startUp<TThreadPool<ThreadBansheePolicy>>((numWorkerThreads));
 		TaskScheduler::startUp();
 		TaskScheduler::instance().removeWorker();
+		gLogger()._startAsync();
         CoreThread::startUp();
         Time::startUp();
         DynLibManager::startUp();
@@ -39,6 +39,8 @@ namespace ls
 		static void onThreadEnded(const String& name)
 		{
 			MemStack::endThread();
+			FrameArena::endThread();
+			MemPool::endThread();
 		}
 	};
 
@@ -0,0 +1,14 @@
+#include "Testing/LSConsoleTestOutput.h"
+#include "Private/UnitTests/LSCoreTestSuite.h"
+
+using namespace ls;
+
+int main()
+{
+	SPtr<TestSuite> tests = CoreTestSuite::create<CoreTestSuite>();
+
+	ConsoleTestOutput testOutput;
+	tests->run(testOutput);
+
+	return 0;
+}
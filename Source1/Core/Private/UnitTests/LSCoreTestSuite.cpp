@@ -0,0 +1,336 @@
+#include "Private/UnitTests/LSCoreTestSuite.h"
+#include "Thread/LSThreadPool.h"
+#include "Thread/LSTaskScheduler.h"
+#include "CoreThread/LSCoreThread.h"
+#include "CoreThread/LSCommandQueue.h"
+#include "CoreThread/LSCoreObject.h"
+#include "CoreThread/LSCoreObjectCore.h"
+#include "CoreThread/LSCoreObjectManager.h"
+#include "General/LSTimer.h"
+
+namespace ls
+{
+	/** Identifies a command queued by one of the producer threads in the command queue tests. */
+	struct ProducedCommand
+	{
+		UINT32 producer;
+		UINT32 sequence;
+	};
+
+	/**
+	 * Queues @p numCommands commands from each of @p numProducers threads. Every command records its producer and its
+	 * sequence number within that producer into @p executed when played back. Every third command carries a callback too
+	 * large to be stored inline, and every fifth one returns a value.
+	 */
+	static Vector<HThread> startProducers(CommandQueue<CommandQueueLockFree>& queue, Vector<ProducedCommand>& executed,
+		UINT32 numProducers, UINT32 numCommands)
+	{
+		Vector<HThread> producers;
+		for (UINT32 i = 0; i < numProducers; i++)
+		{
+			producers.push_back(ThreadPool::instance().run("CommandQueueProducer", [&queue, &executed, i, numCommands]()
+			{
+				for (UINT32 j = 0; j < numCommands; j++)
+				{
+					ProducedCommand command = { i, j };
+					if (j % 5 == 0)
+					{
+						queue.queueReturn([&executed, command](AsyncOp& op)
+						{
+							executed.push_back(command);
+							op._completeOperation(command.sequence);
+						});
+					}
+					else if (j % 3 == 0)
+					{
+						UINT8 padding[128] = {};
+						queue.queue([&executed, command, padding]()
+						{
+							executed.push_back({ command.producer, command.sequence + padding[0] });
+						});
+					}
+					else
+						queue.queue([&executed, command]() { executed.push_back(command); });
+				}
+			}));
+		}
+
+		return producers;
+	}
+
+	/** Checks that @p executed contains all the produced commands, in the order each producer queued them. */
+	static bool isProducedInOrder(const Vector<ProducedCommand>& executed, UINT32 numProducers, UINT32 numCommands)
+	{
+		if (executed.size() != numProducers * numCommands)
+			return false;
+
+		Vector<UINT32> nextSequence(numProducers, 0);
+		for (auto& command : executed)
+		{
+			if (command.producer >= numProducers || command.sequence != nextSequence[command.producer])
+				return false;
+
+			nextSequence[command.producer]++;
+		}
+
+		return true;
+	}
+
+	namespace ct
+	{
+		/** Core thread counterpart of TestSyncObject, recording the synced value and the order it was synced in. */
+		class TestSyncObject : public CoreObject
+		{
+		public:
+			UINT32 value = 0;
+			UINT32 syncIdx = 0;
+
+			/** Incremented for every synced object. Only accessed from the core thread. */
+			static UINT32 sNextSyncIdx;
+
+		protected:
+			void syncToCore(const CoreSyncData& data) override
+			{
+				value = data.getData<UINT32>();
+				syncIdx = ++sNextSyncIdx;
+			}
+		};
+
+		UINT32 TestSyncObject::sNextSyncIdx = 0;
+	}
+
+	/** Core object syncing a single value, optionally depending on another object of the same type. */
+	class TestSyncObject : public CoreObject
+	{
+	public:
+		TestSyncObject(TestSyncObject* dependency)
+			:CoreObject(false), mDependency(dependency)
+		{ }
+
+		/** Creates and initializes a new object. */
+		static SPtr<TestSyncObject> create(TestSyncObject* dependency = nullptr)
+		{
+			SPtr<TestSyncObject> object = ls_core_ptr_new<TestSyncObject>(dependency);
+			object->_setThisPtr(object);
+			object->initialize();
+
+			return object;
+		}
+
+		/** Changes the value and marks it for syncing to the core object. */
+		void setValue(UINT32 value)
+		{
+			mValue = value;
+			markCoreDirty();
+		}
+
+		UINT32 getValue() const { return mValue; }
+
+		/** Sets a callback triggered whenever the object's value is serialized for the core thread. */
+		void setOnSync(std::function<void()> onSync) { mOnSync = std::move(onSync); }
+
+		/** Returns the core thread counterpart of the object. */
+		SPtr<ct::TestSyncObject> getCore() const { return std::static_pointer_cast<ct::TestSyncObject>(mCoreSpecific); }
+
+	protected:
+		SPtr<ct::CoreObject> createCore() const override
+		{
+			SPtr<ct::TestSyncObject> core = ls_shared_ptr_new<ct::TestSyncObject>();
+			core->_setThisPtr(core);
+
+			return core;
+		}
+
+		CoreSyncData syncToCore(FrameAlloc* allocator) override
+		{
+			UINT8* data = allocator->alloc(sizeof(mValue));
+			memcpy(data, &mValue, sizeof(mValue));
+
+			if (mOnSync)
+				mOnSync();
+
+			return CoreSyncData(data, sizeof(mValue));
+		}
+
+		void getCoreDependencies(Vector<CoreObject*>& dependencies) override
+		{
+			if (mDependency != nullptr)
+				dependencies.push_back(mDependency);
+		}
+
+	private:
+		TestSyncObject* mDependency;
+		UINT32 mValue = 0;
+		std::function<void()> mOnSync;
+	};
+
+	void CoreTestSuite::startUp()
+	{
+		ThreadPool::startUp<TThreadPool<>>(LS_THREAD_HARDWARE_CONCURRENCY, 64);
+		TaskScheduler::startUp();
+		CoreThread::startUp();
+		CoreObjectManager::startUp();
+	}
+
+	void CoreTestSuite::shutDown()
+	{
+		CoreObjectManager::shutDown();
+		CoreThread::shutDown();
+		TaskScheduler::shutDown();
+		ThreadPool::shutDown();
+	}
+
+	CoreTestSuite::CoreTestSuite()
+	{
+		LS_ADD_TEST(CoreTestSuite::testCommandQueueOrdering)
+		LS_ADD_TEST(CoreTestSuite::testCommandQueueConcurrentPlayback)
+		LS_ADD_TEST(CoreTestSuite::testCoreObjectSync)
+		LS_ADD_TEST(CoreTestSuite::testCoreObjectDirtiedWhileSyncing)
+	}
+
+	void CoreTestSuite::testCommandQueueOrdering()
+	{
+		static constexpr UINT32 NUM_PRODUCERS = 4;
+		static constexpr UINT32 NUM_COMMANDS = 1000;
+
+		// Small capacity so most of the commands end up in the overflow queue
+		CommandQueue<CommandQueueLockFree> queue(gCoreThread().getCoreThreadId(), 16);
+		Vector<ProducedCommand> executed;
+
+		Vector<HThread> producers = startProducers(queue, executed, NUM_PRODUCERS, NUM_COMMANDS);
+		for (auto& producer : producers)
+			producer.blockUntilComplete();
+
+		LS_TEST_ASSERT(!queue.isEmpty());
+
+		// Commands left in the ring buffer when the overflow started are played back first, and the overflow queue on
+		// the next call
+		gCoreThread().queueCommand([&queue]()
+		{
+			while (!queue.isEmpty())
+				queue.playback();
+		}, CTQF_InternalQueue | CTQF_BlockUntilComplete);
+
+		LS_TEST_ASSERT(queue.isEmpty());
+		LS_TEST_ASSERT(isProducedInOrder(executed, NUM_PRODUCERS, NUM_COMMANDS));
+	}
+
+	void CoreTestSuite::testCommandQueueConcurrentPlayback()
+	{
+		static constexpr UINT32 NUM_PRODUCERS = 4;
+		static constexpr UINT32 NUM_COMMANDS = 5000;
+		static constexpr UINT64 TIMEOUT_MS = 10000;
+
+		CommandQueue<CommandQueueLockFree> queue(gCoreThread().getCoreThreadId(), 64);
+		Vector<ProducedCommand> executed;
+
+		Vector<HThread> producers = startProducers(queue, executed, NUM_PRODUCERS, NUM_COMMANDS);
+
+		// Play back on the core thread while the producers are still queuing, until all the commands were seen
+		gCoreThread().queueCommand([&queue, &executed]()
+		{
+			Timer timer;
+			while (executed.size() < NUM_PRODUCERS * NUM_COMMANDS && timer.getMilliseconds() < TIMEOUT_MS)
+				queue.playback();
+		}, CTQF_InternalQueue | CTQF_BlockUntilComplete);
+
+		for (auto& producer : producers)
+			producer.blockUntilComplete();
+
+		LS_TEST_ASSERT(queue.isEmpty());
+		LS_TEST_ASSERT(isProducedInOrder(executed, NUM_PRODUCERS, NUM_COMMANDS));
+	}
+
+	void CoreTestSuite::testCoreObjectSync()
+	{
+		// Enough objects for each dependency level to be serialized on the worker threads
+		static constexpr UINT32 NUM_OBJECTS = 1024;
+
+		Vector<SPtr<TestSyncObject>> dependencies;
+		Vector<SPtr<TestSyncObject>> dependants;
+		for (UINT32 i = 0; i < NUM_OBJECTS; i++)
+		{
+			dependencies.push_back(TestSyncObject::create());
+			dependants.push_back(TestSyncObject::create(dependencies.back().get()));
+		}
+
+		// Another thread keeps creating, dirtying and destroying objects while the sync is in progress
+		std::atomic<bool> stopChurn(false);
+		HThread churn = ThreadPool::instance().run("CoreObjectChurn", [&stopChurn]()
+		{
+			UINT32 value = 0;
+			while (!stopChurn.load())
+			{
+				SPtr<TestSyncObject> object = TestSyncObject::create();
+				object->setValue(value++);
+			}
+		});
+
+		for (UINT32 frame = 0; frame < 3; frame++)
+		{
+			for (UINT32 i = 0; i < NUM_OBJECTS; i++)
+			{
+				dependencies[i]->setValue(frame * NUM_OBJECTS + i);
+				dependants[i]->setValue(frame * NUM_OBJECTS + i + 1);
+			}
+
+			CoreObjectManager::instance().syncToCore();
+			gCoreThread().submit(true);
+
+			bool allSynced = true;
+			bool dependenciesFirst = true;
+			for (UINT32 i = 0; i < NUM_OBJECTS; i++)
+			{
+				SPtr<ct::TestSyncObject> dependencyCore = dependencies[i]->getCore();
+				SPtr<ct::TestSyncObject> dependantCore = dependants[i]->getCore();
+
+				allSynced &= dependencyCore->value == dependencies[i]->getValue();
+				allSynced &= dependantCore->value == dependants[i]->getValue();
+				dependenciesFirst &= dependencyCore->syncIdx < dependantCore->syncIdx;
+			}
+
+			LS_TEST_ASSERT(allSynced);
+			LS_TEST_ASSERT(dependenciesFirst);
+		}
+
+		stopChurn.store(true);
+		churn.blockUntilComplete();
+
+		dependants.clear();
+		dependencies.clear();
+
+		// Flush the sync data of the destroyed objects
+		CoreObjectManager::instance().syncToCore();
+		gCoreThread().submit(true);
+	}
+
+	void CoreTestSuite::testCoreObjectDirtiedWhileSyncing()
+	{
+		SPtr<TestSyncObject> object = TestSyncObject::create();
+		object->setValue(1);
+
+		// Another thread changes the object after its value was serialized, raising the same dirty flags again
+		object->setOnSync([&object]()
+		{
+			HThread modify = ThreadPool::instance().run("CoreObjectModify", [&object]() { object->setValue(2); });
+			modify.blockUntilComplete();
+		});
+
+		CoreObjectManager::instance().syncToCore();
+		gCoreThread().submit(true);
+
+		LS_TEST_ASSERT(object->getCore()->value == 1);
+
+		// The change made during the previous sync must still be pending
+		object->setOnSync(nullptr);
+
+		CoreObjectManager::instance().syncToCore();
+		gCoreThread().submit(true);
+
+		LS_TEST_ASSERT(object->getCore()->value == 2);
+
+		object = nullptr;
+		CoreObjectManager::instance().syncToCore();
+		gCoreThread().submit(true);
+	}
+}
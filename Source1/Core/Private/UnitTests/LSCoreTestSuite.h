@@ -0,0 +1,21 @@
+#pragma once
+
+#include "LSCorePrerequisites.h"
+#include "Testing/LSTestSuite.h"
+
+namespace ls
+{
+	class CoreTestSuite : public TestSuite
+	{
+	public:
+		CoreTestSuite();
+		void startUp() override;
+		void shutDown() override;
+
+	private:
+		void testCommandQueueOrdering();
+		void testCommandQueueConcurrentPlayback();
+		void testCoreObjectSync();
+		void testCoreObjectDirtiedWhileSyncing();
+	};
+}
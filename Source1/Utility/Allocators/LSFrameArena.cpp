@@ -0,0 +1,276 @@
+#include "Prerequisites/LSPrerequisitesUtil.h"
+#include "Allocators/LSFrameArena.h"
+#include "Thread/LSSpinLock.h"
+
+namespace ls
+{
+	struct FrameArena::SharedData
+	{
+		~SharedData()
+		{
+			for(Block* blocks : { freeBlocks, retiredBlocks })
+			{
+				while(blocks != nullptr)
+				{
+					Block* next = blocks->next;
+					ls_free_aligned16(blocks);
+
+					blocks = next;
+				}
+			}
+		}
+
+		SpinLock poolLock;
+		Block* freeBlocks = nullptr; /**< Blocks available for reuse. */
+		Block* retiredBlocks = nullptr; /**< Blocks released during the current frame, reusable after it ends. */
+
+		Mutex arenaMutex;
+		Vector<FrameArena*> arenas;
+	};
+
+	std::atomic<UINT64> FrameArena::sFrameIdx(0);
+	static LS_THREADLOCAL FrameArena* CurrentArena = nullptr;
+
+	FrameArena::FrameArena()
+		: mOwnerThread(LS_THREAD_CURRENT_ID), mFrameBytes(0), mPeakFrameBytes(0), mReservedBytes(0), mNumHeapBlocks(0)
+	{ }
+
+	FrameArena::~FrameArena()
+	{
+		for(Block* blocks : { mUsedBlocks, mFreeBlocks })
+		{
+			while(blocks != nullptr)
+			{
+				Block* next = blocks->next;
+				ls_free_aligned16(blocks);
+
+				blocks = next;
+			}
+		}
+	}
+
+	void FrameArena::allocSlow(UINT32 amount)
+	{
+		if(mFrameIdx != getFrameIdx())
+			beginFrame();
+
+		if(amount <= (UINT32)(mEnd - mPos))
+			return;
+
+		// Find a block kept from the previous frames, or get a new one. Remaining space in the current block is lost
+		// until the next frame.
+		Block* block = nullptr;
+		for(Block** iter = &mFreeBlocks; *iter != nullptr; iter = &(*iter)->next)
+		{
+			if((*iter)->size >= amount)
+			{
+				block = *iter;
+				*iter = block->next;
+				break;
+			}
+		}
+
+		if(block == nullptr)
+			block = acquireBlock(amount);
+
+		block->next = mUsedBlocks;
+		mUsedBlocks = block;
+
+		mPos = getData(block);
+		mEnd = mPos + block->size;
+	}
+
+	void FrameArena::beginFrame()
+	{
+		UINT64 frameBytes = mFrameBytes.load(std::memory_order_relaxed);
+		if(frameBytes > mPeakFrameBytes.load(std::memory_order_relaxed))
+			mPeakFrameBytes.store(frameBytes, std::memory_order_relaxed);
+
+		mFrameBytes.store(0, std::memory_order_relaxed);
+
+		// Keep enough blocks to satisfy as much memory as was used during the last frame, and return the rest
+		Block* keptBlocks = nullptr;
+		Block* releasedBlocks = nullptr;
+		UINT64 keptBytes = 0;
+		UINT64 releasedBytes = 0;
+
+		for(Block* blocks : { mUsedBlocks, mFreeBlocks })
+		{
+			while(blocks != nullptr)
+			{
+				Block* next = blocks->next;
+				if(keptBytes < frameBytes)
+				{
+					blocks->next = keptBlocks;
+					keptBlocks = blocks;
+					keptBytes += blocks->size;
+				}
+				else
+				{
+					blocks->next = releasedBlocks;
+					releasedBlocks = blocks;
+					releasedBytes += blocks->size;
+				}
+
+				blocks = next;
+			}
+		}
+
+		if(releasedBlocks != nullptr)
+		{
+			SharedData& sharedData = getSharedData();
+			ScopedSpinLock lock(sharedData.poolLock);
+
+			moveBlocks(releasedBlocks, sharedData.freeBlocks);
+		}
+
+		mReservedBytes.fetch_sub(releasedBytes, std::memory_order_relaxed);
+
+		mUsedBlocks = nullptr;
+		mFreeBlocks = keptBlocks;
+		mPos = nullptr;
+		mEnd = nullptr;
+		mFrameIdx = getFrameIdx();
+	}
+
+	FrameArena::Block* FrameArena::acquireBlock(UINT32 amount)
+	{
+		SharedData& sharedData = getSharedData();
+
+		Block* block = nullptr;
+		{
+			ScopedSpinLock lock(sharedData.poolLock);
+
+			for(Block** iter = &sharedData.freeBlocks; *iter != nullptr; iter = &(*iter)->next)
+			{
+				if((*iter)->size >= amount)
+				{
+					block = *iter;
+					*iter = block->next;
+					break;
+				}
+			}
+		}
+
+		if(block == nullptr)
+		{
+			UINT32 size = std::max(BLOCK_SIZE, ((amount + BLOCK_SIZE - 1) / BLOCK_SIZE) * BLOCK_SIZE);
+
+			block = (Block*)ls_alloc_aligned16(sizeof(Block) + size);
+			block->size = size;
+
+			mNumHeapBlocks.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		mReservedBytes.fetch_add(block->size, std::memory_order_relaxed);
+		return block;
+	}
+
+	FrameArenaStats FrameArena::getStats() const
+	{
+		FrameArenaStats stats;
+		stats.threadId = mOwnerThread;
+		stats.frameBytes = mFrameBytes.load(std::memory_order_relaxed);
+		stats.peakFrameBytes = std::max(stats.frameBytes, mPeakFrameBytes.load(std::memory_order_relaxed));
+		stats.reservedBytes = mReservedBytes.load(std::memory_order_relaxed);
+		stats.numHeapBlocks = mNumHeapBlocks.load(std::memory_order_relaxed);
+
+		return stats;
+	}
+
+	FrameArena& FrameArena::current()
+	{
+		if(CurrentArena == nullptr)
+		{
+			CurrentArena = ls_new<FrameArena>();
+
+			SharedData& sharedData = getSharedData();
+			Lock lock(sharedData.arenaMutex);
+			sharedData.arenas.push_back(CurrentArena);
+		}
+
+		return *CurrentArena;
+	}
+
+	void FrameArena::endFrame()
+	{
+		SharedData& sharedData = getSharedData();
+
+		{
+			ScopedSpinLock lock(sharedData.poolLock);
+
+			moveBlocks(sharedData.retiredBlocks, sharedData.freeBlocks);
+			sharedData.retiredBlocks = nullptr;
+		}
+
+		sFrameIdx.fetch_add(1, std::memory_order_release);
+	}
+
+	Vector<FrameArenaStats> FrameArena::getAllStats()
+	{
+		SharedData& sharedData = getSharedData();
+		Lock lock(sharedData.arenaMutex);
+
+		Vector<FrameArenaStats> stats;
+		for(auto& arena : sharedData.arenas)
+			stats.push_back(arena->getStats());
+
+		return stats;
+	}
+
+	void FrameArena::endThread()
+	{
+		FrameArena* arena = CurrentArena;
+		if(arena == nullptr)
+			return;
+
+		SharedData& sharedData = getSharedData();
+		{
+			Lock lock(sharedData.arenaMutex);
+
+			auto iterFind = std::find(sharedData.arenas.begin(), sharedData.arenas.end(), arena);
+			if(iterFind != sharedData.arenas.end())
+				sharedData.arenas.erase(iterFind);
+		}
+
+		// Memory allocated during the current frame might still be in use by other threads, so it can only be reused
+		// once the frame ends
+		bool isCurrentFrame = arena->mFrameIdx == getFrameIdx();
+
+		{
+			ScopedSpinLock lock(sharedData.poolLock);
+
+			moveBlocks(arena->mUsedBlocks, isCurrentFrame ? sharedData.retiredBlocks : sharedData.freeBlocks);
+			moveBlocks(arena->mFreeBlocks, sharedData.freeBlocks);
+		}
+
+		arena->mUsedBlocks = nullptr;
+		arena->mFreeBlocks = nullptr;
+
+		ls_delete(arena);
+		CurrentArena = nullptr;
+	}
+
+	void FrameArena::moveBlocks(Block* blocks, Block*& target)
+	{
+		while(blocks != nullptr)
+		{
+			Block* next = blocks->next;
+			blocks->next = target;
+			target = blocks;
+
+			blocks = next;
+		}
+	}
+
+	FrameArena::SharedData& FrameArena::getSharedData()
+	{
+		static SharedData sharedData;
+		return sharedData;
+	}
+
+	LS_UTILITY_EXPORT FrameArena& gFrameArena()
+	{
+		return FrameArena::current();
+	}
+}
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <new>                  /* For 'placement new' */
+
+#include "Prerequisites/LSPlatformDefines.h"
+#include "Prerequisites/LSTypes.h"
+#include "Prerequisites/LSStdHeaders.h"
+#include "Thread/LSThread.h"
+
+namespace ls
+{
+	/** @addtogroup Internal-Utility
+	 *  @{
+	 */
+
+	/** @addtogroup Memory-Internal
+	 *  @{
+	 */
+
+	/** Usage statistics of a single thread's FrameArena. */
+	struct FrameArenaStats
+	{
+		ThreadId threadId; /**< Thread that owns the arena. */
+		UINT64 frameBytes = 0; /**< Bytes allocated by the thread during its last active frame. */
+		UINT64 peakFrameBytes = 0; /**< Highest number of bytes allocated by the thread during a single frame. */
+		UINT64 reservedBytes = 0; /**< Size of the memory blocks currently owned by the arena. */
+		UINT64 numHeapBlocks = 0; /**< Number of blocks the arena had to allocate from the heap, instead of recycling. */
+	};
+
+	/**
+	 * Frame allocator shared by all threads. Each thread allocates from its own arena without any synchronization, but
+	 * unlike with gFrameAlloc() all the arenas are reset together, at a global frame boundary (see endFrame()). This
+	 * means memory allocated on one thread (e.g. a TaskScheduler worker) may be handed over to and used by other threads
+	 * until the end of the frame.
+	 *
+	 * Memory blocks are recycled between frames. Each arena keeps as many blocks as it used during its last frame, and
+	 * returns the rest to a global pool other arenas take their blocks from. Once the per-frame usage settles no more
+	 * memory is allocated from the heap.
+	 *
+	 * @note
+	 * Individual allocations cannot be freed. All memory allocated by the arenas becomes invalid after the call to
+	 * endFrame().
+	 * @note
+	 * No engine system ends the frame on its own. Whoever owns the frame loop the arenas are used in must call endFrame()
+	 * once per frame, otherwise memory is never recycled and the arenas keep growing.
+	 * @note
+	 * Thread safe, as each thread only ever accesses its own arena. endFrame() must not be called while other threads
+	 * are still allocating memory or using memory allocated in the current frame.
+	 */
+	class LS_UTILITY_EXPORT FrameArena
+	{
+		/** Header of a block of memory owned either by an arena or the global block pool. */
+		struct alignas(16) Block
+		{
+			Block* next;
+			UINT32 size;
+		};
+
+	public:
+		/** Size of a standard memory block. Larger allocations get their own block. */
+		static constexpr UINT32 BLOCK_SIZE = 256 * 1024;
+
+		/** Largest supported allocation, in bytes. Leaves room for the alignment and block header. */
+		static constexpr UINT32 MAX_ALLOC_SIZE = 1U << 31;
+
+		FrameArena();
+		~FrameArena();
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		/**
+		 * Allocates a new piece of memory of the specified size, aligned to a 16 byte boundary.
+		 *
+		 * @param[in]	amount	Amount of memory to allocate, in bytes.
+		 *
+		 * @note	Must only be called from the thread owning the arena.
+		 */
+		UINT8* alloc(UINT32 amount)
+		{
+			assert(amount <= MAX_ALLOC_SIZE && "Frame arena allocation too large.");
+			amount = (amount + 15) & ~15;
+
+			if(mFrameIdx != getFrameIdx() || amount > (UINT32)(mEnd - mPos))
+				allocSlow(amount);
+
+			UINT8* data = mPos;
+			mPos += amount;
+			mFrameBytes.store(mFrameBytes.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+
+			return data;
+		}
+
+		/**
+		 * Allocates a new piece of memory of the specified size aligned to the specified boundary.
+		 *
+		 * @param[in]	amount		Amount of memory to allocate, in bytes.
+		 * @param[in]	alignment	Alignment of the allocated memory. Must be power of two.
+		 *
+		 * @note	Must only be called from the thread owning the arena.
+		 */
+		UINT8* allocAligned(UINT32 amount, UINT32 alignment)
+		{
+			if(alignment <= 16)
+				return alloc(amount);
+
+			UINT8* data = alloc(amount + alignment - 16);
+			return (UINT8*)(((UINT64)data + alignment - 1) & ~((UINT64)alignment - 1));
+		}
+
+		/**
+		 * Allocates and constructs a new object.
+		 *
+		 * @note	Must only be called from the thread owning the arena.
+		 */
+		template<class T, class... Args>
+		T* construct(Args &&...args)
+		{
+			return new ((T*)allocAligned(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		/** Does nothing, memory is only released at the end of the frame. Provided for compatibility with StdAlloc. */
+		void free(void* data) { }
+
+		/** Returns the usage statistics of this arena. May be called from any thread. */
+		FrameArenaStats getStats() const;
+
+		/** Returns the arena of the calling thread, creating it if needed. */
+		static FrameArena& current();
+
+		/**
+		 * Ends the current frame. All memory allocated by any of the arenas becomes invalid, and will be reused the next
+		 * time the arena's thread allocates memory.
+		 *
+		 * @note	Must only be called when no other thread is using frame arena memory, normally once all tasks for the
+		 *			frame have completed. Must be called by the system owning the frame loop the arenas are used in.
+		 */
+		static void endFrame();
+
+		/** Returns the index of the current frame, incremented on each endFrame() call. */
+		static UINT64 getFrameIdx() { return sFrameIdx.load(std::memory_order_acquire); }
+
+		/** Returns usage statistics of all the arenas currently in use. */
+		static Vector<FrameArenaStats> getAllStats();
+
+		/**
+		 * Releases the calling thread's arena, if it has one, and hands its memory over to the global block pool. Should
+		 * be called before a thread that might have used its arena exits.
+		 */
+		static void endThread();
+
+	private:
+		/** Resets the arena if the frame changed, and makes room for an allocation of @p amount bytes. */
+		void allocSlow(UINT32 amount);
+
+		/** Releases all allocations made in the previous frame, and trims the blocks that weren't needed. */
+		void beginFrame();
+
+		/** Retrieves a block large enough for @p amount bytes from the global pool, or allocates a new one. */
+		Block* acquireBlock(UINT32 amount);
+
+		/** Moves all blocks from the @p blocks list to the front of the @p target list. */
+		static void moveBlocks(Block* blocks, Block*& target);
+
+		/** Data shared by all the arenas. */
+		struct SharedData;
+
+		/** Returns the data shared by all the arenas. */
+		static SharedData& getSharedData();
+
+		/** Returns the data section of a block. */
+		static UINT8* getData(Block* block) { return (UINT8*)block + sizeof(Block); }
+
+		Block* mUsedBlocks = nullptr; /**< Blocks used during the current frame, the most recently used one first. */
+		Block* mFreeBlocks = nullptr; /**< Blocks kept from previous frames, not yet used in the current frame. */
+		UINT8* mPos = nullptr;
+		UINT8* mEnd = nullptr;
+		UINT64 mFrameIdx = 0;
+
+		ThreadId mOwnerThread;
+		std::atomic<UINT64> mFrameBytes;
+		std::atomic<UINT64> mPeakFrameBytes;
+		std::atomic<UINT64> mReservedBytes;
+		std::atomic<UINT64> mNumHeapBlocks;
+
+		static std::atomic<UINT64> sFrameIdx;
+	};
+
+	/** @} */
+	/** @} */
+
+	/** @addtogroup Memory
+	 *  @{
+	 */
+
+	/**
+	 * Returns the frame arena of the calling thread. Memory allocated from it remains valid on all threads until the
+	 * next FrameArena::endFrame() call.
+	 *
+	 * @note	Thread safe.
+	 * @note	FrameArena::endFrame() isn't called automatically. The owner of the frame loop must call it every frame.
+	 */
+	LS_UTILITY_EXPORT FrameArena& gFrameArena();
+
+	/** @} */
+
+	/** @addtogroup Internal-Utility
+	 *  @{
+	 */
+
+	/** @addtogroup Memory-Internal
+	 *  @{
+	 */
+
+	/**
+	 * Specialized memory allocator implementations that allows use of the calling thread's frame arena in normal
+	 * new/delete/free/dealloc operators.
+	 */
+	template<>
+	class MemoryAllocator<FrameArena> : public MemoryAllocatorBase
+	{
+	public:
+		/** @copydoc MemoryAllocator::allocate */
+		static void* allocate(size_t bytes)
+		{
+			if(!isValidSize(bytes, 16))
+				return nullptr;
+
+			return gFrameArena().alloc((UINT32)bytes);
+		}
+
+		/** @copydoc MemoryAllocator::allocateAligned */
+		static void* allocateAligned(size_t bytes, size_t alignment)
+		{
+			if(!isValidSize(bytes, alignment))
+				return nullptr;
+
+			return gFrameArena().allocAligned((UINT32)bytes, (UINT32)alignment);
+		}
+
+		/** @copydoc MemoryAllocator::allocateAligned16 */
+		static void* allocateAligned16(size_t bytes)
+		{
+			if(!isValidSize(bytes, 16))
+				return nullptr;
+
+			return gFrameArena().alloc((UINT32)bytes);
+		}
+
+		/** @copydoc MemoryAllocator::free */
+		static void free(void* ptr) { }
+
+		/** @copydoc MemoryAllocator::freeAligned */
+		static void freeAligned(void* ptr) { }
+
+		/** @copydoc MemoryAllocator::freeAligned16 */
+		static void freeAligned16(void* ptr) { }
+
+	private:
+		/** 
+		 * Checks if an allocation fits within the arena's 32-bit sizes. Larger requests are rejected rather than
+		 * truncated.
+		 */
+		static bool isValidSize(size_t bytes, size_t alignment)
+		{
+			const size_t maxSize = FrameArena::MAX_ALLOC_SIZE;
+			const bool valid = alignment <= maxSize && bytes <= maxSize - alignment;
+			assert(valid && "Frame arena allocation too large.");
+
+			return valid;
+		}
+	};
+
+	/** @} */
+	/** @} */
+}
@@ -0,0 +1,445 @@
+#include "Prerequisites/LSPrerequisitesUtil.h"
+#include "Allocators/LSMemAllocProfiler.h"
+#include "FileSystem/LSFileSystem.h"
+#include "FileSystem/LSDataStream.h"
+
+#if COMPILER_GCC || COMPILER_CLANG
+#include <cxxabi.h>
+#endif
+
+namespace ls
+{
+	/** Counters of a single category or call site, updated from any thread. */
+	struct AllocCounters
+	{
+		std::atomic<UINT64> numAllocs{0};
+		std::atomic<UINT64> numFrees{0};
+		std::atomic<UINT64> allocatedBytes{0};
+		std::atomic<UINT64> freedBytes{0};
+		std::atomic<UINT64> peakLiveBytes{0};
+
+		void onAlloc(UINT64 bytes)
+		{
+			numAllocs.fetch_add(1, std::memory_order_relaxed);
+			UINT64 allocated = allocatedBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+			// Frees can race with the read, which at worst makes the peak a little higher than it really was
+			UINT64 live = allocated - freedBytes.load(std::memory_order_relaxed);
+			UINT64 peak = peakLiveBytes.load(std::memory_order_relaxed);
+			while(live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+			{ }
+		}
+
+		void onFree(UINT64 bytes)
+		{
+			numFrees.fetch_add(1, std::memory_order_relaxed);
+			freedBytes.fetch_add(bytes, std::memory_order_relaxed);
+		}
+
+		MemAllocStats getStats() const
+		{
+			MemAllocStats stats;
+			stats.numAllocs = numAllocs.load(std::memory_order_relaxed);
+			stats.numFrees = numFrees.load(std::memory_order_relaxed);
+			stats.freedBytes = freedBytes.load(std::memory_order_relaxed);
+			stats.allocatedBytes = allocatedBytes.load(std::memory_order_relaxed);
+			stats.liveBytes = stats.allocatedBytes - std::min(stats.freedBytes, stats.allocatedBytes);
+			stats.peakLiveBytes = std::max(peakLiveBytes.load(std::memory_order_relaxed), stats.liveBytes);
+
+			return stats;
+		}
+	};
+
+	/** Entry in the call site hash table. Never removed once added. */
+	struct AllocSite
+	{
+		std::atomic<bool> used{false};
+		bool overflow = false;
+		UINT32 category = 0;
+		const char* scope = nullptr;
+		void* address = nullptr;
+		AllocCounters counters;
+	};
+
+	/** Header placed in front of every tracked allocation. */
+	struct AllocHeader
+	{
+		UINT64 size;
+		UINT32 site;
+		UINT32 offset;
+	};
+
+	static_assert(sizeof(AllocHeader) == MemAllocProfiler::HEADER_SIZE, "Invalid allocation header size.");
+
+	/** All the data recorded by the profiler. */
+	struct ProfilerData
+	{
+		// Sites without a scope or address, one per category, are used once the table is full, so they get their own space
+		static constexpr UINT32 TABLE_SIZE = MemAllocProfiler::MAX_SITES + MemAllocProfiler::MAX_CATEGORIES;
+
+		// Followed by one overflow site per category, used for sites that can't be placed within MAX_PROBES slots
+		static constexpr UINT32 CAPACITY = TABLE_SIZE + MemAllocProfiler::MAX_CATEGORIES;
+
+		/** Maximum number of slots looked at when searching the table for a site. */
+		static constexpr UINT32 MAX_PROBES = 128;
+
+		/** Returned by probeSite() if neither the site nor an empty slot were found. */
+		static constexpr UINT32 NO_SITE = std::numeric_limits<UINT32>::max();
+
+		// Never freed, as tracked allocations might still be freed during static destruction
+		ProfilerData()
+		{
+			sites = ls_newN<AllocSite, ProfilerAlloc>(CAPACITY);
+			siteOrder = (UINT32*)ls_alloc<ProfilerAlloc>(CAPACITY * sizeof(UINT32));
+		}
+
+		SpinLock lock; /**< Taken when adding categories and sites. */
+
+		const char* categoryNames[MemAllocProfiler::MAX_CATEGORIES];
+		AllocCounters categories[MemAllocProfiler::MAX_CATEGORIES];
+		std::atomic<UINT32> numCategories{0};
+
+		AllocSite* sites; /**< Hash table of all the sites, with linear probing. */
+		UINT32* siteOrder; /**< Indices of the sites in the table, in the order they were added. */
+		std::atomic<UINT32> numSites{0};
+		UINT32 numNamedSites = 0;
+
+		AllocCounters total;
+	};
+
+	static ProfilerData& getProfilerData()
+	{
+		static ProfilerData data;
+		return data;
+	}
+
+	static LS_THREADLOCAL const char* CurrentScope = nullptr;
+
+	/** 
+	 * Returns the index of the site matching the provided key, or of the empty slot where it should be added. Returns
+	 * ProfilerData::NO_SITE if neither is found within ProfilerData::MAX_PROBES slots.
+	 */
+	static UINT32 probeSite(const ProfilerData& data, UINT32 category, const char* scope, void* address)
+	{
+		UINT64 hash = (UINT64)(uintptr_t)address * 0x9E3779B97F4A7C15ULL;
+		hash ^= (UINT64)(uintptr_t)scope * 0xC2B2AE3D27D4EB4FULL;
+		hash ^= category * 0x165667B19E3779F9ULL;
+		hash ^= hash >> 29;
+
+		UINT32 idx = (UINT32)(hash % ProfilerData::TABLE_SIZE);
+		for(UINT32 i = 0; i < ProfilerData::MAX_PROBES; i++)
+		{
+			const AllocSite& site = data.sites[idx];
+			if(!site.used.load(std::memory_order_acquire))
+				return idx;
+
+			if(site.category == category && site.scope == scope && site.address == address)
+				return idx;
+
+			idx = (idx + 1) % ProfilerData::TABLE_SIZE;
+		}
+
+		return ProfilerData::NO_SITE;
+	}
+
+	/** Adds a site to the list of sites in the order they were added. Caller must hold the lock. */
+	static void addSiteToOrder(ProfilerData& data, UINT32 idx)
+	{
+		UINT32 numSites = data.numSites.load(std::memory_order_relaxed);
+		data.siteOrder[numSites] = idx;
+		data.numSites.store(numSites + 1, std::memory_order_release);
+	}
+
+	/** Finds the site matching the provided key, adding it if it doesn't exist yet. Returns its index in the table. */
+	static UINT32 findOrAddSite(ProfilerData& data, UINT32 category, const char* scope, void* address)
+	{
+		const UINT32 overflowIdx = ProfilerData::TABLE_SIZE + category;
+
+		// Sites are only ever added, so a lookup that reaches an empty slot can only miss a site added concurrently
+		UINT32 idx = probeSite(data, category, scope, address);
+		if(idx != ProfilerData::NO_SITE && data.sites[idx].used.load(std::memory_order_acquire))
+			return idx;
+
+		if(idx == ProfilerData::NO_SITE && data.sites[overflowIdx].used.load(std::memory_order_acquire))
+			return overflowIdx;
+
+		ScopedSpinLock lock(data.lock);
+
+		// Merge new sites into a single one per category once the limit is reached
+		bool isFallback = scope == nullptr && address == nullptr;
+		if(!isFallback && data.numNamedSites >= MemAllocProfiler::MAX_SITES)
+		{
+			scope = nullptr;
+			address = nullptr;
+			isFallback = true;
+		}
+
+		idx = probeSite(data, category, scope, address);
+		if(idx == ProfilerData::NO_SITE)
+		{
+			AllocSite& overflowSite = data.sites[overflowIdx];
+			if(!overflowSite.used.load(std::memory_order_relaxed))
+			{
+				overflowSite.category = category;
+				overflowSite.overflow = true;
+				overflowSite.used.store(true, std::memory_order_release);
+
+				addSiteToOrder(data, overflowIdx);
+			}
+
+			return overflowIdx;
+		}
+
+		AllocSite& site = data.sites[idx];
+		if(site.used.load(std::memory_order_relaxed))
+			return idx;
+
+		site.category = category;
+		site.scope = scope;
+		site.address = address;
+		site.used.store(true, std::memory_order_release);
+
+		if(!isFallback)
+			data.numNamedSites++;
+
+		addSiteToOrder(data, idx);
+		return idx;
+	}
+
+	static void subtract(UINT64& value, UINT64 newer, UINT64 older)
+	{
+		value = newer - std::min(newer, older);
+	}
+
+	static MemAllocStats getStatsDelta(const MemAllocStats& newer, const MemAllocStats& older)
+	{
+		MemAllocStats output = newer;
+		subtract(output.numAllocs, newer.numAllocs, older.numAllocs);
+		subtract(output.numFrees, newer.numFrees, older.numFrees);
+		subtract(output.allocatedBytes, newer.allocatedBytes, older.allocatedBytes);
+		subtract(output.freedBytes, newer.freedBytes, older.freedBytes);
+
+		return output;
+	}
+
+	MemAllocSnapshot MemAllocSnapshot::getDelta(const MemAllocSnapshot& older) const
+	{
+		MemAllocSnapshot output = *this;
+		output.total = getStatsDelta(total, older.total);
+
+		for(size_t i = 0; i < categories.size() && i < older.categories.size(); i++)
+			output.categories[i].stats = getStatsDelta(categories[i].stats, older.categories[i].stats);
+
+		for(size_t i = 0; i < sites.size() && i < older.sites.size(); i++)
+			output.sites[i].stats = getStatsDelta(sites[i].stats, older.sites[i].stats);
+
+		return output;
+	}
+
+	MemAllocProfiler::Scope::Scope(const char* name)
+		: mPrevious(CurrentScope)
+	{
+		CurrentScope = name;
+	}
+
+	MemAllocProfiler::Scope::~Scope()
+	{
+		CurrentScope = mPrevious;
+	}
+
+	UINT32 MemAllocProfiler::registerCategory(const char* typeName)
+	{
+		const char* name = typeName;
+
+#if COMPILER_GCC || COMPILER_CLANG
+		// Demangled name is allocated with malloc, and kept for the lifetime of the program
+		int status = 0;
+		char* demangledName = abi::__cxa_demangle(typeName, nullptr, nullptr, &status);
+		if(status == 0 && demangledName != nullptr)
+			name = demangledName;
+#endif
+
+		ProfilerData& data = getProfilerData();
+		ScopedSpinLock lock(data.lock);
+
+		// Same category might get registered more than once if instantiated in multiple modules
+		UINT32 numCategories = data.numCategories.load(std::memory_order_relaxed);
+		for(UINT32 i = 0; i < numCategories; i++)
+		{
+			if(strcmp(data.categoryNames[i], name) == 0)
+			{
+				if(name != typeName)
+					::free((void*)name);
+
+				return i;
+			}
+		}
+
+		if(numCategories == MAX_CATEGORIES)
+		{
+			LS_ASSERT(false && "Too many allocator categories.");
+			return MAX_CATEGORIES - 1;
+		}
+
+		data.categoryNames[numCategories] = name;
+		data.numCategories.store(numCategories + 1, std::memory_order_release);
+
+		return numCategories;
+	}
+
+	void* MemAllocProfiler::onAlloc(void* data, size_t offset, size_t bytes, UINT32 category, void* address)
+	{
+		if(data == nullptr)
+			return nullptr;
+
+		ProfilerData& profilerData = getProfilerData();
+		UINT32 site = findOrAddSite(profilerData, category, CurrentScope, CurrentScope != nullptr ? nullptr : address);
+
+		profilerData.sites[site].counters.onAlloc(bytes);
+		profilerData.categories[category].onAlloc(bytes);
+		profilerData.total.onAlloc(bytes);
+
+		UINT8* ptr = (UINT8*)data + offset;
+
+		AllocHeader* header = (AllocHeader*)(ptr - HEADER_SIZE);
+		header->size = bytes;
+		header->site = site;
+		header->offset = (UINT32)offset;
+
+		return ptr;
+	}
+
+	void* MemAllocProfiler::onFree(void* ptr)
+	{
+		if(ptr == nullptr)
+			return nullptr;
+
+		AllocHeader* header = (AllocHeader*)((UINT8*)ptr - HEADER_SIZE);
+
+		ProfilerData& profilerData = getProfilerData();
+		AllocSite& site = profilerData.sites[header->site];
+
+		site.counters.onFree(header->size);
+		profilerData.categories[site.category].onFree(header->size);
+		profilerData.total.onFree(header->size);
+
+		return (UINT8*)ptr - header->offset;
+	}
+
+	MemAllocSnapshot MemAllocProfiler::getSnapshot()
+	{
+		ProfilerData& data = getProfilerData();
+
+		MemAllocSnapshot snapshot;
+		snapshot.total = data.total.getStats();
+
+		UINT32 numCategories = data.numCategories.load(std::memory_order_acquire);
+		snapshot.categories.resize(numCategories);
+
+		for(UINT32 i = 0; i < numCategories; i++)
+		{
+			snapshot.categories[i].name = data.categoryNames[i];
+			snapshot.categories[i].stats = data.categories[i].getStats();
+		}
+
+		UINT32 numSites = data.numSites.load(std::memory_order_acquire);
+		snapshot.sites.resize(numSites);
+
+		for(UINT32 i = 0; i < numSites; i++)
+		{
+			const AllocSite& site = data.sites[data.siteOrder[i]];
+
+			snapshot.sites[i].category = site.category;
+			snapshot.sites[i].scope = site.scope;
+			snapshot.sites[i].address = site.address;
+			snapshot.sites[i].overflow = site.overflow;
+			snapshot.sites[i].stats = site.counters.getStats();
+		}
+
+		return snapshot;
+	}
+
+	void MemAllocProfiler::saveSnapshot(const MemAllocSnapshot& snapshot, const Path& path)
+	{
+		using ProfilerStringStream = std::basic_stringstream<char, std::char_traits<char>, StdAlloc<char, ProfilerAlloc>>;
+
+		ProfilerStringStream stream;
+		stream << "Type,Category,Site,NumAllocs,NumFrees,AllocatedBytes,FreedBytes,LiveBytes,PeakLiveBytes" << std::endl;
+
+		// Names may contain separators (e.g. template arguments), so text fields are quoted, with quotes doubled
+		auto writeText = [&stream](const char* text)
+		{
+			stream << '"';
+			for(const char* iter = text; *iter != '\0'; ++iter)
+			{
+				if(*iter == '"')
+					stream << '"';
+
+				stream << *iter;
+			}
+
+			stream << '"';
+		};
+
+		auto writeStats = [&stream](const MemAllocStats& stats)
+		{
+			stream << stats.numAllocs << "," << stats.numFrees << "," << stats.allocatedBytes << "," << stats.freedBytes
+				<< "," << stats.liveBytes << "," << stats.peakLiveBytes << std::endl;
+		};
+
+		stream << "Total,,,";
+		writeStats(snapshot.total);
+
+		auto sortedIndices = [](const auto& entries)
+		{
+			MemAllocSnapshot::ProfilerVector<UINT32> indices(entries.size());
+			for(UINT32 i = 0; i < (UINT32)indices.size(); i++)
+				indices[i] = i;
+
+			std::sort(indices.begin(), indices.end(), [&entries](UINT32 a, UINT32 b)
+			{
+				return entries[a].stats.liveBytes > entries[b].stats.liveBytes;
+			});
+
+			return indices;
+		};
+
+		for(UINT32 i : sortedIndices(snapshot.categories))
+		{
+			stream << "Category,";
+			writeText(snapshot.categories[i].name);
+			stream << ",,";
+			writeStats(snapshot.categories[i].stats);
+		}
+
+		for(UINT32 i : sortedIndices(snapshot.sites))
+		{
+			const MemAllocSiteStats& site = snapshot.sites[i];
+
+			const char* category = "";
+			if(site.category < snapshot.categories.size())
+				category = snapshot.categories[site.category].name;
+
+			stream << "Site,";
+			writeText(category);
+			stream << ",";
+
+			if(site.overflow)
+				stream << "<overflow>";
+			else if(site.scope != nullptr)
+				writeText(site.scope);
+			else if(site.address != nullptr)
+				stream << site.address;
+			else
+				stream << "<other>";
+
+			stream << ",";
+			writeStats(site.stats);
+		}
+
+		auto contents = stream.str();
+
+		SPtr<DataStream> fileStream = FileSystem::createAndOpenFile(path);
+		fileStream->write(contents.data(), contents.size());
+	}
+}
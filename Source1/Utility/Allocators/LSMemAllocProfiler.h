@@ -1,7 +1,15 @@
 #pragma once
 
+#include <atomic>
+
+#include "Prerequisites/LSPlatformDefines.h"
+#include "Prerequisites/LSTypes.h"
+#include "Prerequisites/LSStdHeaders.h"
+
 namespace ls
 {
+	class Path;
+
 	/** @addtogroup Internal-Utility
 	 *  @{
 	 */
@@ -11,7 +19,7 @@ namespace ls
 	 */
 
 	/**
-	 * Specialized allocator for profiler so we can avoid tracking internal profiler memory allocations which would skew 
+	 * Specialized allocator for profiler so we can avoid tracking internal profiler memory allocations which would skew
 	 * profiler results.
 	 */
 	class ProfilerAlloc
@@ -35,6 +43,131 @@ namespace ls
 		}
 	};
 
+	/** Allocation counters of a single category or call site, as recorded by MemAllocProfiler. */
+	struct MemAllocStats
+	{
+		UINT64 numAllocs = 0; /**< Number of allocations made. */
+		UINT64 numFrees = 0; /**< Number of allocations freed. */
+		UINT64 allocatedBytes = 0; /**< Total number of bytes allocated. */
+		UINT64 freedBytes = 0; /**< Total number of bytes freed. */
+		UINT64 liveBytes = 0; /**< Bytes allocated and not yet freed. */
+		UINT64 peakLiveBytes = 0; /**< Highest value of liveBytes so far. */
+	};
+
+	/** Allocation counters of all allocations made through a single MemoryAllocator<T> specialization. */
+	struct MemAllocCategoryStats
+	{
+		const char* name = nullptr; /**< Name of the allocator category type. */
+		MemAllocStats stats;
+	};
+
+	/**
+	 * Allocation counters of a single call site. A call site is identified by its category, the active
+	 * MemAllocProfiler::Scope, and the code address the allocation was made from.
+	 */
+	struct MemAllocSiteStats
+	{
+		UINT32 category = 0; /**< Index of the site's category in MemAllocSnapshot::categories. */
+		const char* scope = nullptr; /**< Name of the scope the allocations were made in, or null if none. */
+		void* address = nullptr; /**< Code address the allocations were made from. */
+		bool overflow = false; /**< True if the site collects allocations of sites that didn't fit in the site table. */
+		MemAllocStats stats;
+	};
+
+	/**
+	 * Allocation counters of all categories and call sites at a point in time. Categories and sites are never removed,
+	 * and keep their index in all later snapshots.
+	 */
+	struct LS_UTILITY_EXPORT MemAllocSnapshot
+	{
+		template<class T>
+		using ProfilerVector = std::vector<T, StdAlloc<T, ProfilerAlloc>>;
+
+		MemAllocStats total;
+		ProfilerVector<MemAllocCategoryStats> categories;
+		ProfilerVector<MemAllocSiteStats> sites;
+
+		/**
+		 * Returns the activity since an older snapshot. Allocation and free counters are the difference between the two
+		 * snapshots, while live and peak bytes are the ones in this snapshot. Entries without any activity are kept so
+		 * indices still match.
+		 */
+		MemAllocSnapshot getDelta(const MemAllocSnapshot& older) const;
+	};
+
+	/**
+	 * Records the number of allocations and bytes allocated through MemoryAllocator<T>, per allocator category and per
+	 * call site. Only active if LS_MEMORY_TRACKING is enabled.
+	 *
+	 * Counters are updated with atomic operations and no locks, except the first time a call site is seen. Taking a
+	 * snapshot only reads the counters, and is cheap enough to be done every frame. All of the profiler's own memory
+	 * comes from ProfilerAlloc, so it never shows up in the results.
+	 *
+	 * @note	Thread safe.
+	 */
+	class LS_UTILITY_EXPORT MemAllocProfiler
+	{
+	public:
+		/** Size of the header placed in front of every tracked allocation. */
+		static constexpr size_t HEADER_SIZE = 16;
+
+		/** Maximum number of call sites tracked separately. Sites seen after the limit is hit are merged into one. */
+		static constexpr UINT32 MAX_SITES = 4096;
+
+		/** Maximum number of allocator categories. */
+		static constexpr UINT32 MAX_CATEGORIES = 64;
+
+		/**
+		 * Names the allocations made on the calling thread while the object is alive, so they are reported as a separate
+		 * call site. Scopes can be nested, in which case the innermost one is used. @p name must outlive the profiler.
+		 */
+		class LS_UTILITY_EXPORT Scope
+		{
+		public:
+			Scope(const char* name);
+			~Scope();
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			const char* mPrevious;
+		};
+
+		/** Registers an allocator category and returns its index. Called once for each MemoryAllocator<T>. */
+		static UINT32 registerCategory(const char* typeName);
+
+		/**
+		 * Records an allocation and writes the tracking header in front of the user's memory.
+		 *
+		 * @param[in]	data		Memory returned by the underlying allocator.
+		 * @param[in]	offset		Offset from @p data at which the user's memory starts. At least HEADER_SIZE.
+		 * @param[in]	bytes		Number of bytes requested by the user.
+		 * @param[in]	category	Category returned by registerCategory().
+		 * @param[in]	address		Code address the allocation was made from.
+		 * @return					Memory to return to the user.
+		 */
+		static void* onAlloc(void* data, size_t offset, size_t bytes, UINT32 category, void* address);
+
+		/** Records a free of memory returned by onAlloc() and returns the memory originally passed to it. */
+		static void* onFree(void* ptr);
+
+		/** Returns the current counters of all categories and call sites. */
+		static MemAllocSnapshot getSnapshot();
+
+		/**
+		 * Writes a snapshot to a CSV file, one row per category followed by one row per call site, sorted by live bytes.
+		 */
+		static void saveSnapshot(const MemAllocSnapshot& snapshot, const Path& path);
+	};
+
 	/** @} */
 	/** @} */
-}
\ No newline at end of file
+}
+
+/** Reports allocations made on the calling thread until the end of the current block under the provided name. */
+#if LS_MEMORY_TRACKING
+#	define LS_MEMORY_SCOPE(name) ls::MemAllocProfiler::Scope _lsMemoryScope(name)
+#else
+#	define LS_MEMORY_SCOPE(name)
+#endif
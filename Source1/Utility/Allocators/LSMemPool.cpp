@@ -0,0 +1,702 @@
+#include "Prerequisites/LSPrerequisitesUtil.h"
+#include "Allocators/LSMemPool.h"
+#include "General/LSUint32_t.h"
+
+#if PLATFORM_WINDOWS
+	#define WIN32_LEAN_AND_MEAN
+	#if !defined(NOMINMAX) && defined(_MSC_VER)
+		#define NOMINMAX // required to stop windows.h messing up std::min
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+#endif
+
+namespace ls
+{
+	/** Granularity of the memory requested from the OS. A multiple of the page size on all supported platforms. */
+	static constexpr size_t OS_ALLOC_GRANULARITY = 64 * 1024;
+	/** Alignment of all blocks, and granularity of their sizes. */
+	static constexpr size_t BLOCK_ALIGN = 2 * sizeof(void*);
+	static constexpr size_t SIZE_MASK = ~(BLOCK_ALIGN - 1);
+
+	/** Blocks smaller than this are all kept in the first level list, split linearly between the second level lists. */
+	static constexpr size_t SMALL_BLOCK = 128;
+
+	static constexpr size_t FREE_BLOCK = 1 << 0; /**< Block is free. */
+	static constexpr size_t PREV_FREE = 1 << 1; /**< Block preceding this one in memory is free. */
+	static constexpr size_t PADDING = 1 << 2; /**< Not a real block, but padding in front of an aligned allocation. */
+
+	static_assert(PADDING < BLOCK_ALIGN, "Block flags must fit into the bits unused by the block size.");
+
+	/**
+	 * Header placed in front of every block of memory in an area. Blocks are laid out back to back, and the end of the
+	 * area is marked with an empty block.
+	 */
+	struct MemPool::BlockHeader
+	{
+		static constexpr size_t OVERHEAD = 2 * sizeof(void*);
+		static constexpr size_t MIN_SIZE = 2 * sizeof(void*);
+
+		/** Returns the memory the block provides to the user. */
+		UINT8* getBuffer() { return (UINT8*)&prevFree; }
+
+		/** Returns the size of the block's buffer, in bytes. */
+		size_t getSize() const { return size & SIZE_MASK; }
+
+		/** Returns the block following this one in memory. */
+		BlockHeader* getNext() { return (BlockHeader*)(getBuffer() + getSize()); }
+
+		/** Returns the header of the block with the provided buffer. */
+		static BlockHeader* fromBuffer(void* ptr) { return (BlockHeader*)((UINT8*)ptr - OVERHEAD); }
+
+		BlockHeader* prevHeader; /**< Block preceding this one in memory. Only valid if PREV_FREE is set. */
+		size_t size; /**< Size of the buffer in bytes, with the block flags stored in the lowest bits. */
+
+		// Only valid while the block is free, otherwise part of the buffer
+		BlockHeader* prevFree;
+		BlockHeader* nextFree;
+	};
+
+	/** Header placed at the start of every area, and every large allocation. */
+	struct alignas(16) MemPool::AreaHeader
+	{
+		/** Returns the first block in the area. */
+		BlockHeader* getFirstBlock() { return (BlockHeader*)((UINT8*)this + sizeof(AreaHeader)); }
+
+		MemPool* owner;
+		AreaHeader* prev;
+		AreaHeader* next;
+		size_t size;
+		bool isLarge;
+	};
+
+	struct MemPool::SharedData
+	{
+		SpinLock lock;
+		MemPool* pools = nullptr; /**< All existing pools. */
+		MemPool* freeThreadPools = nullptr; /**< Thread pools released by their threads, available for reuse. */
+	};
+
+	static LS_THREADLOCAL MemPool* CurrentPool = nullptr;
+
+	/**
+	 * Maps @p size bytes of memory aligned to @p alignment directly from the OS. A range larger by the alignment is
+	 * reserved to find an aligned address, but only @p size bytes of it are kept. @p size must be a multiple of
+	 * OS_ALLOC_GRANULARITY.
+	 */
+	static void* mapAlignedMemory(size_t size, size_t alignment)
+	{
+#if PLATFORM_WINDOWS
+		// Reserved ranges can only be released as a whole, so release the larger range and map the aligned part of it
+		// again. Another thread might map the same range in between, in which case try again.
+		while(true)
+		{
+			UINT8* data = (UINT8*)VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+			if(data == nullptr)
+				return nullptr;
+
+			UINT8* alignedData = (UINT8*)(((uintptr_t)data + alignment - 1) & ~(uintptr_t)(alignment - 1));
+			VirtualFree(data, 0, MEM_RELEASE);
+
+			void* output = VirtualAlloc(alignedData, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+			if(output != nullptr)
+				return output;
+		}
+#else
+		UINT8* data = (UINT8*)mmap(nullptr, size + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(data == MAP_FAILED)
+			return nullptr;
+
+		// Unmap the unaligned parts in front of and behind the kept range
+		UINT8* alignedData = (UINT8*)(((uintptr_t)data + alignment - 1) & ~(uintptr_t)(alignment - 1));
+		size_t frontSize = (size_t)(alignedData - data);
+
+		if(frontSize > 0)
+			munmap(data, frontSize);
+
+		if(frontSize < alignment)
+			munmap(alignedData + size, alignment - frontSize);
+
+		return alignedData;
+#endif
+	}
+
+	/** Releases memory mapped with mapAlignedMemory(). */
+	static void unmapAlignedMemory(void* data, size_t size)
+	{
+#if PLATFORM_WINDOWS
+		VirtualFree(data, 0, MEM_RELEASE);
+#else
+		munmap(data, size);
+#endif
+	}
+
+	MemPool::MemPool()
+		: mHasOwnerThread(false), mRemoteFrees(nullptr)
+	{
+		memset(mSlBitmap, 0, sizeof(mSlBitmap));
+		memset(mBlocks, 0, sizeof(mBlocks));
+
+		SharedData& data = getSharedData();
+		ScopedSpinLock lock(data.lock);
+
+		mNextPool = data.pools;
+		data.pools = this;
+	}
+
+	MemPool::~MemPool()
+	{
+		SharedData& data = getSharedData();
+		{
+			ScopedSpinLock lock(data.lock);
+
+			MemPool** pool = &data.pools;
+			while(*pool != this)
+				pool = &(*pool)->mNextPool;
+
+			*pool = mNextPool;
+		}
+
+		while(mAreas != nullptr)
+		{
+			AreaHeader* next = mAreas->next;
+			unmapAlignedMemory(mAreas, AREA_SIZE);
+
+			mAreas = next;
+		}
+
+		// Large allocations are independent of the areas, so they stay valid and are released once freed
+		ScopedSpinLock lock(mLock);
+		for(AreaHeader* area = mLargeAllocs; area != nullptr; area = area->next)
+			area->owner = nullptr;
+
+		mLargeAllocs = nullptr;
+	}
+
+	void* MemPool::alloc(size_t size)
+	{
+		if(size > MAX_POOLED_SIZE)
+			return allocLarge(size, BLOCK_ALIGN);
+
+		ScopedSpinLock lock(mLock);
+		processRemoteFrees();
+
+		return allocBlock(size);
+	}
+
+	void* MemPool::allocAligned(size_t size, size_t alignment)
+	{
+		assert((alignment & (alignment - 1)) == 0 && alignment <= AREA_SIZE / 2);
+
+		if(alignment <= BLOCK_ALIGN)
+			return alloc(size);
+
+		if(size + alignment > MAX_POOLED_SIZE)
+			return allocLarge(size, alignment);
+
+		UINT8* data;
+		{
+			ScopedSpinLock lock(mLock);
+			processRemoteFrees();
+
+			data = (UINT8*)allocBlock(size + alignment);
+		}
+
+		if(data == nullptr)
+			return nullptr;
+
+		// Leave room for a header in front of the aligned memory, pointing free() to the real block
+		UINT8* alignedData = (UINT8*)(((uintptr_t)data + BlockHeader::OVERHEAD + alignment - 1) & ~(uintptr_t)(alignment - 1));
+
+		BlockHeader* padding = BlockHeader::fromBuffer(alignedData);
+		padding->prevHeader = BlockHeader::fromBuffer(data);
+		padding->size = PADDING;
+
+		return alignedData;
+	}
+
+	void* MemPool::realloc(void* ptr, size_t size)
+	{
+		if(ptr == nullptr)
+			return alloc(size);
+
+		if(size == 0)
+		{
+			free(ptr);
+			return nullptr;
+		}
+
+		size_t oldSize = getAllocSize(ptr);
+		if(size <= oldSize)
+			return ptr;
+
+		void* newPtr = alloc(size);
+		if(newPtr == nullptr)
+			return nullptr;
+
+		memcpy(newPtr, ptr, oldSize);
+		free(ptr);
+
+		return newPtr;
+	}
+
+	MemPoolStats MemPool::getStats() const
+	{
+		ScopedSpinLock lock(mLock);
+
+		MemPoolStats stats;
+		stats.reservedBytes = mReservedBytes;
+		stats.usedBytes = mUsedBytes;
+		stats.peakUsedBytes = mPeakUsedBytes;
+		stats.freeBytes = mFreeBytes;
+		stats.numAreas = mNumAreas;
+		stats.numLargeAllocs = mNumLargeAllocs;
+		stats.numAllocs = mNumAllocs;
+		stats.numRemoteFrees = mNumRemoteFrees;
+
+		// The largest block is in the highest non-empty list, but blocks within a list aren't sorted
+		if(mFlBitmap != 0)
+		{
+			UINT32 fl = uint32_cntlnz(mFlBitmap);
+			UINT32 sl = uint32_cntlnz(mSlBitmap[fl]);
+
+			for(BlockHeader* block = mBlocks[fl][sl]; block != nullptr; block = block->nextFree)
+				stats.largestFreeBlock = std::max(stats.largestFreeBlock, (UINT64)block->getSize());
+		}
+
+		return stats;
+	}
+
+	void MemPool::free(void* ptr)
+	{
+		if(ptr == nullptr)
+			return;
+
+		AreaHeader* area = getArea(ptr);
+		if(area->isLarge)
+		{
+			freeLarge(area);
+			return;
+		}
+
+		MemPool* owner = area->owner;
+		if(owner->mIsThreadPool && owner != CurrentPool && owner->mHasOwnerThread.load(std::memory_order_acquire))
+		{
+			owner->pushRemoteFree(ptr);
+			return;
+		}
+
+		ScopedSpinLock lock(owner->mLock);
+		owner->processRemoteFrees();
+		owner->freeBlock(ptr);
+	}
+
+	size_t MemPool::getAllocSize(void* ptr)
+	{
+		AreaHeader* area = getArea(ptr);
+		if(area->isLarge)
+			return area->size - (size_t)((UINT8*)ptr - (UINT8*)area);
+
+		// Block flags might be modified by the owner as neighbouring blocks change
+		ScopedSpinLock lock(area->owner->mLock);
+
+		BlockHeader* block = BlockHeader::fromBuffer(ptr);
+		if(block->size & PADDING)
+			block = block->prevHeader;
+
+		return (size_t)(block->getBuffer() + block->getSize() - (UINT8*)ptr);
+	}
+
+	MemPool& MemPool::current()
+	{
+		if(CurrentPool != nullptr)
+			return *CurrentPool;
+
+		MemPool* pool;
+		{
+			SharedData& data = getSharedData();
+			ScopedSpinLock lock(data.lock);
+
+			pool = data.freeThreadPools;
+			if(pool != nullptr)
+				data.freeThreadPools = pool->mNextFreePool;
+		}
+
+		// Pool memory must not come from the general allocator, as it might be backed by this same pool
+		if(pool == nullptr)
+		{
+			pool = new (platformAlignedAlloc(sizeof(MemPool), alignof(MemPool))) MemPool();
+			pool->mIsThreadPool = true;
+		}
+
+		pool->mNextFreePool = nullptr;
+		pool->mHasOwnerThread.store(true, std::memory_order_release);
+
+		CurrentPool = pool;
+		return *pool;
+	}
+
+	void MemPool::endThread()
+	{
+		MemPool* pool = CurrentPool;
+		if(pool == nullptr)
+			return;
+
+		CurrentPool = nullptr;
+
+		// From now on other threads free directly into the pool, under its lock
+		pool->mHasOwnerThread.store(false, std::memory_order_seq_cst);
+		{
+			ScopedSpinLock lock(pool->mLock);
+			pool->processRemoteFrees();
+		}
+
+		SharedData& data = getSharedData();
+		ScopedSpinLock lock(data.lock);
+
+		pool->mNextFreePool = data.freeThreadPools;
+		data.freeThreadPools = pool;
+	}
+
+	MemPoolStats MemPool::getGlobalStats()
+	{
+		SharedData& data = getSharedData();
+		ScopedSpinLock lock(data.lock);
+
+		MemPoolStats output;
+		for(MemPool* pool = data.pools; pool != nullptr; pool = pool->mNextPool)
+		{
+			MemPoolStats stats = pool->getStats();
+
+			output.reservedBytes += stats.reservedBytes;
+			output.usedBytes += stats.usedBytes;
+			output.peakUsedBytes += stats.peakUsedBytes;
+			output.freeBytes += stats.freeBytes;
+			output.largestFreeBlock = std::max(output.largestFreeBlock, stats.largestFreeBlock);
+			output.numAreas += stats.numAreas;
+			output.numLargeAllocs += stats.numLargeAllocs;
+			output.numAllocs += stats.numAllocs;
+			output.numRemoteFrees += stats.numRemoteFrees;
+		}
+
+		return output;
+	}
+
+	MemPool::SharedData& MemPool::getSharedData()
+	{
+		static SharedData sharedData;
+		return sharedData;
+	}
+
+	void MemPool::mapSize(size_t size, UINT32& fl, UINT32& sl)
+	{
+		if(size < SMALL_BLOCK)
+		{
+			fl = 0;
+			sl = (UINT32)(size / (SMALL_BLOCK / MAX_SLI));
+		}
+		else
+		{
+			UINT32 msb = uint32_cntlnz((UINT32)size);
+
+			fl = msb - FLI_OFFSET;
+			sl = (UINT32)(size >> (msb - MAX_LOG2_SLI)) - MAX_SLI;
+		}
+	}
+
+	void MemPool::mapRequestSize(size_t size, UINT32& fl, UINT32& sl)
+	{
+		// Round up to the next list, so any block found in it is large enough
+		if(size >= SMALL_BLOCK)
+			size += ((size_t)1 << (uint32_cntlnz((UINT32)size) - MAX_LOG2_SLI)) - 1;
+
+		mapSize(size, fl, sl);
+	}
+
+	void* MemPool::allocBlock(size_t size)
+	{
+		if(size < BlockHeader::MIN_SIZE)
+			size = BlockHeader::MIN_SIZE;
+		else
+			size = (size + BLOCK_ALIGN - 1) & SIZE_MASK;
+
+		UINT32 fl, sl;
+		mapRequestSize(size, fl, sl);
+
+		BlockHeader* block = findSuitableBlock(fl, sl);
+		if(block == nullptr)
+		{
+			if(!addArea())
+				return nullptr;
+
+			mapRequestSize(size, fl, sl);
+			block = findSuitableBlock(fl, sl);
+		}
+
+		removeBlock(block);
+
+		// Split off the remainder as a new free block, if large enough
+		BlockHeader* next = block->getNext();
+		size_t remaining = block->getSize() - size;
+		if(remaining >= sizeof(BlockHeader))
+		{
+			BlockHeader* split = (BlockHeader*)(block->getBuffer() + size);
+			split->size = (remaining - BlockHeader::OVERHEAD) | FREE_BLOCK;
+			next->prevHeader = split;
+
+			insertBlock(split);
+			block->size = size | (block->size & PREV_FREE);
+		}
+		else
+		{
+			next->size &= ~PREV_FREE;
+			block->size &= ~FREE_BLOCK;
+		}
+
+		mUsedBytes += block->getSize() + BlockHeader::OVERHEAD;
+		mPeakUsedBytes = std::max(mPeakUsedBytes, mUsedBytes);
+		mNumAllocs++;
+
+		return block->getBuffer();
+	}
+
+	void MemPool::freeBlock(void* ptr)
+	{
+		BlockHeader* block = BlockHeader::fromBuffer(ptr);
+		if(block->size & PADDING)
+			block = block->prevHeader;
+
+		mUsedBytes -= block->getSize() + BlockHeader::OVERHEAD;
+		block->size |= FREE_BLOCK;
+
+		// Merge with the neighbouring blocks, if free
+		BlockHeader* next = block->getNext();
+		if(next->size & FREE_BLOCK)
+		{
+			removeBlock(next);
+			block->size += next->getSize() + BlockHeader::OVERHEAD;
+		}
+
+		if(block->size & PREV_FREE)
+		{
+			BlockHeader* prev = block->prevHeader;
+			removeBlock(prev);
+			prev->size += block->getSize() + BlockHeader::OVERHEAD;
+
+			block = prev;
+		}
+
+		next = block->getNext();
+
+		// Release the area if it's now empty, unless the rest of the pool is close to full and would likely need a new
+		// area again soon
+		AreaHeader* area = getArea(block);
+		if(block == area->getFirstBlock() && next->getSize() == 0)
+		{
+			if(mNumAreas > 1 && mFreeBytes >= AREA_SIZE / 2)
+			{
+				releaseArea(area);
+				return;
+			}
+		}
+
+		insertBlock(block);
+
+		next->size |= PREV_FREE;
+		next->prevHeader = block;
+	}
+
+	void* MemPool::allocLarge(size_t size, size_t alignment)
+	{
+		size_t offset = (sizeof(AreaHeader) + alignment - 1) & ~(alignment - 1);
+		size_t totalSize = (offset + size + OS_ALLOC_GRANULARITY - 1) & ~(OS_ALLOC_GRANULARITY - 1);
+
+		// Aligned to the area size so free() can find the header the same way as for the areas
+		AreaHeader* area = (AreaHeader*)mapAlignedMemory(totalSize, AREA_SIZE);
+		if(area == nullptr)
+			return nullptr;
+
+		area->owner = this;
+		area->prev = nullptr;
+		area->size = totalSize;
+		area->isLarge = true;
+
+		ScopedSpinLock lock(mLock);
+		area->next = mLargeAllocs;
+		if(mLargeAllocs != nullptr)
+			mLargeAllocs->prev = area;
+
+		mLargeAllocs = area;
+
+		mReservedBytes += totalSize;
+		mUsedBytes += totalSize;
+		mPeakUsedBytes = std::max(mPeakUsedBytes, mUsedBytes);
+		mNumLargeAllocs++;
+		mNumAllocs++;
+
+		return (UINT8*)area + offset;
+	}
+
+	void MemPool::freeLarge(AreaHeader* area)
+	{
+		// Owner is cleared if the pool was destroyed while the allocation was still in use
+		MemPool* owner = area->owner;
+		if(owner != nullptr)
+		{
+			ScopedSpinLock lock(owner->mLock);
+
+			if(area->prev != nullptr)
+				area->prev->next = area->next;
+			else
+				owner->mLargeAllocs = area->next;
+
+			if(area->next != nullptr)
+				area->next->prev = area->prev;
+
+			owner->mReservedBytes -= area->size;
+			owner->mUsedBytes -= area->size;
+			owner->mNumLargeAllocs--;
+		}
+
+		unmapAlignedMemory(area, area->size);
+	}
+
+	bool MemPool::addArea()
+	{
+		static_assert(sizeof(AreaHeader) % BLOCK_ALIGN == 0, "Area header must preserve block alignment.");
+
+		AreaHeader* area = (AreaHeader*)mapAlignedMemory(AREA_SIZE, AREA_SIZE);
+		if(area == nullptr)
+			return false;
+
+		area->owner = this;
+		area->prev = nullptr;
+		area->next = mAreas;
+		area->size = AREA_SIZE;
+		area->isLarge = false;
+
+		if(mAreas != nullptr)
+			mAreas->prev = area;
+
+		mAreas = area;
+
+		// A single free block covering the area, followed by an empty used block marking its end
+		BlockHeader* block = area->getFirstBlock();
+		block->size = ((AREA_SIZE - sizeof(AreaHeader) - 2 * BlockHeader::OVERHEAD) & SIZE_MASK) | FREE_BLOCK;
+
+		BlockHeader* end = block->getNext();
+		end->prevHeader = block;
+		end->size = PREV_FREE;
+
+		insertBlock(block);
+
+		mReservedBytes += AREA_SIZE;
+		mNumAreas++;
+
+		return true;
+	}
+
+	void MemPool::releaseArea(AreaHeader* area)
+	{
+		if(area->prev != nullptr)
+			area->prev->next = area->next;
+		else
+			mAreas = area->next;
+
+		if(area->next != nullptr)
+			area->next->prev = area->prev;
+
+		mReservedBytes -= AREA_SIZE;
+		mNumAreas--;
+
+		unmapAlignedMemory(area, AREA_SIZE);
+	}
+
+	void MemPool::processRemoteFrees()
+	{
+		if(mRemoteFrees.load(std::memory_order_relaxed) == nullptr)
+			return;
+
+		void* ptr = mRemoteFrees.exchange(nullptr, std::memory_order_acquire);
+		while(ptr != nullptr)
+		{
+			void* next = *(void**)ptr;
+			freeBlock(ptr);
+			mNumRemoteFrees++;
+
+			ptr = next;
+		}
+	}
+
+	void MemPool::pushRemoteFree(void* ptr)
+	{
+		// The freed memory itself stores the link to the next entry
+		void* head = mRemoteFrees.load(std::memory_order_relaxed);
+		do
+		{
+			*(void**)ptr = head;
+		} while(!mRemoteFrees.compare_exchange_weak(head, ptr, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	MemPool::BlockHeader* MemPool::findSuitableBlock(UINT32& fl, UINT32& sl) const
+	{
+		UINT32 slMap = mSlBitmap[fl] & (~0U << sl);
+		if(slMap == 0)
+		{
+			UINT32 flMap = mFlBitmap & (~0U << (fl + 1));
+			if(flMap == 0)
+				return nullptr;
+
+			fl = uint32_cnttz(flMap);
+			slMap = mSlBitmap[fl];
+		}
+
+		sl = uint32_cnttz(slMap);
+		return mBlocks[fl][sl];
+	}
+
+	void MemPool::insertBlock(BlockHeader* block)
+	{
+		UINT32 fl, sl;
+		mapSize(block->getSize(), fl, sl);
+
+		block->prevFree = nullptr;
+		block->nextFree = mBlocks[fl][sl];
+
+		if(block->nextFree != nullptr)
+			block->nextFree->prevFree = block;
+
+		mBlocks[fl][sl] = block;
+		mSlBitmap[fl] |= 1U << sl;
+		mFlBitmap |= 1U << fl;
+
+		mFreeBytes += block->getSize();
+	}
+
+	void MemPool::removeBlock(BlockHeader* block)
+	{
+		UINT32 fl, sl;
+		mapSize(block->getSize(), fl, sl);
+
+		if(block->nextFree != nullptr)
+			block->nextFree->prevFree = block->prevFree;
+
+		if(block->prevFree != nullptr)
+			block->prevFree->nextFree = block->nextFree;
+		else
+		{
+			mBlocks[fl][sl] = block->nextFree;
+
+			if(mBlocks[fl][sl] == nullptr)
+			{
+				mSlBitmap[fl] &= ~(1U << sl);
+
+				if(mSlBitmap[fl] == 0)
+					mFlBitmap &= ~(1U << fl);
+			}
+		}
+
+		mFreeBytes -= block->getSize();
+	}
+}
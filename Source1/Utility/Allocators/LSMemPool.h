@@ -0,0 +1,205 @@
+#pragma once
+
+#include <atomic>
+
+#include "Prerequisites/LSPlatformDefines.h"
+#include "Prerequisites/LSTypes.h"
+#include "Thread/LSSpinLock.h"
+
+namespace ls
+{
+	/** @addtogroup Internal-Utility
+	 *  @{
+	 */
+
+	/** @addtogroup Memory-Internal
+	 *  @{
+	 */
+
+	/** Usage statistics of a single MemPool, or of all the pools combined (see MemPool::getGlobalStats()). */
+	struct MemPoolStats
+	{
+		UINT64 reservedBytes = 0; /**< Memory requested from the OS, including areas and large allocations. */
+		UINT64 usedBytes = 0; /**< Memory in use by live allocations, including block headers and alignment padding. */
+		UINT64 peakUsedBytes = 0; /**< Highest value of usedBytes over the lifetime of the pool. */
+		UINT64 freeBytes = 0; /**< Memory available for new allocations in the pool's areas. */
+		UINT64 largestFreeBlock = 0; /**< Size of the largest allocation that can be made without adding an area. */
+		UINT64 numAreas = 0; /**< Number of areas owned by the pool. */
+		UINT64 numLargeAllocs = 0; /**< Number of live allocations too large to be served from an area. */
+		UINT64 numAllocs = 0; /**< Total number of allocations made from the pool. */
+		UINT64 numRemoteFrees = 0; /**< Total number of allocations freed by threads other than the pool's owner. */
+
+		/**
+		 * Returns the portion of free memory that cannot be used for a single allocation, in range [0, 1]. 0 means all
+		 * the free memory is in one contiguous block.
+		 */
+		float getFragmentation() const
+		{
+			if(freeBytes == 0)
+				return 0.0f;
+
+			return 1.0f - (float)largestFreeBlock / (float)freeBytes;
+		}
+	};
+
+	/**
+	 * General purpose allocator based on the two-level segregated fit (TLSF) algorithm. Allocations and frees run in
+	 * constant time, with low fragmentation.
+	 *
+	 * Memory is requested from the OS in fixed size areas, added as the pool runs out of space and released once they
+	 * become empty. Allocations larger than MAX_POOLED_SIZE bypass the areas and are requested from the OS directly.
+	 *
+	 * Each thread can use its own pool (see current()), in which case no two threads contend for the same lock. Memory
+	 * freed by a thread other than the pool's owner is pushed to a lock-free list, and returned to the pool the next
+	 * time its owner allocates. Pools can also be created manually and used as arenas shared by any number of threads.
+	 *
+	 * @note	Thread safe. Memory may be freed on any thread, regardless of which pool it was allocated from.
+	 */
+	class LS_UTILITY_EXPORT MemPool
+	{
+		struct BlockHeader;
+		struct AreaHeader;
+
+	public:
+		/** Size of a single area. Areas are also aligned to this value, which is how pointers are mapped to them. */
+		static constexpr size_t AREA_SIZE = 1024 * 1024;
+
+		/** Largest allocation served from an area. Larger allocations are requested from the OS directly. */
+		static constexpr size_t MAX_POOLED_SIZE = AREA_SIZE / 4;
+
+		MemPool();
+
+		/**
+		 * Returns the pool's areas to the OS, invalidating all the memory allocated from them. Large allocations still
+		 * in use are not owned by the areas, and remain valid until freed.
+		 */
+		~MemPool();
+
+		MemPool(const MemPool&) = delete;
+		MemPool& operator=(const MemPool&) = delete;
+
+		/** Allocates @p size bytes, aligned to a 16 byte boundary. */
+		void* alloc(size_t size);
+
+		/**
+		 * Allocates @p size bytes aligned to the specified boundary.
+		 *
+		 * @param[in]	size		Amount of memory to allocate, in bytes.
+		 * @param[in]	alignment	Alignment of the allocated memory. Must be power of two, smaller than AREA_SIZE.
+		 */
+		void* allocAligned(size_t size, size_t alignment);
+
+		/**
+		 * Resizes an allocation made from any pool, preserving its contents. Memory is moved to this pool if the
+		 * allocation cannot be resized in place.
+		 */
+		void* realloc(void* ptr, size_t size);
+
+		/** Returns usage statistics of this pool. */
+		MemPoolStats getStats() const;
+
+		/**
+		 * Frees memory allocated from any pool. If the memory belongs to a pool owned by another thread it is handed over
+		 * to the owner, and released on its next allocation.
+		 */
+		static void free(void* ptr);
+
+		/** Returns the number of bytes usable at @p ptr, which may be more than was requested when allocating it. */
+		static size_t getAllocSize(void* ptr);
+
+		/** Returns the pool owned by the calling thread, creating it if needed. */
+		static MemPool& current();
+
+		/**
+		 * Releases the calling thread's pool, if it has one. Memory allocated from it remains valid, and the pool will be
+		 * reused by the next thread that needs one. Should be called before a thread that might have used its pool exits.
+		 */
+		static void endThread();
+
+		/** Returns statistics of all the pools combined. largestFreeBlock is the largest block found in any pool. */
+		static MemPoolStats getGlobalStats();
+
+	private:
+		static constexpr UINT32 MAX_LOG2_SLI = 5;
+		static constexpr UINT32 MAX_SLI = 1 << MAX_LOG2_SLI;
+		static constexpr UINT32 FLI_OFFSET = 6;
+		static constexpr UINT32 MAX_FLI = 20;
+		static constexpr UINT32 REAL_FLI = MAX_FLI - FLI_OFFSET;
+
+		static_assert(AREA_SIZE <= (1 << MAX_FLI), "Areas too large for the first level index.");
+
+		/** Data shared by all the pools. */
+		struct SharedData;
+
+		/** Returns the data shared by all the pools. */
+		static SharedData& getSharedData();
+
+		/** Maps a block size to the free list holding blocks of that size. */
+		static void mapSize(size_t size, UINT32& fl, UINT32& sl);
+
+		/** Maps a requested size to the first free list whose blocks are all large enough for it. */
+		static void mapRequestSize(size_t size, UINT32& fl, UINT32& sl);
+
+		/** Allocates a block of at least @p size bytes. Caller must hold the pool lock. */
+		void* allocBlock(size_t size);
+
+		/** Returns a block to the free lists, merging it with its free neighbours. Caller must hold the pool lock. */
+		void freeBlock(void* ptr);
+
+		/** Allocates memory directly from the OS, for allocations larger than MAX_POOLED_SIZE. */
+		void* allocLarge(size_t size, size_t alignment);
+
+		/** Releases an allocation made by allocLarge(). */
+		static void freeLarge(AreaHeader* area);
+
+		/** Requests a new area from the OS and adds its memory to the free lists. Caller must hold the pool lock. */
+		bool addArea();
+
+		/** Removes an empty area from the pool and returns its memory to the OS. Caller must hold the pool lock. */
+		void releaseArea(AreaHeader* area);
+
+		/** Releases all memory freed by other threads since the last call. Caller must hold the pool lock. */
+		void processRemoteFrees();
+
+		/** Pushes memory freed by a thread other than the owner onto the remote free list. */
+		void pushRemoteFree(void* ptr);
+
+		/** Finds a free block of at least the size mapped to @p fl and @p sl, and updates them to its list. */
+		BlockHeader* findSuitableBlock(UINT32& fl, UINT32& sl) const;
+
+		/** Adds a free block to the free list matching its size. */
+		void insertBlock(BlockHeader* block);
+
+		/** Removes a free block from the free list matching its size. */
+		void removeBlock(BlockHeader* block);
+
+		/** Returns the header of the area that contains @p ptr. */
+		static AreaHeader* getArea(void* ptr) { return (AreaHeader*)((uintptr_t)ptr & ~(uintptr_t)(AREA_SIZE - 1)); }
+
+		mutable SpinLock mLock;
+		UINT32 mFlBitmap = 0;
+		UINT32 mSlBitmap[REAL_FLI];
+		BlockHeader* mBlocks[REAL_FLI][MAX_SLI];
+		AreaHeader* mAreas = nullptr;
+		AreaHeader* mLargeAllocs = nullptr; /**< Live allocations made by allocLarge(). */
+
+		UINT64 mReservedBytes = 0;
+		UINT64 mUsedBytes = 0;
+		UINT64 mPeakUsedBytes = 0;
+		UINT64 mFreeBytes = 0;
+		UINT64 mNumAreas = 0;
+		UINT64 mNumLargeAllocs = 0;
+		UINT64 mNumAllocs = 0;
+		UINT64 mNumRemoteFrees = 0;
+
+		bool mIsThreadPool = false;
+		std::atomic<bool> mHasOwnerThread;
+		std::atomic<void*> mRemoteFrees;
+
+		MemPool* mNextPool = nullptr; /**< Next pool in the global list of all pools. */
+		MemPool* mNextFreePool = nullptr; /**< Next pool in the list of thread pools not owned by any thread. */
+	};
+
+	/** @} */
+	/** @} */
+}
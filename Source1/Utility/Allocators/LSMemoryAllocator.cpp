@@ -7,4 +7,23 @@ namespace ls
 
 	void MemoryCounter::incAllocCount() { ++Allocs; }
 	void MemoryCounter::incFreeCount() { ++Frees; }
+
+#if LS_MEMORY_TRACKING
+	UINT32 MemoryAllocatorBase::registerCategory(const char* typeName)
+	{
+		return MemAllocProfiler::registerCategory(typeName);
+	}
+
+	void* MemoryAllocatorBase::trackAlloc(void* data, size_t offset, size_t bytes, UINT32 category, void* address)
+	{
+		static_assert(TRACKING_HEADER_SIZE == MemAllocProfiler::HEADER_SIZE, "Tracking header size mismatch.");
+
+		return MemAllocProfiler::onAlloc(data, offset, bytes, category, address);
+	}
+
+	void* MemoryAllocatorBase::trackFree(void* ptr)
+	{
+		return MemAllocProfiler::onFree(ptr);
+	}
+#endif
 }
\ No newline at end of file
@@ -5,12 +5,20 @@
 #include <new>
 #include <limits>
 #include <cstdint>
+#include <cstdlib>
 #include <utility>
+#include <typeinfo>
 
-#if PLATFORM_LINUX
+#if PLATFORM_LINUX || PLATFORM_WINDOWS || PLATFORM_WINRT
 #  include <malloc.h>
 #endif
 
+#if LS_MEMORY_TRACKING && COMPILER_MSVC
+#  include <intrin.h>
+#endif
+
+#include "Allocators/LSMemPool.h"
+
 namespace ls
 {
 	class MemoryAllocatorBase;
@@ -23,23 +31,36 @@ namespace ls
 	 *  @{
 	 */
 
+	/**
+	 * Allocates @p size bytes aligned to @p alignment using the platform's aligned allocator. Unlike padding a regular
+	 * allocation, the platform allocator doesn't reserve an extra @p alignment bytes, which matters for large alignments.
+	 * Alignment must be a power of two. Free with platformAlignedFree().
+	 */
 	inline void* platformAlignedAlloc(size_t size, size_t alignment)
 	{
-		void* data = ::malloc(size + (alignment - 1) + sizeof(void*));
-		if (data == nullptr)
+#if PLATFORM_WINDOWS || PLATFORM_WINRT
+		return _aligned_malloc(size, alignment);
+#else
+		// posix_memalign() requires the alignment to be a multiple of the pointer size
+		if (alignment < sizeof(void*))
+			alignment = sizeof(void*);
+
+		void* data = nullptr;
+		if (posix_memalign(&data, alignment, size) != 0)
 			return nullptr;
 
-		char* alignedData = ((char*)data) + sizeof(void*);
-		alignedData += (alignment - ((uintptr_t)alignedData) & (alignment - 1)) & (alignment - 1);
-
-		((void**)alignedData)[-1] = data;
-		return alignedData;
+		return data;
+#endif
 	}
 
+	/** Frees memory allocated with platformAlignedAlloc(). */
 	inline void platformAlignedFree(void* ptr)
 	{
-		// TODO: Document how this works.
-		::free(((void**)ptr)[-1]);
+#if PLATFORM_WINDOWS || PLATFORM_WINRT
+		_aligned_free(ptr);
+#else
+		::free(ptr);
+#endif
 	}
 
 	/**
@@ -70,55 +91,114 @@ namespace ls
 		static LS_THREADLOCAL uint64_t Frees;
 	};
 
+#if LS_MEMORY_TRACKING
+	/** Returns the code address the calling function returns to. */
+#	if COMPILER_MSVC
+#		define LS_RETURN_ADDRESS() _ReturnAddress()
+#	else
+#		define LS_RETURN_ADDRESS() __builtin_return_address(0)
+#	endif
+
+	/**
+	 * Keeps the MemoryAllocator allocation methods out of line in tracking builds, so the return address they capture
+	 * points into the code making the allocation, rather than into that code's caller.
+	 */
+#	if COMPILER_MSVC
+#		define LS_TRACKED_ALLOC_METHOD __declspec(noinline)
+#	else
+#		define LS_TRACKED_ALLOC_METHOD __attribute__((noinline))
+#	endif
+#else
+#	define LS_TRACKED_ALLOC_METHOD
+#endif
+
 	/** Base class all memory allocators need to inherit. Provides allocation and free counting. */
 	class MemoryAllocatorBase
 	{
 	protected:
 		static void incAllocCount() { MemoryCounter::incAllocCount(); }
 		static void incFreeCount() { MemoryCounter::incFreeCount(); }
+
+#if LS_MEMORY_TRACKING
+		/** Size of the header MemAllocProfiler places in front of every tracked allocation. */
+		static constexpr size_t TRACKING_HEADER_SIZE = 16;
+
+		/** Registers an allocator category with MemAllocProfiler, and returns its index. */
+		static LS_UTILITY_EXPORT UINT32 registerCategory(const char* typeName);
+
+		/**
+		 * Records an allocation with MemAllocProfiler. @p data must have room for the tracking header in front of the
+		 * user's memory, which starts at @p offset. @p address is the code address the allocation was made from. Returns
+		 * the user's memory.
+		 */
+		static LS_UTILITY_EXPORT void* trackAlloc(void* data, size_t offset, size_t bytes, UINT32 category,
+			void* address);
+
+		/** Records a free with MemAllocProfiler, and returns the memory originally passed to trackAlloc(). */
+		static LS_UTILITY_EXPORT void* trackFree(void* ptr);
+#endif
 	};
 
 	/**
 	 * Memory allocator providing a generic implementation. Specialize for specific categories as needed.
 	 *
 	 * @note	For example you might implement a pool allocator for specific types in order
-	 * 			to reduce allocation overhead. By default standard malloc/free are used.
+	 * 			to reduce allocation overhead. By default standard malloc/free are used, or the calling thread's MemPool if
+	 *			LS_USE_MEMPOOL is enabled. If LS_MEMORY_TRACKING is enabled all allocations are reported to
+	 *			MemAllocProfiler.
 	 */
 	template<class T>
 	class MemoryAllocator : public MemoryAllocatorBase
 	{
 	public:
 		/** Allocates @p bytes bytes. */
-		static void* allocate(size_t bytes)
+		LS_TRACKED_ALLOC_METHOD static void* allocate(size_t bytes)
 		{
 #if LS_PROFILING_ENABLED
 			incAllocCount();
 #endif
 
-			return malloc(bytes);
+#if LS_MEMORY_TRACKING
+			void* data = allocateInternal(bytes + TRACKING_HEADER_SIZE);
+			return trackAlloc(data, TRACKING_HEADER_SIZE, bytes, getCategory(), LS_RETURN_ADDRESS());
+#else
+			return allocateInternal(bytes);
+#endif
 		}
 
 		/**
 		 * Allocates @p bytes and aligns them to the specified boundary (in bytes). If the aligment is less or equal to
 		 * 16 it is more efficient to use the allocateAligned16() alternative of this method. Alignment must be power of two.
 		 */
-		static void* allocateAligned(size_t bytes, size_t alignment)
+		LS_TRACKED_ALLOC_METHOD static void* allocateAligned(size_t bytes, size_t alignment)
 		{
 #if LS_PROFILING_ENABLED
 			incAllocCount();
 #endif
 
-			return platformAlignedAlloc(bytes, alignment);
+#if LS_MEMORY_TRACKING
+			// Keep the user's memory aligned by padding the header up to the alignment
+			size_t offset = alignment > TRACKING_HEADER_SIZE ? alignment : TRACKING_HEADER_SIZE;
+			void* data = allocateAlignedInternal(bytes + offset, alignment);
+			return trackAlloc(data, offset, bytes, getCategory(), LS_RETURN_ADDRESS());
+#else
+			return allocateAlignedInternal(bytes, alignment);
+#endif
 		}
 
 		/** Allocates @p bytes and aligns them to a 16 byte boundary. */
-		static void* allocateAligned16(size_t bytes)
+		LS_TRACKED_ALLOC_METHOD static void* allocateAligned16(size_t bytes)
 		{
 #if LS_PROFILING_ENABLED
 			incAllocCount();
 #endif
 
-			return platformAlignedAlloc(bytes, 16);
+#if LS_MEMORY_TRACKING
+			void* data = allocateAlignedInternal(bytes + TRACKING_HEADER_SIZE, 16);
+			return trackAlloc(data, TRACKING_HEADER_SIZE, bytes, getCategory(), LS_RETURN_ADDRESS());
+#else
+			return allocateAlignedInternal(bytes, 16);
+#endif
 		}
 
 		/** Frees the memory at the specified location. */
@@ -128,7 +208,15 @@ namespace ls
 			incFreeCount();
 #endif
 
+#if LS_MEMORY_TRACKING
+			ptr = trackFree(ptr);
+#endif
+
+#if LS_USE_MEMPOOL
+			MemPool::free(ptr);
+#else
 			::free(ptr);
+#endif
 		}
 
 		/** Frees memory allocated with allocateAligned() */
@@ -138,7 +226,11 @@ namespace ls
 			incFreeCount();
 #endif
 
-			platformAlignedFree(ptr);
+#if LS_MEMORY_TRACKING
+			ptr = trackFree(ptr);
+#endif
+
+			freeAlignedInternal(ptr);
 		}
 
 		/** Frees memory allocated with allocateAligned16() */
@@ -148,8 +240,52 @@ namespace ls
 			incFreeCount();
 #endif
 
+#if LS_MEMORY_TRACKING
+			ptr = trackFree(ptr);
+#endif
+
+			freeAlignedInternal(ptr);
+		}
+
+	private:
+		/** Allocates memory from the underlying allocator. */
+		static void* allocateInternal(size_t bytes)
+		{
+#if LS_USE_MEMPOOL
+			return MemPool::current().alloc(bytes);
+#else
+			return malloc(bytes);
+#endif
+		}
+
+		/** Allocates aligned memory from the underlying allocator. */
+		static void* allocateAlignedInternal(size_t bytes, size_t alignment)
+		{
+#if LS_USE_MEMPOOL
+			return MemPool::current().allocAligned(bytes, alignment);
+#else
+			return platformAlignedAlloc(bytes, alignment);
+#endif
+		}
+
+		/** Frees memory allocated with allocateAlignedInternal(). */
+		static void freeAlignedInternal(void* ptr)
+		{
+#if LS_USE_MEMPOOL
+			MemPool::free(ptr);
+#else
 			platformAlignedFree(ptr);
+#endif
+		}
+
+#if LS_MEMORY_TRACKING
+		/** Returns the index of this allocator's category in MemAllocProfiler. */
+		static UINT32 getCategory()
+		{
+			static const UINT32 category = registerCategory(typeid(T).name());
+			return category;
 		}
+#endif
 	};
 
 	/**
@@ -383,5 +519,6 @@ namespace ls
 #include "Allocators/LSStackAlloc.h"
 #include "Allocators/LSFreeAlloc.h"
 #include "Allocators/LSFrameAlloc.h"
+#include "Allocators/LSFrameArena.h"
 #include "Allocators/LSStaticAlloc.h"
 #include "Allocators/LSMemAllocProfiler.h"
@@ -11,6 +11,10 @@ namespace ls
 
 	/**
 	 * A memory allocator that allocates elements of the same size. Allows for fairly quick allocations and deallocations.
+	 *
+	 * Blocks are allocated on an address aligned to their (power of two) size, which allows the block owning an element
+	 * to be found in constant time when the element is freed. Any space the alignment leaves at the end of the block is
+	 * used for additional elements.
 	 * 
 	 * @tparam	ElemSize		Size of a single element in the pool. This will be the exact allocation size. 4 byte minimum.
 	 * @tparam	ElemsPerBlock	Determines how much space to reserve for elements. This determines the initial size of the
@@ -20,20 +24,25 @@ namespace ls
 	 *							element size, or aren't a multiplier of element size will introduce additionally padding
 	 *							for each element, and therefore require more internal memory.
 	 * @tparam	Lock			If true the pool allocator will be made thread safe (at the cost of performance).
+	 * @tparam	ThreadCacheSize	Only relevant if @p Lock is true. If non-zero each thread keeps up to this many freed
+	 *							elements in a thread local cache, and reuses them for its next allocations without
+	 *							locking. Only a single pool per template instantiation can use the cache on a thread at
+	 *							a time, others fall back to locking. Cached elements are returned to the pool when the
+	 *							thread exits or the pool is destroyed.
 	 */
-	template <int ElemSize, int ElemsPerBlock = 512, int Alignment = 4, bool Lock = false>
+	template <int ElemSize, int ElemsPerBlock = 512, int Alignment = 4, bool Lock = false, UINT32 ThreadCacheSize = 0>
 	class PoolAlloc
 	{
 	private:
-		/** A single block able to hold ElemsPerBlock elements. */
+		/** A single block able to hold at least ElemsPerBlock elements. */
 		class MemBlock
 		{
 		public:
 			MemBlock(UINT8* blockData)
-				:blockData(blockData), freePtr(0), freeElems(ElemsPerBlock), nextBlock(nullptr)
+				:blockData(blockData), freePtr(0), freeElems(BlockElemCount), nextBlock(nullptr), prevBlock(nullptr)
 			{
 				UINT32 offset = 0;
-				for(UINT32 i = 0; i < ElemsPerBlock; i++)
+				for(UINT32 i = 0; i < BlockElemCount; i++)
 				{
 					UINT32* entryPtr = (UINT32*)&blockData[offset];
 
@@ -44,7 +53,7 @@ namespace ls
 
 			~MemBlock()
 			{
-				assert(freeElems == ElemsPerBlock && "Not all elements were deallocated from a block.");
+				assert(freeElems == BlockElemCount && "Not all elements were deallocated from a block.");
 			}
 
 			/**
@@ -74,6 +83,34 @@ namespace ls
 			UINT32 freePtr;
 			UINT32 freeElems;
 			MemBlock* nextBlock;
+			MemBlock* prevBlock;
+		};
+
+		/**
+		 * Freed elements kept by a single thread for reuse. While it holds elements the cache is linked into the list of
+		 * caches of the owning pool, so the pool can take them back when it is destroyed.
+		 */
+		struct ThreadCache
+		{
+			/** Returns the cached elements to their pool when the thread exits. */
+			~ThreadCache()
+			{
+				if(owner.load(std::memory_order_relaxed) != nullptr)
+				{
+					ScopedLock<true> cacheLock(getCacheMutex());
+					releaseCache(*this);
+				}
+			}
+
+			/**
+			 * Pool the cached elements belong to. Only set by the thread the cache belongs to, but might be cleared by
+			 * another thread destroying the pool.
+			 */
+			std::atomic<PoolAlloc*> owner{nullptr};
+			ThreadCache* nextCache = nullptr;
+			ThreadCache* prevCache = nullptr;
+			UINT32 numElems = 0;
+			void* elems[ThreadCacheSize > 0 ? ThreadCacheSize : 1];
 		};
 
 	public:
@@ -81,11 +118,19 @@ namespace ls
 		{
 			static_assert(ElemSize >= 4, "Pool allocator minimum allowed element size is 4 bytes.");
 			static_assert(ElemsPerBlock > 0, "Number of elements per block must be at least 1.");
-			static_assert(ElemsPerBlock * ActualElemSize <= UINT_MAX, "Pool allocator block size too large.");
+			static_assert(BlockSize <= UINT_MAX, "Pool allocator block size too large.");
 		}
 
 		~PoolAlloc()
 		{
+			if(useThreadCache())
+			{
+				// Elements cached by any thread must be back in their blocks before the blocks are freed
+				ScopedLock<true> cacheLock(getCacheMutex());
+				while(mThreadCaches != nullptr)
+					releaseCache(*mThreadCaches);
+			}
+
 			ScopedLock<Lock> lock(mLockPolicy);
 
 			MemBlock* curBlock = mFreeBlock;
@@ -101,51 +146,61 @@ namespace ls
 		/** Allocates enough memory for a single element in the pool. */
 		UINT8* alloc()
 		{
-			ScopedLock<Lock> lock(mLockPolicy);
-
-			if(mFreeBlock == nullptr || mFreeBlock->freeElems == 0)
-				allocBlock();
-
-			mTotalNumElems++;
-			UINT8* output = mFreeBlock->alloc();
+			if(useThreadCache())
+			{
+				ThreadCache& cache = ThreadCacheData;
+				if(cache.owner.load(std::memory_order_relaxed) == this && cache.numElems > 0)
+					return (UINT8*)cache.elems[--cache.numElems];
+			}
 
-			return output;
+			ScopedLock<Lock> lock(mLockPolicy);
+			return allocInternal();
 		}
 
 		/** Deallocates an element from the pool. */
 		void free(void* data)
 		{
-			ScopedLock<Lock> lock(mLockPolicy);
-
-			MemBlock* curBlock = mFreeBlock;
-			while(curBlock)
+			if(useThreadCache())
 			{
-				constexpr UINT32 blockDataSize = ActualElemSize * ElemsPerBlock;
-				if(data >= curBlock->blockData && data < (curBlock->blockData + blockDataSize))
+				ThreadCache& cache = ThreadCacheData;
+				PoolAlloc* owner = cache.owner.load(std::memory_order_relaxed);
+
+				// Take over a cache that holds no elements of another pool. Checked under the mutex, as a pool being
+				// destroyed on another thread might be releasing the cache.
+				if(owner != this)
 				{
-					curBlock->dealloc(data);
-					mTotalNumElems--;
+					ScopedLock<true> cacheLock(getCacheMutex());
+
+					owner = cache.owner.load(std::memory_order_relaxed);
+					if(owner == nullptr || cache.numElems == 0)
+					{
+						releaseCache(cache);
+						attachCache(cache);
 
-					if(curBlock->freeElems == 0 && curBlock->nextBlock)
+						owner = this;
+					}
+				}
+
+				if(owner == this)
+				{
+					if(cache.numElems == ThreadCacheSize)
 					{
-						// Free the block, but only if there is some extra free space in other blocks
-						const UINT32 totalSpace = (mNumBlocks - 1) * ElemsPerBlock;
-						const UINT32 freeSpace = totalSpace - mTotalNumElems;
-
-						if(freeSpace > ElemsPerBlock / 2)
-						{
-							mFreeBlock = curBlock->nextBlock;
-							deallocBlock(curBlock);
-						}
+						// Return half of the cache to the pool, with a single lock
+						ScopedLock<Lock> lock(mLockPolicy);
+
+						for(UINT32 i = ThreadCacheSize / 2; i < ThreadCacheSize; i++)
+							freeInternal(cache.elems[i]);
+
+						cache.numElems = ThreadCacheSize / 2;
 					}
 
+					cache.elems[cache.numElems++] = data;
 					return;
 				}
-
-				curBlock = curBlock->nextBlock;
 			}
 
-			assert(false);
+			ScopedLock<Lock> lock(mLockPolicy);
+			freeInternal(data);
 		}
 
 		/** Allocates and constructs a single pool element. */
@@ -167,46 +222,129 @@ namespace ls
 		}
 
 	private:
-		/** Allocates a new block of memory using a heap allocator. */
-		MemBlock* allocBlock()
+		/** Returns true if the calling thread should attempt to use its thread local cache. */
+		static constexpr bool useThreadCache() { return Lock && ThreadCacheSize > 0; }
+
+		/**
+		 * Returns the mutex that must be held when changing the owner of a thread cache. Never destroyed, as global pools
+		 * and threads might release their caches after static destruction started.
+		 */
+		static Mutex& getCacheMutex()
 		{
-			MemBlock* newBlock = nullptr;
-			MemBlock* curBlock = mFreeBlock;
+			static Mutex* mutex = new Mutex();
+			return *mutex;
+		}
 
-			while (curBlock != nullptr)
-			{
-				MemBlock* nextBlock = curBlock->nextBlock;
-				if (nextBlock != nullptr && nextBlock->freeElems > 0)
-				{
-					// Found an existing block with free space
-					newBlock = nextBlock;
+		/** Makes this pool the owner of the provided empty cache. Caller must hold the cache mutex. */
+		void attachCache(ThreadCache& cache)
+		{
+			cache.prevCache = nullptr;
+			cache.nextCache = mThreadCaches;
 
-					curBlock->nextBlock = newBlock->nextBlock;
-					newBlock->nextBlock = mFreeBlock;
+			if(mThreadCaches != nullptr)
+				mThreadCaches->prevCache = &cache;
 
-					break;
-				}
+			mThreadCaches = &cache;
+			cache.owner.store(this, std::memory_order_relaxed);
+		}
 
-				curBlock = nextBlock;
+		/**
+		 * Returns all elements in the cache to the pool owning it, and detaches the cache from the pool. Does nothing if
+		 * the cache has no owner. Caller must hold the cache mutex.
+		 */
+		static void releaseCache(ThreadCache& cache)
+		{
+			PoolAlloc* owner = cache.owner.load(std::memory_order_relaxed);
+			if(owner == nullptr)
+				return;
+
+			{
+				ScopedLock<Lock> lock(owner->mLockPolicy);
+				for(UINT32 i = 0; i < cache.numElems; i++)
+					owner->freeInternal(cache.elems[i]);
 			}
 
-			if (newBlock == nullptr)
+			cache.numElems = 0;
+
+			if(cache.prevCache != nullptr)
+				cache.prevCache->nextCache = cache.nextCache;
+			else
+				owner->mThreadCaches = cache.nextCache;
+
+			if(cache.nextCache != nullptr)
+				cache.nextCache->prevCache = cache.prevCache;
+
+			cache.nextCache = nullptr;
+			cache.prevCache = nullptr;
+			cache.owner.store(nullptr, std::memory_order_relaxed);
+		}
+
+		/** Allocates an element from the first block with free space. Caller must hold the lock. */
+		UINT8* allocInternal()
+		{
+			// Blocks with free space are always kept in front of full blocks
+			if(mFreeBlock == nullptr || mFreeBlock->freeElems == 0)
+				allocBlock();
+
+			mTotalNumElems++;
+			MemBlock* block = mFreeBlock;
+			UINT8* output = block->alloc();
+
+			if(block->freeElems == 0 && block->nextBlock != nullptr)
 			{
-				constexpr UINT32 blockDataSize = ActualElemSize * ElemsPerBlock;
-				size_t paddedBlockDataSize = blockDataSize + (Alignment - 1); // Padding for potential alignment correction
+				unlinkBlock(block);
+				linkBlockBack(block);
+			}
 
-				UINT8* data = (UINT8*)ls_alloc(sizeof(MemBlock) + (UINT32)paddedBlockDataSize);
+			return output;
+		}
 
-				void* blockData = data + sizeof(MemBlock);
-				blockData = std::align(Alignment, blockDataSize, blockData, paddedBlockDataSize);
+		/** Returns an element to the block it was allocated from. Caller must hold the lock. */
+		void freeInternal(void* data)
+		{
+			MemBlock* block = (MemBlock*)((uintptr_t)data & ~(uintptr_t)(BlockSize - 1));
+			assert(data >= block->blockData && data < (block->blockData + BlockElemCount * ActualElemSize));
 
-				newBlock = new (data) MemBlock((UINT8*)blockData);
-				mNumBlocks++;
+			bool wasFull = block->freeElems == 0;
 
-				newBlock->nextBlock = mFreeBlock;
+			block->dealloc(data);
+			mTotalNumElems--;
+
+			if(block->freeElems == BlockElemCount && mNumBlocks > 1)
+			{
+				// Free the block, but only if there is some extra free space in other blocks
+				const UINT32 totalSpace = (mNumBlocks - 1) * BlockElemCount;
+				const UINT32 freeSpace = totalSpace - mTotalNumElems;
+
+				if(freeSpace > BlockElemCount / 2)
+				{
+					unlinkBlock(block);
+					deallocBlock(block);
+
+					return;
+				}
 			}
 
-			mFreeBlock = newBlock;
+			if(wasFull && block != mFreeBlock)
+			{
+				unlinkBlock(block);
+				linkBlockFront(block);
+			}
+		}
+
+		/**
+		 * Allocates a new block of memory using a heap allocator, and makes it the first block in the list. Blocks come
+		 * straight from the platform's aligned allocator, as the generic allocators pad the allocation by the alignment,
+		 * which would double the size of every block.
+		 */
+		MemBlock* allocBlock()
+		{
+			UINT8* data = (UINT8*)platformAlignedAlloc(BlockSize, BlockSize);
+
+			MemBlock* newBlock = new (data) MemBlock(data + BlockDataOffset);
+			mNumBlocks++;
+
+			linkBlockFront(newBlock);
 			return newBlock;
 		}
 
@@ -214,33 +352,104 @@ namespace ls
 		void deallocBlock(MemBlock* block)
 		{
 			block->~MemBlock();
-			ls_free(block);
+			platformAlignedFree(block);
 
 			mNumBlocks--;
 		}
 
+		/** Inserts a block at the start of the block list. */
+		void linkBlockFront(MemBlock* block)
+		{
+			block->prevBlock = nullptr;
+			block->nextBlock = mFreeBlock;
+
+			if(mFreeBlock != nullptr)
+				mFreeBlock->prevBlock = block;
+			else
+				mLastBlock = block;
+
+			mFreeBlock = block;
+		}
+
+		/** Inserts a block at the end of the block list. */
+		void linkBlockBack(MemBlock* block)
+		{
+			block->nextBlock = nullptr;
+			block->prevBlock = mLastBlock;
+
+			if(mLastBlock != nullptr)
+				mLastBlock->nextBlock = block;
+			else
+				mFreeBlock = block;
+
+			mLastBlock = block;
+		}
+
+		/** Removes a block from the block list. */
+		void unlinkBlock(MemBlock* block)
+		{
+			if(block->prevBlock != nullptr)
+				block->prevBlock->nextBlock = block->nextBlock;
+			else
+				mFreeBlock = block->nextBlock;
+
+			if(block->nextBlock != nullptr)
+				block->nextBlock->prevBlock = block->prevBlock;
+			else
+				mLastBlock = block->prevBlock;
+
+			block->nextBlock = nullptr;
+			block->prevBlock = nullptr;
+		}
+
+		/** Returns the smallest power of two larger or equal to @p size. */
+		static constexpr size_t nextPow2(size_t size, size_t value = 1)
+		{
+			return value >= size ? value : nextPow2(size, value * 2);
+		}
+
 		static constexpr int ActualElemSize = ((ElemSize + Alignment - 1) / Alignment) * Alignment;
 
+		/** Offset of the first element from the start of the block, leaving room for the MemBlock header. */
+		static constexpr UINT32 BlockDataOffset =
+			(UINT32)(((sizeof(MemBlock) + Alignment - 1) / Alignment) * Alignment);
+
+		/** Size of a block, including the header. Blocks are always aligned to their size. */
+		static constexpr size_t BlockSize = nextPow2(BlockDataOffset + (size_t)ActualElemSize * ElemsPerBlock);
+
+		/** Number of elements that fit in a single block. At least ElemsPerBlock. */
+		static constexpr UINT32 BlockElemCount = (UINT32)((BlockSize - BlockDataOffset) / ActualElemSize);
+
+		/** Uses thread_local rather than LS_THREADLOCAL, as the cache needs to be released when the thread exits. */
+		static thread_local ThreadCache ThreadCacheData;
+
 		LockingPolicy<Lock> mLockPolicy;
-		MemBlock* mFreeBlock = nullptr;
+		MemBlock* mFreeBlock = nullptr; /**< First block in the list. Blocks with free space are kept before full ones. */
+		MemBlock* mLastBlock = nullptr;
 		UINT32 mTotalNumElems = 0;
 		UINT32 mNumBlocks = 0;
+		ThreadCache* mThreadCaches = nullptr; /**< Caches of all threads holding elements of this pool. */
 	};
 
+	template <int ElemSize, int ElemsPerBlock, int Alignment, bool Lock, UINT32 ThreadCacheSize>
+	thread_local typename PoolAlloc<ElemSize, ElemsPerBlock, Alignment, Lock, ThreadCacheSize>::ThreadCache
+		PoolAlloc<ElemSize, ElemsPerBlock, Alignment, Lock, ThreadCacheSize>::ThreadCacheData;
+
 	/** 
 	 * Helper class used by GlobalPoolAlloc that allocates a static pool allocator. GlobalPoolAlloc cannot do it
 	 * directly since it gets specialized which means the static members would need to be defined in the implementation
 	 * file, which complicates its usage.
 	 */
-	template <class T, int ElemsPerBlock = 512, int Alignment = 4, bool Lock = true>
+	template <class T, int ElemsPerBlock = 512, int Alignment = 4, bool Lock = true, UINT32 ThreadCacheSize = 0>
 	class StaticPoolAlloc
 	{
 	public:
-		static PoolAlloc<sizeof(T), ElemsPerBlock, Alignment, Lock> m;
+		static PoolAlloc<sizeof(T), ElemsPerBlock, Alignment, Lock, ThreadCacheSize> m;
 	};
 
-	template <class T, int ElemsPerBlock, int Alignment, bool Lock>
-	PoolAlloc<sizeof(T), ElemsPerBlock, Alignment, Lock> StaticPoolAlloc<T, ElemsPerBlock, Alignment, Lock>::m;
+	template <class T, int ElemsPerBlock, int Alignment, bool Lock, UINT32 ThreadCacheSize>
+	PoolAlloc<sizeof(T), ElemsPerBlock, Alignment, Lock, ThreadCacheSize>
+		StaticPoolAlloc<T, ElemsPerBlock, Alignment, Lock, ThreadCacheSize>::m;
 
 	/** Specializable template that allows users to implement globally accessible pool allocators for custom types. */
 	template<class T>
@@ -259,6 +468,13 @@ namespace ls
 #define IMPLEMENT_GLOBAL_POOL(Type, ElemsPerBlock)									\
 	template<> class GlobalPoolAlloc<Type> : public StaticPoolAlloc<Type, ElemsPerBlock> { };
 
+	/** 
+	 * Implements a global pool for the specified type, same as IMPLEMENT_GLOBAL_POOL. Additionally each thread caches up
+	 * to ThreadCacheSize freed elements and reuses them without locking the pool.
+	 */
+#define IMPLEMENT_GLOBAL_POOL_CACHED(Type, ElemsPerBlock, ThreadCacheSize)			\
+	template<> class GlobalPoolAlloc<Type> : public StaticPoolAlloc<Type, ElemsPerBlock, 4, true, ThreadCacheSize> { };
+
 	/** Allocates a new object of type T using the global pool allocator, without constructing it. */
 	template<class T>
 	T* ls_pool_alloc()
@@ -291,5 +507,84 @@ namespace ls
 		ls_pool_free(ptr);
 	}
 
+	/**
+	 * Standard library compatible allocator that takes single element allocations from a thread safe pool shared by all
+	 * allocators of the same type. Allocations of multiple elements use the general allocator instead. 
+	 *
+	 * Mainly useful with std::allocate_shared, as the allocator gets rebound to the internal type holding both the object 
+	 * and its reference counts, so the whole shared pointer comes from a pool. See ls_pool_shared_ptr_new().
+	 */
+	template <class T, int ElemsPerBlock = 512>
+	class StdPoolAlloc
+	{
+	public:
+		using value_type		= T;
+		using pointer			= value_type*;
+		using const_pointer		= const value_type*;
+		using reference			= value_type&;
+		using const_reference	= const value_type&;
+		using size_type			= std::size_t;
+		using difference_type	= std::ptrdiff_t;
+
+		constexpr StdPoolAlloc() = default;
+		constexpr StdPoolAlloc(StdPoolAlloc&&) = default;
+		constexpr StdPoolAlloc(const StdPoolAlloc&) = default;
+		template<class U> constexpr StdPoolAlloc(const StdPoolAlloc<U, ElemsPerBlock>&) { };
+		template<class U> constexpr bool operator==(const StdPoolAlloc<U, ElemsPerBlock>&) const noexcept { return true; }
+		template<class U> constexpr bool operator!=(const StdPoolAlloc<U, ElemsPerBlock>&) const noexcept { return false; }
+
+		template<class U> class rebind { public: using other = StdPoolAlloc<U, ElemsPerBlock>; };
+
+		/** Allocate but don't initialize number elements of type T. */
+		static T* allocate(const size_t num)
+		{
+			if (num == 0)
+				return nullptr;
+
+			if (num == 1)
+				return (T*)getPool().alloc();
+
+			if (num > std::numeric_limits<size_t>::max() / sizeof(T))
+				return nullptr; // Error
+
+			return static_cast<T*>(ls_alloc(num * sizeof(T)));
+		}
+
+		/** Deallocate storage p of deleted elements. */
+		static void deallocate(pointer p, size_type num)
+		{
+			if (num == 1)
+				getPool().free(p);
+			else
+				ls_free(p);
+		}
+
+		static constexpr size_t max_size() { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+	private:
+		static constexpr int ElemSize = sizeof(T) > 4 ? (int)sizeof(T) : 4;
+		static constexpr int Alignment = alignof(T) > 4 ? (int)alignof(T) : 4;
+
+		using Pool = PoolAlloc<ElemSize, ElemsPerBlock, Alignment, true, 32>;
+
+		/** Returns the pool for this type. The pool is never destroyed, as its elements may outlive static destruction. */
+		static Pool& getPool()
+		{
+			static Pool* pool = ls_new<Pool>();
+			return *pool;
+		}
+	};
+
+	/**
+	 * Creates a new shared pointer whose object and reference counts are allocated together from a pool. Prefer this over
+	 * ls_shared_ptr_new() for small objects created and destroyed in large numbers, such as the ones created by
+	 * RTTITypeBase::newRTTIObject() when decoding.
+	 */
+	template<class Type, class... Args>
+	SPtr<Type> ls_pool_shared_ptr_new(Args &&...args)
+	{
+		return std::allocate_shared<Type>(StdPoolAlloc<Type>(), std::forward<Args>(args)...);
+	}
+
 	/** @} */
 }
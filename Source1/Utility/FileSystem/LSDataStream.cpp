@@ -2,6 +2,19 @@
 #include "Logger/LSLogger.h"
 #include "String/LSUnicode.h"
 
+#if PLATFORM_WINDOWS
+	#define WIN32_LEAN_AND_MEAN
+	#if !defined(NOMINMAX) && defined(_MSC_VER)
+		#define NOMINMAX // required to stop windows.h messing up std::min
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
 namespace ls
 {
 	const UINT32 DataStream::StreamTempSize = 128;
@@ -416,4 +429,199 @@ namespace ls
 			}
 		}
 	}
+
+	void FileDataStream::flush()
+	{
+		if (mFStream)
+			mFStream->flush();
+	}
+
+	/** File mapped into memory, unmapped once the last stream referencing it is destroyed. */
+	struct MMapDataStream::Mapping
+	{
+		Mapping(const Path& path);
+		~Mapping();
+
+		Mapping(const Mapping&) = delete;
+		Mapping& operator=(const Mapping&) = delete;
+
+		UINT8* data = nullptr;
+		size_t size = 0;
+
+#if PLATFORM_WINDOWS
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
+#endif
+	};
+
+#if PLATFORM_WINDOWS
+	MMapDataStream::Mapping::Mapping(const Path& path)
+	{
+		WString pathString = UTF8::toWide(path.toString());
+
+		file = CreateFileW(pathString.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 
+			FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			LOGWRN("Cannot open file: " + path.toString());
+			return;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+			return;
+
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			LOGWRN("Cannot map file: " + path.toString());
+			return;
+		}
+
+		data = (UINT8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == nullptr)
+		{
+			LOGWRN("Cannot map file: " + path.toString());
+			return;
+		}
+
+		size = (size_t)fileSize.QuadPart;
+	}
+
+	MMapDataStream::Mapping::~Mapping()
+	{
+		if (data != nullptr)
+			UnmapViewOfFile(data);
+
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+	}
+#else
+	MMapDataStream::Mapping::Mapping(const Path& path)
+	{
+		int fd = open(path.toString().c_str(), O_RDONLY);
+		if (fd == -1)
+		{
+			LOGWRN("Cannot open file: " + path.toString());
+			return;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0)
+		{
+			void* mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapped != MAP_FAILED)
+			{
+				data = (UINT8*)mapped;
+				size = (size_t)st.st_size;
+			}
+			else
+				LOGWRN("Cannot map file: " + path.toString() + ". Error: " + strerror(errno) + ".");
+		}
+
+		// The mapping stays valid after the descriptor is closed
+		::close(fd);
+	}
+
+	MMapDataStream::Mapping::~Mapping()
+	{
+		if (data != nullptr)
+			munmap(data, size);
+	}
+#endif
+
+	/** Read-only memory stream referencing a part of a mapped file, keeping the mapping alive. */
+	class MMapDataStream::ViewDataStream : public MemoryDataStream
+	{
+	public:
+		ViewDataStream(const SPtr<Mapping>& mapping, const UINT8* data, size_t size)
+			: MemoryDataStream(const_cast<UINT8*>(data), size, false), mMapping(mapping)
+		{
+			mAccess = READ;
+		}
+
+	private:
+		SPtr<Mapping> mMapping;
+	};
+
+	MMapDataStream::MMapDataStream(const Path& filePath)
+		: DataStream(READ), mPath(filePath)
+	{
+		mMapping = ls_shared_ptr_new<Mapping>(filePath);
+
+		mData = mPos = mMapping->data;
+		mSize = mMapping->size;
+		mEnd = mData + mSize;
+	}
+
+	MMapDataStream::~MMapDataStream()
+	{
+		close();
+	}
+
+	size_t MMapDataStream::read(void* buf, size_t count)
+	{
+		size_t cnt = std::min(count, (size_t)(mEnd - mPos));
+		if (cnt == 0)
+			return 0;
+
+		memcpy(buf, mPos, cnt);
+		mPos += cnt;
+
+		return cnt;
+	}
+
+	void MMapDataStream::skip(size_t count)
+	{
+		size_t newpos = (size_t)((mPos - mData) + count);
+		assert(mData + newpos <= mEnd);
+
+		mPos = mData + newpos;
+	}
+
+	void MMapDataStream::seek(size_t pos)
+	{
+		assert(mData + pos <= mEnd);
+		mPos = mData + pos;
+	}
+
+	size_t MMapDataStream::tell() const
+	{
+		return mPos - mData;
+	}
+
+	bool MMapDataStream::eof() const
+	{
+		return mPos >= mEnd;
+	}
+
+	SPtr<DataStream> MMapDataStream::readView(size_t count)
+	{
+		if (mMapping == nullptr || count > (size_t)(mEnd - mPos))
+			return nullptr;
+
+		SPtr<DataStream> view = ls_shared_ptr_new<ViewDataStream>(mMapping, mPos, count);
+		mPos += count;
+
+		return view;
+	}
+
+	SPtr<DataStream> MMapDataStream::clone(bool copyData) const
+	{
+		// The data is read-only, so the clone can share the mapping
+		SPtr<MMapDataStream> copy = ls_shared_ptr_new<MMapDataStream>(*this);
+		copy->mPos = copy->mData;
+
+		return copy;
+	}
+
+	void MMapDataStream::close()
+	{
+		// Views created from this stream keep the mapping alive on their own
+		mMapping = nullptr;
+		mData = mPos = mEnd = nullptr;
+	}
 }
@@ -126,6 +126,13 @@ namespace ls
 		/** Returns true if the stream has reached the end. */
 		virtual bool eof() const = 0;
 
+		/**
+		 * Returns a stream referencing the next @p count bytes of this stream without copying them, and advances the read 
+		 * pointer past them. The returned stream keeps the referenced data alive. Returns null if the stream doesn't 
+		 * support referencing its data, in which case the read pointer is not moved.
+		 */
+		virtual SPtr<DataStream> readView(size_t count) { return nullptr; }
+
 		/** Returns the total size of the data to be read from the stream, or 0 if this is indeterminate for this stream. */
 		size_t size() const { return mSize; }
 
@@ -140,6 +147,9 @@ namespace ls
 
 		/** Close the stream. This makes further operations invalid. */
 		virtual void close() = 0;
+
+		/** Writes any data buffered by the stream to its destination. Does nothing for streams that don't buffer. */
+		virtual void flush() { }
 		
 	protected:
 		static const UINT32 StreamTempSize;
@@ -269,6 +279,9 @@ namespace ls
 		/** @copydoc DataStream::close */
 		void close() override;
 
+		/** @copydoc DataStream::flush */
+		void flush() override;
+
 		/** Returns the path of the file opened by the stream. */
 		const Path& getPath() const { return mPath; }
 
@@ -280,6 +293,68 @@ namespace ls
 		bool mFreeOnClose;	
 	};
 
+	/** 
+	 * Read-only data stream for a file mapped into memory. Reading is a plain memory copy, and readView() returns streams
+	 * referencing the mapped file data directly. The mapping is kept alive as long as the stream or any of its views 
+	 * exist.
+	 */
+	class LS_UTILITY_EXPORT MMapDataStream : public DataStream
+	{
+	public:
+		/**
+		 * Maps the file at the provided path into memory.
+		 *
+		 * @param[in]	filePath	Path of the file to open.
+		 */
+		MMapDataStream(const Path& filePath);
+		~MMapDataStream();
+
+		bool isFile() const override { return true; }
+
+		/** Get a pointer to the start of the mapped file data. */
+		const UINT8* getPtr() const { return mData; }
+
+		/** Get a pointer to the current position in the mapped file data. */
+		const UINT8* getCurrentPtr() const { return mPos; }
+
+		/** @copydoc DataStream::read */
+		size_t read(void* buf, size_t count) override;
+
+		/** @copydoc DataStream::skip */
+		void skip(size_t count) override;
+	
+		/** @copydoc DataStream::seek */
+		void seek(size_t pos) override;
+
+		/** @copydoc DataStream::tell */
+		size_t tell() const override;
+
+		/** @copydoc DataStream::eof */
+		bool eof() const override;
+
+		/** @copydoc DataStream::readView */
+		SPtr<DataStream> readView(size_t count) override;
+
+		/** @copydoc DataStream::clone */
+		SPtr<DataStream> clone(bool copyData = true) const override;
+
+		/** @copydoc DataStream::close */
+		void close() override;
+
+		/** Returns the path of the file opened by the stream. */
+		const Path& getPath() const { return mPath; }
+
+	protected:
+		struct Mapping;
+		class ViewDataStream;
+
+		Path mPath;
+		SPtr<Mapping> mMapping;
+		const UINT8* mData = nullptr;
+		const UINT8* mPos = nullptr;
+		const UINT8* mEnd = nullptr;
+	};
+
 	/** @} */
 }
 
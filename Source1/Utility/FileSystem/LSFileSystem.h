@@ -15,10 +15,13 @@ namespace ls
 		/**
 		 * Opens a file and returns a data stream capable of reading or writing to that file.
 		 *
-		 * @param[in]	fullPath	Full path to a file.
-		 * @param[in]	readOnly	(optional) If true, returned stream will only be readable.
+		 * @param[in]	fullPath		Full path to a file.
+		 * @param[in]	readOnly		(optional) If true, returned stream will only be readable.
+		 * @param[in]	memoryMapped	(optional) If true, and the file is opened read-only, the file is mapped into
+		 *								memory and returned as a MMapDataStream. Useful for large files whose data
+		 *								should be referenced rather than copied, see DataStream::readView().
 		 */
-		static SPtr<DataStream> openFile(const Path& fullPath, bool readOnly = true);
+		static SPtr<DataStream> openFile(const Path& fullPath, bool readOnly = true, bool memoryMapped = false);
 
 		/**
 		 * Opens a file and returns a data stream capable of reading and writing to that file. If file doesn't exist new
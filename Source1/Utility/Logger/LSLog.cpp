@@ -13,6 +13,49 @@ namespace ls
 		RecursiveLock lock(mMutex);
 
 		mUnreadEntries.push(LogEntry(message, channel));
+		trim();
+	}
+
+	void Log::logMsg(String&& message, UINT32 channel)
+	{
+		RecursiveLock lock(mMutex);
+
+		mUnreadEntries.push(LogEntry(std::move(message), channel));
+		trim();
+	}
+
+	void Log::setCapacity(UINT32 capacity)
+	{
+		RecursiveLock lock(mMutex);
+
+		mCapacity = capacity;
+		trim();
+	}
+
+	void Log::trim()
+	{
+		if (mCapacity == 0)
+			return;
+
+		size_t numEntries = mEntries.size() + mUnreadEntries.size();
+		if (numEntries <= mCapacity)
+			return;
+
+		while (numEntries > mCapacity && !mEntries.empty())
+		{
+			mEntries.pop_front();
+			numEntries--;
+			mNumDiscarded++;
+		}
+
+		while (numEntries > mCapacity)
+		{
+			mUnreadEntries.pop();
+			numEntries--;
+			mNumDiscarded++;
+		}
+
+		mHash++;
 	}
 
 	void Log::clear()
@@ -24,6 +67,7 @@ namespace ls
 		while (!mUnreadEntries.empty())
 			mUnreadEntries.pop();
 
+		mNumDiscarded = 0;
 		mHash++;
 	}
 
@@ -31,7 +75,7 @@ namespace ls
 	{
 		RecursiveLock lock(mMutex);
 
-		Vector<LogEntry> newEntries;
+		Deque<LogEntry> newEntries;
 		for(auto& entry : mEntries)
 		{
 			if (entry.getChannel() == channel)
@@ -75,6 +119,8 @@ namespace ls
 
 	bool Log::getLastEntry(LogEntry& entry)
 	{
+		RecursiveLock lock(mMutex);
+
 		if (mEntries.size() == 0)
 			return false;
 
@@ -86,7 +132,7 @@ namespace ls
 	{
 		RecursiveLock lock(mMutex);
 
-		return mEntries;
+		return Vector<LogEntry>(mEntries.begin(), mEntries.end());
 	}
 
 	Vector<LogEntry> Log::getAllEntries() const
@@ -95,6 +141,8 @@ namespace ls
 		{
 			RecursiveLock lock(mMutex);
 
+			entries.reserve(mEntries.size() + mUnreadEntries.size());
+
 			for (auto& entry : mEntries)
 				entries.push_back(entry);
 
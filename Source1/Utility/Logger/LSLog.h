@@ -31,6 +31,8 @@ namespace ls
 	/**
 	 * Used for logging messages. Can categorize messages according to channels, save the log to a file
 	 * and send out callbacks when a new message is added.
+	 *
+	 * Keeps up to a fixed number of the most recent entries, see setCapacity(). Use a LogFile to keep the entire history.
 	 * 			
 	 * @note	Thread safe.
 	 */
@@ -48,6 +50,21 @@ namespace ls
 		 */
 		void logMsg(const String& message, UINT32 channel);
 
+		/** @copydoc logMsg(const String&, UINT32) */
+		void logMsg(String&& message, UINT32 channel);
+
+		/** 
+		 * Sets the maximum number of entries the log keeps, including unread ones. Once full, the oldest entries are
+		 * discarded as new ones are logged. Use 0 for no limit.
+		 */
+		void setCapacity(UINT32 capacity);
+
+		/** Returns the maximum number of entries the log keeps, or 0 if there is no limit. */
+		UINT32 getCapacity() const { return mCapacity; }
+
+		/** Returns the number of entries discarded because the log was full, since it was created or last cleared. */
+		UINT64 getNumDiscarded() const { return mNumDiscarded; }
+
 		/** Removes all log entries. */
 		void clear();
 
@@ -79,14 +96,22 @@ namespace ls
 		 */
 		UINT64 getHash() const { return mHash; }
 
+		/** Number of entries a log keeps by default. */
+		static constexpr UINT32 DEFAULT_CAPACITY = 16384;
+
 	private:
 		friend class Logger;
 
 		/** Returns all log entries, including those marked as unread. */
 		Vector<LogEntry> getAllEntries() const;
 
-		Vector<LogEntry> mEntries;
+		/** Discards the oldest entries, read ones first, until the number of entries is within the capacity. */
+		void trim();
+
+		Deque<LogEntry> mEntries;
 		Queue<LogEntry> mUnreadEntries;
+		UINT32 mCapacity = DEFAULT_CAPACITY;
+		UINT64 mNumDiscarded = 0;
 		UINT64 mHash = 0;
 		mutable RecursiveMutex mMutex;
 	};
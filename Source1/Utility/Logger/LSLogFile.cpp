@@ -0,0 +1,92 @@
+#include "Logger/LSLogFile.h"
+#include "FileSystem/LSFileSystem.h"
+#include "FileSystem/LSDataStream.h"
+#include "General/LSCompression.h"
+
+namespace ls
+{
+	LogFile::LogFile(const Path& path, const LogFileOptions& options)
+		:mPath(path), mOptions(options)
+	{
+		if (FileSystem::isFile(mPath) && FileSystem::getFileSize(mPath) > 0)
+			rotate();
+		else
+			open();
+	}
+
+	void LogFile::write(const String& message)
+	{
+		bool rotateFile = mOptions.maxSize > 0 && mSize > 0 && (mSize + message.size() + 1) > mOptions.maxSize;
+		rotateFile |= mOptions.maxAge > 0 && (UINT64)(std::time(nullptr) - mOpenTime) >= mOptions.maxAge;
+
+		if (rotateFile)
+			rotate();
+
+		mStream->write(message.data(), message.size());
+		mStream->write("\n", 1);
+
+		mSize += message.size() + 1;
+	}
+
+	void LogFile::flush()
+	{
+		if (mStream != nullptr)
+			mStream->flush();
+	}
+
+	void LogFile::rotate()
+	{
+		// Closes the file
+		mStream = nullptr;
+
+		if (mOptions.maxRotatedFiles > 0)
+		{
+			const Path oldest = getRotatedPath(mOptions.maxRotatedFiles);
+			if (FileSystem::exists(oldest))
+				FileSystem::remove(oldest);
+
+			for (UINT32 i = mOptions.maxRotatedFiles - 1; i >= 1; i--)
+			{
+				const Path rotatedPath = getRotatedPath(i);
+				if (FileSystem::exists(rotatedPath))
+					FileSystem::move(rotatedPath, getRotatedPath(i + 1));
+			}
+
+			if (mOptions.compress)
+			{
+				SPtr<DataStream> input = FileSystem::openFile(mPath);
+				SPtr<MemoryDataStream> compressed = Compression::compress(input);
+				input = nullptr;
+
+				SPtr<DataStream> output = FileSystem::createAndOpenFile(getRotatedPath(1));
+				output->write(compressed->getPtr(), compressed->size());
+				output = nullptr;
+
+				FileSystem::remove(mPath);
+			}
+			else
+				FileSystem::move(mPath, getRotatedPath(1));
+		}
+
+		open();
+	}
+
+	Path LogFile::getRotatedPath(UINT32 index) const
+	{
+		String filename = mPath.getFilename() + "." + toString(index);
+		if (mOptions.compress)
+			filename += ".snappy";
+
+		Path output = mPath;
+		output.setFilename(filename);
+
+		return output;
+	}
+
+	void LogFile::open()
+	{
+		mStream = FileSystem::createAndOpenFile(mPath);
+		mSize = 0;
+		mOpenTime = std::time(nullptr);
+	}
+}
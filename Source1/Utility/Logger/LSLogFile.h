@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Prerequisites/LSPrerequisitesUtil.h"
+
+namespace ls
+{
+	/** @addtogroup Debug
+	 *  @{
+	 */
+
+	/** Determines when a LogFile starts a new file, and what happens to the previous ones. */
+	struct LogFileOptions
+	{
+		/** Size in bytes the file can grow to before it is rotated, or 0 for no limit. */
+		UINT64 maxSize = 16 * 1024 * 1024;
+
+		/** Number of seconds after which the file is rotated, or 0 for no limit. */
+		UINT64 maxAge = 0;
+
+		/** Number of rotated files to keep. Once exceeded the oldest rotated file is deleted. */
+		UINT32 maxRotatedFiles = 5;
+
+		/** If true rotated files are compressed using Compression. */
+		bool compress = false;
+	};
+
+	/**
+	 * Text file log entries are appended to as they are logged. Once the file grows over the size limit, or gets older
+	 * than the age limit, it is rotated: the file is renamed to "<path>.1", previously rotated files move up by one and
+	 * the oldest is deleted. Compressed rotated files have an additional ".snappy" extension.
+	 *
+	 * @note	Not thread safe.
+	 */
+	class LS_UTILITY_EXPORT LogFile
+	{
+	public:
+		/** Opens the file for writing. An existing file at the same path is rotated first. */
+		LogFile(const Path& path, const LogFileOptions& options = LogFileOptions());
+
+		/** Appends a message followed by a new line, rotating the file first if it exceeded its limits. */
+		void write(const String& message);
+
+		/** Writes any buffered messages to the file. */
+		void flush();
+
+		/** Moves the current file to the rotated files and starts a new one. */
+		void rotate();
+
+		/** Returns the path of the file currently being written to. */
+		const Path& getPath() const { return mPath; }
+
+		/** Returns the path of a rotated file, with index 1 being the most recently rotated one. */
+		Path getRotatedPath(UINT32 index) const;
+
+	private:
+		/** Creates a new file at the log path, replacing any existing one. */
+		void open();
+
+		Path mPath;
+		LogFileOptions mOptions;
+		SPtr<DataStream> mStream;
+		UINT64 mSize = 0;
+		std::time_t mOpenTime = 0;
+	};
+
+	/** @} */
+}
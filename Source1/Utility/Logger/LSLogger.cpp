@@ -26,28 +26,561 @@ void logToIDEConsole(const ls::String& message)
 
 namespace ls
 {
+	/** Set while the calling thread is writing log entries, so entries it logs meanwhile are written immediately. */
+	static LS_THREADLOCAL bool IsWritingEntries = false;
+
+	/** 
+	 * Ring buffer a single thread queues its log entries in, and the background thread reads them from. Read and write
+	 * positions only ever increase, and are wrapped when accessing the data.
+	 */
+	struct Logger::ThreadBuffer
+	{
+		/** Placed in front of each queued message. */
+		struct EntryHeader
+		{
+			const LogCallSite* site;
+			UINT32 channel;
+			UINT32 length;
+		};
+
+		/** Entry length signaling the rest of the buffer is unused, and reading continues from its start. */
+		static constexpr UINT32 PADDING_LENGTH = std::numeric_limits<UINT32>::max();
+
+		ThreadBuffer(UINT64 loggerId)
+			:loggerId(loggerId)
+		{
+			data = (UINT8*)ls_alloc(THREAD_BUFFER_SIZE);
+		}
+
+		~ThreadBuffer()
+		{
+			ls_free(data);
+		}
+
+		/** Returns the number of bytes an entry with a message of the provided length takes up in the buffer. */
+		static UINT32 getEntrySize(UINT32 length)
+		{
+			return (sizeof(EntryHeader) + length + 7) & ~7U;
+		}
+
+		/** 
+		 * Queues a new entry. Returns false if there is not enough space in the buffer. Must only be called by the
+		 * owner thread.
+		 *
+		 * @param[out]	numQueuedBytes	Number of bytes in the buffer waiting to be read, including the new entry.
+		 */
+		bool push(const LogCallSite* site, UINT32 channel, const char* msg, UINT32 length, UINT32& numQueuedBytes)
+		{
+			const UINT32 entrySize = getEntrySize(length);
+
+			UINT64 curWritePos = writePos.load(std::memory_order_relaxed);
+			const UINT64 curReadPos = readPos.load(std::memory_order_acquire);
+
+			UINT32 offset = (UINT32)(curWritePos % THREAD_BUFFER_SIZE);
+			const UINT32 padding = entrySize > (THREAD_BUFFER_SIZE - offset) ? THREAD_BUFFER_SIZE - offset : 0;
+
+			if ((curWritePos + padding + entrySize - curReadPos) > THREAD_BUFFER_SIZE)
+				return false;
+
+			// Entries are always contiguous, so skip to the start if there isn't enough space at the end
+			if (padding > 0)
+			{
+				if (padding >= sizeof(EntryHeader))
+				{
+					EntryHeader header = { nullptr, 0, PADDING_LENGTH };
+					memcpy(data + offset, &header, sizeof(header));
+				}
+
+				curWritePos += padding;
+				offset = 0;
+			}
+
+			EntryHeader header = { site, channel, length };
+			memcpy(data + offset, &header, sizeof(header));
+			memcpy(data + offset + sizeof(header), msg, length);
+
+			curWritePos += entrySize;
+			writePos.store(curWritePos, std::memory_order_release);
+
+			numQueuedBytes = (UINT32)(curWritePos - curReadPos);
+			return true;
+		}
+
+		/** 
+		 * Releases a reference to the buffer held by the logger or the thread that claimed it, deleting the buffer once
+		 * neither holds it.
+		 */
+		void release()
+		{
+			if (numRefs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				ls_delete(this);
+		}
+
+		UINT8* data;
+		std::atomic<UINT64> writePos{0};
+		std::atomic<UINT64> readPos{0};
+		UINT64 loggerId; /**< Instance ID of the logger owning the buffer. */
+		std::atomic<bool> claimed{true}; /**< Set while a thread queues its entries in the buffer. */
+		std::atomic<UINT32> numRefs{2}; /**< References held by the logger and the claiming thread. */
+		ThreadBuffer* next = nullptr; /**< Next buffer of the same logger. */
+		ThreadBuffer* nextClaimed = nullptr; /**< Next buffer claimed by the same thread. Only used by that thread. */
+	};
+
+	/** Keeps track of the buffers claimed by a thread, and releases them when the thread exits. */
+	struct Logger::ThreadBufferGuard
+	{
+		~ThreadBufferGuard()
+		{
+			ThreadBuffer* buffer = claimed;
+			while (buffer != nullptr)
+			{
+				ThreadBuffer* next = buffer->nextClaimed;
+
+				// Any queued entries are still processed, after which another thread may reuse the buffer
+				buffer->nextClaimed = nullptr;
+				buffer->claimed.store(false, std::memory_order_release);
+				buffer->release();
+
+				buffer = next;
+			}
+		}
+
+		ThreadBuffer* claimed = nullptr;
+	};
+
+	Logger::Logger()
+	{
+		static std::atomic<UINT64> NextInstanceId{1};
+		mInstanceId = NextInstanceId.fetch_add(1, std::memory_order_relaxed);
+
+		for (auto& entry : mRateLimits)
+			entry.store(DEFAULT_RATE_LIMIT, std::memory_order_relaxed);
+	}
+
+	Logger::~Logger()
+	{
+		_stopAsync();
+
+		// Buffers still claimed by running threads are deleted once those threads exit
+		ThreadBuffer* buffer = mThreadBuffers.load(std::memory_order_acquire);
+		while (buffer != nullptr)
+		{
+			ThreadBuffer* next = buffer->next;
+			buffer->release();
+
+			buffer = next;
+		}
+	}
+
 	void Logger::logLogger(const String& msg)
 	{
-		mLog.logMsg(msg, (UINT32)DebugChannel::Debug);
-		logToIDEConsole(msg);
+		logEntry(nullptr, (UINT32)DebugChannel::Debug, msg.data(), (UINT32)msg.size());
 	}
 
 	void Logger::logWarning(const String& msg)
 	{
-		mLog.logMsg(msg, (UINT32)DebugChannel::Warning);
-		logToIDEConsole(msg);
+		logEntry(nullptr, (UINT32)DebugChannel::Warning, msg.data(), (UINT32)msg.size());
 	}
 
 	void Logger::logError(const String& msg)
 	{
-		mLog.logMsg(msg, (UINT32)DebugChannel::Error);
-		logToIDEConsole(msg);
+		logEntry(nullptr, (UINT32)DebugChannel::Error, msg.data(), (UINT32)msg.size());
 	}
 
 	void Logger::log(const String& msg, UINT32 channel)
 	{
-		mLog.logMsg(msg, channel);
-		logToIDEConsole(msg);
+		logEntry(nullptr, channel, msg.data(), (UINT32)msg.size());
+	}
+
+	void Logger::log(const LogCallSite& site, const String& msg)
+	{
+		logEntry(&site, site.channel, msg.data(), (UINT32)msg.size());
+	}
+
+	void Logger::log(const LogCallSite& site, const char* msg)
+	{
+		logEntry(&site, site.channel, msg, (UINT32)strlen(msg));
+	}
+
+	void Logger::logEntry(const LogCallSite* site, UINT32 channel, const char* msg, UINT32 length)
+	{
+		if (!isChannelEnabled(channel))
+			return;
+
+		// Logged while writing other entries (e.g. by the log file), we already hold the lock
+		if (IsWritingEntries)
+		{
+			writeEntry(site, channel, msg, length);
+			return;
+		}
+
+		if (mAsyncRunning.load(std::memory_order_relaxed) && length <= MAX_QUEUED_MESSAGE_SIZE)
+		{
+			ThreadBuffer* buffer = getThreadBuffer();
+
+			UINT32 numQueuedBytes = 0;
+			if (buffer->push(site, channel, msg, length, numQueuedBytes))
+			{
+				// The background thread might have stopped without seeing the entry, see _stopAsync()
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (!mAsyncRunning.load(std::memory_order_relaxed))
+				{
+					flush();
+					return;
+				}
+
+				// Wake the background thread early if the buffer is filling up, once per crossing of the threshold
+				const UINT32 entrySize = ThreadBuffer::getEntrySize(length);
+				if (numQueuedBytes > THREAD_BUFFER_SIZE / 2 && (numQueuedBytes - entrySize) <= THREAD_BUFFER_SIZE / 2)
+				{
+					{
+						Lock lock(mAsyncMutex);
+						mAsyncWake = true;
+					}
+
+					mAsyncSignal.notify_one();
+				}
+
+				return;
+			}
+		}
+
+		// Process immediately, after any entries queued before it
+		Lock lock(mSinkMutex);
+		IsWritingEntries = true;
+
+		processBuffers();
+		writeEntry(site, channel, msg, length);
+
+		IsWritingEntries = false;
+	}
+
+	Logger::ThreadBuffer* Logger::getThreadBuffer()
+	{
+		// Identified by ID rather than address, as a new logger may be created where a destroyed one used to be
+		static LS_THREADLOCAL UINT64 CurrentOwnerId = 0;
+		static LS_THREADLOCAL ThreadBuffer* CurrentBuffer = nullptr;
+
+		if (CurrentOwnerId == mInstanceId)
+			return CurrentBuffer;
+
+		// Look for a buffer the thread claimed earlier, in case it logs to multiple loggers
+		ThreadBufferGuard& guard = getClaimedBuffers();
+
+		ThreadBuffer* buffer = guard.claimed;
+		while (buffer != nullptr && buffer->loggerId != mInstanceId)
+			buffer = buffer->nextClaimed;
+
+		if (buffer == nullptr)
+		{
+			// Reuse a buffer released by a thread that exited
+			for (buffer = mThreadBuffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next)
+			{
+				bool expected = false;
+				if (!buffer->claimed.load(std::memory_order_relaxed) && 
+					buffer->claimed.compare_exchange_strong(expected, true, std::memory_order_acquire))
+				{
+					buffer->numRefs.fetch_add(1, std::memory_order_relaxed);
+					break;
+				}
+			}
+
+			if (buffer == nullptr)
+			{
+				buffer = ls_new<ThreadBuffer>(mInstanceId);
+				buffer->next = mThreadBuffers.load(std::memory_order_relaxed);
+
+				while (!mThreadBuffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release,
+					std::memory_order_relaxed))
+				{ }
+			}
+
+			buffer->nextClaimed = guard.claimed;
+			guard.claimed = buffer;
+		}
+
+		CurrentOwnerId = mInstanceId;
+		CurrentBuffer = buffer;
+
+		return buffer;
+	}
+
+	Logger::ThreadBufferGuard& Logger::getClaimedBuffers()
+	{
+		// Uses thread_local rather than LS_THREADLOCAL, as the buffers need to be released when the thread exits
+		static thread_local ThreadBufferGuard Guard;
+		return Guard;
+	}
+
+	void Logger::processBuffers()
+	{
+		typedef ThreadBuffer::EntryHeader EntryHeader;
+
+		for (ThreadBuffer* buffer = mThreadBuffers.load(std::memory_order_acquire); buffer != nullptr; 
+			buffer = buffer->next)
+		{
+			UINT64 readPos = buffer->readPos.load(std::memory_order_relaxed);
+			const UINT64 writePos = buffer->writePos.load(std::memory_order_acquire);
+
+			while (readPos < writePos)
+			{
+				const UINT32 offset = (UINT32)(readPos % THREAD_BUFFER_SIZE);
+				const UINT32 bytesToEnd = THREAD_BUFFER_SIZE - offset;
+
+				if (bytesToEnd < sizeof(EntryHeader))
+				{
+					readPos += bytesToEnd;
+					continue;
+				}
+
+				EntryHeader header;
+				memcpy(&header, buffer->data + offset, sizeof(header));
+
+				if (header.length == ThreadBuffer::PADDING_LENGTH)
+				{
+					readPos += bytesToEnd;
+					continue;
+				}
+
+				writeEntry(header.site, header.channel, (const char*)buffer->data + offset + sizeof(header), 
+					header.length);
+
+				// Release the space right away, so the owner thread doesn't need to wait for the whole batch
+				readPos += ThreadBuffer::getEntrySize(header.length);
+				buffer->readPos.store(readPos, std::memory_order_release);
+			}
+		}
+	}
+
+	void Logger::writeEntry(const LogCallSite* site, UINT32 channel, const char* msg, UINT32 length)
+	{
+		String message;
+		if (site != nullptr)
+		{
+			const String line = toString(site->line);
+			const size_t functionLength = strlen(site->function);
+			const size_t fileLength = strlen(site->file);
+
+			message.reserve(length + functionLength + fileLength + line.size() + 16);
+			message.append(msg, length);
+			message.append("\n\t\t in ");
+			message.append(site->function, functionLength);
+			message.append(" [");
+			message.append(site->file, fileLength);
+			message.append(":");
+			message.append(line);
+			message.append("]\n");
+		}
+		else
+			message.assign(msg, length);
+
+		if (mConsoleOutput.load(std::memory_order_relaxed))
+			logToIDEConsole(message);
+
+		if (mLogFile != nullptr)
+		{
+			mLogFile->write(message);
+
+			// Errors are often followed by a crash, so make sure they reach the file
+			if (channel == (UINT32)DebugChannel::Error || channel == (UINT32)DebugChannel::CompilerError)
+				mLogFile->flush();
+		}
+
+		mLog.logMsg(std::move(message), channel);
+	}
+
+	void Logger::flush()
+	{
+		if (IsWritingEntries)
+			return;
+
+		Lock lock(mSinkMutex);
+		IsWritingEntries = true;
+
+		processBuffers();
+
+		if (mLogFile != nullptr)
+			mLogFile->flush();
+
+		IsWritingEntries = false;
+	}
+
+	void Logger::setChannelEnabled(UINT32 channel, bool enabled)
+	{
+		if (channel >= MAX_FILTERED_CHANNELS)
+		{
+			LS_EXCEPT(InvalidParametersException, "Only channels below " + toString(MAX_FILTERED_CHANNELS) + 
+				" can be disabled.");
+		}
+
+		if (enabled)
+			mDisabledChannels.fetch_and(~(1U << channel), std::memory_order_relaxed);
+		else
+			mDisabledChannels.fetch_or(1U << channel, std::memory_order_relaxed);
+	}
+
+	void Logger::setMinimumSeverity(DebugChannel severity)
+	{
+		auto getSeverity = [](DebugChannel channel)
+		{
+			switch (channel)
+			{
+			default:
+			case DebugChannel::Debug: 
+				return 0;
+			case DebugChannel::Warning:
+			case DebugChannel::CompilerWarning:
+				return 1;
+			case DebugChannel::Error:
+			case DebugChannel::CompilerError:
+				return 2;
+			}
+		};
+
+		const int minSeverity = getSeverity(severity);
+		for (auto channel : { DebugChannel::Debug, DebugChannel::Warning, DebugChannel::Error, 
+			DebugChannel::CompilerWarning, DebugChannel::CompilerError })
+		{
+			setChannelEnabled((UINT32)channel, getSeverity(channel) >= minSeverity);
+		}
+	}
+
+	void Logger::setRateLimit(UINT32 channel, UINT32 maxMessages)
+	{
+		if (channel >= MAX_FILTERED_CHANNELS)
+		{
+			LS_EXCEPT(InvalidParametersException, "Only channels below " + toString(MAX_FILTERED_CHANNELS) + 
+				" can be rate limited.");
+		}
+
+		mRateLimits[channel].store(maxMessages, std::memory_order_relaxed);
+	}
+
+	bool Logger::checkRateLimit(LogCallSite& site, UINT32 maxMessages)
+	{
+		const UINT64 now = mTimer.getMilliseconds();
+		const UINT32 interval = mRateLimitInterval.load(std::memory_order_relaxed);
+
+		// Only one of the threads logging at the same time starts the new interval, and reports the dropped messages
+		UINT64 windowStart = site.windowStart.load(std::memory_order_relaxed);
+		if ((now - windowStart) >= interval && 
+			site.windowStart.compare_exchange_strong(windowStart, now, std::memory_order_relaxed))
+		{
+			site.numInWindow.store(0, std::memory_order_relaxed);
+			reportSuppressed(site);
+		}
+
+		if (site.numInWindow.fetch_add(1, std::memory_order_relaxed) < maxMessages)
+			return true;
+
+		site.numSuppressed.fetch_add(1, std::memory_order_relaxed);
+
+		// Track the call site so its dropped messages get reported even if it stops logging
+		if (!site.isTracked.exchange(true, std::memory_order_relaxed))
+		{
+			site.nextTracked = mTrackedSites.load(std::memory_order_relaxed);
+			while (!mTrackedSites.compare_exchange_weak(site.nextTracked, &site, std::memory_order_release,
+				std::memory_order_relaxed))
+			{ }
+		}
+
+		return false;
+	}
+
+	void Logger::reportSuppressed(LogCallSite& site)
+	{
+		const UINT32 numSuppressed = site.numSuppressed.exchange(0, std::memory_order_relaxed);
+		if (numSuppressed == 0)
+			return;
+
+		const String message = "Dropped " + toString(numSuppressed) + " message(s) logged here after exceeding the "
+			"rate limit.";
+
+		logEntry(&site, site.channel, message.data(), (UINT32)message.size());
+	}
+
+	void Logger::reportAllSuppressed(bool endedOnly)
+	{
+		const UINT64 now = mTimer.getMilliseconds();
+		const UINT32 interval = mRateLimitInterval.load(std::memory_order_relaxed);
+
+		for (LogCallSite* site = mTrackedSites.load(std::memory_order_acquire); site != nullptr; site = site->nextTracked)
+		{
+			if (endedOnly && (now - site->windowStart.load(std::memory_order_relaxed)) < interval)
+				continue;
+
+			reportSuppressed(*site);
+		}
+	}
+
+	void Logger::setLogFile(const Path& path, const LogFileOptions& options)
+	{
+		Lock lock(mSinkMutex);
+
+		if (path.isEmpty())
+			mLogFile = nullptr;
+		else
+			mLogFile = ls_shared_ptr_new<LogFile>(path, options);
+	}
+
+	void Logger::_startAsync()
+	{
+		if (mAsyncRunning.load(std::memory_order_relaxed))
+			return;
+
+		{
+			Lock lock(mAsyncMutex);
+			mAsyncShutdown = false;
+			mAsyncWake = false;
+		}
+
+		mAsyncThread = ThreadPool::instance().run("Logger", std::bind(&Logger::runAsync, this));
+		mAsyncRunning.store(true, std::memory_order_seq_cst);
+	}
+
+	void Logger::_stopAsync()
+	{
+		if (!mAsyncRunning.load(std::memory_order_relaxed))
+			return;
+
+		reportAllSuppressed(false);
+
+		// Threads that queue an entry after this point will see the flag when they check it again, and process their
+		// entries themselves
+		mAsyncRunning.store(false, std::memory_order_seq_cst);
+
+		{
+			Lock lock(mAsyncMutex);
+			mAsyncShutdown = true;
+		}
+
+		mAsyncSignal.notify_one();
+		mAsyncThread.blockUntilComplete();
+
+		flush();
+	}
+
+	void Logger::runAsync()
+	{
+		while (true)
+		{
+			bool shutdown;
+			{
+				Lock lock(mAsyncMutex);
+
+				if (!mAsyncShutdown && !mAsyncWake)
+					mAsyncSignal.wait_for(lock, std::chrono::milliseconds(ASYNC_POLL_INTERVAL_MS));
+
+				mAsyncWake = false;
+				shutdown = mAsyncShutdown;
+			}
+
+			flush();
+			reportAllSuppressed(true);
+
+			if (shutdown)
+				break;
+		}
 	}
 
 	void Logger::writeAsBMP(UINT8* rawPixels, UINT32 bytesPerPixel, UINT32 width, UINT32 height, const Path& filePath,
@@ -90,8 +623,12 @@ namespace ls
 		}
 	}
 
-	void Logger::saveLog(const Path& path) const
+	void Logger::saveLog(const Path& path)
 	{
+		// Make sure the entries still queued by other threads, and the number of dropped messages are included
+		reportAllSuppressed(false);
+		flush();
+
 		static const char* style =
 			R"(html {
   font-family: sans-serif;
@@ -208,6 +745,8 @@ table td
 </body>
 </html>)";
 
+		SPtr<DataStream> fileStream = FileSystem::createAndOpenFile(path);
+
 		StringStream stream;
 		stream << htmlPreStyleHeader;
 		stream << style;
@@ -236,53 +775,67 @@ table td
 
 		// Write log entries
 		stream << "<h2>Log entries</h2>\n";
+
+		const UINT64 numDiscarded = mLog.getNumDiscarded();
+		if (numDiscarded > 0)
+			stream << "<p>" << numDiscarded << " older entries were discarded.</p>\n";
+
 		stream << htmlEntriesTableHeader;
+		fileStream->writeString(stream.str());
+
+		// Entries are written in batches, so the whole log is never held in memory as text
+		String buffer;
+		buffer.reserve(SAVE_LOG_BUFFER_SIZE);
 
 		bool alternate = false;
 		Vector<LogEntry> entries = mLog.getAllEntries();
 		for (auto& entry : entries)
 		{
-			String channelName;
+			const char* rowClass;
+			const char* typeName;
 			if (entry.getChannel() == (UINT32)DebugChannel::Error || entry.getChannel() == (UINT32)DebugChannel::CompilerError)
 			{
-				if (!alternate)
-					stream << R"(		<tr class="error-row">)" << std::endl;
-				else
-					stream << R"(		<tr class="error-alt-row">)" << std::endl;
-
-				stream << R"(			<td>Error</td>)" << std::endl;
+				rowClass = alternate ? "error-alt-row" : "error-row";
+				typeName = "Error";
 			}
 			else if (entry.getChannel() == (UINT32)DebugChannel::Warning || entry.getChannel() == (UINT32)DebugChannel::CompilerWarning)
 			{
-				if (!alternate)
-					stream << R"(		<tr class="warn-row">)" << std::endl;
-				else
-					stream << R"(		<tr class="warn-alt-row">)" << std::endl;
-
-				stream << R"(			<td>Warning</td>)" << std::endl;
+				rowClass = alternate ? "warn-alt-row" : "warn-row";
+				typeName = "Warning";
 			}
 			else
 			{
-				if (!alternate)
-					stream << R"(		<tr class="debug-row">)" << std::endl;
-				else
-					stream << R"(		<tr class="debug-alt-row">)" << std::endl;
+				rowClass = alternate ? "debug-alt-row" : "debug-row";
+				typeName = "Debug";
+			}
+
+			buffer += "\t\t<tr class=\"";
+			buffer += rowClass;
+			buffer += "\">\n\t\t\t<td>";
+			buffer += typeName;
+			buffer += "</td>\n\t\t\t<td>";
 
-				stream << R"(			<td>Debug</td>)" << std::endl;
+			for (char c : entry.getMessage())
+			{
+				if (c == '\n')
+					buffer += "<br>\n";
+				else
+					buffer += c;
 			}
 
-			String parsedMessage = StringUtil::replaceAll(entry.getMessage(), "\n", "<br>\n");
+			buffer += "</td>\n\t\t</tr>\n";
 
-			stream << R"(			<td>)" << parsedMessage << "</td>" << std::endl;
-			stream << R"(		</tr>)" << std::endl;
+			if (buffer.size() >= SAVE_LOG_BUFFER_SIZE)
+			{
+				fileStream->write(buffer.data(), buffer.size());
+				buffer.clear();
+			}
 
 			alternate = !alternate;
 		}
 
-		stream << htmlFooter;
-
-		SPtr<DataStream> fileStream = FileSystem::createAndOpenFile(path);
-		fileStream->writeString(stream.str());
+		buffer += htmlFooter;
+		fileStream->write(buffer.data(), buffer.size());
 	}
 
 	LS_UTILITY_EXPORT Logger& gLogger()
@@ -2,6 +2,9 @@
 
 #include "Prerequisites/LSPrerequisitesUtil.h"
 #include "Logger/LSLog.h"
+#include "Logger/LSLogFile.h"
+#include "Thread/LSThreadPool.h"
+#include "General/LSTimer.h"
 
 namespace ls
 {
@@ -17,15 +20,43 @@ namespace ls
 		Debug, Warning, Error, CompilerWarning, CompilerError
 	};
 
+	/** 
+	 * Location in code that logs messages. The LOG* macros create a single static instance per call site, so the 
+	 * location doesn't need to be copied or formatted when a message is logged. Also keeps track of the messages logged
+	 * from the location, for rate limiting.
+	 */
+	struct LogCallSite
+	{
+		const char* function;
+		const char* file;
+		UINT32 line;
+		UINT32 channel;
+
+		std::atomic<UINT64> windowStart; /**< Time the current rate limiting interval started at, in milliseconds. */
+		std::atomic<UINT32> numInWindow; /**< Number of messages logged in the current rate limiting interval. */
+		std::atomic<UINT32> numSuppressed; /**< Number of messages dropped by rate limiting that weren't reported yet. */
+		std::atomic<bool> isTracked; /**< True once added to the list of call sites that dropped messages. */
+		LogCallSite* nextTracked; /**< Next call site in the list of call sites that dropped messages. */
+	};
+
 	/**
 	 * Utility class providing various debug functionality.
 	 *
+	 * Once _startAsync() is called, logging a message only copies it into a buffer owned by the calling thread. The
+	 * messages are formatted and added to the log, console and log file on a background thread. Until then, and if a
+	 * thread's buffer is full, messages are processed immediately on the logging thread.
+	 *
+	 * Messages logged through the LOG* macros can be filtered per channel before their arguments are evaluated, and are
+	 * rate limited per call site, see setChannelEnabled() and setRateLimit(). Channels below LS_LOG_MIN_LEVEL are removed
+	 * at compile time.
+	 *
 	 * @note	Thread safe.
 	 */
 	class LS_UTILITY_EXPORT Logger
 	{
 	public:
-		Logger() = default;
+		Logger();
+		~Logger();
 
 		/** Adds a log entry in the "Debug" channel. */
 		void logLogger(const String& msg);
@@ -39,6 +70,59 @@ namespace ls
 		/** Adds a log entry in the specified channel. You may specify custom channels as needed. */
 		void log(const String& msg, UINT32 channel);
 
+		/** Adds a log entry in the channel of the provided call site, followed by the call site location. */
+		void log(const LogCallSite& site, const String& msg);
+
+		/** @copydoc log(const LogCallSite&, const String&) */
+		void log(const LogCallSite& site, const char* msg);
+
+		/** Enables or disables a channel. Messages logged to a disabled channel are discarded. */
+		void setChannelEnabled(UINT32 channel, bool enabled);
+
+		/** Checks if messages logged to the channel are kept. Channels above MAX_FILTERED_CHANNELS are always enabled. */
+		bool isChannelEnabled(UINT32 channel) const
+		{
+			if (channel >= MAX_FILTERED_CHANNELS)
+				return true;
+
+			return (mDisabledChannels.load(std::memory_order_relaxed) & (1U << channel)) == 0;
+		}
+
+		/** 
+		 * Disables the built-in channels less severe than the provided one, and enables the rest. Severity increases
+		 * from debug to warning to error. Compiler warnings and errors have the same severity as warnings and errors.
+		 */
+		void setMinimumSeverity(DebugChannel severity);
+
+		/**
+		 * Limits how many messages a single call site can log to a channel during each interval. Once a call site exceeds
+		 * the limit its messages are dropped until the interval ends, after which a single entry reports how many were 
+		 * dropped. Only applies to messages logged through the LOG* macros.
+		 *
+		 * @param[in]	channel		Channel to limit. Must be below MAX_FILTERED_CHANNELS.
+		 * @param[in]	maxMessages	Maximum number of messages per call site and interval, or 0 for no limit.
+		 */
+		void setRateLimit(UINT32 channel, UINT32 maxMessages);
+
+		/** Sets the length of the interval used by setRateLimit(), in milliseconds. */
+		void setRateLimitInterval(UINT32 milliseconds) { mRateLimitInterval.store(milliseconds, std::memory_order_relaxed); }
+
+		/** Enables or disables printing log entries to the console. Entries are still added to the log and log file. */
+		void setConsoleOutput(bool enabled) { mConsoleOutput.store(enabled, std::memory_order_relaxed); }
+
+		/** 
+		 * Processes all pending log entries, so they are added to the log, console and log file before returning. The log
+		 * file is flushed to disk as well.
+		 */
+		void flush();
+
+		/** 
+		 * Starts writing all log entries to a text file, in addition to keeping them in the log. Unlike the log the file
+		 * keeps the entire history, split over multiple files according to @p options. Provide an empty path to stop 
+		 * writing to the file.
+		 */
+		void setLogFile(const Path& path, const LogFileOptions& options = LogFileOptions());
+
 		/** Retrieves the Log used by the Debug instance. */
 		Log& getLog() { return mLog; }
 
@@ -51,7 +135,7 @@ namespace ls
 		 * 
 		 * @param	path	Absolute path to the log filename.
 		 */
-		void saveLog(const Path& path) const;
+		void saveLog(const Path& path);
 
 		/**
 		 * Triggered when a new entry in the log is added.
@@ -79,23 +163,159 @@ namespace ls
 		 */
 		void _triggerCallbacks();
 
+		/** 
+		 * Starts processing log entries on a background thread, run through the ThreadPool. Must be paired with a call
+		 * to _stopAsync() before the ThreadPool is shut down.
+		 */
+		void _startAsync();
+
+		/** Processes all pending log entries and stops the background thread started by _startAsync(). */
+		void _stopAsync();
+
+		/** 
+		 * Checks if a message from the call site should be logged, according to its channel and rate limit. Used by the
+		 * LOG* macros before evaluating the message.
+		 */
+		bool _shouldLog(LogCallSite& site)
+		{
+			if (!isChannelEnabled(site.channel))
+				return false;
+
+			if (site.channel >= MAX_FILTERED_CHANNELS)
+				return true;
+
+			const UINT32 maxMessages = mRateLimits[site.channel].load(std::memory_order_relaxed);
+			if (maxMessages == 0)
+				return true;
+
+			return checkRateLimit(site, maxMessages);
+		}
+
+		/** Number of channels that can be disabled or rate limited, starting from channel 0. */
+		static constexpr UINT32 MAX_FILTERED_CHANNELS = 32;
+
+		/** Number of messages a call site can log to a channel per interval by default. */
+		static constexpr UINT32 DEFAULT_RATE_LIMIT = 50;
+
+		/** Default length of the rate limiting interval, in milliseconds. */
+		static constexpr UINT32 DEFAULT_RATE_LIMIT_INTERVAL_MS = 1000;
+
 		/** @} */
 	private:
+		struct ThreadBuffer;
+		struct ThreadBufferGuard;
+
+		/** Logs a message, either by queuing it in the calling thread's buffer, or by processing it immediately. */
+		void logEntry(const LogCallSite* site, UINT32 channel, const char* msg, UINT32 length);
+
+		/** Returns the buffer of the calling thread, creating it if needed. */
+		ThreadBuffer* getThreadBuffer();
+
+		/** Returns the buffers claimed by the calling thread for all loggers. */
+		static ThreadBufferGuard& getClaimedBuffers();
+
+		/** Processes all entries queued in thread buffers. Caller must hold mSinkMutex. */
+		void processBuffers();
+
+		/** Formats an entry and adds it to the log, console and log file. Caller must hold mSinkMutex. */
+		void writeEntry(const LogCallSite* site, UINT32 channel, const char* msg, UINT32 length);
+
+		/** Main loop of the background thread. */
+		void runAsync();
+
+		/** 
+		 * Counts a message against the rate limit of the call site, starting a new interval if the current one ended.
+		 * Returns false if the message should be dropped.
+		 */
+		bool checkRateLimit(LogCallSite& site, UINT32 maxMessages);
+
+		/** Logs an entry reporting the number of messages the call site dropped since the last report, if any. */
+		void reportSuppressed(LogCallSite& site);
+
+		/** 
+		 * Reports the dropped messages of all call sites. If @p endedOnly is true only call sites whose rate limiting
+		 * interval ended are reported.
+		 */
+		void reportAllSuppressed(bool endedOnly);
+
 		UINT64 mLogHash = 0;
 		Log mLog;
+
+		/** Unique for every logger ever created, so a thread never uses a buffer of a destroyed logger. */
+		UINT64 mInstanceId = 0;
+
+		std::atomic<ThreadBuffer*> mThreadBuffers{nullptr};
+		std::atomic<bool> mAsyncRunning{false};
+
+		HThread mAsyncThread;
+		bool mAsyncShutdown = false;
+		bool mAsyncWake = false;
+		Mutex mAsyncMutex;
+		Signal mAsyncSignal;
+
+		Mutex mSinkMutex;
+		SPtr<LogFile> mLogFile;
+
+		std::atomic<bool> mConsoleOutput{true};
+		std::atomic<UINT32> mDisabledChannels{0};
+		std::atomic<UINT32> mRateLimits[MAX_FILTERED_CHANNELS];
+		std::atomic<UINT32> mRateLimitInterval{DEFAULT_RATE_LIMIT_INTERVAL_MS};
+		std::atomic<LogCallSite*> mTrackedSites{nullptr};
+		Timer mTimer;
+
+		/** Size of the buffer each thread queues its entries in, in bytes. */
+		static constexpr UINT32 THREAD_BUFFER_SIZE = 64 * 1024;
+
+		/** Longest message that is queued. Longer messages are processed immediately. */
+		static constexpr UINT32 MAX_QUEUED_MESSAGE_SIZE = THREAD_BUFFER_SIZE / 8;
+
+		/** Maximum time the background thread waits before checking the thread buffers, in milliseconds. */
+		static constexpr UINT32 ASYNC_POLL_INTERVAL_MS = 5;
+
+		/** Amount of text saveLog() collects before writing it to the file, in bytes. */
+		static constexpr UINT32 SAVE_LOG_BUFFER_SIZE = 64 * 1024;
 	};
 
 	/** A simpler way of accessing the Debug module. */
 	LS_UTILITY_EXPORT Logger& gLogger();
 
+/** 
+ * Logs a message to the provided logger and channel, along with the location of the call. The message is only evaluated
+ * if the channel is enabled and the call site didn't exceed its rate limit.
+ */
+#define LS_LOG_TO(logger, x, channel)																		\
+	do																										\
+	{																										\
+		static ls::LogCallSite _lsLogCallSite = { __PRETTY_FUNCTION__, __FILE__, __LINE__, (ls::UINT32)(channel),	\
+			{0}, {0}, {0}, {false}, nullptr };																\
+		ls::Logger& _lsLogger = (logger);																	\
+		if (_lsLogger._shouldLog(_lsLogCallSite))															\
+			_lsLogger.log(_lsLogCallSite, (x));																\
+	} while(0)
+
+/** Logs a message on the provided channel, along with the location of the call. */
+#define LS_LOG_CHANNEL(x, channel) LS_LOG_TO(ls::gLogger(), x, channel)
+
+#if LS_LOG_MIN_LEVEL <= 0
 /** Shortcut for logging a message in the debug channel. */
-#define LOGDBG(x) ls::gLogger().logLogger((x) + ls::String("\n\t\t in ") + __PRETTY_FUNCTION__ + " [" + __FILE__ + ":" + ls::toString(__LINE__) + "]\n");
+#define LOGDBG(x) LS_LOG_CHANNEL(x, ls::DebugChannel::Debug)
+#else
+#define LOGDBG(x) ((void)0)
+#endif
 
+#if LS_LOG_MIN_LEVEL <= 1
 /** Shortcut for logging a message in the warning channel. */
-#define LOGWRN(x) ls::gLogger().logWarning((x) + ls::String("\n\t\t in ") + __PRETTY_FUNCTION__ + " [" + __FILE__ + ":" + ls::toString(__LINE__) + "]\n");
+#define LOGWRN(x) LS_LOG_CHANNEL(x, ls::DebugChannel::Warning)
+#else
+#define LOGWRN(x) ((void)0)
+#endif
 
+#if LS_LOG_MIN_LEVEL <= 2
 /** Shortcut for logging a message in the error channel. */
-#define LOGERR(x) ls::gLogger().logError((x) + ls::String("\n\t\t in ") + __PRETTY_FUNCTION__ + " [" + __FILE__ + ":" + ls::toString(__LINE__) + "]\n");
+#define LOGERR(x) LS_LOG_CHANNEL(x, ls::DebugChannel::Error)
+#else
+#define LOGERR(x) ((void)0)
+#endif
 
 /** Shortcut for logging a verbose message in the debug channel. Verbose messages can be ignored unlike other log messages. */
 #define LOGDBG_VERBOSE(x) ((void)0)
@@ -13,6 +13,27 @@
 
 #define LS_PROFILING_ENABLED 1
 
+// 0 - General allocations use the standard malloc/free
+// 1 - General allocations use a TLSF MemPool owned by the calling thread
+#ifndef LS_USE_MEMPOOL
+#define LS_USE_MEMPOOL 0
+#endif
+
+// 0 - Only the number of allocations and frees is counted
+// 1 - Allocations are tracked per allocator category and call site, see MemAllocProfiler
+#ifndef LS_MEMORY_TRACKING
+#define LS_MEMORY_TRACKING 0
+#endif
+
+// Least severe log messages compiled in by the LOGDBG/LOGWRN/LOGERR macros, the rest are removed along with their arguments
+// 0 - Debug messages, warnings and errors
+// 1 - Warnings and errors
+// 2 - Errors only
+// 3 - None
+#ifndef LS_LOG_MIN_LEVEL
+#define LS_LOG_MIN_LEVEL 0
+#endif
+
 // Config from the build system
 //#include <LSFrameworkConfig.h> Todo
 
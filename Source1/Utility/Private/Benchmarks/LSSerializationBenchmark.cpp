@@ -0,0 +1,633 @@
+#include "Private/Benchmarks/LSSerializationBenchmark.h"
+#include "Reflection/LSRTTIType.h"
+#include "Serialization/LSBinarySerializer.h"
+#include "Serialization/LSMemorySerializer.h"
+#include "Serialization/LSFileSerializer.h"
+#include "Serialization/LSBinaryCloner.h"
+#include "Serialization/LSBinaryDiff.h"
+#include "Serialization/LSSerializedObject.h"
+#include "FileSystem/LSDataStream.h"
+#include "FileSystem/LSFileSystem.h"
+#include "General/LSTimer.h"
+#include "Allocators/LSMemAllocProfiler.h"
+#include "Thread/LSTaskScheduler.h"
+
+#include <iomanip>
+
+namespace ls
+{
+	enum TypeID_SerializationBenchmark
+	{
+		TID_BenchWideStruct = 60000,
+		TID_BenchNode = 60001,
+		TID_BenchArrays = 60002,
+		TID_BenchDataBlock = 60003
+	};
+
+	/** Structure with many plain fields of various types. */
+	class BenchWideStruct : public IReflectable
+	{
+	public:
+		UINT32 u0 = 0, u1 = 0, u2 = 0, u3 = 0, u4 = 0, u5 = 0, u6 = 0, u7 = 0;
+		float f0 = 0.0f, f1 = 0.0f, f2 = 0.0f, f3 = 0.0f;
+		UINT64 l0 = 0, l1 = 0;
+		String s0, s1;
+
+		/** Fills all fields with values derived from @p seed. */
+		void fill(UINT32 seed)
+		{
+			u0 = seed; u1 = seed * 3; u2 = seed * 5; u3 = seed * 7;
+			u4 = seed ^ 0xFF; u5 = seed + 11; u6 = seed + 13; u7 = seed + 17;
+			f0 = seed * 0.5f; f1 = seed * 0.25f; f2 = seed * 2.0f; f3 = seed * 4.0f;
+			l0 = (UINT64)seed << 32; l1 = ~(UINT64)seed;
+			s0 = "WideStructName" + toString(seed);
+			s1 = "A somewhat longer string value stored in the structure";
+		}
+
+		friend class BenchWideStructRTTI;
+		static RTTITypeBase* getRTTIStatic();
+		RTTITypeBase* getRTTI() const override;
+	};
+
+	class BenchWideStructRTTI : public RTTIType<BenchWideStruct, IReflectable, BenchWideStructRTTI>
+	{
+	private:
+		LS_BEGIN_RTTI_MEMBERS
+			LS_RTTI_MEMBER_PLAIN(u0, 0)
+			LS_RTTI_MEMBER_PLAIN(u1, 1)
+			LS_RTTI_MEMBER_PLAIN(u2, 2)
+			LS_RTTI_MEMBER_PLAIN(u3, 3)
+			LS_RTTI_MEMBER_PLAIN(u4, 4)
+			LS_RTTI_MEMBER_PLAIN(u5, 5)
+			LS_RTTI_MEMBER_PLAIN(u6, 6)
+			LS_RTTI_MEMBER_PLAIN(u7, 7)
+			LS_RTTI_MEMBER_PLAIN(f0, 8)
+			LS_RTTI_MEMBER_PLAIN(f1, 9)
+			LS_RTTI_MEMBER_PLAIN(f2, 10)
+			LS_RTTI_MEMBER_PLAIN(f3, 11)
+			LS_RTTI_MEMBER_PLAIN(l0, 12)
+			LS_RTTI_MEMBER_PLAIN(l1, 13)
+			LS_RTTI_MEMBER_PLAIN(s0, 14)
+			LS_RTTI_MEMBER_PLAIN(s1, 15)
+		LS_END_RTTI_MEMBERS
+
+	public:
+		const String& getRTTIName() override
+		{
+			static String name = "BenchWideStruct";
+			return name;
+		}
+
+		UINT32 getRTTIId() override
+		{
+			return TID_BenchWideStruct;
+		}
+
+		SPtr<IReflectable> newRTTIObject() override
+		{
+			return ls_shared_ptr_new<BenchWideStruct>();
+		}
+	};
+
+	RTTITypeBase* BenchWideStruct::getRTTIStatic()
+	{
+		return BenchWideStructRTTI::instance();
+	}
+
+	RTTITypeBase* BenchWideStruct::getRTTI() const
+	{
+		return BenchWideStruct::getRTTIStatic();
+	}
+
+	/** Node in a graph of objects referencing each other through pointers. */
+	class BenchNode : public IReflectable
+	{
+	public:
+		UINT32 id = 0;
+		float weight = 0.0f;
+		SPtr<BenchNode> link;
+		Vector<SPtr<BenchNode>> children;
+
+		friend class BenchNodeRTTI;
+		static RTTITypeBase* getRTTIStatic();
+		RTTITypeBase* getRTTI() const override;
+	};
+
+	class BenchNodeRTTI : public RTTIType<BenchNode, IReflectable, BenchNodeRTTI>
+	{
+	private:
+		LS_BEGIN_RTTI_MEMBERS
+			LS_RTTI_MEMBER_PLAIN(id, 0)
+			LS_RTTI_MEMBER_PLAIN(weight, 1)
+			LS_RTTI_MEMBER_REFLPTR(link, 2)
+			LS_RTTI_MEMBER_REFLPTR_ARRAY(children, 3)
+		LS_END_RTTI_MEMBERS
+
+	public:
+		const String& getRTTIName() override
+		{
+			static String name = "BenchNode";
+			return name;
+		}
+
+		UINT32 getRTTIId() override
+		{
+			return TID_BenchNode;
+		}
+
+		SPtr<IReflectable> newRTTIObject() override
+		{
+			return ls_shared_ptr_new<BenchNode>();
+		}
+	};
+
+	RTTITypeBase* BenchNode::getRTTIStatic()
+	{
+		return BenchNodeRTTI::instance();
+	}
+
+	RTTITypeBase* BenchNode::getRTTI() const
+	{
+		return BenchNode::getRTTIStatic();
+	}
+
+	/** Object containing a large plain array and a large array of structures. */
+	class BenchArrays : public IReflectable
+	{
+	public:
+		Vector<float> values;
+		Vector<BenchWideStruct> structs;
+
+		friend class BenchArraysRTTI;
+		static RTTITypeBase* getRTTIStatic();
+		RTTITypeBase* getRTTI() const override;
+	};
+
+	class BenchArraysRTTI : public RTTIType<BenchArrays, IReflectable, BenchArraysRTTI>
+	{
+	private:
+		LS_BEGIN_RTTI_MEMBERS
+			LS_RTTI_MEMBER_PLAIN_ARRAY(values, 0)
+			LS_RTTI_MEMBER_REFL_ARRAY(structs, 1)
+		LS_END_RTTI_MEMBERS
+
+	public:
+		const String& getRTTIName() override
+		{
+			static String name = "BenchArrays";
+			return name;
+		}
+
+		UINT32 getRTTIId() override
+		{
+			return TID_BenchArrays;
+		}
+
+		SPtr<IReflectable> newRTTIObject() override
+		{
+			return ls_shared_ptr_new<BenchArrays>();
+		}
+	};
+
+	RTTITypeBase* BenchArrays::getRTTIStatic()
+	{
+		return BenchArraysRTTI::instance();
+	}
+
+	RTTITypeBase* BenchArrays::getRTTI() const
+	{
+		return BenchArrays::getRTTIStatic();
+	}
+
+	/** Object containing a large blob of binary data. */
+	class BenchDataBlock : public IReflectable
+	{
+	public:
+		UINT32 format = 0;
+		Vector<UINT8> data;
+
+		friend class BenchDataBlockRTTI;
+		static RTTITypeBase* getRTTIStatic();
+		RTTITypeBase* getRTTI() const override;
+	};
+
+	class BenchDataBlockRTTI : public RTTIType<BenchDataBlock, IReflectable, BenchDataBlockRTTI>
+	{
+	private:
+		UINT32& getFormat(BenchDataBlock* obj) { return obj->format; }
+		void setFormat(BenchDataBlock* obj, UINT32& val) { obj->format = val; }
+
+		SPtr<DataStream> getData(BenchDataBlock* obj, UINT32& size)
+		{
+			size = (UINT32)obj->data.size();
+			return ls_shared_ptr_new<MemoryDataStream>(obj->data.data(), obj->data.size(), false);
+		}
+
+		void setData(BenchDataBlock* obj, const SPtr<DataStream>& value, UINT32 size)
+		{
+			obj->data.resize(size);
+			value->read(obj->data.data(), size);
+		}
+
+	public:
+		BenchDataBlockRTTI()
+		{
+			addPlainField("format", 0, &BenchDataBlockRTTI::getFormat, &BenchDataBlockRTTI::setFormat);
+			addDataBlockField("data", 1, &BenchDataBlockRTTI::getData, &BenchDataBlockRTTI::setData);
+		}
+
+		const String& getRTTIName() override
+		{
+			static String name = "BenchDataBlock";
+			return name;
+		}
+
+		UINT32 getRTTIId() override
+		{
+			return TID_BenchDataBlock;
+		}
+
+		SPtr<IReflectable> newRTTIObject() override
+		{
+			return ls_shared_ptr_new<BenchDataBlock>();
+		}
+	};
+
+	RTTITypeBase* BenchDataBlock::getRTTIStatic()
+	{
+		return BenchDataBlockRTTI::instance();
+	}
+
+	RTTITypeBase* BenchDataBlock::getRTTI() const
+	{
+		return BenchDataBlock::getRTTIStatic();
+	}
+
+	/** A root object to run the serialization paths on, along with a slightly modified copy used for diffing. */
+	struct SerializationBenchmark::DataSet
+	{
+		String name;
+		SPtr<IReflectable> object;
+		SPtr<IReflectable> modified;
+		UINT64 numObjects = 0;
+		UINT32 iterations = 0;
+	};
+
+	/** Depth and number of children per node of the tree in the graph data set. */
+	static constexpr UINT32 GRAPH_DEPTH = 6;
+	static constexpr UINT32 GRAPH_BRANCHING = 4;
+
+	static constexpr UINT32 NUM_ARRAY_VALUES = 256 * 1024;
+	static constexpr UINT32 NUM_ARRAY_STRUCTS = 2048;
+	static constexpr UINT32 DATA_BLOCK_SIZE = 16 * 1024 * 1024;
+
+	/** Size of the buffer BinarySerializer encodes into, before the contents are discarded. */
+	static constexpr UINT32 ENCODE_BUFFER_SIZE = 64 * 1024;
+
+	/**
+	 * Builds a tree of nodes. Each node also links to a leaf created earlier, so some nodes are referenced from
+	 * multiple places.
+	 */
+	static SPtr<BenchNode> createGraph(UINT32 depth, UINT32& nextId, SPtr<BenchNode>& lastLeaf)
+	{
+		SPtr<BenchNode> node = ls_shared_ptr_new<BenchNode>();
+		node->id = nextId++;
+		node->weight = node->id * 0.5f;
+		node->link = lastLeaf;
+
+		if (depth == 0)
+		{
+			node->link = nullptr;
+			lastLeaf = node;
+			return node;
+		}
+
+		for (UINT32 i = 0; i < GRAPH_BRANCHING; i++)
+			node->children.push_back(createGraph(depth - 1, nextId, lastLeaf));
+
+		return node;
+	}
+
+	/** Returns a leaf of the graph, following the first child at every level. */
+	static BenchNode* getFirstLeaf(BenchNode* node)
+	{
+		while (!node->children.empty())
+			node = node->children[0].get();
+
+		return node;
+	}
+
+	static SPtr<BenchArrays> createArrays()
+	{
+		SPtr<BenchArrays> arrays = ls_shared_ptr_new<BenchArrays>();
+
+		arrays->values.resize(NUM_ARRAY_VALUES);
+		for (UINT32 i = 0; i < NUM_ARRAY_VALUES; i++)
+			arrays->values[i] = i * 0.125f;
+
+		arrays->structs.resize(NUM_ARRAY_STRUCTS);
+		for (UINT32 i = 0; i < NUM_ARRAY_STRUCTS; i++)
+			arrays->structs[i].fill(i);
+
+		return arrays;
+	}
+
+	static SPtr<BenchDataBlock> createDataBlock()
+	{
+		SPtr<BenchDataBlock> dataBlock = ls_shared_ptr_new<BenchDataBlock>();
+		dataBlock->format = 1;
+		dataBlock->data.resize(DATA_BLOCK_SIZE);
+
+		for (UINT32 i = 0; i < DATA_BLOCK_SIZE; i++)
+			dataBlock->data[i] = (UINT8)(i * 31);
+
+		return dataBlock;
+	}
+
+	double SerializationBenchmarkResult::getMBPerSecond() const
+	{
+		if (microseconds == 0)
+			return 0.0;
+
+		return (bytes / (1024.0 * 1024.0)) / (microseconds / 1000000.0);
+	}
+
+	double SerializationBenchmarkResult::getObjectsPerSecond() const
+	{
+		if (microseconds == 0)
+			return 0.0;
+
+		return objects / (microseconds / 1000000.0);
+	}
+
+	double SerializationBenchmarkResult::getAllocsPerObject() const
+	{
+		if (objects == 0)
+			return 0.0;
+
+		return allocs / (double)objects;
+	}
+
+	SerializationBenchmark::SerializationBenchmark(float scale, const Path& tempFolder)
+		:mScale(scale), mTempFolder(tempFolder)
+	{ }
+
+	void SerializationBenchmark::run()
+	{
+		mResults.clear();
+
+		if (!FileSystem::exists(mTempFolder))
+			FileSystem::createDir(mTempFolder);
+
+		auto scaleIterations = [this](UINT32 iterations)
+		{
+			return std::max(1U, (UINT32)(iterations * mScale));
+		};
+
+		{
+			DataSet dataSet;
+			dataSet.name = "WideStruct";
+
+			SPtr<BenchWideStruct> object = ls_shared_ptr_new<BenchWideStruct>();
+			object->fill(1);
+
+			SPtr<BenchWideStruct> modified = ls_shared_ptr_new<BenchWideStruct>();
+			modified->fill(1);
+			modified->u3 = 0;
+
+			dataSet.object = object;
+			dataSet.modified = modified;
+			dataSet.numObjects = 1;
+			dataSet.iterations = scaleIterations(20000);
+
+			runDataSet(dataSet);
+		}
+
+		{
+			DataSet dataSet;
+			dataSet.name = "Graph";
+
+			UINT32 nextId = 0;
+			SPtr<BenchNode> lastLeaf;
+			SPtr<BenchNode> object = createGraph(GRAPH_DEPTH, nextId, lastLeaf);
+
+			UINT32 numObjects = nextId;
+			nextId = 0;
+			lastLeaf = nullptr;
+
+			SPtr<BenchNode> modified = createGraph(GRAPH_DEPTH, nextId, lastLeaf);
+			getFirstLeaf(modified.get())->weight = -1.0f;
+
+			dataSet.object = object;
+			dataSet.modified = modified;
+			dataSet.numObjects = numObjects;
+			dataSet.iterations = scaleIterations(50);
+
+			runDataSet(dataSet);
+		}
+
+		{
+			DataSet dataSet;
+			dataSet.name = "Arrays";
+
+			SPtr<BenchArrays> modified = createArrays();
+			modified->values[NUM_ARRAY_VALUES / 2] = -1.0f;
+			modified->structs[NUM_ARRAY_STRUCTS / 2].u0 = 0;
+
+			dataSet.object = createArrays();
+			dataSet.modified = modified;
+			dataSet.numObjects = 1 + NUM_ARRAY_STRUCTS;
+			dataSet.iterations = scaleIterations(20);
+
+			runDataSet(dataSet);
+		}
+
+		{
+			DataSet dataSet;
+			dataSet.name = "DataBlock";
+
+			SPtr<BenchDataBlock> modified = createDataBlock();
+			modified->data[DATA_BLOCK_SIZE / 2] ^= 0xFF;
+
+			dataSet.object = createDataBlock();
+			dataSet.modified = modified;
+			dataSet.numObjects = 1;
+			dataSet.iterations = scaleIterations(20);
+
+			runDataSet(dataSet);
+		}
+	}
+
+	void SerializationBenchmark::runDataSet(const DataSet& dataSet)
+	{
+		IReflectable* object = dataSet.object.get();
+
+		MemorySerializer memorySerializer;
+		MemorySerializerBuffer encoded;
+		UINT32 encodedSize = memorySerializer.encode(object, encoded);
+
+		// BinarySerializer
+		{
+			UINT8* buffer = (UINT8*)ls_alloc(ENCODE_BUFFER_SIZE);
+
+			measure("BinarySerializer::encode", dataSet, encodedSize, [&]()
+			{
+				BinarySerializer bs;
+
+				UINT32 bytesWritten = 0;
+				bs.encode(object, buffer, ENCODE_BUFFER_SIZE, &bytesWritten,
+					[buffer](UINT8* bufferStart, UINT32 bytesWritten, UINT32& newBufferSize)
+				{
+					newBufferSize = ENCODE_BUFFER_SIZE;
+					return buffer;
+				});
+			});
+
+			ls_free(buffer);
+		}
+
+		measure("BinarySerializer::decode", dataSet, encodedSize, [&]()
+		{
+			SPtr<MemoryDataStream> stream = ls_shared_ptr_new<MemoryDataStream>(encoded.getData(), encodedSize, false);
+
+			BinarySerializer bs;
+			bs.decode(stream, encodedSize);
+		});
+
+		if (TaskScheduler::isStarted())
+		{
+			measure("BinarySerializer::decodeParallel", dataSet, encodedSize, [&]()
+			{
+				SPtr<MemoryDataStream> stream = ls_shared_ptr_new<MemoryDataStream>(encoded.getData(), encodedSize, false);
+
+				BinarySerializer bs;
+				bs.decodeParallel(stream, encodedSize);
+			});
+		}
+
+		// MemorySerializer
+		{
+			MemorySerializerBuffer output;
+			measure("MemorySerializer::encode", dataSet, encodedSize, [&]()
+			{
+				memorySerializer.encode(object, output);
+			});
+		}
+
+		measure("MemorySerializer::decode", dataSet, encodedSize, [&]()
+		{
+			memorySerializer.decode(encoded.getData(), encodedSize);
+		});
+
+		// FileEncoder/FileDecoder
+		Path filePath = mTempFolder + ("SerializationBenchmark_" + dataSet.name + ".asset");
+
+		measure("FileEncoder::encode", dataSet, encodedSize, [&]()
+		{
+			FileEncoder encoder(filePath);
+			encoder.encode(object);
+		});
+
+		measure("FileDecoder::decode", dataSet, encodedSize, [&]()
+		{
+			FileDecoder decoder(filePath);
+			decoder.decode();
+		});
+
+		measure("FileDecoder::decode (mapped)", dataSet, encodedSize, [&]()
+		{
+			FileDecoder decoder(filePath, true);
+			decoder.decode();
+		});
+
+		FileSystem::remove(filePath);
+
+		// BinaryCloner
+		measure("BinaryCloner::clone", dataSet, encodedSize, [&]()
+		{
+			BinaryCloner::clone(object);
+		});
+
+		// BinaryDiff, including the creation of the intermediate representation it works on
+		measure("SerializedObject::create", dataSet, encodedSize, [&]()
+		{
+			SerializedObject::create(*object);
+		});
+
+		IDiff& diffHandler = object->getRTTI()->getDiffHandler();
+		measure("BinaryDiff::generateDiff", dataSet, encodedSize, [&]()
+		{
+			SPtr<SerializedObject> orgSerialized = SerializedObject::create(*object);
+			SPtr<SerializedObject> newSerialized = SerializedObject::create(*dataSet.modified);
+
+			diffHandler.generateDiff(orgSerialized, newSerialized);
+		});
+	}
+
+	void SerializationBenchmark::measure(const String& path, const DataSet& dataSet, UINT64 bytesPerIteration,
+		const std::function<void()>& iteration)
+	{
+		SerializationBenchmarkResult result;
+		result.path = path;
+		result.dataSet = dataSet.name;
+		result.iterations = dataSet.iterations;
+		result.bytes = bytesPerIteration * dataSet.iterations;
+		result.objects = dataSet.numObjects * dataSet.iterations;
+
+#if LS_MEMORY_TRACKING
+		MemAllocSnapshot before = MemAllocProfiler::getSnapshot();
+#endif
+
+		UINT64 numAllocs = MemoryCounter::getNumAllocs();
+		Timer timer;
+
+		for (UINT32 i = 0; i < dataSet.iterations; i++)
+			iteration();
+
+		result.microseconds = timer.getMicroseconds();
+		result.allocs = MemoryCounter::getNumAllocs() - numAllocs;
+
+#if LS_MEMORY_TRACKING
+		MemAllocSnapshot after = MemAllocProfiler::getSnapshot();
+		if (after.total.peakLiveBytes > before.total.peakLiveBytes)
+			result.peakBytes = after.total.peakLiveBytes - before.total.liveBytes;
+#endif
+
+		mResults.push_back(result);
+	}
+
+	void SerializationBenchmark::print(std::ostream& stream) const
+	{
+		stream << std::left << std::setw(36) << "Path" << std::setw(12) << "Data set" << std::right
+			<< std::setw(12) << "MB/s" << std::setw(14) << "Objects/s" << std::setw(14) << "Allocs/object"
+			<< std::setw(14) << "Peak bytes" << std::endl;
+
+		stream << std::fixed << std::setprecision(2);
+		for (auto& result : mResults)
+		{
+			stream << std::left << std::setw(36) << result.path << std::setw(12) << result.dataSet << std::right
+				<< std::setw(12) << result.getMBPerSecond() << std::setw(14) << result.getObjectsPerSecond()
+				<< std::setw(14) << result.getAllocsPerObject() << std::setw(14) << result.peakBytes << std::endl;
+		}
+	}
+
+	void SerializationBenchmark::saveResults(const Path& path) const
+	{
+		StringStream stream;
+		stream << "Path,DataSet,Iterations,Bytes,Objects,Microseconds,Allocs,PeakBytes,MBPerSecond,ObjectsPerSecond,"
+			"AllocsPerObject" << std::endl;
+
+		for (auto& result : mResults)
+		{
+			stream << result.path << "," << result.dataSet << "," << result.iterations << "," << result.bytes << ","
+				<< result.objects << "," << result.microseconds << "," << result.allocs << "," << result.peakBytes << ","
+				<< result.getMBPerSecond() << "," << result.getObjectsPerSecond() << "," << result.getAllocsPerObject()
+				<< std::endl;
+		}
+
+		String contents = stream.str();
+
+		SPtr<DataStream> fileStream = FileSystem::createAndOpenFile(path);
+		fileStream->write(contents.data(), contents.size());
+	}
+}
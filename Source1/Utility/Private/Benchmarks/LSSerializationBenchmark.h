@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Prerequisites/LSPrerequisitesUtil.h"
+
+namespace ls
+{
+	/** @addtogroup Internal-Utility
+	 *  @{
+	 */
+
+	/** @addtogroup Serialization-Internal
+	 *  @{
+	 */
+
+	/** Measurements of a single serialization path run on a single data set. */
+	struct SerializationBenchmarkResult
+	{
+		String path; /**< Name of the serialization path that was measured. */
+		String dataSet; /**< Name of the data set the path was run on. */
+		UINT32 iterations = 0; /**< Number of times the path was run on the data set. */
+		UINT64 bytes = 0; /**< Total number of encoded bytes processed over all iterations. */
+		UINT64 objects = 0; /**< Total number of objects processed over all iterations. */
+		UINT64 microseconds = 0; /**< Total time taken by all iterations. */
+		UINT64 allocs = 0; /**< Number of allocations made by the calling thread over all iterations. */
+
+		/** 
+		 * Amount the run raised the peak memory use above the memory in use when it started, or 0 if it stayed below an
+		 * earlier peak. Only available with LS_MEMORY_TRACKING.
+		 */
+		UINT64 peakBytes = 0;
+
+		/** Returns the throughput in megabytes of encoded data per second. */
+		double getMBPerSecond() const;
+
+		/** Returns the throughput in objects per second. */
+		double getObjectsPerSecond() const;
+
+		/** Returns the average number of allocations made per processed object. */
+		double getAllocsPerObject() const;
+	};
+
+	/**
+	 * Measures the throughput of BinarySerializer, MemorySerializer, FileEncoder/FileDecoder, BinaryCloner and
+	 * BinaryDiff on a set of synthetic data sets: wide structures with many plain fields, deep graphs of referenced
+	 * objects, large arrays and large data blocks.
+	 *
+	 * Allocation counts come from MemoryCounter and only include allocations made on the calling thread. Peak memory
+	 * is only reported if LS_MEMORY_TRACKING is enabled.
+	 */
+	class LS_UTILITY_EXPORT SerializationBenchmark
+	{
+	public:
+		/**
+		 * Creates the benchmark.
+		 *
+		 * @param[in]	scale		Multiplier for the number of iterations each path is run for. Use a smaller value for
+		 *							a quick smoke run.
+		 * @param[in]	tempFolder	Folder to write the files used by the file serialization paths to.
+		 */
+		SerializationBenchmark(float scale, const Path& tempFolder);
+
+		/** Runs all the serialization paths on all data sets. Results of previous runs are discarded. */
+		void run();
+
+		/** Returns the results of the last run. */
+		const Vector<SerializationBenchmarkResult>& getResults() const { return mResults; }
+
+		/** Writes the results of the last run to the provided stream as a human readable table. */
+		void print(std::ostream& stream) const;
+
+		/** Writes the results of the last run to a CSV file, one row per path and data set. */
+		void saveResults(const Path& path) const;
+
+	private:
+		struct DataSet;
+
+		/** Runs all the serialization paths on a single data set. */
+		void runDataSet(const DataSet& dataSet);
+
+		/**
+		 * Runs @p iteration as many times as the data set requires, and records the measurements under the provided path
+		 * name. @p bytesPerIteration is the amount of encoded data processed by a single iteration.
+		 */
+		void measure(const String& path, const DataSet& dataSet, UINT64 bytesPerIteration, 
+			const std::function<void()>& iteration);
+
+		float mScale;
+		Path mTempFolder;
+		Vector<SerializationBenchmarkResult> mResults;
+	};
+
+	/** @} */
+	/** @} */
+}
@@ -0,0 +1,390 @@
+#include "Private/Benchmarks/LSStringBenchmark.h"
+#include "FileSystem/LSDataStream.h"
+#include "FileSystem/LSFileSystem.h"
+#include "General/LSTimer.h"
+
+#include <iomanip>
+
+namespace ls
+{
+	/** Number of lines in the text the operations are run on. */
+	static constexpr UINT32 NUM_LINES = 2048;
+
+	/** Number of times each operation is run over the text, before scaling. */
+	static constexpr UINT32 NUM_ITERATIONS = 100;
+
+	/** Written to by the benchmarked operations, so their results aren't optimized out. */
+	static volatile size_t sSink = 0;
+
+	/** Prevents the compiler from discarding the computation of @p value. */
+	static void consume(size_t value)
+	{
+		sSink = sSink + value;
+	}
+
+	/** Previous implementation of StringUtil::split(), copying the substrings as they are found. */
+	static Vector<String> baselineSplit(const String& str, const String& delims, unsigned int maxSplits = 0)
+	{
+		Vector<String> ret;
+		ret.reserve(maxSplits ? maxSplits+1 : 10);
+
+		unsigned int numSplits = 0;
+
+		size_t start, pos;
+		start = 0;
+		do
+		{
+			pos = str.find_first_of(delims, start);
+			if (pos == start)
+				start = pos + 1;
+			else if (pos == String::npos || (maxSplits && numSplits == maxSplits))
+			{
+				ret.push_back(str.substr(start));
+				break;
+			}
+			else
+			{
+				ret.push_back(str.substr(start, pos - start));
+				start = pos + 1;
+			}
+
+			start = str.find_first_not_of(delims, start);
+			++numSplits;
+
+		} while (pos != String::npos);
+
+		return ret;
+	}
+
+	/** Previous implementation of StringUtil::tokenise(). Expects the string not to end with a delimiter. */
+	static Vector<String> baselineTokenise(const String& str, const String& singleDelims, const String& doubleDelims,
+		unsigned int maxSplits = 0)
+	{
+		Vector<String> ret;
+		ret.reserve(maxSplits ? maxSplits + 1 : 10);
+
+		unsigned int numSplits = 0;
+		String delims = singleDelims + doubleDelims;
+
+		size_t start, pos;
+		char curDoubleDelim = 0;
+		start = 0;
+		do
+		{
+			if (curDoubleDelim != 0)
+				pos = str.find(curDoubleDelim, start);
+			else
+				pos = str.find_first_of(delims, start);
+
+			if (pos == start)
+			{
+				char curDelim = str.at(pos);
+				if (doubleDelims.find_first_of(curDelim) != String::npos)
+					curDoubleDelim = curDelim;
+
+				start = pos + 1;
+			}
+			else if (pos == String::npos || (maxSplits && numSplits == maxSplits))
+			{
+				ret.push_back(str.substr(start));
+				break;
+			}
+			else
+			{
+				curDoubleDelim = 0;
+
+				ret.push_back(str.substr(start, pos - start));
+				start = pos + 1;
+			}
+
+			if (curDoubleDelim == 0)
+				start = str.find_first_not_of(singleDelims, start);
+
+			++numSplits;
+
+		} while (pos != String::npos);
+
+		return ret;
+	}
+
+	/** Previous implementation of case insensitive StringUtil::startsWith(), lower casing a copy of the string start. */
+	static bool baselineStartsWith(const String& str, const String& pattern)
+	{
+		size_t thisLen = str.length();
+		size_t patternLen = pattern.length();
+		if (thisLen < patternLen || patternLen == 0)
+			return false;
+
+		String startOfThis = str.substr(0, patternLen);
+		StringUtil::toLowerCase(startOfThis);
+
+		return (startOfThis == pattern);
+	}
+
+	/** Previous implementation of case insensitive StringUtil::match(), lower casing copies of both strings. */
+	static bool baselineMatch(const String& str, const String& pattern)
+	{
+		String tmpStr = str;
+		String tmpPattern = pattern;
+		StringUtil::toLowerCase(tmpStr);
+		StringUtil::toLowerCase(tmpPattern);
+
+		return StringUtil::match(tmpStr, tmpPattern, true);
+	}
+
+	/** Previous implementation of StringUtil::replaceAll(), replacing each occurrence in place. */
+	static String baselineReplaceAll(const String& source, const String& replaceWhat, const String& replaceWithWhat)
+	{
+		String result = source;
+		String::size_type pos = 0;
+		while(1)
+		{
+			pos = result.find(replaceWhat,pos);
+			if (pos == String::npos) break;
+			result.replace(pos,replaceWhat.size(), replaceWithWhat);
+			pos += replaceWithWhat.size();
+		}
+		return result;
+	}
+
+	/** Builds the text the operations are run on, made out of lines of comma separated values. */
+	static String createText()
+	{
+		StringStream stream;
+		for (UINT32 i = 0; i < NUM_LINES; i++)
+		{
+			stream << "Entry" << i << ", " << (i * 7) << ", \"Quoted, value " << (i % 13) << "\", "
+				<< (i % 2 ? "enabled" : "disabled");
+
+			if (i + 1 < NUM_LINES)
+				stream << "\n";
+		}
+
+		return stream.str();
+	}
+
+	double StringBenchmarkResult::getMBPerSecond() const
+	{
+		if (microseconds == 0)
+			return 0.0;
+
+		return (bytes / (1024.0 * 1024.0)) / (microseconds / 1000000.0);
+	}
+
+	double StringBenchmarkResult::getAllocsPerIteration() const
+	{
+		if (iterations == 0)
+			return 0.0;
+
+		return allocs / (double)iterations;
+	}
+
+	StringBenchmark::StringBenchmark(float scale)
+		:mScale(scale)
+	{ }
+
+	void StringBenchmark::run()
+	{
+		mResults.clear();
+
+		const UINT32 iterations = std::max(1U, (UINT32)(NUM_ITERATIONS * mScale));
+
+		const String text = createText();
+		const Vector<String> lines = StringUtil::split(text, "\n");
+
+		const String delims = ", \n";
+		const UINT64 textSize = text.size();
+
+		measure("split", "Baseline", iterations, textSize, [&]()
+		{
+			consume(baselineSplit(text, delims).size());
+		});
+
+		measure("split", "StringUtil::split", iterations, textSize, [&]()
+		{
+			consume(StringUtil::split(text, delims).size());
+		});
+
+		measure("split", "StringUtil::splitView", iterations, textSize, [&]()
+		{
+			size_t numEntries = 0;
+			for (auto& entry : StringUtil::splitView(text, delims))
+				numEntries += entry.size();
+
+			consume(numEntries);
+		});
+
+		measure("tokenise", "Baseline", iterations, textSize, [&]()
+		{
+			consume(baselineTokenise(text, delims, "\"").size());
+		});
+
+		measure("tokenise", "StringUtil::tokenise", iterations, textSize, [&]()
+		{
+			consume(StringUtil::tokenise(text, delims, "\"").size());
+		});
+
+		measure("tokenise", "StringUtil::tokeniseView", iterations, textSize, [&]()
+		{
+			size_t numEntries = 0;
+			for (auto& entry : StringUtil::tokeniseView(text, delims, "\""))
+				numEntries += entry.size();
+
+			consume(numEntries);
+		});
+
+		measure("findFirstOf", "String::find_first_of", iterations, textSize, [&]()
+		{
+			size_t numFound = 0;
+			for (size_t pos = text.find_first_of("\"!"); pos != String::npos; pos = text.find_first_of("\"!", pos + 1))
+				numFound++;
+
+			consume(numFound);
+		});
+
+		measure("findFirstOf", "StringUtil::findFirstOf", iterations, textSize, [&]()
+		{
+			size_t numFound = 0;
+			for (size_t pos = StringUtil::findFirstOf(text, "\"!"); pos != String::npos;
+				pos = StringUtil::findFirstOf(text, "\"!", pos + 1))
+			{
+				numFound++;
+			}
+
+			consume(numFound);
+		});
+
+		const String prefix = "entry1";
+		const String pattern = "*quoted*enabled";
+
+		UINT64 linesSize = 0;
+		for (auto& line : lines)
+			linesSize += line.size();
+
+		measure("startsWith", "Baseline", iterations, linesSize, [&]()
+		{
+			size_t numMatches = 0;
+			for (auto& line : lines)
+				numMatches += baselineStartsWith(line, prefix) ? 1 : 0;
+
+			consume(numMatches);
+		});
+
+		measure("startsWith", "StringUtil::startsWith", iterations, linesSize, [&]()
+		{
+			size_t numMatches = 0;
+			for (auto& line : lines)
+				numMatches += StringUtil::startsWith(line, prefix) ? 1 : 0;
+
+			consume(numMatches);
+		});
+
+		measure("match", "Baseline", iterations, linesSize, [&]()
+		{
+			size_t numMatches = 0;
+			for (auto& line : lines)
+				numMatches += baselineMatch(line, pattern) ? 1 : 0;
+
+			consume(numMatches);
+		});
+
+		measure("match", "StringUtil::match", iterations, linesSize, [&]()
+		{
+			size_t numMatches = 0;
+			for (auto& line : lines)
+				numMatches += StringUtil::match(line, pattern, false) ? 1 : 0;
+
+			consume(numMatches);
+		});
+
+		measure("compare", "Baseline", iterations, linesSize, [&]()
+		{
+			// Case insensitive comparison through upper cased copies
+			int total = 0;
+			for (size_t i = 1; i < lines.size(); i++)
+			{
+				String lhs = lines[i - 1];
+				String rhs = lines[i];
+				StringUtil::toUpperCase(lhs);
+				StringUtil::toUpperCase(rhs);
+
+				total += lhs.compare(rhs);
+			}
+
+			consume((size_t)total);
+		});
+
+		measure("compare", "StringUtil::compare", iterations, linesSize, [&]()
+		{
+			int total = 0;
+			for (size_t i = 1; i < lines.size(); i++)
+				total += StringUtil::compare(lines[i - 1], lines[i], false);
+
+			consume((size_t)total);
+		});
+
+		measure("replaceAll", "Baseline", iterations, textSize, [&]()
+		{
+			consume(baselineReplaceAll(text, ", ", ";").size());
+		});
+
+		measure("replaceAll", "StringUtil::replaceAll", iterations, textSize, [&]()
+		{
+			consume(StringUtil::replaceAll(text, ", ", ";").size());
+		});
+	}
+
+	void StringBenchmark::measure(const String& operation, const String& implementation, UINT32 iterations,
+		UINT64 bytesPerIteration, const std::function<void()>& iteration)
+	{
+		StringBenchmarkResult result;
+		result.operation = operation;
+		result.implementation = implementation;
+		result.iterations = iterations;
+		result.bytes = bytesPerIteration * iterations;
+
+		UINT64 numAllocs = MemoryCounter::getNumAllocs();
+		Timer timer;
+
+		for (UINT32 i = 0; i < iterations; i++)
+			iteration();
+
+		result.microseconds = timer.getMicroseconds();
+		result.allocs = MemoryCounter::getNumAllocs() - numAllocs;
+
+		mResults.push_back(result);
+	}
+
+	void StringBenchmark::print(std::ostream& stream) const
+	{
+		stream << std::left << std::setw(14) << "Operation" << std::setw(28) << "Implementation" << std::right
+			<< std::setw(12) << "MB/s" << std::setw(18) << "Allocs/iteration" << std::endl;
+
+		stream << std::fixed << std::setprecision(2);
+		for (auto& result : mResults)
+		{
+			stream << std::left << std::setw(14) << result.operation << std::setw(28) << result.implementation
+				<< std::right << std::setw(12) << result.getMBPerSecond() << std::setw(18)
+				<< result.getAllocsPerIteration() << std::endl;
+		}
+	}
+
+	void StringBenchmark::saveResults(const Path& path) const
+	{
+		StringStream stream;
+		stream << "Operation,Implementation,Iterations,Bytes,Microseconds,Allocs,MBPerSecond,AllocsPerIteration"
+			<< std::endl;
+
+		for (auto& result : mResults)
+		{
+			stream << result.operation << "," << result.implementation << "," << result.iterations << ","
+				<< result.bytes << "," << result.microseconds << "," << result.allocs << "," << result.getMBPerSecond()
+				<< "," << result.getAllocsPerIteration() << std::endl;
+		}
+
+		String contents = stream.str();
+
+		SPtr<DataStream> fileStream = FileSystem::createAndOpenFile(path);
+		fileStream->write(contents.data(), contents.size());
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Prerequisites/LSPrerequisitesUtil.h"
+
+namespace ls
+{
+	/** @addtogroup Internal-Utility
+	 *  @{
+	 */
+
+	/** @addtogroup String-Internal
+	 *  @{
+	 */
+
+	/** Measurements of a single implementation of a string operation. */
+	struct StringBenchmarkResult
+	{
+		String operation; /**< Name of the operation that was measured. */
+		String implementation; /**< Name of the implementation of the operation that was measured. */
+		UINT32 iterations = 0; /**< Number of times the operation was run over the test text. */
+		UINT64 bytes = 0; /**< Total number of characters processed over all iterations. */
+		UINT64 microseconds = 0; /**< Total time taken by all iterations. */
+		UINT64 allocs = 0; /**< Number of allocations made by the calling thread over all iterations. */
+
+		/** Returns the throughput in megabytes of processed text per second. */
+		double getMBPerSecond() const;
+
+		/** Returns the average number of allocations made per iteration. */
+		double getAllocsPerIteration() const;
+	};
+
+	/**
+	 * Compares the throughput and number of allocations of StringUtil operations against copies of their previous,
+	 * allocating implementations. Operations are run on a synthetic text made out of comma separated lines.
+	 *
+	 * Allocation counts come from MemoryCounter and only include allocations made on the calling thread.
+	 */
+	class LS_UTILITY_EXPORT StringBenchmark
+	{
+	public:
+		/**
+		 * Creates the benchmark.
+		 *
+		 * @param[in]	scale		Multiplier for the number of iterations each operation is run for. Use a smaller value
+		 *							for a quick smoke run.
+		 */
+		StringBenchmark(float scale);
+
+		/** Runs all the operations. Results of previous runs are discarded. */
+		void run();
+
+		/** Returns the results of the last run. */
+		const Vector<StringBenchmarkResult>& getResults() const { return mResults; }
+
+		/** Writes the results of the last run to the provided stream as a human readable table. */
+		void print(std::ostream& stream) const;
+
+		/** Writes the results of the last run to a CSV file, one row per operation and implementation. */
+		void saveResults(const Path& path) const;
+
+	private:
+		/**
+		 * Runs @p iteration the provided number of times, and records the measurements under the provided operation and
+		 * implementation names. @p bytesPerIteration is the number of characters processed by a single iteration.
+		 */
+		void measure(const String& operation, const String& implementation, UINT32 iterations,
+			UINT64 bytesPerIteration, const std::function<void()>& iteration);
+
+		float mScale;
+		Vector<StringBenchmarkResult> mResults;
+	};
+
+	/** @} */
+	/** @} */
+}
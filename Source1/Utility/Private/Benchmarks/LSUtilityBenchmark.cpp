@@ -0,0 +1,57 @@
+#include "Private/Benchmarks/LSSerializationBenchmark.h"
+#include "Private/Benchmarks/LSStringBenchmark.h"
+#include "FileSystem/LSFileSystem.h"
+#include "Thread/LSThreadPool.h"
+#include "Thread/LSTaskScheduler.h"
+
+#include <iostream>
+
+using namespace ls;
+
+/**
+ * Runs the serialization and string benchmarks and prints the results. Usage: LSUtilityBenchmark [results.csv] [scale]
+ * If a results path is provided the results are also written to it in CSV format. String benchmark results are written
+ * next to it, with a "-String" suffix added to the file name.
+ */
+int main(int argc, char* argv[])
+{
+	float scale = 1.0f;
+	if (argc > 2)
+		scale = (float)atof(argv[2]);
+
+	// Used by the serializers and BinaryDiff for temporary field data
+	MemStack::beginThread();
+
+	ThreadPool::startUp<TThreadPool<>>(LS_THREAD_HARDWARE_CONCURRENCY, 64);
+	TaskScheduler::startUp(TaskSchedulerMode::WorkStealing);
+
+	{
+		SerializationBenchmark benchmark(scale, FileSystem::getTempDirectoryPath() + "LSUtilityBenchmark/");
+		benchmark.run();
+		benchmark.print(std::cout);
+
+		if (argc > 1)
+			benchmark.saveResults(Path(argv[1]));
+	}
+
+	{
+		StringBenchmark benchmark(scale);
+		benchmark.run();
+		benchmark.print(std::cout);
+
+		if (argc > 1)
+		{
+			Path path(argv[1]);
+			path.setBasename(path.getFilename(false) + "-String");
+
+			benchmark.saveResults(path);
+		}
+	}
+
+	TaskScheduler::shutDown();
+	ThreadPool::shutDown();
+
+	MemStack::endThread();
+
+	return 0;
+}
@@ -4,6 +4,7 @@
 #include "Reflection/LSRTTIType.h"
 #include "Serialization/LSSerializedObject.h"
 #include "FileSystem/LSDataStream.h"
+#include "Allocators/LSPoolAlloc.h"
 
 namespace ls
 {
@@ -70,7 +71,7 @@ namespace ls
 
 		SPtr<IReflectable> newRTTIObject() override
 		{
-			return ls_shared_ptr_new<SerializedField>();
+			return ls_pool_shared_ptr_new<SerializedField>();
 		}
 	};
 
@@ -87,6 +88,17 @@ namespace ls
 
 		void setData(SerializedDataBlock* obj, const SPtr<DataStream>& value, UINT32 size)
 		{
+			// Keep referencing the source data if possible, instead of copying it
+			SPtr<DataStream> view = value->readView(size);
+			if (view != nullptr)
+			{
+				obj->stream = view;
+				obj->size = size;
+				obj->offset = 0;
+
+				return;
+			}
+
 			UINT8* data = (UINT8*)ls_alloc(size);
 			SPtr<MemoryDataStream> memStream = ls_shared_ptr_new<MemoryDataStream>(data, size);
 			value->read(data, size);
@@ -114,7 +126,7 @@ namespace ls
 
 		SPtr<IReflectable> newRTTIObject() override
 		{
-			return ls_shared_ptr_new<SerializedDataBlock>();
+			return ls_pool_shared_ptr_new<SerializedDataBlock>();
 		}
 	};
 
@@ -160,7 +172,7 @@ namespace ls
 
 		SPtr<IReflectable> newRTTIObject() override
 		{
-			return ls_shared_ptr_new<SerializedObject>();
+			return ls_pool_shared_ptr_new<SerializedObject>();
 		}
 	};
 
@@ -225,7 +237,7 @@ namespace ls
 
 		SPtr<IReflectable> newRTTIObject() override
 		{
-			return ls_shared_ptr_new<SerializedArray>();
+			return ls_pool_shared_ptr_new<SerializedArray>();
 		}
 
 	private:
@@ -293,7 +305,7 @@ namespace ls
 
 		SPtr<IReflectable> newRTTIObject() override
 		{
-			return ls_shared_ptr_new<SerializedSubObject>();
+			return ls_pool_shared_ptr_new<SerializedSubObject>();
 		}
 
 	private:
@@ -343,7 +355,7 @@ namespace ls
 
 		SPtr<IReflectable> newRTTIObject() override
 		{
-			return ls_shared_ptr_new<SerializedEntry>();
+			return ls_pool_shared_ptr_new<SerializedEntry>();
 		}
 	};
 
@@ -390,7 +402,7 @@ namespace ls
 
 		SPtr<IReflectable> newRTTIObject() override
 		{
-			return ls_shared_ptr_new<SerializedArrayEntry>();
+			return ls_pool_shared_ptr_new<SerializedArrayEntry>();
 		}
 	};
 
@@ -1,8 +1,10 @@
 #include "Private/UnitTests/LSFileSystemTestSuite.h"
 
 #include "Logger/LSLogger.h"
+#include "Logger/LSLogFile.h"
 #include "Error/LSException.h"
 #include "FileSystem/LSFileSystem.h"
+#include "FileSystem/LSDataStream.h"
 
 #include <algorithm>
 #include <fstream>
@@ -82,6 +84,11 @@ namespace ls
 		LS_ADD_TEST(FileSystemTestSuite::testGetChildren);
 		LS_ADD_TEST(FileSystemTestSuite::testGetLastModifiedTime);
 		LS_ADD_TEST(FileSystemTestSuite::testGetTempDirectoryPath);
+		LS_ADD_TEST(FileSystemTestSuite::testOpenFile_memory_mapped);
+		LS_ADD_TEST(FileSystemTestSuite::testMMapDataStream_readView);
+		LS_ADD_TEST(FileSystemTestSuite::testMMapDataStream_clone);
+		LS_ADD_TEST(FileSystemTestSuite::testMMapDataStream_empty);
+		LS_ADD_TEST(FileSystemTestSuite::testLogFile_rotate);
 	}
 
 	void FileSystemTestSuite::testExists_yes_file()
@@ -297,4 +304,148 @@ namespace ls
 		/* No judging. */
 		LS_TEST_ASSERT(!path.toString().empty());
 	}
+
+	void FileSystemTestSuite::testOpenFile_memory_mapped()
+	{
+		Path path = mTestDirectory + "mapped";
+		createFile(path, "0123456789");
+
+		SPtr<DataStream> stream = FileSystem::openFile(path, true, true);
+		LS_TEST_ASSERT(stream != nullptr && stream->isFile());
+		LS_TEST_ASSERT(std::dynamic_pointer_cast<MMapDataStream>(stream) != nullptr);
+		LS_TEST_ASSERT(stream->size() == 10);
+
+		char data[16] = {};
+		LS_TEST_ASSERT(stream->read(data, 4) == 4);
+		LS_TEST_ASSERT(String(data, 4) == "0123");
+
+		stream->skip(2);
+		LS_TEST_ASSERT(stream->tell() == 6);
+
+		// Reads past the end are clamped
+		LS_TEST_ASSERT(stream->read(data, sizeof(data)) == 4);
+		LS_TEST_ASSERT(String(data, 4) == "6789");
+		LS_TEST_ASSERT(stream->eof());
+
+		// Writable files are never mapped
+		SPtr<DataStream> writable = FileSystem::openFile(path, false, true);
+		LS_TEST_ASSERT(std::dynamic_pointer_cast<MMapDataStream>(writable) == nullptr);
+	}
+
+	void FileSystemTestSuite::testMMapDataStream_readView()
+	{
+		Path path = mTestDirectory + "mapped-view";
+		createFile(path, "0123456789");
+
+		SPtr<DataStream> stream = FileSystem::openFile(path, true, true);
+		stream->seek(2);
+
+		SPtr<DataStream> view = stream->readView(5);
+		LS_TEST_ASSERT(view != nullptr && view->size() == 5);
+		LS_TEST_ASSERT(stream->tell() == 7);
+
+		// A view across the end of the mapping fails and leaves the read position alone
+		LS_TEST_ASSERT(stream->readView(4) == nullptr);
+		LS_TEST_ASSERT(stream->readView((size_t)-1) == nullptr);
+		LS_TEST_ASSERT(stream->tell() == 7);
+
+		// A view up to the end of the mapping is fine
+		SPtr<DataStream> tail = stream->readView(3);
+		LS_TEST_ASSERT(tail != nullptr && tail->size() == 3);
+		LS_TEST_ASSERT(stream->eof());
+
+		// Views keep the mapping alive after the stream is closed
+		stream->close();
+		stream = nullptr;
+
+		char data[8] = {};
+		LS_TEST_ASSERT(view->read(data, sizeof(data)) == 5);
+		LS_TEST_ASSERT(String(data, 5) == "23456");
+		LS_TEST_ASSERT(tail->read(data, sizeof(data)) == 3);
+		LS_TEST_ASSERT(String(data, 3) == "789");
+	}
+
+	void FileSystemTestSuite::testMMapDataStream_clone()
+	{
+		Path path = mTestDirectory + "mapped-clone";
+		createFile(path, "0123456789");
+
+		SPtr<DataStream> stream = FileSystem::openFile(path, true, true);
+		stream->seek(8);
+
+		// Clones start reading from the beginning, independently of the original
+		SPtr<DataStream> clone = stream->clone();
+		LS_TEST_ASSERT(clone != nullptr && clone->size() == 10 && clone->tell() == 0);
+
+		stream = nullptr;
+
+		char data[16] = {};
+		LS_TEST_ASSERT(clone->read(data, sizeof(data)) == 10);
+		LS_TEST_ASSERT(String(data, 10) == "0123456789");
+
+		clone->seek(4);
+		SPtr<DataStream> view = clone->readView(2);
+		LS_TEST_ASSERT(view != nullptr);
+		LS_TEST_ASSERT(view->read(data, 2) == 2 && String(data, 2) == "45");
+	}
+
+	void FileSystemTestSuite::testMMapDataStream_empty()
+	{
+		Path path = mTestDirectory + "mapped-empty";
+		createEmptyFile(path);
+
+		SPtr<DataStream> stream = FileSystem::openFile(path, true, true);
+		LS_TEST_ASSERT(stream != nullptr);
+		LS_TEST_ASSERT(stream->size() == 0 && stream->tell() == 0);
+		LS_TEST_ASSERT(stream->eof());
+
+		char data[4];
+		LS_TEST_ASSERT(stream->read(data, sizeof(data)) == 0);
+		LS_TEST_ASSERT(stream->readView(1) == nullptr);
+
+		SPtr<DataStream> clone = stream->clone();
+		LS_TEST_ASSERT(clone != nullptr && clone->size() == 0 && clone->eof());
+	}
+
+	void FileSystemTestSuite::testLogFile_rotate()
+	{
+		Path path = mTestDirectory + "rotated.log";
+		Path rotated1 = mTestDirectory + "rotated.log.1";
+		Path rotated2 = mTestDirectory + "rotated.log.2";
+		Path rotated3 = mTestDirectory + "rotated.log.3";
+
+		LogFileOptions options;
+		options.maxSize = 16;
+		options.maxRotatedFiles = 2;
+
+		{
+			LogFile file(path, options);
+			LS_TEST_ASSERT(file.getRotatedPath(1) == rotated1);
+
+			// Each message after the first one exceeds the size limit, and the oldest rotated file gets deleted
+			file.write("first");
+			file.write("second-message");
+			file.write("third-message");
+			file.write("fourth-message");
+		}
+
+		LS_TEST_ASSERT(readFile(path) == "fourth-message");
+		LS_TEST_ASSERT(readFile(rotated1) == "third-message");
+		LS_TEST_ASSERT(readFile(rotated2) == "second-message");
+		LS_TEST_ASSERT(!FileSystem::exists(rotated3));
+
+		// An existing file is rotated when opened
+		{
+			LogFile file(path, options);
+			file.write("fifth");
+		}
+
+		LS_TEST_ASSERT(readFile(path) == "fifth");
+		LS_TEST_ASSERT(readFile(rotated1) == "fourth-message");
+		LS_TEST_ASSERT(readFile(rotated2) == "third-message");
+
+		FileSystem::remove(path);
+		FileSystem::remove(rotated1);
+		FileSystem::remove(rotated2);
+	}
 }
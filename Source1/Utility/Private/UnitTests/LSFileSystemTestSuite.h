@@ -33,6 +33,11 @@ namespace ls
 		void testGetChildren();
 		void testGetLastModifiedTime();
 		void testGetTempDirectoryPath();
+		void testOpenFile_memory_mapped();
+		void testMMapDataStream_readView();
+		void testMMapDataStream_clone();
+		void testMMapDataStream_empty();
+		void testLogFile_rotate();
 
 		Path mTestDirectory;
 	};
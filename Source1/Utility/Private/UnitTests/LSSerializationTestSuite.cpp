@@ -0,0 +1,806 @@
+#include "Private/UnitTests/LSSerializationTestSuite.h"
+#include "Reflection/LSRTTIType.h"
+#include "Allocators/LSPoolAlloc.h"
+#include "Serialization/LSBinaryCloner.h"
+#include "Serialization/LSMemorySerializer.h"
+#include "Serialization/LSFileSerializer.h"
+#include "Serialization/LSBinarySerializer.h"
+#include "Serialization/LSBinaryDiff.h"
+#include "Serialization/LSSerializedObject.h"
+#include "FileSystem/LSDataStream.h"
+#include "FileSystem/LSFileSystem.h"
+#include "String/LSStringID.h"
+
+#include <stdexcept>
+
+namespace ls
+{
+	/** Nodes with this id fail to deserialize. */
+	static constexpr UINT32 FAILING_NODE_ID = 0xFFFFFFFF;
+
+	enum TypeID_SerializationTests
+	{
+		TID_TestNode = 60100,
+		TID_TestDataBlock = 60101,
+		TID_TestLargeTypeId = IReflectable::MAX_FLAT_TYPE_ID + 60102
+	};
+
+	/** Node in a graph of objects referencing each other through pointers. */
+	class TestNode : public IReflectable
+	{
+	public:
+		UINT32 id = 0;
+		String name;
+		StringID tag;
+		Vector<StringID> tags;
+		SPtr<TestNode> link;
+		SPtr<TestNode> parent;
+		Vector<SPtr<TestNode>> children;
+
+		friend class TestNodeRTTI;
+		static RTTITypeBase* getRTTIStatic();
+		RTTITypeBase* getRTTI() const override;
+	};
+
+	class TestNodeRTTI : public RTTIType<TestNode, IReflectable, TestNodeRTTI>
+	{
+	private:
+		LS_BEGIN_RTTI_MEMBERS
+			LS_RTTI_MEMBER_PLAIN(name, 1)
+			LS_RTTI_MEMBER_REFLPTR(link, 2)
+			LS_RTTI_MEMBER_REFLPTR_ARRAY(children, 3)
+			LS_RTTI_MEMBER_PLAIN(tag, 5)
+			LS_RTTI_MEMBER_PLAIN_ARRAY(tags, 6)
+		LS_END_RTTI_MEMBERS
+
+		UINT32& getId(TestNode* obj) { return obj->id; }
+		void setId(TestNode* obj, UINT32& val)
+		{
+			// Thrown directly, as LS_EXCEPT terminates the application
+			if (val == FAILING_NODE_ID)
+				throw std::runtime_error("Failed to deserialize the node.");
+
+			obj->id = val;
+		}
+
+		SPtr<TestNode> getParent(TestNode* obj) { return obj->parent; }
+		void setParent(TestNode* obj, SPtr<TestNode> val) { obj->parent = val; }
+
+	public:
+		TestNodeRTTI()
+		{
+			addPlainField("id", 0, &TestNodeRTTI::getId, &TestNodeRTTI::setId);
+			addReflectablePtrField("parent", 4, &TestNodeRTTI::getParent, &TestNodeRTTI::setParent, RTTI_Flag_WeakRef);
+		}
+
+		const String& getRTTIName() override
+		{
+			static String name = "TestNode";
+			return name;
+		}
+
+		UINT32 getRTTIId() override
+		{
+			return TID_TestNode;
+		}
+
+		SPtr<IReflectable> newRTTIObject() override
+		{
+			return ls_shared_ptr_new<TestNode>();
+		}
+	};
+
+	RTTITypeBase* TestNode::getRTTIStatic()
+	{
+		return TestNodeRTTI::instance();
+	}
+
+	RTTITypeBase* TestNode::getRTTI() const
+	{
+		return TestNode::getRTTIStatic();
+	}
+
+	/** Object containing a blob of binary data. */
+	class TestDataBlock : public IReflectable
+	{
+	public:
+		UINT32 format = 0;
+		Vector<UINT8> data;
+
+		friend class TestDataBlockRTTI;
+		static RTTITypeBase* getRTTIStatic();
+		RTTITypeBase* getRTTI() const override;
+	};
+
+	class TestDataBlockRTTI : public RTTIType<TestDataBlock, IReflectable, TestDataBlockRTTI>
+	{
+	private:
+		UINT32& getFormat(TestDataBlock* obj) { return obj->format; }
+		void setFormat(TestDataBlock* obj, UINT32& val) { obj->format = val; }
+
+		SPtr<DataStream> getData(TestDataBlock* obj, UINT32& size)
+		{
+			size = (UINT32)obj->data.size();
+			return ls_shared_ptr_new<MemoryDataStream>(obj->data.data(), obj->data.size(), false);
+		}
+
+		void setData(TestDataBlock* obj, const SPtr<DataStream>& value, UINT32 size)
+		{
+			obj->data.resize(size);
+			value->read(obj->data.data(), size);
+		}
+
+	public:
+		TestDataBlockRTTI()
+		{
+			addPlainField("format", 0, &TestDataBlockRTTI::getFormat, &TestDataBlockRTTI::setFormat);
+			addDataBlockField("data", 1, &TestDataBlockRTTI::getData, &TestDataBlockRTTI::setData);
+		}
+
+		const String& getRTTIName() override
+		{
+			static String name = "TestDataBlock";
+			return name;
+		}
+
+		UINT32 getRTTIId() override
+		{
+			return TID_TestDataBlock;
+		}
+
+		SPtr<IReflectable> newRTTIObject() override
+		{
+			return ls_shared_ptr_new<TestDataBlock>();
+		}
+	};
+
+	RTTITypeBase* TestDataBlock::getRTTIStatic()
+	{
+		return TestDataBlockRTTI::instance();
+	}
+
+	RTTITypeBase* TestDataBlock::getRTTI() const
+	{
+		return TestDataBlock::getRTTIStatic();
+	}
+
+	/** Object whose type ID is too large for the flat type table. */
+	class TestLargeTypeId : public IReflectable
+	{
+	public:
+		UINT32 value = 0;
+
+		friend class TestLargeTypeIdRTTI;
+		static RTTITypeBase* getRTTIStatic();
+		RTTITypeBase* getRTTI() const override;
+	};
+
+	class TestLargeTypeIdRTTI : public RTTIType<TestLargeTypeId, IReflectable, TestLargeTypeIdRTTI>
+	{
+	private:
+		LS_BEGIN_RTTI_MEMBERS
+			LS_RTTI_MEMBER_PLAIN(value, 0)
+		LS_END_RTTI_MEMBERS
+
+	public:
+		const String& getRTTIName() override
+		{
+			static String name = "TestLargeTypeId";
+			return name;
+		}
+
+		UINT32 getRTTIId() override
+		{
+			return TID_TestLargeTypeId;
+		}
+
+		SPtr<IReflectable> newRTTIObject() override
+		{
+			return ls_pool_shared_ptr_new<TestLargeTypeId>();
+		}
+	};
+
+	RTTITypeBase* TestLargeTypeId::getRTTIStatic()
+	{
+		return TestLargeTypeIdRTTI::instance();
+	}
+
+	RTTITypeBase* TestLargeTypeId::getRTTI() const
+	{
+		return TestLargeTypeId::getRTTIStatic();
+	}
+
+	/** Creates an object with @p size bytes of data in its data block. */
+	static SPtr<TestDataBlock> createDataBlock(UINT32 size)
+	{
+		SPtr<TestDataBlock> object = ls_shared_ptr_new<TestDataBlock>();
+		object->format = size;
+		object->data.resize(size);
+		for (UINT32 i = 0; i < size; i++)
+			object->data[i] = (UINT8)(i * 31);
+
+		return object;
+	}
+
+	/** Checks if @p object is a TestDataBlock with the same contents as @p original. */
+	static bool isSameDataBlock(const SPtr<IReflectable>& object, const SPtr<TestDataBlock>& original)
+	{
+		if (object == nullptr || !rtti_is_of_type<TestDataBlock>(object))
+			return false;
+
+		SPtr<TestDataBlock> dataBlock = std::static_pointer_cast<TestDataBlock>(object);
+		return dataBlock->format == original->format && dataBlock->data == original->data;
+	}
+
+	/** Creates a node with the provided id and a name derived from it. */
+	static SPtr<TestNode> createNode(UINT32 id)
+	{
+		SPtr<TestNode> node = ls_shared_ptr_new<TestNode>();
+		node->id = id;
+		node->name = "Node" + toString(id);
+
+		// Every fourth node is left without a tag
+		if (id % 4 != 0)
+			node->tag = StringID("Tag" + toString(id % 4));
+
+		for (UINT32 i = 0; i < id % 3; i++)
+			node->tags.push_back(StringID("Node" + toString(id) + "Tag" + toString(i)));
+
+		return node;
+	}
+
+	/**
+	 * Creates a root node with two children, both linking to the same shared node, and each referencing the root as
+	 * their parent.
+	 */
+	static SPtr<TestNode> createHierarchy()
+	{
+		SPtr<TestNode> root = createNode(0);
+		SPtr<TestNode> shared = createNode(3);
+
+		for (UINT32 i = 1; i <= 2; i++)
+		{
+			SPtr<TestNode> child = createNode(i);
+			child->link = shared;
+			child->parent = root;
+
+			root->children.push_back(child);
+		}
+
+		return root;
+	}
+
+	/**
+	 * Creates a tree of nodes with @p numNodes nodes, where each leaf node is also linked to the leaf created before it,
+	 * so most of the leaves are referenced from multiple places.
+	 */
+	static SPtr<TestNode> createTree(UINT32 numNodes)
+	{
+		Vector<SPtr<TestNode>> nodes;
+		for (UINT32 i = 0; i < numNodes; i++)
+		{
+			SPtr<TestNode> node = createNode(i);
+			if (i > 0)
+				nodes[(i - 1) / 4]->children.push_back(node);
+
+			// Link to the previous node if it is a leaf, so the links never form a cycle
+			if (i > 1 && (i - 1) * 4 + 1 >= numNodes)
+				node->link = nodes[i - 1];
+
+			nodes.push_back(node);
+		}
+
+		return nodes[0];
+	}
+
+	/** 
+	 * Checks if the graphs of nodes starting at @p lhs and @p rhs have the same contents and the same structure,
+	 * including which nodes are shared. 
+	 */
+	static bool isSameGraph(TestNode* lhs, TestNode* rhs, UnorderedMap<TestNode*, TestNode*>& visited)
+	{
+		if (lhs == nullptr || rhs == nullptr)
+			return lhs == rhs;
+
+		auto iterFind = visited.find(lhs);
+		if (iterFind != visited.end())
+			return iterFind->second == rhs;
+
+		visited[lhs] = rhs;
+
+		if (lhs->id != rhs->id || lhs->name != rhs->name || lhs->children.size() != rhs->children.size())
+			return false;
+
+		if (lhs->tag != rhs->tag || lhs->tags != rhs->tags)
+			return false;
+
+		if (!isSameGraph(lhs->link.get(), rhs->link.get(), visited))
+			return false;
+
+		if (!isSameGraph(lhs->parent.get(), rhs->parent.get(), visited))
+			return false;
+
+		for (UINT32 i = 0; i < (UINT32)lhs->children.size(); i++)
+		{
+			if (!isSameGraph(lhs->children[i].get(), rhs->children[i].get(), visited))
+				return false;
+		}
+
+		return true;
+	}
+
+	/** Releases the references from the children to their parent, so the reference cycles don't leak the nodes. */
+	static void releaseHierarchy(const SPtr<TestNode>& root)
+	{
+		for (auto& child : root->children)
+			child->parent = nullptr;
+	}
+
+	void SerializationTestSuite::startUp()
+	{
+		// Used by the serializer for temporary field data
+		MemStack::beginThread();
+
+		mTestDirectory = FileSystem::getTempDirectoryPath() + "SerializationTestDirectory/";
+		FileSystem::createDir(mTestDirectory);
+	}
+
+	void SerializationTestSuite::shutDown()
+	{
+		FileSystem::remove(mTestDirectory, true);
+
+		MemStack::endThread();
+	}
+
+	SerializationTestSuite::SerializationTestSuite()
+	{
+		LS_ADD_TEST(SerializationTestSuite::testFindField)
+		LS_ADD_TEST(SerializationTestSuite::testTypeIdLookup)
+		LS_ADD_TEST(SerializationTestSuite::testClonerShallowReferences)
+		LS_ADD_TEST(SerializationTestSuite::testClonerDeepReferences)
+		LS_ADD_TEST(SerializationTestSuite::testClonerCycles)
+		LS_ADD_TEST(SerializationTestSuite::testClonerDataBlock)
+		LS_ADD_TEST(SerializationTestSuite::testMemorySerializerBuffer)
+		LS_ADD_TEST(SerializationTestSuite::testFileSerializer)
+		LS_ADD_TEST(SerializationTestSuite::testFileSerializerLegacy)
+		LS_ADD_TEST(SerializationTestSuite::testDecodeParallel)
+		LS_ADD_TEST(SerializationTestSuite::testDecodeParallelException)
+		LS_ADD_TEST(SerializationTestSuite::testDiffHashes)
+		LS_ADD_TEST(SerializationTestSuite::testSerializedObjectLifetime)
+	}
+
+	void SerializationTestSuite::testFindField()
+	{
+		RTTITypeBase* rtti = TestNode::getRTTIStatic();
+		LS_TEST_ASSERT(rtti->getNumFields() == 7);
+
+		RTTIField* idField = rtti->findField(0);
+		RTTIField* parentField = rtti->findField(4);
+		LS_TEST_ASSERT(idField != nullptr && idField->mName == "id");
+		LS_TEST_ASSERT(parentField != nullptr && parentField->mName == "parent");
+		LS_TEST_ASSERT(rtti->findField("id") == idField);
+		LS_TEST_ASSERT(rtti->findField("parent") == parentField);
+		LS_TEST_ASSERT(rtti->findField("children")->mUniqueId == 3);
+
+		// Unused IDs
+		LS_TEST_ASSERT(rtti->findField(-1) == nullptr);
+		LS_TEST_ASSERT(rtti->findField(7) == nullptr);
+		LS_TEST_ASSERT(rtti->findField(1000) == nullptr);
+
+		// Lookup using the expected index of the field
+		for (UINT32 i = 0; i < rtti->getNumFields(); i++)
+		{
+			UINT32 nextIdx = i;
+			RTTIField* field = rtti->getField(i);
+			LS_TEST_ASSERT(rtti->findField(field->mUniqueId, nextIdx) == field);
+			LS_TEST_ASSERT(nextIdx == i + 1);
+
+			// Wrong expected index falls back to the ID lookup
+			nextIdx = (i + 1) % rtti->getNumFields();
+			LS_TEST_ASSERT(rtti->findField(field->mUniqueId, nextIdx) == field);
+			LS_TEST_ASSERT(nextIdx == i + 1);
+		}
+
+		UINT32 nextIdx = 2;
+		LS_TEST_ASSERT(rtti->findField(1000, nextIdx) == nullptr);
+		LS_TEST_ASSERT(nextIdx == 2);
+
+		// Clones share the fields of the type, including clones of clones
+		FrameAlloc alloc;
+		RTTITypeBase* clone = rtti->_clone(alloc);
+		RTTITypeBase* cloneOfClone = clone->_clone(alloc);
+
+		for (auto& instance : { clone, cloneOfClone })
+		{
+			LS_TEST_ASSERT(instance->getNumFields() == rtti->getNumFields());
+
+			for (UINT32 i = 0; i < rtti->getNumFields(); i++)
+				LS_TEST_ASSERT(instance->getField(i) == rtti->getField(i));
+
+			LS_TEST_ASSERT(instance->findField(0) == idField);
+			LS_TEST_ASSERT(instance->findField("parent") == parentField);
+		}
+
+		alloc.destruct(cloneOfClone);
+		alloc.destruct(clone);
+	}
+
+	void SerializationTestSuite::testTypeIdLookup()
+	{
+		// Types with small IDs are found in the flat table
+		LS_TEST_ASSERT(IReflectable::_getRTTIfromTypeId(TID_TestNode) == TestNode::getRTTIStatic());
+		LS_TEST_ASSERT(IReflectable::_getRTTIfromTypeId(TID_TestDataBlock) == TestDataBlock::getRTTIStatic());
+		LS_TEST_ASSERT(IReflectable::_getFlatRTTITypes()[TID_TestNode] == TestNode::getRTTIStatic());
+
+		// Types with large IDs are found in the map
+		LS_TEST_ASSERT(IReflectable::_getRTTIfromTypeId(TID_TestLargeTypeId) == TestLargeTypeId::getRTTIStatic());
+		LS_TEST_ASSERT(IReflectable::getAllRTTITypes()[TID_TestLargeTypeId] == TestLargeTypeId::getRTTIStatic());
+
+		// Unused IDs
+		LS_TEST_ASSERT(IReflectable::_getRTTIfromTypeId(60199) == nullptr);
+		LS_TEST_ASSERT(IReflectable::_getRTTIfromTypeId(IReflectable::MAX_FLAT_TYPE_ID - 1) == nullptr);
+		LS_TEST_ASSERT(IReflectable::_getRTTIfromTypeId(IReflectable::MAX_FLAT_TYPE_ID + 60199) == nullptr);
+		LS_TEST_ASSERT(IReflectable::createInstanceFromTypeId(60199) == nullptr);
+
+		LS_TEST_ASSERT(IReflectable::createInstanceFromTypeId(TID_TestNode)->getTypeId() == TID_TestNode);
+		LS_TEST_ASSERT(IReflectable::createInstanceFromTypeId(TID_TestLargeTypeId)->getTypeId() == TID_TestLargeTypeId);
+
+		// Both kinds of types get created when decoding
+		SPtr<TestNode> node = createNode(10);
+		SPtr<TestLargeTypeId> large = ls_pool_shared_ptr_new<TestLargeTypeId>();
+		large->value = 20;
+
+		MemorySerializer serializer;
+		MemorySerializerBuffer buffer;
+
+		UINT32 size = serializer.encode(node.get(), buffer);
+		SPtr<TestNode> decodedNode = std::static_pointer_cast<TestNode>(serializer.decode(buffer.getData(), size));
+		LS_TEST_ASSERT(decodedNode != nullptr && decodedNode->id == 10 && decodedNode->name == node->name);
+
+		size = serializer.encode(large.get(), buffer);
+		SPtr<IReflectable> decodedLarge = serializer.decode(buffer.getData(), size);
+		LS_TEST_ASSERT(decodedLarge != nullptr && decodedLarge->getTypeId() == TID_TestLargeTypeId);
+		LS_TEST_ASSERT(std::static_pointer_cast<TestLargeTypeId>(decodedLarge)->value == 20);
+	}
+
+	void SerializationTestSuite::testClonerShallowReferences()
+	{
+		SPtr<TestNode> root = createHierarchy();
+		SPtr<TestNode> clone = std::static_pointer_cast<TestNode>(BinaryCloner::clone(root.get(), true));
+
+		LS_TEST_ASSERT(clone != nullptr && clone != root);
+		LS_TEST_ASSERT(clone->id == 0 && clone->name == "Node0");
+
+		// Shallow clones keep referencing the original objects
+		LS_TEST_ASSERT(clone->children.size() == 2);
+		LS_TEST_ASSERT(clone->children[0] == root->children[0]);
+		LS_TEST_ASSERT(clone->children[1] == root->children[1]);
+
+		releaseHierarchy(root);
+	}
+
+	void SerializationTestSuite::testClonerDeepReferences()
+	{
+		SPtr<TestNode> root = createHierarchy();
+		SPtr<TestNode> clone = std::static_pointer_cast<TestNode>(BinaryCloner::clone(root.get(), false));
+
+		LS_TEST_ASSERT(clone != nullptr && clone != root);
+		LS_TEST_ASSERT(clone->children.size() == 2);
+
+		for (UINT32 i = 0; i < 2; i++)
+		{
+			const SPtr<TestNode>& child = clone->children[i];
+
+			LS_TEST_ASSERT(child != root->children[i]);
+			LS_TEST_ASSERT(child->id == i + 1 && child->name == root->children[i]->name);
+			LS_TEST_ASSERT(child->link != nullptr && child->link != root->children[i]->link);
+			LS_TEST_ASSERT(child->link->id == 3);
+
+			// References to the root point to its clone
+			LS_TEST_ASSERT(child->parent == clone);
+		}
+
+		// Objects referenced from multiple places are cloned only once
+		LS_TEST_ASSERT(clone->children[0]->link == clone->children[1]->link);
+
+		// Modifying the clone leaves the original untouched
+		clone->children[0]->link->name = "Modified";
+		LS_TEST_ASSERT(root->children[0]->link->name == "Node3");
+
+		releaseHierarchy(clone);
+		releaseHierarchy(root);
+	}
+
+	void SerializationTestSuite::testClonerCycles()
+	{
+		// Cycle that doesn't go through the root object, and isn't flagged as a weak reference
+		SPtr<TestNode> root = createNode(0);
+		SPtr<TestNode> first = createNode(1);
+		SPtr<TestNode> second = createNode(2);
+
+		root->link = first;
+		first->link = second;
+		second->link = first;
+
+		SPtr<TestNode> clone = std::static_pointer_cast<TestNode>(BinaryCloner::clone(root.get(), false));
+
+		LS_TEST_ASSERT(clone != nullptr);
+
+		SPtr<TestNode> clonedFirst = clone->link;
+		LS_TEST_ASSERT(clonedFirst != nullptr && clonedFirst != first && clonedFirst->id == 1);
+
+		SPtr<TestNode> clonedSecond = clonedFirst->link;
+		LS_TEST_ASSERT(clonedSecond != nullptr && clonedSecond != second && clonedSecond->id == 2);
+		LS_TEST_ASSERT(clonedSecond->link == clonedFirst);
+
+		second->link = nullptr;
+		clonedSecond->link = nullptr;
+	}
+
+	void SerializationTestSuite::testClonerDataBlock()
+	{
+		static constexpr UINT32 DATA_SIZE = 64 * 1024 + 7;
+
+		SPtr<TestDataBlock> original = createDataBlock(DATA_SIZE);
+		SPtr<TestDataBlock> clone = std::static_pointer_cast<TestDataBlock>(BinaryCloner::clone(original.get()));
+
+		LS_TEST_ASSERT(isSameDataBlock(clone, original));
+		LS_TEST_ASSERT(clone->data.data() != original->data.data());
+
+		SPtr<TestDataBlock> empty = ls_shared_ptr_new<TestDataBlock>();
+		SPtr<TestDataBlock> emptyClone = std::static_pointer_cast<TestDataBlock>(BinaryCloner::clone(empty.get()));
+
+		LS_TEST_ASSERT(emptyClone != nullptr && emptyClone->data.empty());
+	}
+
+	void SerializationTestSuite::testMemorySerializerBuffer()
+	{
+		// Sizes ending close to the buffer growth steps, so the final flush has to grow the buffer
+		static constexpr UINT32 SIZES[] = { 0, 100, 16 * 1024 - 40, 16 * 1024, 48 * 1024 - 40, 1024 * 1024 - 40 };
+
+		MemorySerializer serializer;
+		MemorySerializerBuffer buffer;
+		for (auto& size : SIZES)
+		{
+			SPtr<TestDataBlock> original = createDataBlock(size);
+
+			// Reused buffer
+			UINT32 bytesWritten = serializer.encode(original.get(), buffer);
+			LS_TEST_ASSERT(bytesWritten > size && buffer.getSize() == bytesWritten);
+			LS_TEST_ASSERT(buffer.getCapacity() >= buffer.getSize());
+			LS_TEST_ASSERT(isSameDataBlock(serializer.decode(buffer.getData(), buffer.getSize()), original));
+
+			buffer.shrinkToFit();
+			LS_TEST_ASSERT(buffer.getCapacity() == bytesWritten && buffer.getSize() == bytesWritten);
+			LS_TEST_ASSERT(isSameDataBlock(serializer.decode(buffer.getData(), buffer.getSize()), original));
+
+			// Buffer owned by the caller
+			UINT32 legacyBytesWritten = 0;
+			UINT8* data = serializer.encode(original.get(), legacyBytesWritten);
+			LS_TEST_ASSERT(data != nullptr && legacyBytesWritten == bytesWritten);
+			LS_TEST_ASSERT(isSameDataBlock(serializer.decode(data, legacyBytesWritten), original));
+
+			ls_free(data);
+		}
+
+		buffer.clear();
+		buffer.shrinkToFit();
+		LS_TEST_ASSERT(buffer.getCapacity() == 0 && buffer.getData() == nullptr);
+	}
+
+	void SerializationTestSuite::testFileSerializer()
+	{
+		const Path path = mTestDirectory + "Objects.asset";
+
+		Vector<SPtr<TestDataBlock>> originals = { createDataBlock(100), createDataBlock(0), createDataBlock(70000) };
+		{
+			FileEncoder encoder(path);
+			for (auto& original : originals)
+				encoder.encode(original.get());
+		}
+
+		for (auto memoryMapped : { false, true })
+		{
+			FileDecoder decoder(path, memoryMapped);
+			LS_TEST_ASSERT(decoder.getVersion() == 2);
+
+			for (auto& original : originals)
+			{
+				LS_TEST_ASSERT(decoder.hasMore());
+				LS_TEST_ASSERT(isSameDataBlock(decoder.decode(), original));
+			}
+
+			// No trailing empty record at the end of the file
+			LS_TEST_ASSERT(!decoder.hasMore());
+			LS_TEST_ASSERT(decoder.decode() == nullptr);
+		}
+
+		FileDecoder decoder(path);
+		decoder.skip();
+		decoder.skip();
+		LS_TEST_ASSERT(isSameDataBlock(decoder.decode(), originals[2]));
+		LS_TEST_ASSERT(!decoder.hasMore());
+	}
+
+	void SerializationTestSuite::testFileSerializerLegacy()
+	{
+		const Path path = mTestDirectory + "Legacy.asset";
+
+		// Legacy files have no header and prefix each record with a 32-bit size
+		Vector<SPtr<TestDataBlock>> originals = { createDataBlock(3), createDataBlock(20000) };
+		{
+			SPtr<DataStream> stream = FileSystem::createAndOpenFile(path);
+
+			MemorySerializer serializer;
+			MemorySerializerBuffer buffer;
+			for (auto& original : originals)
+			{
+				UINT32 size = serializer.encode(original.get(), buffer);
+				stream->write(&size, sizeof(size));
+				stream->write(buffer.getData(), size);
+			}
+		}
+
+		FileDecoder decoder(path);
+		LS_TEST_ASSERT(decoder.getVersion() == 1);
+
+		for (auto& original : originals)
+		{
+			LS_TEST_ASSERT(decoder.hasMore());
+			LS_TEST_ASSERT(isSameDataBlock(decoder.decode(), original));
+		}
+
+		LS_TEST_ASSERT(!decoder.hasMore());
+		LS_TEST_ASSERT(decoder.decode() == nullptr);
+	}
+
+	void SerializationTestSuite::testDecodeParallel()
+	{
+		// Enough nodes to decode in parallel, and few enough to fall back to decoding serially
+		for (auto numNodes : { 1000U, 10U })
+		{
+			SPtr<TestNode> root = createTree(numNodes);
+
+			MemorySerializer serializer;
+			MemorySerializerBuffer buffer;
+			UINT32 size = serializer.encode(root.get(), buffer);
+
+			SPtr<MemoryDataStream> stream = ls_shared_ptr_new<MemoryDataStream>(buffer.getData(), size, false);
+
+			BinarySerializer bs;
+			SPtr<IReflectable> decoded = bs.decode(stream, size);
+			LS_TEST_ASSERT(stream->tell() == size);
+
+			stream->seek(0);
+			SPtr<IReflectable> decodedParallel = bs.decodeParallel(stream, size);
+			LS_TEST_ASSERT(stream->tell() == size);
+
+			LS_TEST_ASSERT(decoded != nullptr && rtti_is_of_type<TestNode>(decoded));
+			LS_TEST_ASSERT(decodedParallel != nullptr && rtti_is_of_type<TestNode>(decodedParallel));
+
+			UnorderedMap<TestNode*, TestNode*> visited;
+			LS_TEST_ASSERT(isSameGraph(root.get(), static_cast<TestNode*>(decoded.get()), visited));
+
+			visited.clear();
+			LS_TEST_ASSERT(isSameGraph(static_cast<TestNode*>(decoded.get()), 
+				static_cast<TestNode*>(decodedParallel.get()), visited));
+		}
+	}
+
+	void SerializationTestSuite::testDecodeParallelException()
+	{
+		SPtr<TestNode> root = createTree(1000);
+		root->children.back()->id = FAILING_NODE_ID;
+
+		MemorySerializer serializer;
+		MemorySerializerBuffer buffer;
+		UINT32 size = serializer.encode(root.get(), buffer);
+
+		SPtr<MemoryDataStream> stream = ls_shared_ptr_new<MemoryDataStream>(buffer.getData(), size, false);
+
+		// Exceptions thrown on the worker threads reach the caller
+		bool thrown = false;
+		try
+		{
+			BinarySerializer bs;
+			bs.decodeParallel(stream, size);
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+
+		LS_TEST_ASSERT(thrown);
+	}
+
+	void SerializationTestSuite::testDiffHashes()
+	{
+		SPtr<TestNode> original = createTree(64);
+		SPtr<TestNode> modified = std::static_pointer_cast<TestNode>(BinaryCloner::clone(original.get(), false));
+		IDiff& diffHandler = TestNode::getRTTIStatic()->getDiffHandler();
+
+		// Separately encoded objects with equal contents hash equally, and have no differences
+		SPtr<SerializedObject> orgSerialized = SerializedObject::create(*original);
+		SPtr<SerializedObject> newSerialized = SerializedObject::create(*modified);
+
+		UINT64 orgHash = 0;
+		UINT64 newHash = 0;
+		LS_TEST_ASSERT(orgSerialized->getHash(orgHash) && newSerialized->getHash(newHash));
+		LS_TEST_ASSERT(orgHash == newHash);
+		LS_TEST_ASSERT(diffHandler.generateDiff(orgSerialized, newSerialized) == nullptr);
+
+		// Clones keep the cached hash
+		UINT64 cloneHash = 0;
+		SPtr<SerializedInstance> clone = orgSerialized->clone();
+		LS_TEST_ASSERT(clone->getHash(cloneHash) && cloneHash == orgHash);
+
+		// Modifying a single leaf changes the hash, and the diff transforms the original into the modified object. The
+		// leaf is also linked from its sibling.
+		SPtr<TestNode> leaf = modified->children[3]->children[2];
+		LS_TEST_ASSERT(leaf->children.empty() && modified->children[3]->children[3]->link == leaf);
+
+		leaf->name = "Modified";
+		newSerialized = SerializedObject::create(*modified);
+		LS_TEST_ASSERT(newSerialized->getHash(newHash) && newHash != orgHash);
+
+		SPtr<SerializedObject> diff = diffHandler.generateDiff(orgSerialized, newSerialized);
+		LS_TEST_ASSERT(diff != nullptr);
+
+		diffHandler.applyDiff(original, diff, nullptr);
+		LS_TEST_ASSERT(original->children[3]->children[2]->name == "Modified");
+		LS_TEST_ASSERT(original->children[3]->children[3]->link->name == "Modified");
+		LS_TEST_ASSERT(original->children[3]->children[1]->name == "Node18");
+		LS_TEST_ASSERT(original->children[0]->name == "Node1");
+
+		// Hashes of modified instances are re-calculated once invalidated
+		SPtr<SerializedObject> nodeSerialized = SerializedObject::create(*createNode(5));
+		SPtr<SerializedField> nameField = std::static_pointer_cast<SerializedField>(
+			nodeSerialized->subObjects[0].entries[1].serialized);
+
+		UINT64 nodeHash = 0;
+		UINT64 modifiedNodeHash = 0;
+		LS_TEST_ASSERT(nodeSerialized->getHash(nodeHash));
+
+		nameField->value[nameField->size - 1] = '6';
+		nameField->invalidateHash();
+		nodeSerialized->invalidateHash();
+		LS_TEST_ASSERT(nodeSerialized->getHash(modifiedNodeHash) && modifiedNodeHash != nodeHash);
+
+		// Instances that reference themselves can't be compared by hash
+		SPtr<SerializedObject> cyclic = SerializedObject::create(*createNode(1));
+		cyclic->subObjects[0].entries[2].serialized = cyclic;
+
+		UINT64 cyclicHash = 0;
+		LS_TEST_ASSERT(!cyclic->getHash(cyclicHash));
+
+		cyclic->subObjects[0].entries[2].serialized = nullptr;
+	}
+
+	void SerializationTestSuite::testSerializedObjectLifetime()
+	{
+		SPtr<TestNode> root = createTree(64);
+		SPtr<SerializedObject> serialized = SerializedObject::create(*root);
+
+		SPtr<SerializedArray> children = std::static_pointer_cast<SerializedArray>(
+			serialized->subObjects[0].entries[3].serialized);
+		LS_TEST_ASSERT(children != nullptr && children->numElements == 4);
+
+		SPtr<SerializedObject> child = std::static_pointer_cast<SerializedObject>(children->entries[1].serialized);
+		SPtr<SerializedObject> clone = std::static_pointer_cast<SerializedObject>(child->clone());
+
+		// Any instance keeps the memory of the entire hierarchy alive
+		serialized = nullptr;
+		children = nullptr;
+
+		SPtr<TestNode> decoded = std::static_pointer_cast<TestNode>(child->decode());
+		LS_TEST_ASSERT(decoded != nullptr && decoded->id == 2 && decoded->name == "Node2");
+		LS_TEST_ASSERT(decoded->children.size() == 4 && decoded->children[0]->name == "Node9");
+
+		// Clones don't depend on the memory of the original hierarchy
+		child = nullptr;
+
+		decoded = std::static_pointer_cast<TestNode>(clone->decode());
+		LS_TEST_ASSERT(decoded != nullptr && decoded->id == 2 && decoded->name == "Node2");
+		LS_TEST_ASSERT(decoded->children.size() == 4 && decoded->children[3]->name == "Node12");
+	}
+}
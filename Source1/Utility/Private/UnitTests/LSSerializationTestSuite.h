@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Testing/LSTestSuite.h"
+
+namespace ls
+{
+	class SerializationTestSuite : public TestSuite
+	{
+	public:
+		SerializationTestSuite();
+		void startUp() override;
+		void shutDown() override;
+
+	private:
+		void testFindField();
+		void testTypeIdLookup();
+		void testClonerShallowReferences();
+		void testClonerDeepReferences();
+		void testClonerCycles();
+		void testClonerDataBlock();
+		void testMemorySerializerBuffer();
+		void testFileSerializer();
+		void testFileSerializerLegacy();
+		void testDecodeParallel();
+		void testDecodeParallelException();
+		void testDiffHashes();
+		void testSerializedObjectLifetime();
+
+		Path mTestDirectory;
+	};
+}
@@ -1,9 +1,15 @@
 #include "Private/UnitTests/LSUtilityTestSuite.h"
 #include "Private/UnitTests/LSFileSystemTestSuite.h"
+#include "Private/UnitTests/LSSerializationTestSuite.h"
 #include "General/LSOctree.h"
 #include "General/LSBitfield.h"
 #include "General/LSDynArray.h"
 #include "Math/LSComplex.h"
+#include "Allocators/LSPoolAlloc.h"
+#include "Thread/LSThreadPool.h"
+#include "Thread/LSTaskScheduler.h"
+#include "Logger/LSLogger.h"
+#include "String/LSStringID.h"
 
 namespace ls
 {
@@ -43,10 +49,18 @@ namespace ls
 	{
 		SPtr<TestSuite> fileSystemTests = create<FileSystemTestSuite>();
 		add(fileSystemTests);
+
+		SPtr<TestSuite> serializationTests = create<SerializationTestSuite>();
+		add(serializationTests);
+
+		ThreadPool::startUp<TThreadPool<>>(LS_THREAD_HARDWARE_CONCURRENCY, 64);
+		TaskScheduler::startUp(TaskSchedulerMode::WorkStealing);
 	}
 
 	void UtilityTestSuite::shutDown()
 	{
+		TaskScheduler::shutDown();
+		ThreadPool::shutDown();
 	}
 
 	UtilityTestSuite::UtilityTestSuite()
@@ -56,6 +70,21 @@ namespace ls
 		LS_ADD_TEST(UtilityTestSuite::testSmallVector)
 		LS_ADD_TEST(UtilityTestSuite::testDynArray)
 		LS_ADD_TEST(UtilityTestSuite::testComplex)
+		LS_ADD_TEST(UtilityTestSuite::testTaskGraph)
+		LS_ADD_TEST(UtilityTestSuite::testParallelFor)
+		LS_ADD_TEST(UtilityTestSuite::testTaskSchedulerShutdown)
+		LS_ADD_TEST(UtilityTestSuite::testNestedTaskWait)
+		LS_ADD_TEST(UtilityTestSuite::testTaskWaitExecutesTasks)
+		LS_ADD_TEST(UtilityTestSuite::testPoolAlloc)
+		LS_ADD_TEST(UtilityTestSuite::testPoolSharedPtr)
+		LS_ADD_TEST(UtilityTestSuite::testFrameArena)
+		LS_ADD_TEST(UtilityTestSuite::testMemPool)
+		LS_ADD_TEST(UtilityTestSuite::testMemAllocProfiler)
+		LS_ADD_TEST(UtilityTestSuite::testLogAsync)
+		LS_ADD_TEST(UtilityTestSuite::testLogFiltering)
+		LS_ADD_TEST(UtilityTestSuite::testLogCapacity)
+		LS_ADD_TEST(UtilityTestSuite::testStringID)
+		LS_ADD_TEST(UtilityTestSuite::testStringUtil)
 	}
 
 	void UtilityTestSuite::testBitfield()
@@ -504,4 +533,996 @@ namespace ls
 		LS_TEST_ASSERT(c7.imag() == 0.620616496f);
 		c7 = 0;
 	}
+
+	void UtilityTestSuite::testTaskGraph()
+	{
+		for(auto mode : { TaskSchedulerMode::GlobalQueue, TaskSchedulerMode::WorkStealing })
+		{
+			TaskScheduler scheduler(mode);
+
+			// Diamond: a -> (b, c) -> d, queued in reverse order
+			UINT32 a = 0, b = 0, c = 0, d = 0;
+			SPtr<Task> taskA = Task::create("A", [&]() { a = 1; });
+			SPtr<Task> taskB = Task::create("B", [&]() { b = a + 1; }, TaskPriority::Normal, taskA);
+			SPtr<Task> taskC = Task::create("C", [&]() { c = a + 2; }, TaskPriority::Normal, taskA);
+			SPtr<Task> taskD = Task::create("D", [&]() { d = b + c; }, { taskB, taskC });
+
+			scheduler.addTask(taskD);
+			scheduler.addTask(taskC);
+			scheduler.addTask(taskB);
+			scheduler.addTask(taskA);
+
+			taskD->wait();
+			LS_TEST_ASSERT(d == 5);
+
+			// Task group in the middle of the graph
+			std::atomic<UINT32> sum{0};
+			UINT32 result = 0;
+
+			SPtr<Task> first = Task::create("First", [&]() { sum = 1; });
+			SPtr<TaskGroup> group = TaskGroup::create("Group", [&](UINT32 idx) { sum += idx; }, 100, { first });
+			SPtr<Task> last = Task::create("Last", [&]() { result = sum; }, { group });
+
+			scheduler.addTask(last);
+			scheduler.addTaskGroup(group);
+			scheduler.addTask(first);
+
+			last->wait();
+			LS_TEST_ASSERT(group->isComplete());
+			LS_TEST_ASSERT(result == 1 + 99 * 100 / 2);
+
+			// Canceling a task cancels everything that depends on it
+			bool executed = false;
+			SPtr<Task> gate = Task::create("Gate", []() { });
+			SPtr<Task> canceled = Task::create("Canceled", [&]() { executed = true; }, TaskPriority::Normal, gate);
+			SPtr<Task> dependant = Task::create("Dependant", [&]() { executed = true; }, TaskPriority::Normal, canceled);
+
+			scheduler.addTask(dependant);
+			scheduler.addTask(canceled);
+			canceled->cancel();
+			scheduler.addTask(gate);
+
+			dependant->wait();
+			LS_TEST_ASSERT(dependant->isCanceled());
+			LS_TEST_ASSERT(!executed);
+
+			// Task groups depending on a canceled task execute none of their items, and cancel their own dependants
+			std::atomic<UINT32> numExecuted{0};
+			SPtr<Task> groupGate = Task::create("GroupGate", []() { });
+			SPtr<Task> canceledDependency = Task::create("CanceledDependency", []() { }, TaskPriority::Normal, groupGate);
+			SPtr<TaskGroup> canceledGroup = TaskGroup::create("CanceledGroup", [&](UINT32 idx) { numExecuted++; }, 100,
+				{ canceledDependency });
+			SPtr<Task> groupDependant = Task::create("GroupDependant", [&]() { numExecuted++; }, { canceledGroup });
+
+			scheduler.addTask(groupDependant);
+			scheduler.addTaskGroup(canceledGroup);
+			scheduler.addTask(canceledDependency);
+			canceledDependency->cancel();
+			scheduler.addTask(groupGate);
+
+			canceledGroup->wait();
+			groupDependant->wait();
+			LS_TEST_ASSERT(canceledGroup->isCanceled() && !canceledGroup->isComplete());
+			LS_TEST_ASSERT(groupDependant->isCanceled());
+
+			// Same for groups queued after their dependency was already canceled
+			SPtr<TaskGroup> lateGroup = TaskGroup::create("LateGroup", [&](UINT32 idx) { numExecuted++; }, 100,
+				{ canceledDependency });
+
+			scheduler.addTaskGroup(lateGroup);
+			lateGroup->wait();
+			LS_TEST_ASSERT(lateGroup->isCanceled());
+			LS_TEST_ASSERT(numExecuted == 0);
+		}
+	}
+
+	void UtilityTestSuite::testParallelFor()
+	{
+		for(auto mode : { TaskSchedulerMode::GlobalQueue, TaskSchedulerMode::WorkStealing })
+		{
+			TaskScheduler scheduler(mode);
+
+			static constexpr UINT32 COUNT = 100000;
+			Vector<UINT32> values(COUNT, 0);
+
+			// Per-index task group
+			SPtr<TaskGroup> group = TaskGroup::create("Group", [&](UINT32 idx) { values[idx] += idx; }, COUNT);
+			scheduler.addTaskGroup(group);
+			group->wait();
+
+			// Chunked range, leaving the first few elements untouched
+			std::atomic<UINT32> numSmallChunks{0};
+			scheduler.parallelFor(10, COUNT, 64, [&](UINT32 begin, UINT32 end)
+			{
+				if(end - begin < 64 && end != COUNT)
+					numSmallChunks++;
+
+				for(UINT32 i = begin; i < end; i++)
+					values[i] += 1;
+			});
+
+			LS_TEST_ASSERT(numSmallChunks == 0);
+
+			bool valid = true;
+			for(UINT32 i = 0; i < COUNT; i++)
+				valid &= values[i] == (i < 10 ? i : i + 1);
+
+			LS_TEST_ASSERT(valid);
+
+			// Nested
+			std::atomic<UINT32> total{0};
+			scheduler.parallelFor(0, 16, 1, [&](UINT32 begin, UINT32 end)
+			{
+				for(UINT32 i = begin; i < end; i++)
+					scheduler.parallelFor(0, 1000, 0, [&](UINT32 innerBegin, UINT32 innerEnd) { total += innerEnd - innerBegin; });
+			});
+
+			LS_TEST_ASSERT(total == 16 * 1000);
+		}
+	}
+
+	void UtilityTestSuite::testTaskSchedulerShutdown()
+	{
+		static constexpr UINT32 NUM_CHAINED = 16;
+		static constexpr UINT32 NUM_INDEPENDENT = 256;
+
+		for(auto mode : { TaskSchedulerMode::GlobalQueue, TaskSchedulerMode::WorkStealing })
+		{
+			std::atomic<UINT32> numExecuted{0};
+			Vector<SPtr<Task>> tasks;
+			{
+				TaskScheduler scheduler(mode);
+
+				// Most of the chain only gets queued after the scheduler started shutting down
+				SPtr<Task> previous;
+				for(UINT32 i = 0; i < NUM_CHAINED; i++)
+				{
+					SPtr<Task> task = Task::create("Chained", [&numExecuted]()
+					{
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+						numExecuted++;
+					}, TaskPriority::Normal, previous);
+
+					scheduler.addTask(task);
+					tasks.push_back(task);
+					previous = task;
+				}
+
+				for(UINT32 i = 0; i < NUM_INDEPENDENT; i++)
+				{
+					SPtr<Task> task = Task::create("Independent", [&numExecuted]() { numExecuted++; });
+
+					scheduler.addTask(task);
+					tasks.push_back(task);
+				}
+			}
+
+			LS_TEST_ASSERT(numExecuted == NUM_CHAINED + NUM_INDEPENDENT);
+
+			bool allComplete = true;
+			for(auto& task : tasks)
+				allComplete &= task->isComplete();
+
+			LS_TEST_ASSERT(allComplete);
+		}
+	}
+
+	void UtilityTestSuite::testNestedTaskWait()
+	{
+		TaskScheduler scheduler(TaskSchedulerMode::GlobalQueue);
+
+		while(scheduler.getNumWorkers() > 2)
+			scheduler.removeWorker();
+
+		while(scheduler.getNumWorkers() < 2)
+			scheduler.addWorker();
+
+		// Returns false if the flag doesn't get set within a second
+		auto waitFor = [](const std::atomic<bool>& flag)
+		{
+			for(UINT32 i = 0; i < 1000 && !flag; i++)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+			return flag.load();
+		};
+
+		std::atomic<bool> innerStarted{false};
+		std::atomic<bool> independentStarted{false};
+		bool ranConcurrently = false;
+
+		// Occupies the second slot until the outer task starts executing the inner task
+		SPtr<Task> blocker = Task::create("Blocker", [&]() { waitFor(innerStarted); });
+		SPtr<Task> outer = Task::create("Outer", [&]()
+		{
+			SPtr<Task> inner = Task::create("Inner", [&]()
+			{
+				innerStarted = true;
+				ranConcurrently = waitFor(independentStarted);
+			}, TaskPriority::High);
+
+			SPtr<Task> independent = Task::create("Independent", [&]() { independentStarted = true; });
+
+			scheduler.addTask(inner);
+			scheduler.addTask(independent);
+
+			// Executes the inner task in the slot of this task, leaving the freed up slot to the independent task
+			inner->wait();
+		});
+
+		scheduler.addTask(blocker);
+		scheduler.addTask(outer);
+
+		// Not using wait(), as this thread would help execute the tasks
+		while(!outer->isComplete())
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		LS_TEST_ASSERT(ranConcurrently);
+	}
+
+	void UtilityTestSuite::testTaskWaitExecutesTasks()
+	{
+		for(auto mode : { TaskSchedulerMode::GlobalQueue, TaskSchedulerMode::WorkStealing })
+		{
+			TaskScheduler scheduler(mode);
+
+			// Without workers, queued tasks can only make progress on the waiting thread
+			while(scheduler.getNumWorkers() > 0)
+				scheduler.removeWorker();
+
+			const std::thread::id waitingThread = std::this_thread::get_id();
+
+			bool ranOnWaitingThread = false;
+			SPtr<Task> dependency = Task::create("Dependency", []() { });
+			SPtr<Task> task = Task::create("Task", [&]()
+			{
+				ranOnWaitingThread = std::this_thread::get_id() == waitingThread;
+			}, TaskPriority::Normal, dependency);
+
+			scheduler.addTask(task);
+			scheduler.addTask(dependency);
+
+			task->wait();
+			LS_TEST_ASSERT(task->isComplete());
+			LS_TEST_ASSERT(ranOnWaitingThread);
+
+			std::atomic<UINT32> numExecuted{0};
+			SPtr<TaskGroup> group = TaskGroup::create("Group", [&](UINT32 idx) { numExecuted++; }, 100);
+			scheduler.addTaskGroup(group);
+
+			group->wait();
+			LS_TEST_ASSERT(numExecuted == 100);
+		}
+	}
+
+	void UtilityTestSuite::testPoolAlloc()
+	{
+		static constexpr UINT32 COUNT = 1000;
+
+		// Elements freed in any order are returned to the block they were allocated from
+		{
+			PoolAlloc<32, 64> pool;
+
+			UINT32* values[COUNT];
+			for(UINT32 i = 0; i < COUNT; i++)
+			{
+				values[i] = (UINT32*)pool.alloc();
+				values[i][0] = i;
+				values[i][7] = i;
+			}
+
+			UnorderedSet<void*> freed;
+			for(UINT32 i = 0; i < COUNT; i += 2)
+			{
+				pool.free(values[i]);
+				freed.insert(values[i]);
+			}
+
+			bool valid = true;
+			for(UINT32 i = 1; i < COUNT; i += 2)
+				valid &= values[i][0] == i && values[i][7] == i;
+
+			LS_TEST_ASSERT(valid);
+
+			// No block became empty, so the freed elements are reused before any new block is allocated
+			bool reused = true;
+			for(UINT32 i = 0; i < COUNT; i += 2)
+			{
+				values[i] = (UINT32*)pool.alloc();
+				reused &= freed.erase(values[i]) == 1;
+			}
+
+			LS_TEST_ASSERT(reused);
+
+			for(UINT32 i = 0; i < COUNT; i++)
+				pool.free(values[i]);
+		}
+
+		// Recently freed elements are kept in the thread local cache, and handed out again first
+		typedef PoolAlloc<32, 64, 4, true, 8> CachedPool;
+		{
+			CachedPool pool;
+
+			void* elem = pool.alloc();
+			pool.free(elem);
+			LS_TEST_ASSERT(pool.alloc() == elem);
+			pool.free(elem);
+
+			// Overflowing the cache returns half of it to the pool
+			void* elems[9];
+			for(auto& entry : elems)
+				entry = pool.alloc();
+
+			for(auto& entry : elems)
+				pool.free(entry);
+
+			LS_TEST_ASSERT(pool.alloc() == elems[8]);
+			pool.free(elems[8]);
+
+			// The cache belongs to the first pool, so the other pool falls back to its own blocks
+			CachedPool otherPool;
+			void* otherElem = otherPool.alloc();
+			otherPool.free(otherElem);
+
+			void* poolElem = pool.alloc();
+			LS_TEST_ASSERT(poolElem != otherElem);
+			LS_TEST_ASSERT(otherPool.alloc() == otherElem);
+
+			// Both pools must get all of their elements back before they are destroyed
+			pool.free(poolElem);
+			otherPool.free(otherElem);
+		}
+
+		// Elements allocated on worker threads and freed on this one end up back in the pool through this thread's cache.
+		// Elements the workers keep in their own caches are taken back by the pool when it is destroyed.
+		{
+			static constexpr UINT32 NUM_THREADS = 4;
+			static constexpr UINT32 NUM_WORKER_CACHED = 4;
+			CachedPool pool;
+
+			UINT32* values[NUM_THREADS][COUNT];
+			Vector<HThread> threads;
+			for(UINT32 i = 0; i < NUM_THREADS; i++)
+			{
+				threads.push_back(ThreadPool::instance().run("testPoolAlloc", [&pool, &values, i]()
+				{
+					for(UINT32 j = 0; j < COUNT; j++)
+					{
+						values[i][j] = (UINT32*)pool.alloc();
+						values[i][j][0] = i * COUNT + j;
+					}
+
+					void* cached[NUM_WORKER_CACHED];
+					for(auto& entry : cached)
+						entry = pool.alloc();
+
+					for(auto& entry : cached)
+						pool.free(entry);
+				}));
+			}
+
+			for(auto& thread : threads)
+				thread.blockUntilComplete();
+
+			UnorderedSet<void*> unique;
+			bool valid = true;
+			for(UINT32 i = 0; i < NUM_THREADS; i++)
+			{
+				for(UINT32 j = 0; j < COUNT; j++)
+				{
+					valid &= values[i][j][0] == i * COUNT + j;
+					unique.insert(values[i][j]);
+				}
+			}
+
+			LS_TEST_ASSERT(valid);
+			LS_TEST_ASSERT(unique.size() == NUM_THREADS * COUNT);
+
+			for(UINT32 i = 0; i < NUM_THREADS; i++)
+			{
+				for(UINT32 j = 0; j < COUNT; j++)
+					pool.free(values[i][j]);
+			}
+		}
+	}
+
+	/** Object that counts how many of its instances are alive. */
+	struct PoolSharedPtrObject
+	{
+		PoolSharedPtrObject(UINT32 value, std::atomic<INT32>& numAlive)
+			:value(value), numAlive(numAlive)
+		{
+			numAlive++;
+		}
+
+		~PoolSharedPtrObject()
+		{
+			numAlive--;
+		}
+
+		UINT32 value;
+		std::atomic<INT32>& numAlive;
+	};
+
+	void UtilityTestSuite::testPoolSharedPtr()
+	{
+		static constexpr UINT32 COUNT = 1000;
+		std::atomic<INT32> numAlive{0};
+
+		// Objects are constructed with the provided arguments, and destructed along with their last reference
+		{
+			SPtr<PoolSharedPtrObject> object = ls_pool_shared_ptr_new<PoolSharedPtrObject>(5, numAlive);
+			LS_TEST_ASSERT(object->value == 5 && numAlive == 1);
+
+			SPtr<PoolSharedPtrObject> copy = object;
+			std::weak_ptr<PoolSharedPtrObject> weak = object;
+			object = nullptr;
+			LS_TEST_ASSERT(numAlive == 1 && copy->value == 5);
+
+			// Reference counts outlive the object while weak references remain
+			copy = nullptr;
+			LS_TEST_ASSERT(numAlive == 0 && weak.expired());
+		}
+
+		// Memory of released objects gets reused
+		{
+			SPtr<PoolSharedPtrObject> object = ls_pool_shared_ptr_new<PoolSharedPtrObject>(1, numAlive);
+			PoolSharedPtrObject* address = object.get();
+			object = nullptr;
+
+			object = ls_pool_shared_ptr_new<PoolSharedPtrObject>(2, numAlive);
+			LS_TEST_ASSERT(object.get() == address && object->value == 2);
+		}
+
+		LS_TEST_ASSERT(numAlive == 0);
+
+		// Objects created on worker threads and released on this one
+		{
+			static constexpr UINT32 NUM_THREADS = 4;
+
+			Vector<SPtr<PoolSharedPtrObject>> objects[NUM_THREADS];
+			Vector<HThread> threads;
+			for(UINT32 i = 0; i < NUM_THREADS; i++)
+			{
+				threads.push_back(ThreadPool::instance().run("testPoolSharedPtr", [&objects, &numAlive, i]()
+				{
+					for(UINT32 j = 0; j < COUNT; j++)
+						objects[i].push_back(ls_pool_shared_ptr_new<PoolSharedPtrObject>(i * COUNT + j, numAlive));
+				}));
+			}
+
+			for(auto& thread : threads)
+				thread.blockUntilComplete();
+
+			UnorderedSet<void*> unique;
+			bool valid = true;
+			for(UINT32 i = 0; i < NUM_THREADS; i++)
+			{
+				for(UINT32 j = 0; j < COUNT; j++)
+				{
+					valid &= objects[i][j]->value == i * COUNT + j;
+					unique.insert(objects[i][j].get());
+				}
+			}
+
+			LS_TEST_ASSERT(valid);
+			LS_TEST_ASSERT(unique.size() == NUM_THREADS * COUNT);
+			LS_TEST_ASSERT(numAlive == (INT32)(NUM_THREADS * COUNT));
+		}
+
+		LS_TEST_ASSERT(numAlive == 0);
+	}
+
+	void UtilityTestSuite::testFrameArena()
+	{
+		TaskScheduler& scheduler = TaskScheduler::instance();
+
+		static constexpr UINT32 COUNT = 256;
+		UINT32* values[COUNT];
+
+		auto runFrame = [&](UINT32 frame)
+		{
+			// Allocate on the workers, and read the memory back on this thread
+			scheduler.parallelFor(0, COUNT, 1, [&](UINT32 begin, UINT32 end)
+			{
+				for(UINT32 i = begin; i < end; i++)
+				{
+					values[i] = (UINT32*)gFrameArena().alloc(1024 * sizeof(UINT32));
+					for(UINT32 j = 0; j < 1024; j++)
+						values[i][j] = frame + i + j;
+				}
+			});
+
+			bool valid = true;
+			for(UINT32 i = 0; i < COUNT; i++)
+			{
+				for(UINT32 j = 0; j < 1024; j++)
+					valid &= values[i][j] == frame + i + j;
+			}
+
+			FrameArena::endFrame();
+			return valid;
+		};
+
+		for(UINT32 i = 0; i < 8; i++)
+			LS_TEST_ASSERT(runFrame(i));
+
+		auto getNumHeapBlocks = []()
+		{
+			UINT64 numHeapBlocks = 0;
+			for(auto& stats : FrameArena::getAllStats())
+				numHeapBlocks += stats.numHeapBlocks;
+
+			return numHeapBlocks;
+		};
+
+		// Blocks from previous frames should get recycled
+		UINT64 numHeapBlocks = getNumHeapBlocks();
+		for(UINT32 i = 0; i < 8; i++)
+			runFrame(i);
+
+		LS_TEST_ASSERT(getNumHeapBlocks() <= numHeapBlocks + scheduler.getNumWorkers() + 1);
+
+		UINT64 peakFrameBytes = 0;
+		for(auto& stats : FrameArena::getAllStats())
+			peakFrameBytes += stats.peakFrameBytes;
+
+		LS_TEST_ASSERT(peakFrameBytes >= COUNT * 1024 * sizeof(UINT32));
+
+		// Aligned allocations
+		UINT8* data = gFrameArena().allocAligned(100, 256);
+		LS_TEST_ASSERT(((UINT64)data & 255) == 0);
+		FrameArena::endFrame();
+	}
+
+	void UtilityTestSuite::testMemPool()
+	{
+		MemPool pool;
+
+		// Grows by adding areas, and releases them once empty
+		static constexpr UINT32 COUNT = 1024;
+		UINT32* values[COUNT];
+		for(UINT32 i = 0; i < COUNT; i++)
+		{
+			UINT32 count = 64 + (i * 37) % 1024;
+			values[i] = (UINT32*)pool.alloc(count * sizeof(UINT32));
+			values[i][0] = count;
+			values[i][count - 1] = i;
+		}
+
+		MemPoolStats stats = pool.getStats();
+		LS_TEST_ASSERT(stats.numAreas > 1);
+		LS_TEST_ASSERT(stats.numAllocs == COUNT);
+
+		bool valid = true;
+		for(UINT32 i = 0; i < COUNT; i += 2)
+		{
+			valid &= values[i][values[i][0] - 1] == i;
+			MemPool::free(values[i]);
+		}
+
+		for(UINT32 i = 1; i < COUNT; i += 2)
+		{
+			valid &= values[i][values[i][0] - 1] == i;
+			MemPool::free(values[i]);
+		}
+
+		LS_TEST_ASSERT(valid);
+
+		stats = pool.getStats();
+		LS_TEST_ASSERT(stats.usedBytes == 0);
+		LS_TEST_ASSERT(stats.numAreas == 1);
+		LS_TEST_ASSERT(stats.getFragmentation() == 0.0f);
+
+		// Aligned, large and resized allocations
+		UINT8* aligned = (UINT8*)pool.allocAligned(100, 256);
+		LS_TEST_ASSERT(((UINT64)aligned & 255) == 0);
+		LS_TEST_ASSERT(MemPool::getAllocSize(aligned) >= 100);
+
+		UINT8* large = (UINT8*)pool.allocAligned(MemPool::MAX_POOLED_SIZE * 2, 64);
+		LS_TEST_ASSERT(((UINT64)large & 63) == 0);
+		LS_TEST_ASSERT(pool.getStats().numLargeAllocs == 1);
+
+		memset(aligned, 5, 100);
+		aligned = (UINT8*)pool.realloc(aligned, 1000);
+		LS_TEST_ASSERT(aligned[0] == 5 && aligned[99] == 5);
+
+		MemPool::free(aligned);
+		MemPool::free(large);
+		LS_TEST_ASSERT(pool.getStats().usedBytes == 0);
+
+		// Large allocations outlive the pool they were allocated from
+		{
+			MemPool largePool;
+			large = (UINT8*)largePool.alloc(MemPool::MAX_POOLED_SIZE * 2);
+		}
+
+		memset(large, 5, MemPool::MAX_POOLED_SIZE * 2);
+		MemPool::free(large);
+
+		// Memory allocated by another thread and freed on this one is handed back to that thread's pool, on its next
+		// allocation
+		UINT64 numRemoteFrees = MemPool::getGlobalStats().numRemoteFrees;
+		std::atomic<UINT32> step{0};
+
+		HThread thread = ThreadPool::instance().run("testMemPool", [&values, &step]()
+		{
+			for(UINT32 i = 0; i < COUNT; i++)
+				values[i] = (UINT32*)MemPool::current().alloc(64 + i);
+
+			step = 1;
+			while(step != 2)
+				std::this_thread::yield();
+
+			MemPool::free(MemPool::current().alloc(64));
+		});
+
+		while(step != 1)
+			std::this_thread::yield();
+
+		for(UINT32 i = 0; i < COUNT; i++)
+			MemPool::free(values[i]);
+
+		step = 2;
+		thread.blockUntilComplete();
+
+		LS_TEST_ASSERT(MemPool::getGlobalStats().numRemoteFrees >= numRemoteFrees + COUNT);
+	}
+
+	void UtilityTestSuite::testMemAllocProfiler()
+	{
+		// Drives the profiler directly, so it's tested even if MemoryAllocator<T> doesn't report to it
+		UINT32 category = MemAllocProfiler::registerCategory("UtilityTestSuite::testMemAllocProfiler");
+		LS_TEST_ASSERT(MemAllocProfiler::registerCategory("UtilityTestSuite::testMemAllocProfiler") == category);
+
+		MemAllocSnapshot before = MemAllocProfiler::getSnapshot();
+
+		void* dataA = malloc(100 + MemAllocProfiler::HEADER_SIZE);
+		void* ptrA = MemAllocProfiler::onAlloc(dataA, MemAllocProfiler::HEADER_SIZE, 100, category, (void*)&before);
+		LS_TEST_ASSERT(ptrA == (UINT8*)dataA + MemAllocProfiler::HEADER_SIZE);
+
+		void* dataB;
+		void* ptrB;
+		{
+			MemAllocProfiler::Scope scope("testMemAllocProfiler");
+
+			dataB = malloc(200 + 64);
+			ptrB = MemAllocProfiler::onAlloc(dataB, 64, 200, category, (void*)&before);
+		}
+
+		MemAllocSnapshot after = MemAllocProfiler::getSnapshot();
+		MemAllocSnapshot delta = after.getDelta(before);
+
+		LS_TEST_ASSERT(delta.categories[category].stats.numAllocs == 2);
+		LS_TEST_ASSERT(delta.categories[category].stats.allocatedBytes == 300);
+		LS_TEST_ASSERT(delta.categories[category].stats.liveBytes == 300);
+
+		UINT32 numSites = 0;
+		for(auto& site : delta.sites)
+		{
+			if(site.category != category)
+				continue;
+
+			if(site.scope != nullptr)
+			{
+				LS_TEST_ASSERT(strcmp(site.scope, "testMemAllocProfiler") == 0 && site.stats.liveBytes == 200);
+			}
+			else
+			{
+				LS_TEST_ASSERT(site.address == (void*)&before && site.stats.liveBytes == 100);
+			}
+
+			numSites++;
+		}
+
+		LS_TEST_ASSERT(numSites == 2);
+
+		LS_TEST_ASSERT(MemAllocProfiler::onFree(ptrA) == dataA);
+		LS_TEST_ASSERT(MemAllocProfiler::onFree(ptrB) == dataB);
+		::free(dataA);
+		::free(dataB);
+
+		MemAllocStats stats = MemAllocProfiler::getSnapshot().categories[category].stats;
+		LS_TEST_ASSERT(stats.liveBytes == 0);
+		LS_TEST_ASSERT(stats.peakLiveBytes == 300);
+		LS_TEST_ASSERT(stats.numFrees == 2);
+
+#if LS_MEMORY_TRACKING
+		// Allocations made through MemoryAllocator<T> are attributed to the code making them, not to the allocator
+		struct TrackedCategory { };
+		typedef MemoryAllocator<TrackedCategory> TrackedAllocator;
+
+		UINT32 trackedCategory = MemAllocProfiler::registerCategory(typeid(TrackedCategory).name());
+		before = MemAllocProfiler::getSnapshot();
+
+		void* trackedA = TrackedAllocator::allocate(100);
+		void* trackedB = TrackedAllocator::allocate(200);
+
+		delta = MemAllocProfiler::getSnapshot().getDelta(before);
+		LS_TEST_ASSERT(delta.categories[trackedCategory].stats.liveBytes == 300);
+
+		Vector<void*> addresses;
+		for(auto& site : delta.sites)
+		{
+			if(site.category == trackedCategory && site.stats.liveBytes > 0)
+				addresses.push_back(site.address);
+		}
+
+		LS_TEST_ASSERT(addresses.size() == 2 && addresses[0] != addresses[1]);
+
+		TrackedAllocator::free(trackedA);
+		TrackedAllocator::free(trackedB);
+		LS_TEST_ASSERT(MemAllocProfiler::getSnapshot().categories[trackedCategory].stats.liveBytes == 0);
+#endif
+	}
+
+	void UtilityTestSuite::testLogAsync()
+	{
+		static constexpr UINT32 NUM_THREADS = 4;
+		static constexpr UINT32 NUM_MESSAGES = 3000; // Enough to wrap around the thread buffers
+
+		// Runs twice, so the second logger is likely created where the first one used to be
+		for (UINT32 run = 0; run < 2; run++)
+		{
+			// Only the log is checked, so don't flood the console with the messages
+			Logger logger;
+			logger.setConsoleOutput(false);
+			logger._startAsync();
+
+			Vector<HThread> threads;
+			for (UINT32 i = 0; i < NUM_THREADS; i++)
+			{
+				threads.push_back(ThreadPool::instance().run("testLogAsync", [&logger, i]()
+				{
+					for (UINT32 j = 0; j < NUM_MESSAGES; j++)
+						logger.log(toString(i) + " " + toString(j), 0);
+				}));
+			}
+
+			// Messages too long to be queued are processed on the calling thread
+			logger.log(String(16 * 1024, 'a'), 1);
+
+			for (auto& thread : threads)
+				thread.blockUntilComplete();
+
+			logger.flush();
+
+			// All messages are in the log, in the order each thread logged them
+			UINT32 nextMessage[NUM_THREADS] = { };
+			UINT32 numLong = 0;
+			bool inOrder = true;
+
+			LogEntry entry;
+			while (logger.getLog().getUnreadEntry(entry))
+			{
+				if (entry.getChannel() == 1)
+				{
+					numLong++;
+					continue;
+				}
+
+				const Vector<String> parts = StringUtil::split(entry.getMessage(), " ");
+				const UINT32 thread = parseUINT32(parts[0]);
+				const UINT32 message = parseUINT32(parts[1]);
+
+				inOrder &= thread < NUM_THREADS && nextMessage[thread] == message;
+				if (thread < NUM_THREADS)
+					nextMessage[thread] = message + 1;
+			}
+
+			LS_TEST_ASSERT(inOrder);
+			LS_TEST_ASSERT(numLong == 1);
+			for (UINT32 i = 0; i < NUM_THREADS; i++)
+				LS_TEST_ASSERT(nextMessage[i] == NUM_MESSAGES);
+
+			// Messages logged around stopping are processed right away
+			logger.logLogger("Before stop");
+			logger._stopAsync();
+			logger.logLogger("After stop");
+
+			LS_TEST_ASSERT(logger.getLog().getUnreadEntry(entry) && entry.getMessage() == "Before stop");
+			LS_TEST_ASSERT(logger.getLog().getUnreadEntry(entry) && entry.getMessage() == "After stop");
+		}
+	}
+
+	void UtilityTestSuite::testLogFiltering()
+	{
+		Logger logger;
+		logger.setRateLimit((UINT32)DebugChannel::Warning, 3);
+		logger.setRateLimitInterval(60 * 1000);
+
+		UINT32 numEvaluated = 0;
+		auto getMessage = [&numEvaluated]()
+		{
+			numEvaluated++;
+			return String("Test message");
+		};
+
+		auto logWarning = [&logger, &getMessage]() { LS_LOG_TO(logger, getMessage(), DebugChannel::Warning); };
+		auto logDebug = [&logger, &getMessage]() { LS_LOG_TO(logger, getMessage(), DebugChannel::Debug); };
+
+		auto countEntries = [&logger]()
+		{
+			UINT32 count = 0;
+			LogEntry entry;
+			while (logger.getLog().getUnreadEntry(entry))
+				count++;
+
+			return count;
+		};
+
+		// Messages over the rate limit are dropped without being evaluated
+		for (UINT32 i = 0; i < 10; i++)
+			logWarning();
+
+		LS_TEST_ASSERT(numEvaluated == 3);
+		LS_TEST_ASSERT(countEntries() == 3);
+
+		// Disabled channels don't evaluate their messages
+		logger.setMinimumSeverity(DebugChannel::Warning);
+		LS_TEST_ASSERT(!logger.isChannelEnabled((UINT32)DebugChannel::Debug));
+		LS_TEST_ASSERT(logger.isChannelEnabled((UINT32)DebugChannel::CompilerWarning));
+
+		logDebug();
+		logger.logLogger("Test message");
+
+		LS_TEST_ASSERT(numEvaluated == 3);
+		LS_TEST_ASSERT(countEntries() == 0);
+
+		logger.setChannelEnabled((UINT32)DebugChannel::Debug, true);
+		logDebug();
+
+		LS_TEST_ASSERT(numEvaluated == 4);
+		LS_TEST_ASSERT(countEntries() == 1);
+
+		// Dropped messages are reported once the interval ends, before the next message
+		logger.setRateLimitInterval(0);
+		logWarning();
+
+		LS_TEST_ASSERT(numEvaluated == 5);
+
+		LogEntry entry;
+		LS_TEST_ASSERT(logger.getLog().getUnreadEntry(entry));
+		LS_TEST_ASSERT(entry.getChannel() == (UINT32)DebugChannel::Warning);
+		LS_TEST_ASSERT(entry.getMessage().find("Dropped 7 message(s)") == 0);
+
+		LS_TEST_ASSERT(logger.getLog().getUnreadEntry(entry));
+		LS_TEST_ASSERT(entry.getMessage().find("Test message") == 0);
+		LS_TEST_ASSERT(countEntries() == 0);
+	}
+
+	void UtilityTestSuite::testLogCapacity()
+	{
+		Log log;
+		log.setCapacity(10);
+
+		for (UINT32 i = 0; i < 25; i++)
+			log.logMsg("Unread " + toString(i), 0);
+
+		// Unread entries are discarded once there are no read ones left
+		LogEntry entry;
+		LS_TEST_ASSERT(log.getUnreadEntry(entry));
+		LS_TEST_ASSERT(entry.getMessage() == "Unread 15");
+		LS_TEST_ASSERT(log.getNumDiscarded() == 15);
+
+		while (log.getUnreadEntry(entry))
+		{ }
+
+		LS_TEST_ASSERT(log.getEntries().size() == 10);
+
+		// Read entries are discarded first
+		for (UINT32 i = 0; i < 5; i++)
+			log.logMsg("New " + toString(i), 0);
+
+		Vector<LogEntry> entries = log.getEntries();
+		LS_TEST_ASSERT(entries.size() == 5);
+		LS_TEST_ASSERT(entries.front().getMessage() == "Unread 20");
+		LS_TEST_ASSERT(log.getNumDiscarded() == 20);
+
+		log.clear();
+		LS_TEST_ASSERT(log.getNumDiscarded() == 0);
+	}
+
+	void UtilityTestSuite::testStringID()
+	{
+		StringID literal = LS_SID("testStringID");
+		LS_TEST_ASSERT(literal == StringID("testStringID"));
+		LS_TEST_ASSERT(literal == StringID(String("testStringID")));
+		LS_TEST_ASSERT(literal != StringID("testStringId"));
+		LS_TEST_ASSERT(strcmp(literal.c_str(), "testStringID") == 0);
+		LS_TEST_ASSERT(literal.size() == 12);
+
+		// Names of any length
+		String longName(4096, 'a');
+		StringID longId(longName);
+		LS_TEST_ASSERT(longId == StringID(longName));
+		LS_TEST_ASSERT(longId.c_str() == longName);
+
+		// Enough entries for the table to grow multiple times, from multiple threads
+		static constexpr UINT32 NUM_NAMES = 50000;
+		static constexpr UINT32 NUM_THREADS = 4;
+
+		Vector<StringID> ids[NUM_THREADS];
+		for (auto& entry : ids)
+			entry.resize(NUM_NAMES);
+
+		Vector<HThread> threads;
+		for (UINT32 i = 0; i < NUM_THREADS; i++)
+		{
+			threads.push_back(ThreadPool::instance().run("testStringID", [&ids, i]()
+			{
+				for (UINT32 j = 0; j < NUM_NAMES; j++)
+					ids[i][j] = StringID("testStringID" + toString(j));
+			}));
+		}
+
+		for (auto& thread : threads)
+			thread.blockUntilComplete();
+
+		for (UINT32 j = 0; j < NUM_NAMES; j++)
+		{
+			for (UINT32 i = 1; i < NUM_THREADS; i++)
+				LS_TEST_ASSERT(ids[i][j] == ids[0][j]);
+
+			LS_TEST_ASSERT(ids[0][j].c_str() == "testStringID" + toString(j));
+		}
+	}
+
+	void UtilityTestSuite::testStringUtil()
+	{
+		// Views yield the same substrings as the allocating versions
+		const String text = "  first second,third ,,fourth ";
+		Vector<String> parts = StringUtil::split(text, " ,");
+		LS_TEST_ASSERT(parts.size() == 4);
+		LS_TEST_ASSERT(parts[0] == "first" && parts[3] == "fourth");
+
+		UINT32 idx = 0;
+		for (StringView part : StringUtil::splitView(text, " ,"))
+		{
+			LS_TEST_ASSERT(idx < parts.size() && part == parts[idx]);
+			LS_TEST_ASSERT(part.data() >= text.data() && part.data() < text.data() + text.size());
+			idx++;
+		}
+		LS_TEST_ASSERT(idx == parts.size());
+
+		parts = StringUtil::split("a b c d", " ", 2);
+		LS_TEST_ASSERT(parts.size() == 3 && parts[2] == "c d");
+		LS_TEST_ASSERT(StringUtil::split("").size() == 1);
+		LS_TEST_ASSERT(StringUtil::split("   ").empty());
+
+		// Tokens can contain delimiters when quoted, and trailing delimiters are ignored
+		parts = StringUtil::tokenise("a \"b c\" d ");
+		LS_TEST_ASSERT(parts.size() == 3);
+		LS_TEST_ASSERT(parts[0] == "a" && parts[1] == "b c" && parts[2] == "d");
+
+		idx = 0;
+		for (StringView token : StringUtil::tokeniseView("a \"b c\" d "))
+			LS_TEST_ASSERT(token == parts[idx++]);
+		LS_TEST_ASSERT(idx == parts.size());
+
+		Vector<WString> wideParts = StringUtil::split(L"one two", L" ");
+		LS_TEST_ASSERT(wideParts.size() == 2 && wideParts[1] == L"two");
+
+		// Searches both within and past the SIMD blocks
+		String haystack(100, 'a');
+		haystack[70] = ';';
+		haystack[90] = ',';
+		LS_TEST_ASSERT(StringUtil::findFirstOf(haystack, ",") == 90);
+		LS_TEST_ASSERT(StringUtil::findFirstOf(haystack, ",;") == 70);
+		LS_TEST_ASSERT(StringUtil::findFirstOf(haystack, ",;", 71) == 90);
+		LS_TEST_ASSERT(StringUtil::findFirstOf(haystack, ",;:!?.-+/") == 70);
+		LS_TEST_ASSERT(StringUtil::findFirstOf(haystack, "xyz") == StringView::npos);
+		LS_TEST_ASSERT(StringUtil::findFirstNotOf(haystack, "a", 10) == 70);
+		LS_TEST_ASSERT(StringUtil::findFirstNotOf(haystack, "a;,") == StringView::npos);
+
+		LS_TEST_ASSERT(StringUtil::startsWith("Hello World", "hello"));
+		LS_TEST_ASSERT(!StringUtil::startsWith("Hello World", "hello", false));
+		LS_TEST_ASSERT(StringUtil::endsWith("Hello World", "world"));
+		LS_TEST_ASSERT(StringUtil::match("Hello World", "hel*orld", false));
+		LS_TEST_ASSERT(!StringUtil::match("Hello World", "hel*orld", true));
+		LS_TEST_ASSERT(StringUtil::compare("abc", "ABD", false) < 0);
+		LS_TEST_ASSERT(StringUtil::compare("abc", "ABC", false) == 0);
+		LS_TEST_ASSERT(StringUtil::compare("abc", "ABC", true) > 0);
+		LS_TEST_ASSERT(StringUtil::replaceAll("a, b, c", ", ", ";") == "a;b;c");
+		LS_TEST_ASSERT(StringUtil::replaceAll("abc", "", "x") == "abc");
+	}
 }
@@ -17,5 +17,20 @@ namespace ls
 		void testSmallVector();
 		void testDynArray();
 		void testComplex();
+		void testTaskGraph();
+		void testParallelFor();
+		void testTaskSchedulerShutdown();
+		void testNestedTaskWait();
+		void testTaskWaitExecutesTasks();
+		void testPoolAlloc();
+		void testPoolSharedPtr();
+		void testFrameArena();
+		void testMemPool();
+		void testMemAllocProfiler();
+		void testLogAsync();
+		void testLogFiltering();
+		void testLogCapacity();
+		void testStringID();
+		void testStringUtil();
 	};
 }
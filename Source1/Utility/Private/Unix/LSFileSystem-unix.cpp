@@ -134,10 +134,13 @@ namespace ls
 		}
 	}
 
-	SPtr<DataStream> FileSystem::openFile(const Path& path, bool readOnly)
+	SPtr<DataStream> FileSystem::openFile(const Path& path, bool readOnly, bool memoryMapped)
 	{
 		String pathString = path.toString();
 
+		if (readOnly && memoryMapped)
+			return ls_shared_ptr_new<MMapDataStream>(path);
+
 		DataStream::AccessMode accessMode = DataStream::READ;
 		if (!readOnly)
 			accessMode = (DataStream::AccessMode)((UINT32)accessMode | (UINT32)DataStream::WRITE);
@@ -273,7 +273,7 @@ namespace ls
 			win32_handleError(GetLastError(), oldPathStr);
 	}
 
-	SPtr<DataStream> FileSystem::openFile(const Path& fullPath, bool readOnly)
+	SPtr<DataStream> FileSystem::openFile(const Path& fullPath, bool readOnly, bool memoryMapped)
 	{
 		WString pathWString = UTF8::toWide(fullPath.toString());
 		const wchar_t* pathString = pathWString.c_str();
@@ -284,6 +284,9 @@ namespace ls
 			return nullptr;
 		}
 
+		if (readOnly && memoryMapped)
+			return ls_shared_ptr_new<MMapDataStream>(fullPath);
+
 		DataStream::AccessMode accessMode = DataStream::READ;
 		if (!readOnly)
 			accessMode = (DataStream::AccessMode)(accessMode | (UINT32)DataStream::WRITE);
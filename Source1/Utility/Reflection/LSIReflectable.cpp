@@ -13,7 +13,11 @@ namespace ls
 				"\" has a duplicate ID: " + toString(rttiType->getRTTIId()));
 		}
 
-		getAllRTTITypes()[rttiType->getRTTIId()] = rttiType;
+		const UINT32 typeId = rttiType->getRTTIId();
+		getAllRTTITypes()[typeId] = rttiType;
+
+		if(typeId < MAX_FLAT_TYPE_ID)
+			_getFlatRTTITypes()[typeId] = rttiType;
 	}
 
 	SPtr<IReflectable> IReflectable::createInstanceFromTypeId(UINT32 rttiTypeId)
@@ -29,6 +33,9 @@ namespace ls
 
 	RTTITypeBase* IReflectable::_getRTTIfromTypeId(UINT32 rttiTypeId)
 	{
+		if(rttiTypeId < MAX_FLAT_TYPE_ID)
+			return _getFlatRTTITypes()[rttiTypeId];
+
 		const auto iterFind = getAllRTTITypes().find(rttiTypeId);
 		if(iterFind != getAllRTTITypes().end())
 			return iterFind->second;
@@ -37,6 +37,9 @@ namespace ls
 			return mAllRTTITypes;
 		}
 
+		/** Type IDs below this value can be looked up through a flat table, instead of through getAllRTTITypes(). */
+		static constexpr UINT32 MAX_FLAT_TYPE_ID = 1 << 16;
+
 		/** Returns true if current RTTI class is derived from @p base (Or if it is the same type as base). */
 		bool isDerivedFrom(RTTITypeBase* base);
 
@@ -66,6 +69,17 @@ namespace ls
 		/** Checks if the provided type id is unique. */
 		static bool _isTypeIdDuplicate(UINT32 typeId);
 
+		/**
+		 * Returns a table of MAX_FLAT_TYPE_ID entries, containing all RTTI types with IDs below MAX_FLAT_TYPE_ID indexed by
+		 * their type ID. Unused IDs are null. The table has a fixed size and never moves, so it can be read from any thread
+		 * (e.g. during BinarySerializer::decodeParallel()) even if types get registered later.
+		 */
+		static RTTITypeBase** _getFlatRTTITypes()
+		{
+			static RTTITypeBase* mFlatRTTITypes[MAX_FLAT_TYPE_ID] = { };
+			return mFlatRTTITypes;
+		}
+
 		/**
 		 * Iterates over all RTTI types and reports any circular references (for example one type having a field referencing
 		 * another type, and that type having a field referencing the first type). Circular references are problematic
@@ -92,6 +92,20 @@ namespace ls
 		 * location and contains the proper type.
 		 */
 		virtual void arrayElemFromBuffer(RTTITypeBase* rtti, void* object, int index, void* buffer) = 0;
+
+		/**
+		 * Copies the value of the field from one object to another, without going through an intermediate buffer. Both
+		 * objects must be of the type owning the field.
+		 */
+		virtual void copyValue(RTTITypeBase* srcRtti, void* srcObject, RTTITypeBase* dstRtti, void* dstObject) = 0;
+
+		/**
+		 * Copies the value at the specified array index of the field from one object to another, without going through an
+		 * intermediate buffer. Both objects must be of the type owning the field, and the destination array must be large
+		 * enough.
+		 */
+		virtual void copyArrayElem(RTTITypeBase* srcRtti, void* srcObject, RTTITypeBase* dstRtti, void* dstObject, 
+			int index) = 0;
 	};
 
 	/** Represents a plain class field containing a specific type. */
@@ -298,6 +312,45 @@ namespace ls
 			(rttiObject->*arraySetter)(castObject, index, value);
 		}
 
+		/** @copydoc RTTIPlainFieldBase::copyValue */
+		void copyValue(RTTITypeBase* srcRtti, void* srcObject, RTTITypeBase* dstRtti, void* dstObject) override
+		{
+			checkIsArray(false);
+			checkType<DataType>();
+
+			if(!setter)
+			{
+				LS_EXCEPT(InternalErrorException,
+					"Specified field (" + mName + ") has no setter.");
+			}
+
+			InterfaceType* srcRttiObject = static_cast<InterfaceType*>(srcRtti);
+			InterfaceType* dstRttiObject = static_cast<InterfaceType*>(dstRtti);
+
+			DataType value = (srcRttiObject->*getter)(static_cast<ObjectType*>(srcObject));
+			(dstRttiObject->*setter)(static_cast<ObjectType*>(dstObject), value);
+		}
+
+		/** @copydoc RTTIPlainFieldBase::copyArrayElem */
+		void copyArrayElem(RTTITypeBase* srcRtti, void* srcObject, RTTITypeBase* dstRtti, void* dstObject, 
+			int index) override
+		{
+			checkIsArray(true);
+			checkType<DataType>();
+
+			if(!arraySetter)
+			{
+				LS_EXCEPT(InternalErrorException, 
+					"Specified field (" + mName + ") has no setter.");
+			}
+
+			InterfaceType* srcRttiObject = static_cast<InterfaceType*>(srcRtti);
+			InterfaceType* dstRttiObject = static_cast<InterfaceType*>(dstRtti);
+
+			DataType value = (srcRttiObject->*arrayGetter)(static_cast<ObjectType*>(srcObject), index);
+			(dstRttiObject->*arraySetter)(static_cast<ObjectType*>(dstObject), index, value);
+		}
+
 	private:
 		union
 		{
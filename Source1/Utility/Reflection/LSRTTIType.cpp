@@ -3,33 +3,69 @@
 
 namespace ls
 {
+	/** Instance whose fields the next RTTITypeBase constructed on this thread should share. */
+	static LS_THREADLOCAL RTTITypeBase* sCloneSource = nullptr;
+
+	RTTITypeBase::RTTITypeBase()
+	{
+		if(sCloneSource != nullptr)
+		{
+			mFields = sCloneSource->mFields;
+			sCloneSource = nullptr;
+		}
+	}
+
 	RTTITypeBase::~RTTITypeBase() 
 	{
-		for(const auto& item : mFields)
+		for(const auto& item : mOwnFields.fields)
 			ls_delete(item);
 	}
 
+	void RTTITypeBase::beginClone()
+	{
+		sCloneSource = this;
+	}
+
 	RTTIField* RTTITypeBase::findField(const String& name)
 	{
-		auto foundElement = std::find_if(mFields.begin(), mFields.end(), [&name](RTTIField* x) { return x->mName == name; });
+		auto foundElement = mFields->indicesByName.find(name);
 
-		if(foundElement == mFields.end())
+		if(foundElement == mFields->indicesByName.end())
 		{
 			LS_EXCEPT(InternalErrorException, 
 				"Cannot find a field with the specified name: " + name);
 		}
 
-		return *foundElement;
+		return mFields->fields[foundElement->second];
 	}
 
 	RTTIField* RTTITypeBase::findField(int uniqueFieldId)
 	{
-		auto foundElement = std::find_if(mFields.begin(), mFields.end(), [&uniqueFieldId](RTTIField* x) { return x->mUniqueId == uniqueFieldId; });
+		if(uniqueFieldId < 0 || uniqueFieldId >= (int)mFields->indicesById.size())
+			return nullptr;
+
+		const UINT32 idx = mFields->indicesById[uniqueFieldId];
+		if(idx == INVALID_FIELD_IDX)
+			return nullptr;
+
+		return mFields->fields[idx];
+	}
+
+	RTTIField* RTTITypeBase::findField(int uniqueFieldId, UINT32& nextIdx)
+	{
+		const Vector<RTTIField*>& fields = mFields->fields;
+		if(nextIdx < (UINT32)fields.size() && fields[nextIdx]->mUniqueId == uniqueFieldId)
+			return fields[nextIdx++];
 
-		if(foundElement == mFields.end())
+		if(uniqueFieldId < 0 || uniqueFieldId >= (int)mFields->indicesById.size())
 			return nullptr;
 
-		return *foundElement;
+		const UINT32 idx = mFields->indicesById[uniqueFieldId];
+		if(idx == INVALID_FIELD_IDX)
+			return nullptr;
+
+		nextIdx = idx + 1;
+		return mFields->fields[idx];
 	}
 
 	void RTTITypeBase::addNewField(RTTIField* field)
@@ -40,25 +76,29 @@ namespace ls
 				"Field argument can't be null.");
 		}
 
-		int uniqueId = field->mUniqueId;
-		auto foundElementById = std::find_if(mFields.begin(), mFields.end(), [uniqueId](RTTIField* x) { return x->mUniqueId == uniqueId; });
-
-		if(foundElementById != mFields.end())
+		FieldTable& table = *mFields;
+		const UINT32 uniqueId = field->mUniqueId;
+		if(uniqueId < (UINT32)table.indicesById.size() && table.indicesById[uniqueId] != INVALID_FIELD_IDX)
 		{
 			LS_EXCEPT(InternalErrorException, 
 				"Field with the same ID already exists.");
 		}
 
-		String& name = field->mName;
-		auto foundElementByName = std::find_if(mFields.begin(), mFields.end(), [&name](RTTIField* x) { return x->mName == name; });
-
-		if(foundElementByName != mFields.end())
+		if(table.indicesByName.find(field->mName) != table.indicesByName.end())
 		{
 			LS_EXCEPT(InternalErrorException, 
 				"Field with the same name already exists.");
 		}
 
-		mFields.push_back(field);
+		// IDs are 16-bit and assigned sequentially in practice, so a dense table stays small
+		if(uniqueId >= (UINT32)table.indicesById.size())
+			table.indicesById.resize(uniqueId + 1, INVALID_FIELD_IDX);
+
+		const UINT32 idx = (UINT32)table.fields.size();
+		table.indicesById[uniqueId] = idx;
+		table.indicesByName[field->mName] = idx;
+
+		table.fields.push_back(field);
 	}
 
 	class SerializationContextRTTI : public RTTIType<SerializationContext, IReflectable, SerializationContextRTTI>
@@ -304,7 +304,7 @@ namespace ls
 	class LS_UTILITY_EXPORT RTTITypeBase
 	{
 	public:
-		RTTITypeBase() = default;
+		RTTITypeBase();
 		virtual ~RTTITypeBase();
 
 		/** Returns RTTI type information for all classes that derive from the class that owns this RTTI type. */
@@ -367,10 +367,10 @@ namespace ls
 		}
 
 		/** Returns the total number of fields in this RTTI type. */
-		UINT32 getNumFields() const { return (UINT32)mFields.size(); }
+		UINT32 getNumFields() const { return (UINT32)mFields->fields.size(); }
 
 		/** Returns a field based on the field index. Use getNumFields() to get total number of fields available. */
-		RTTIField* getField(UINT32 idx) { return mFields.at(idx); }
+		RTTIField* getField(UINT32 idx) { return mFields->fields.at(idx); }
 
 		/**
 		 * Tries to find a field with the specified name. Throws an exception if it can't.
@@ -389,6 +389,18 @@ namespace ls
 		 */
 		RTTIField* findField(int uniqueFieldId);
 
+		/**
+		 * Same as findField(int), but checks the field at index @p nextIdx first, and then sets @p nextIdx to the index
+		 * following the found field. Lets callers that visit fields in the order they were registered in (such as when 
+		 * decoding serialized data) find each field with a single comparison.
+		 *
+		 * @param	uniqueFieldId	Unique identifier for the field.
+		 * @param	nextIdx			Index of the field expected to have the provided identifier. Start with zero.
+		 *
+		 * @return	nullptr if it can't find the field, in which case @p nextIdx is not modified.
+		 */
+		RTTIField* findField(int uniqueFieldId, UINT32& nextIdx);
+
 		/** @name Internal 
 		 *  @{
 		 */
@@ -397,9 +409,10 @@ namespace ls
 		virtual void _registerDerivedClass(RTTITypeBase* derivedClass) = 0;
 
 		/** 
-		 * Constucts a cloned version of the underlying class. The cloned version will not have any field information and
-		 * should instead be used for passing to various RTTIField methods during serialization/deserialization. This
-		 * allows each object instance to have a unique places to store temporary instance-specific data.
+		 * Constucts a cloned version of the underlying class. The cloned version doesn't register its own fields and
+		 * instead shares the fields (and their lookup tables) of the instance it was cloned from. It should be used for
+		 * passing to various RTTIField methods during serialization/deserialization. This allows each object instance to
+		 * have a unique places to store temporary instance-specific data.
 		 */
 		virtual RTTITypeBase* _clone(FrameAlloc& alloc) = 0;
 
@@ -414,8 +427,32 @@ namespace ls
 		 */
 		void addNewField(RTTIField* field);
 
+		/** 
+		 * Makes the next RTTITypeBase constructed on this thread a clone of this instance. Must be called right before 
+		 * constructing the clone. 
+		 */
+		void beginClone();
+
+		/** Returns true if this instance was created through _clone() and shares the fields of another instance. */
+		bool isClone() const { return mFields != &mOwnFields; }
+
 	private:
-		Vector<RTTIField*> mFields;
+		static constexpr UINT32 INVALID_FIELD_IDX = (UINT32)-1;
+
+		/** Fields of a type, along with tables used for looking them up. */
+		struct FieldTable
+		{
+			Vector<RTTIField*> fields;
+
+			/** Index of each field in @p fields, indexed by the field's unique ID. INVALID_FIELD_IDX for unused IDs. */
+			Vector<UINT32> indicesById;
+			UnorderedMap<String, UINT32> indicesByName;
+		};
+
+		FieldTable mOwnFields;
+
+		/** Points to mOwnFields, or to the fields of the instance this instance was cloned from. */
+		FieldTable* mFields = &mOwnFields;
 	};
 
 	/** Used for initializing a certain type as soon as the program is loaded. */
@@ -551,6 +588,7 @@ namespace ls
 		/** @copydoc RTTITypeBase::_clone */
 		RTTITypeBase* _clone(FrameAlloc& alloc) override
 		{
+			beginClone();
 			return alloc.construct<MyRTTIType>();
 		}
 
@@ -571,6 +609,9 @@ namespace ls
 			static_assert(!(std::is_base_of<ls::IReflectable, DataType>::value), 
 				"Data type derives from IReflectable but it is being added as a plain field.");
 
+			if (isClone())
+				return;
+
 			auto newField = ls_new<RTTIPlainField<InterfaceType, DataType, ObjectType>>();
 			newField->initSingle(name, uniqueId, getter, setter, flags);
 			addNewField(newField);
@@ -585,6 +626,9 @@ namespace ls
 			static_assert((std::is_base_of<ls::IReflectable, DataType>::value), 
 				"Invalid data type for complex field. It needs to derive from ls::IReflectable.");
 
+			if (isClone())
+				return;
+
 			auto newField = ls_new<RTTIReflectableField<InterfaceType, DataType, ObjectType>>();
 			newField->initSingle(name, uniqueId, getter, setter, flags);
 			addNewField(newField);
@@ -599,6 +643,9 @@ namespace ls
 			static_assert((std::is_base_of<ls::IReflectable, DataType>::value), 
 				"Invalid data type for complex field. It needs to derive from ls::IReflectable.");
 
+			if (isClone())
+				return;
+
 			auto newField = ls_new<RTTIReflectablePtrField<InterfaceType, DataType, ObjectType>>();
 			newField->initSingle(name, uniqueId, getter, setter, flags);
 			addNewField(newField);
@@ -619,6 +666,9 @@ namespace ls
 			static_assert(!(std::is_base_of<ls::IReflectable, DataType>::value), 
 				"Data type derives from IReflectable but it is being added as a plain field.");
 
+			if (isClone())
+				return;
+
 			auto newField = ls_new<RTTIPlainField<InterfaceType, DataType, ObjectType>>();
 			newField->initArray(name, uniqueId, getter, getSize, setter, setSize, flags);
 			addNewField(newField);
@@ -635,6 +685,9 @@ namespace ls
 			static_assert((std::is_base_of<ls::IReflectable, DataType>::value), 
 				"Invalid data type for complex field. It needs to derive from ls::IReflectable.");
 
+			if (isClone())
+				return;
+
 			auto newField = ls_new<RTTIReflectableField<InterfaceType, DataType, ObjectType>>();
 			newField->initArray(name, uniqueId, getter, getSize, setter, setSize, flags);
 			addNewField(newField);
@@ -651,6 +704,9 @@ namespace ls
 			static_assert((std::is_base_of<ls::IReflectable, DataType>::value), 
 				"Invalid data type for complex field. It needs to derive from ls::IReflectable.");
 
+			if (isClone())
+				return;
+
 			auto newField = ls_new<RTTIReflectablePtrField<InterfaceType, DataType, ObjectType>>();
 			newField->initArray(name, uniqueId, getter, getSize, setter, setSize, flags);
 			addNewField(newField);
@@ -661,6 +717,9 @@ namespace ls
 		void addDataBlockField(const String& name, UINT32 uniqueId, SPtr<DataStream> (InterfaceType::*getter)(ObjectType*, UINT32&), 
 			void (InterfaceType::*setter)(ObjectType*, const SPtr<DataStream>&, UINT32), UINT64 flags = 0)
 		{
+			if (isClone())
+				return;
+
 			auto newField = ls_new<RTTIManagedDataBlockField<InterfaceType, UINT8*, ObjectType>>();
 			newField->initSingle(name, uniqueId, getter, setter, flags);
 			addNewField(newField);
@@ -1,4 +1,6 @@
 #include "Serialization/LSBinaryCloner.h"
+#include "Error/LSException.h"
+#include "Logger/LSLogger.h"
 #include "Reflection/LSIReflectable.h"
 #include "Reflection/LSRTTIType.h"
 #include "Reflection/LSRTTIField.h"
@@ -6,7 +8,7 @@
 #include "Reflection/LSRTTIReflectableField.h"
 #include "Reflection/LSRTTIReflectablePtrField.h"
 #include "Reflection/LSRTTIManagedDataBlockField.h"
-#include "Serialization/LSMemorySerializer.h"
+#include "FileSystem/LSDataStream.h"
 
 namespace ls
 {
@@ -15,212 +17,234 @@ namespace ls
 		if (object == nullptr)
 			return nullptr;
 
-		ObjectReferenceData referenceData;
-		if (shallow)
+		SPtr<IReflectable> clonedObj = IReflectable::createInstanceFromTypeId(object->getRTTI()->getRTTIId());
+		if (clonedObj == nullptr)
+			return nullptr;
+
+		FrameAlloc& alloc = gFrameAlloc();
+		alloc.markFrame();
 		{
-			FrameAlloc& alloc = gFrameAlloc();
+			CloneContext context(alloc, shallow);
+
+			// References to the root object from within the hierarchy should point to its clone. Note that we don't own
+			// the root object, so we can't keep a reference to it.
+			ClonedObject& rootEntry = context.clonedObjects[object];
+			rootEntry.clone = clonedObj;
+			rootEntry.cloneInProgress = true;
 
-			alloc.markFrame();
-			gatherReferences(object, alloc, referenceData);
-			alloc.clear();
+			cloneFields(object, clonedObj.get(), context);
 		}
+		alloc.clear();
 
-		std::function<void*(UINT32)> allocator = &MemoryAllocator<GenAlloc>::allocate;
+		return clonedObj;
+	}
 
-		MemorySerializer ms;
-		UINT32 dataSize = 0;
-		UINT8* data = ms.encode(object, dataSize, allocator, shallow);
-		SPtr<IReflectable> clonedObj = ms.decode(data, dataSize);
+	SPtr<IReflectable> BinaryCloner::cloneReferencedObject(const SPtr<IReflectable>& object, bool isWeakRef,
+		CloneContext& context)
+	{
+		if (object == nullptr)
+			return nullptr;
 
-		if (shallow)
+		auto iterFind = context.clonedObjects.find(object.get());
+		if (iterFind != context.clonedObjects.end())
 		{
-			FrameAlloc& alloc = gFrameAlloc();
+			const ClonedObject& clonedObject = iterFind->second;
+			if (clonedObject.cloneInProgress && !isWeakRef)
+			{
+				LOGWRN("Detected a circular reference when cloning. Referenced object's fields " \
+					"will be resolved in an undefined order (i.e. one of the objects will not " \
+					"be fully cloned when assigned to its field). Use RTTI_Flag_WeakRef to " \
+					"get rid of this warning and tell the system which of the objects is allowed " \
+					"to be cloned after it is assigned to its field.");
+			}
 
-			alloc.markFrame();
-			restoreReferences(clonedObj.get(), alloc, referenceData);
-			alloc.clear();
+			return clonedObject.clone;
 		}
 
-		ls_free(data);
-		return clonedObj;
+		SPtr<IReflectable> clone = IReflectable::createInstanceFromTypeId(object->getRTTI()->getRTTIId());
+
+		// Keep a reference to the original object, as the field might have created it on the fly, and we don't want its
+		// address to be reused by another object while cloning
+		ClonedObject& clonedObject = context.clonedObjects[object.get()];
+		clonedObject.original = object;
+		clonedObject.clone = clone;
+
+		if (clone != nullptr)
+		{
+			clonedObject.cloneInProgress = true;
+			cloneFields(object.get(), clone.get(), context);
+
+			// Lookup again, as the entry is not guaranteed to stay valid while cloning its fields
+			context.clonedObjects[object.get()].cloneInProgress = false;
+		}
+
+		return clone;
 	}
 
-	void BinaryCloner::gatherReferences(IReflectable* object, FrameAlloc& alloc, ObjectReferenceData& referenceData)
+	void BinaryCloner::cloneFields(IReflectable* source, IReflectable* destination, CloneContext& context)
 	{
-		if (object == nullptr)
-			return;
+		FrameVector<RTTITypeBase*> types;
+		FrameVector<RTTITypeBase*> sourceRttiInstances;
+		FrameVector<RTTITypeBase*> destinationRttiInstances;
 
-		RTTITypeBase* rtti = object->getRTTI();
-		Stack<RTTITypeBase*> rttiInstances;
+		RTTITypeBase* rtti = source->getRTTI();
 		while (rtti != nullptr)
 		{
-			RTTITypeBase* rttiInstance = rtti->_clone(alloc);
+			types.push_back(rtti);
+			sourceRttiInstances.push_back(rtti->_clone(context.alloc));
+			destinationRttiInstances.push_back(rtti->_clone(context.alloc));
 
-			rttiInstance->onSerializationStarted(object, nullptr);
-			SubObjectReferenceData* subObjectData = nullptr;
+			rtti = rtti->getBaseClass();
+		}
 
-			UINT32 numFields = rtti->getNumFields();
-			for (UINT32 i = 0; i < numFields; i++)
-			{
-				RTTIField* field = rtti->getField(i);
-				FieldId fieldId;
-				fieldId.field = field;
-				fieldId.arrayIdx = -1;
+		// Notify in the same order as the serializer would: derived classes first when reading, base classes first when
+		// writing
+		for (auto& rttiInstance : sourceRttiInstances)
+			rttiInstance->onSerializationStarted(source, nullptr);
 
-				if (field->isArray())
-				{
-					const UINT32 numElements = field->getArraySize(rttiInstance, object);
-
-					for (UINT32 j = 0; j < numElements; j++)
-					{
-						fieldId.arrayIdx = j;
-
-						if (field->mType == SerializableFT_ReflectablePtr)
-						{
-							auto* curField = static_cast<RTTIReflectablePtrFieldBase*>(field);
-							SPtr<IReflectable> childObj = curField->getArrayValue(rttiInstance, object, j);
-
-							if (childObj != nullptr)
-							{
-								if (subObjectData == nullptr)
-								{
-									referenceData.subObjectData.push_back(SubObjectReferenceData());
-									subObjectData = &referenceData.subObjectData[referenceData.subObjectData.size() - 1];
-									subObjectData->rtti = rtti;
-								}
-
-								subObjectData->references.push_back(ObjectReference());
-								ObjectReference& reference = subObjectData->references.back();
-								reference.fieldId = fieldId;
-								reference.object = childObj;
-							}
-						}
-						else if (field->mType == SerializableFT_Reflectable)
-						{
-							auto* curField = static_cast<RTTIReflectableFieldBase*>(field);
-							IReflectable* childObj = &curField->getArrayValue(rttiInstance, object, j);
-							
-							if (subObjectData == nullptr)
-							{
-								referenceData.subObjectData.push_back(SubObjectReferenceData());
-								subObjectData = &referenceData.subObjectData[referenceData.subObjectData.size() - 1];
-								subObjectData->rtti = rtti;
-							}
-
-							subObjectData->children.push_back(ObjectReferenceData());
-							ObjectReferenceData& childData = subObjectData->children.back();
-							childData.fieldId = fieldId;
-
-							gatherReferences(childObj, alloc, childData);
-						}
-					}
-				}
-				else
-				{
-					if (field->mType == SerializableFT_ReflectablePtr)
-					{
-						auto* curField = static_cast<RTTIReflectablePtrFieldBase*>(field);
-						SPtr<IReflectable> childObj = curField->getValue(rttiInstance, object);
-
-						if (childObj != nullptr)
-						{
-							if (subObjectData == nullptr)
-							{
-								referenceData.subObjectData.push_back(SubObjectReferenceData());
-								subObjectData = &referenceData.subObjectData[referenceData.subObjectData.size() - 1];
-								subObjectData->rtti = rtti;
-							}
-
-							subObjectData->references.push_back(ObjectReference());
-							ObjectReference& reference = subObjectData->references.back();
-							reference.fieldId = fieldId;
-							reference.object = childObj;
-						}
-					}
-					else if (field->mType == SerializableFT_Reflectable)
-					{
-						auto* curField = static_cast<RTTIReflectableFieldBase*>(field);
-						IReflectable* childObj = &curField->getValue(rttiInstance, object);
-
-						if (subObjectData == nullptr)
-						{
-							referenceData.subObjectData.push_back(SubObjectReferenceData());
-							subObjectData = &referenceData.subObjectData[referenceData.subObjectData.size() - 1];
-							subObjectData->rtti = rtti;
-						}
-
-						subObjectData->children.push_back(ObjectReferenceData());
-						ObjectReferenceData& childData = subObjectData->children.back();
-						childData.fieldId = fieldId;
-
-						gatherReferences(childObj, alloc, childData);
-					}
-				}
-			}
+		for (auto iter = destinationRttiInstances.rbegin(); iter != destinationRttiInstances.rend(); ++iter)
+			(*iter)->onDeserializationStarted(destination, nullptr);
 
-			rttiInstances.push(rttiInstance);
-			rtti = rtti->getBaseClass();
+		for (UINT32 i = 0; i < (UINT32)types.size(); i++)
+		{
+			RTTITypeBase* type = types[i];
+
+			const UINT32 numFields = type->getNumFields();
+			for (UINT32 j = 0; j < numFields; j++)
+			{
+				cloneField(type->getField(j), sourceRttiInstances[i], source, destinationRttiInstances[i], 
+					destination, context);
+			}
 		}
 
-		while (!rttiInstances.empty())
+		for (auto iter = destinationRttiInstances.rbegin(); iter != destinationRttiInstances.rend(); ++iter)
 		{
-			RTTITypeBase* rttiInstance = rttiInstances.top();
-			rttiInstances.pop();
+			(*iter)->onDeserializationEnded(destination, nullptr);
+			context.alloc.destruct(*iter);
+		}
 
-			rttiInstance->onSerializationEnded(object, nullptr);
-			alloc.destruct(rttiInstance);
+		for (auto iter = sourceRttiInstances.rbegin(); iter != sourceRttiInstances.rend(); ++iter)
+		{
+			(*iter)->onSerializationEnded(source, nullptr);
+			context.alloc.destruct(*iter);
 		}
 	}
 
-	void BinaryCloner::restoreReferences(IReflectable* object, FrameAlloc& alloc, const ObjectReferenceData& referenceData)
+	void BinaryCloner::cloneField(RTTIField* field, RTTITypeBase* sourceRtti, IReflectable* source, 
+		RTTITypeBase* destinationRtti, IReflectable* destination, CloneContext& context)
 	{
-		for(auto iter = referenceData.subObjectData.rbegin(); iter != referenceData.subObjectData.rend(); ++iter)
+		UINT32 numElements = 0;
+		if (field->mIsVectorType)
 		{
-			const SubObjectReferenceData& subObject = *iter;
+			numElements = field->getArraySize(sourceRtti, source);
+			field->setArraySize(destinationRtti, destination, numElements);
+		}
 
-			if (!subObject.references.empty())
+		switch (field->mType)
+		{
+		case SerializableFT_Plain:
+		{
+			auto* curField = static_cast<RTTIPlainFieldBase*>(field);
+
+			if (field->mIsVectorType)
 			{
-				RTTITypeBase* rttiInstance = subObject.rtti->_clone(alloc);
-				rttiInstance->onDeserializationStarted(object, nullptr);
+				for (UINT32 i = 0; i < numElements; i++)
+					curField->copyArrayElem(sourceRtti, source, destinationRtti, destination, i);
+			}
+			else
+				curField->copyValue(sourceRtti, source, destinationRtti, destination);
 
-				for (auto& reference : subObject.references)
+			break;
+		}
+		case SerializableFT_Reflectable:
+		{
+			auto* curField = static_cast<RTTIReflectableFieldBase*>(field);
+
+			// Note: Would be nice to avoid this copy by value and clone directly into the field
+			if (field->mIsVectorType)
+			{
+				for (UINT32 i = 0; i < numElements; i++)
 				{
-					auto* curField = static_cast<RTTIReflectablePtrFieldBase*>(reference.fieldId.field);
+					IReflectable& childObj = curField->getArrayValue(sourceRtti, source, i);
+
+					SPtr<IReflectable> clonedChildObj = curField->newObject();
+					cloneFields(&childObj, clonedChildObj.get(), context);
 
-					if (curField->isArray())
-						curField->setArrayValue(rttiInstance, object, reference.fieldId.arrayIdx, reference.object);
-					else
-						curField->setValue(rttiInstance, object, reference.object);
+					curField->setArrayValue(destinationRtti, destination, i, *clonedChildObj);
 				}
+			}
+			else
+			{
+				IReflectable& childObj = curField->getValue(sourceRtti, source);
 
-				rttiInstance->onDeserializationEnded(object, nullptr);
-				alloc.destruct(rttiInstance);
+				SPtr<IReflectable> clonedChildObj = curField->newObject();
+				cloneFields(&childObj, clonedChildObj.get(), context);
+
+				curField->setValue(destinationRtti, destination, *clonedChildObj);
 			}
-		}
 
-		for (auto& subObject : referenceData.subObjectData)
+			break;
+		}
+		case SerializableFT_ReflectablePtr:
 		{
-			if (!subObject.children.empty())
-			{
-				RTTITypeBase* rttiInstance = subObject.rtti->_clone(alloc);
-				rttiInstance->onSerializationStarted(object, nullptr);
+			auto* curField = static_cast<RTTIReflectablePtrFieldBase*>(field);
+			const bool isWeakRef = (curField->getFlags() & RTTI_Flag_WeakRef) != 0;
 
-				for (auto& childObjectData : subObject.children)
+			// Shallow clones keep referencing the original objects
+			if (field->mIsVectorType)
+			{
+				for (UINT32 i = 0; i < numElements; i++)
 				{
-					auto* curField = static_cast<RTTIReflectableFieldBase*>(childObjectData.fieldId.field);
-
-					IReflectable* childObj = nullptr;
-					if (curField->isArray())
-						childObj = &curField->getArrayValue(rttiInstance, object, childObjectData.fieldId.arrayIdx);
-					else
-						childObj = &curField->getValue(rttiInstance, object);
+					SPtr<IReflectable> childObj = curField->getArrayValue(sourceRtti, source, i);
+					if (!context.shallow)
+						childObj = cloneReferencedObject(childObj, isWeakRef, context);
 
-					restoreReferences(childObj, alloc, childObjectData);
+					curField->setArrayValue(destinationRtti, destination, i, childObj);
 				}
+			}
+			else
+			{
+				SPtr<IReflectable> childObj = curField->getValue(sourceRtti, source);
+				if (!context.shallow)
+					childObj = cloneReferencedObject(childObj, isWeakRef, context);
+
+				curField->setValue(destinationRtti, destination, childObj);
+			}
+
+			break;
+		}
+		case SerializableFT_DataBlock:
+		{
+			auto* curField = static_cast<RTTIManagedDataBlockFieldBase*>(field);
+
+			UINT32 dataBlockSize = 0;
+			SPtr<DataStream> blockStream = curField->getValue(sourceRtti, source, dataBlockSize);
 
-				rttiInstance->onSerializationEnded(object, nullptr);
-				alloc.destruct(rttiInstance);
+			// Objects without data block contents report a null stream, which the clone receives as well
+			if (blockStream == nullptr)
+			{
+				curField->setValue(destinationRtti, destination, nullptr, 0);
+				break;
+			}
+
+			// Share the data if the source stream can reference it directly, as it is read-only
+			SPtr<DataStream> stream = blockStream->readView(dataBlockSize);
+			if (stream == nullptr)
+			{
+				UINT8* dataBlockBuffer = (UINT8*)ls_alloc(dataBlockSize);
+				blockStream->read(dataBlockBuffer, dataBlockSize);
+
+				stream = ls_shared_ptr_new<MemoryDataStream>(dataBlockBuffer, dataBlockSize);
 			}
+
+			curField->setValue(destinationRtti, destination, stream, dataBlockSize);
+
+			break;
+		}
+		default:
+			LS_EXCEPT(InternalErrorException,
+				"Error cloning data. Encountered a type I don't know how to clone. Type: " + toString(UINT32(field->mType)) +
+				", Is array: " + toString(field->mIsVectorType));
 		}
 	}
-}
\ No newline at end of file
+}
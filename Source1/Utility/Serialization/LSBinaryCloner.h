@@ -8,7 +8,10 @@ namespace ls
 	 *  @{
 	 */
 
-	/** Helper class that performs cloning of an object that implements RTTI. */
+	/**
+	 * Helper class that performs cloning of an object that implements RTTI. Fields are copied directly from the original
+	 * to the cloned object by walking their RTTI types, without serializing the object into an intermediate buffer.
+	 */
 	class LS_UTILITY_EXPORT BinaryCloner
 	{
 	public:
@@ -23,53 +26,47 @@ namespace ls
 		static SPtr<IReflectable> clone(IReflectable* object, bool shallow = false);
 
 	private:
-		struct ObjectReferenceData;
-
-		/** Identifier representing a single field or an array entry in an object. */
-		struct FieldId
+		/** Original object referenced through a pointer field, and its clone. */
+		struct ClonedObject
 		{
-			RTTIField* field;
-			INT32 arrayIdx;
+			SPtr<IReflectable> original;
+			SPtr<IReflectable> clone;
+			bool cloneInProgress = false; /**< Used for reporting circular references. */
 		};
 
-		/** A saved reference to an object with a field identifier that owns it. */
-		struct ObjectReference
+		/** Data shared by all the objects cloned in a single call to clone(). */
+		struct CloneContext
 		{
-			FieldId fieldId;
-			SPtr<IReflectable> object;
-		};
+			CloneContext(FrameAlloc& alloc, bool shallow)
+				:alloc(alloc), shallow(shallow)
+			{ }
 
-		/**
-		 * Contains all object references in a portion of an object belonging to a specific class (base and derived 
-		 * classes count as separate sub-objects).
-		 */
-		struct SubObjectReferenceData
-		{
-			RTTITypeBase* rtti;
-			Vector<ObjectReference> references;
-			Vector<ObjectReferenceData> children;
-		};
+			FrameAlloc& alloc;
+			bool shallow;
 
-		/**
-		 * Contains all object references in an entire object, as well as the identifier of the field owning this object.
-		 */
-		struct ObjectReferenceData
-		{
-			FieldId fieldId;
-			Vector<SubObjectReferenceData> subObjectData;
+			/** 
+			 * Clones of all the objects referenced through pointer fields, so objects referenced multiple times are only
+			 * cloned once.
+			 */
+			FrameUnorderedMap<IReflectable*, ClonedObject> clonedObjects;
 		};
 
 		/**
-		 * Iterates over the provided object hierarchy and retrieves all object references which are returned in 
-		 * @p referenceData output parameter, also in a hierarchical format for easier parsing.
+		 * Returns a clone of an object referenced through a pointer field, cloning it if this is the first time the
+		 * object is encountered.
 		 */
-		static void gatherReferences(IReflectable* object, FrameAlloc& alloc, ObjectReferenceData& referenceData);
+		static SPtr<IReflectable> cloneReferencedObject(const SPtr<IReflectable>& object, bool isWeakRef,
+			CloneContext& context);
 
 		/**
-		 * Restores a set of references retrieved by gatherReferences() and applies them to a specific object. Type of the 
-		 * object must be the same as the type that was used when calling gatherReferences().
+		 * Copies the values of all fields from @p source to @p destination, including fields of their base classes. 
+		 * Both objects must be of the same type.
 		 */
-		static void restoreReferences(IReflectable* object, FrameAlloc& alloc, const ObjectReferenceData& referenceData);
+		static void cloneFields(IReflectable* source, IReflectable* destination, CloneContext& context);
+
+		/** Copies the value of a single field from @p source to @p destination. */
+		static void cloneField(RTTIField* field, RTTITypeBase* sourceRtti, IReflectable* source, 
+			RTTITypeBase* destinationRtti, IReflectable* destination, CloneContext& context);
 	};
 
 	/** @} */
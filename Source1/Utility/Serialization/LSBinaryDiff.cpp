@@ -7,9 +7,31 @@
 
 namespace ls
 {
+	/** 
+	 * Checks if two serialized instances are known to have equal contents by comparing their hashes, without walking 
+	 * their hierarchies. Returns false if the contents differ, or if they cannot be compared by hash.
+	 */
+	static bool isUnchanged(const SPtr<SerializedInstance>& orgData, const SPtr<SerializedInstance>& newData)
+	{
+		if (orgData == nullptr || newData == nullptr)
+			return false;
+
+		if (orgData == newData)
+			return true;
+
+		UINT64 orgHash, newHash;
+		if (!orgData->getHash(orgHash) || !newData->getHash(newHash))
+			return false;
+
+		return orgHash == newHash;
+	}
+
 	SPtr<SerializedObject> IDiff::generateDiff(const SPtr<SerializedObject>& orgObj,
 		const SPtr<SerializedObject>& newObj)
 	{
+		if (isUnchanged(orgObj, newObj))
+			return nullptr;
+
 		ObjectMap objectMap;
 		return generateDiff(orgObj, newObj, objectMap);
 	}
@@ -18,6 +40,9 @@ namespace ls
 		const SPtr<SerializedInstance>& newData, ObjectMap& objectMap)
 	{
 		SPtr<SerializedInstance> modification;
+		if (isUnchanged(orgData, newData))
+			return modification;
+
 		switch (fieldType)
 		{
 		case SerializableFT_ReflectablePtr:
@@ -120,152 +145,155 @@ namespace ls
 		FrameAlloc& alloc = gFrameAlloc();
 		alloc.markFrame();
 
-		FrameVector<DiffCommand> commands;
-
-		DiffObjectMap objectMap;
-		applyDiff(object, diff, alloc, objectMap, commands, context);
+		// Frame allocated containers must be destroyed before the frame is cleared
+		{
+			FrameVector<DiffCommand> commands;
 
-		IReflectable* destObject = nullptr;
-		RTTITypeBase* rttiInstance = nullptr;
+			DiffObjectMap objectMap;
+			applyDiff(object, diff, alloc, objectMap, commands, context);
 
-		Stack<IReflectable*> objectStack;
-		Vector<std::pair<RTTITypeBase*, IReflectable*>> rttiInstances;
+			IReflectable* destObject = nullptr;
+			RTTITypeBase* rttiInstance = nullptr;
 
-		for (auto& command : commands)
-		{
-			bool isArray = (command.type & Diff_ArrayFlag) != 0;
-			DiffCommandType type = (DiffCommandType)(command.type & 0xF);
+			Stack<IReflectable*> objectStack;
+			Vector<std::pair<RTTITypeBase*, IReflectable*>> rttiInstances;
 
-			switch (type)
-			{
-			case Diff_ArraySize:
-				command.field->setArraySize(rttiInstance, destObject, command.arraySize);
-				break;
-			case Diff_ObjectStart:
+			for (auto& command : commands)
 			{
-				destObject = command.object.get();
-				objectStack.push(destObject);
+				bool isArray = (command.type & Diff_ArrayFlag) != 0;
+				DiffCommandType type = (DiffCommandType)(command.type & 0xF);
 
-				FrameStack<RTTITypeBase*> rttiTypes;
-				RTTITypeBase* curRtti = destObject->getRTTI();
-				while (curRtti != nullptr)
+				switch (type)
 				{
-					rttiTypes.push(curRtti);
-					curRtti = curRtti->getBaseClass();
-				}
-
-				// Call base class first, followed by derived classes
-				while(!rttiTypes.empty())
+				case Diff_ArraySize:
+					command.field->setArraySize(rttiInstance, destObject, command.arraySize);
+					break;
+				case Diff_ObjectStart:
 				{
-					RTTITypeBase* curRtti = rttiTypes.top();
-					RTTITypeBase* rttiInstance = curRtti->_clone(alloc);
+					destObject = command.object.get();
+					objectStack.push(destObject);
 
-					rttiInstances.push_back(std::make_pair(rttiInstance, destObject));
-					rttiInstance->onDeserializationStarted(destObject, context);
+					FrameStack<RTTITypeBase*> rttiTypes;
+					RTTITypeBase* curRtti = destObject->getRTTI();
+					while (curRtti != nullptr)
+					{
+						rttiTypes.push(curRtti);
+						curRtti = curRtti->getBaseClass();
+					}
 
-					rttiTypes.pop();
-				}
-			}
-				break;
-			case Diff_SubObjectStart:
-				{
-					// Find the instance
-					rttiInstance = nullptr;
-					for(auto iter = rttiInstances.rbegin(); iter != rttiInstances.rend(); ++iter)
+					// Call base class first, followed by derived classes
+					while(!rttiTypes.empty())
 					{
-						if(iter->second != destObject)
-							break;
+						RTTITypeBase* curRtti = rttiTypes.top();
+						RTTITypeBase* rttiInstance = curRtti->_clone(alloc);
 
-						if(iter->first->getRTTIId() == command.rttiType->getRTTIId())
-							rttiInstance = iter->first;
-					}
+						rttiInstances.push_back(std::make_pair(rttiInstance, destObject));
+						rttiInstance->onDeserializationStarted(destObject, context);
 
-					assert(rttiInstance);
+						rttiTypes.pop();
+					}
 				}
-				break;
-			case Diff_ObjectEnd:
-			{
-				while (!rttiInstances.empty())
-				{
-					if(rttiInstances.back().second != destObject)
-						break;
+					break;
+				case Diff_SubObjectStart:
+					{
+						// Find the instance
+						rttiInstance = nullptr;
+						for(auto iter = rttiInstances.rbegin(); iter != rttiInstances.rend(); ++iter)
+						{
+							if(iter->second != destObject)
+								break;
 
-					RTTITypeBase* rttiInstance = rttiInstances.back().first;
+							if(iter->first->getRTTIId() == command.rttiType->getRTTIId())
+								rttiInstance = iter->first;
+						}
 
-					rttiInstance->onDeserializationEnded(destObject, context);
-					alloc.destruct(rttiInstance);
+						assert(rttiInstance);
+					}
+					break;
+				case Diff_ObjectEnd:
+				{
+					while (!rttiInstances.empty())
+					{
+						if(rttiInstances.back().second != destObject)
+							break;
 
-					rttiInstances.erase(rttiInstances.end() - 1);
-				}
+						RTTITypeBase* rttiInstance = rttiInstances.back().first;
 
-				objectStack.pop();
+						rttiInstance->onDeserializationEnded(destObject, context);
+						alloc.destruct(rttiInstance);
 
-				if (!objectStack.empty())
-					destObject = objectStack.top();
-				else
-					destObject = nullptr;
-			}
-				break;
-			default:
-				break;
-			}
+						rttiInstances.erase(rttiInstances.end() - 1);
+					}
 
-			if (isArray)
-			{
-				switch (type)
-				{
-				case Diff_ReflectablePtr:
-				{
-					RTTIReflectablePtrFieldBase* field = static_cast<RTTIReflectablePtrFieldBase*>(command.field);
-					field->setArrayValue(rttiInstance, destObject, command.arrayIdx, command.object);
-				}
-					break;
-				case Diff_Reflectable:
-				{
-					RTTIReflectableFieldBase* field = static_cast<RTTIReflectableFieldBase*>(command.field);
-					field->setArrayValue(rttiInstance, destObject, command.arrayIdx, *command.object);
-				}
-					break;
-				case Diff_Plain:
-				{
-					RTTIPlainFieldBase* field = static_cast<RTTIPlainFieldBase*>(command.field);
-					field->arrayElemFromBuffer(rttiInstance, destObject, command.arrayIdx, command.value);
+					objectStack.pop();
+
+					if (!objectStack.empty())
+						destObject = objectStack.top();
+					else
+						destObject = nullptr;
 				}
 					break;
 				default:
 					break;
 				}
-			}
-			else
-			{
-				switch (type)
-				{
-				case Diff_ReflectablePtr:
-				{
-					RTTIReflectablePtrFieldBase* field = static_cast<RTTIReflectablePtrFieldBase*>(command.field);
-					field->setValue(rttiInstance, destObject, command.object);
-				}
-					break;
-				case Diff_Reflectable:
-				{
-					RTTIReflectableFieldBase* field = static_cast<RTTIReflectableFieldBase*>(command.field);
-					field->setValue(rttiInstance, destObject, *command.object);
-				}
-					break;
-				case Diff_Plain:
+
+				if (isArray)
 				{
-					RTTIPlainFieldBase* field = static_cast<RTTIPlainFieldBase*>(command.field);
-					field->fromBuffer(rttiInstance, destObject, command.value);
+					switch (type)
+					{
+					case Diff_ReflectablePtr:
+					{
+						RTTIReflectablePtrFieldBase* field = static_cast<RTTIReflectablePtrFieldBase*>(command.field);
+						field->setArrayValue(rttiInstance, destObject, command.arrayIdx, command.object);
+					}
+						break;
+					case Diff_Reflectable:
+					{
+						RTTIReflectableFieldBase* field = static_cast<RTTIReflectableFieldBase*>(command.field);
+						field->setArrayValue(rttiInstance, destObject, command.arrayIdx, *command.object);
+					}
+						break;
+					case Diff_Plain:
+					{
+						RTTIPlainFieldBase* field = static_cast<RTTIPlainFieldBase*>(command.field);
+						field->arrayElemFromBuffer(rttiInstance, destObject, command.arrayIdx, command.value);
+					}
+						break;
+					default:
+						break;
+					}
 				}
-					break;
-				case Diff_DataBlock:
+				else
 				{
-					RTTIManagedDataBlockFieldBase* field = static_cast<RTTIManagedDataBlockFieldBase*>(command.field);
-					field->setValue(rttiInstance, destObject, command.streamValue, command.size);
-				}
-					break;
-				default:
-					break;
+					switch (type)
+					{
+					case Diff_ReflectablePtr:
+					{
+						RTTIReflectablePtrFieldBase* field = static_cast<RTTIReflectablePtrFieldBase*>(command.field);
+						field->setValue(rttiInstance, destObject, command.object);
+					}
+						break;
+					case Diff_Reflectable:
+					{
+						RTTIReflectableFieldBase* field = static_cast<RTTIReflectableFieldBase*>(command.field);
+						field->setValue(rttiInstance, destObject, *command.object);
+					}
+						break;
+					case Diff_Plain:
+					{
+						RTTIPlainFieldBase* field = static_cast<RTTIPlainFieldBase*>(command.field);
+						field->fromBuffer(rttiInstance, destObject, command.value);
+					}
+						break;
+					case Diff_DataBlock:
+					{
+						RTTIManagedDataBlockFieldBase* field = static_cast<RTTIManagedDataBlockFieldBase*>(command.field);
+						field->setValue(rttiInstance, destObject, command.streamValue, command.size);
+					}
+						break;
+					default:
+						break;
+					}
 				}
 			}
 		}
@@ -317,6 +345,10 @@ namespace ls
 						orgEntryData = orgEntryFind->second.serialized;
 				}
 
+				// Skip entire unchanged fields, including arrays and object hierarchies
+				if (isUnchanged(orgEntryData, newEntryData))
+					continue;
+
 				SPtr<SerializedInstance> modification;
 				bool hasModification = false;
 				if (genericField->isArray())
@@ -11,6 +11,8 @@
 #include "Reflection/LSRTTIManagedDataBlockField.h"
 #include "Serialization/LSMemorySerializer.h"
 #include "FileSystem/LSDataStream.h"
+#include "Thread/LSTaskScheduler.h"
+#include "Thread/LSSpinLock.h"
 
 #include <unordered_set>
 
@@ -42,13 +44,16 @@ namespace ls
 		:mAlloc(&gFrameAlloc())
 	{ }
 
-	void BinarySerializer::encode(IReflectable* object, UINT8* buffer, UINT32 bufferLength, UINT32* bytesWritten, 
+	void BinarySerializer::encode(IReflectable* object, UINT8* buffer, UINT32 bufferLength, UINT32* totalBytesWritten, 
 		std::function<UINT8*(UINT8*, UINT32, UINT32&)> flushBufferCallback, bool shallow, SerializationContext* context)
 	{
+		// Bytes written to the current buffer, reset on every flush
+		UINT32 bufferBytesWritten = 0;
+		UINT32* bytesWritten = &bufferBytesWritten;
+
 		mObjectsToEncode.clear();
 		mObjectAddrToId.clear();
 		mLastUsedObjectId = 1;
-		*bytesWritten = 0;
 		mTotalBytesWritten = 0;
 		mContext = context;
 
@@ -112,16 +117,26 @@ namespace ls
 			buffer = flushBufferCallback(buffer - *bytesWritten, *bytesWritten, bufferLength);
 		}
 
-		*bytesWritten = mTotalBytesWritten;
-
 		encodedObjects.clear();
 		mObjectsToEncode.clear();
 		mObjectAddrToId.clear();
 
 		mAlloc->clear();
+
+		if(totalBytesWritten != nullptr)
+		{
+			if(mTotalBytesWritten > std::numeric_limits<UINT32>::max())
+			{
+				LS_EXCEPT(InternalErrorException, 
+					"Encoded data is larger than 4GB, so its size cannot be reported. Count the bytes passed to the flush "
+					"callback instead.");
+			}
+
+			*totalBytesWritten = (UINT32)mTotalBytesWritten;
+		}
 	}
 
-	SPtr<IReflectable> BinarySerializer::decode(const SPtr<DataStream>& data, UINT32 dataLength, 
+	SPtr<IReflectable> BinarySerializer::decode(const SPtr<DataStream>& data, UINT64 dataLength, 
 		SerializationContext* context)
 	{
 		mContext = context;
@@ -130,11 +145,225 @@ namespace ls
 			return nullptr;
 
 		const size_t start = data->tell();
-		const size_t end = start + dataLength;
+		const size_t end = start + (size_t)dataLength;
 		mDecodeObjectMap.clear();
 
 		// Note: Ideally we can avoid iterating twice over the stream data
 		// Create empty instances of all ptr objects
+		SPtr<IReflectable> rootObject = createDecodeObjects(data, end);
+
+		// Now go through all of the objects and actually decode them
+		decodeObjects(data, end);
+
+		return rootObject;
+	}
+
+	SPtr<IReflectable> BinarySerializer::decodeParallel(const SPtr<DataStream>& data, UINT64 dataLength, 
+		SerializationContext* context)
+	{
+		if (!TaskScheduler::isStarted())
+			return decode(data, dataLength, context);
+
+		mContext = context;
+
+		if (dataLength == 0)
+			return nullptr;
+
+		const size_t end = data->tell() + (size_t)dataLength;
+		mDecodeObjectMap.clear();
+
+		SPtr<IReflectable> rootObject = createDecodeObjects(data, end);
+
+		const UINT32 numObjects = (UINT32)mDecodeObjectMap.size();
+		if (numObjects < MIN_PARALLEL_DECODE_OBJECTS)
+		{
+			// Objects are already created, decode them the same way decode() would
+			decodeObjects(data, end);
+			return rootObject;
+		}
+
+		Vector<ObjectToDecode*> objects;
+		UnorderedMap<UINT32, UINT32> objectIdToIdx;
+		objects.reserve(numObjects);
+
+		for (auto& entry : mDecodeObjectMap)
+		{
+			objectIdToIdx[entry.first] = (UINT32)objects.size();
+			objects.push_back(&entry.second);
+		}
+
+		Vector<ParallelDecodeObject> parallelObjects(numObjects);
+
+		// Each thread keeps the RTTI instances of the objects it decoded in its own allocator, until they are finalized,
+		// and reads through its own stream, so the threads don't fight over the read position
+		struct DecodeWorker
+		{
+			ThreadId threadId;
+			FrameAlloc* alloc;
+			SPtr<DataStream> stream;
+		};
+
+		Vector<DecodeWorker> workers;
+		SpinLock workersLock;
+
+		auto getWorker = [&]()
+		{
+			ThreadId threadId = LS_THREAD_CURRENT_ID;
+
+			{
+				ScopedSpinLock lock(workersLock);
+				for (auto& worker : workers)
+				{
+					if (worker.threadId == threadId)
+						return worker;
+				}
+			}
+
+			DecodeWorker worker;
+			worker.threadId = threadId;
+			worker.alloc = ls_new<FrameAlloc>(DECODE_ALLOC_BLOCK_SIZE);
+			worker.alloc->setOwnerThread(threadId);
+			worker.stream = data->clone(false);
+
+			ScopedSpinLock lock(workersLock);
+			workers.push_back(worker);
+
+			return worker;
+		};
+
+		// Exceptions can't propagate out of the tasks, so the first one is rethrown once all the tasks are done
+		std::exception_ptr exception;
+		SpinLock exceptionLock;
+
+		TaskScheduler::instance().parallelFor(0, numObjects, DECODE_OBJECTS_PER_TASK, [&](UINT32 first, UINT32 last)
+		{
+			FrameAlloc& tempAlloc = gFrameAlloc();
+			tempAlloc.markFrame();
+
+			try
+			{
+				DecodeWorker worker = getWorker();
+
+				for (UINT32 i = first; i < last; i++)
+				{
+					ParallelDecodeObject& parallelObject = parallelObjects[i];
+					parallelObject.alloc = worker.alloc;
+
+					worker.stream->seek(objects[i]->offset);
+					decodeEntry(worker.stream, end, objects[i]->object, &parallelObject, true);
+				}
+			}
+			catch (...)
+			{
+				ScopedSpinLock lock(exceptionLock);
+				if (exception == nullptr)
+					exception = std::current_exception();
+			}
+
+			tempAlloc.clear();
+		});
+
+		for (auto& worker : workers)
+			worker.alloc->setOwnerThread(LS_THREAD_CURRENT_ID);
+
+		if (exception != nullptr)
+		{
+			// Release the RTTI instances of the objects that were decoded, without finishing the objects
+			for (auto& parallelObject : parallelObjects)
+			{
+				for (auto& rttiInstance : parallelObject.rttiInstances)
+					parallelObject.alloc->destruct(rttiInstance);
+			}
+
+			for (auto& worker : workers)
+				ls_delete(worker.alloc);
+
+			mDecodeObjectMap.clear();
+			data->seek(end);
+
+			std::rethrow_exception(exception);
+		}
+
+		// Finish the objects serially, making sure objects are finished before the objects that reference them
+		Stack<std::pair<UINT32, UINT32>> finalizeStack;
+		for (UINT32 i = 0; i < numObjects; i++)
+		{
+			if (parallelObjects[i].isFinalized)
+				continue;
+
+			parallelObjects[i].finalizeInProgress = true;
+			finalizeStack.push(std::make_pair(i, 0));
+
+			while (!finalizeStack.empty())
+			{
+				auto& top = finalizeStack.top();
+				ParallelDecodeObject& parallelObject = parallelObjects[top.first];
+
+				if (top.second < (UINT32)parallelObject.dependencies.size())
+				{
+					const UINT32 dependencyId = parallelObject.dependencies[top.second++];
+
+					auto findIdx = objectIdToIdx.find(dependencyId);
+					if (findIdx == objectIdToIdx.end())
+						continue;
+
+					ParallelDecodeObject& dependency = parallelObjects[findIdx->second];
+					if (dependency.isFinalized)
+						continue;
+
+					if (dependency.finalizeInProgress)
+					{
+						LOGWRN("Detected a circular reference when decoding. Referenced object's fields " \
+							"will be resolved in an undefined order (i.e. one of the objects will not " \
+							"be fully deserialized when assigned to its field). Use RTTI_Flag_WeakRef to " \
+							"get rid of this warning and tell the system which of the objects is allowed " \
+							"to be deserialized after it is assigned to its field.");
+
+						continue;
+					}
+
+					dependency.finalizeInProgress = true;
+					finalizeStack.push(std::make_pair(findIdx->second, 0));
+					continue;
+				}
+
+				finalizeParallelObject(objects[top.first]->object.get(), parallelObject);
+				finalizeStack.pop();
+			}
+		}
+
+		for (auto& worker : workers)
+			ls_delete(worker.alloc);
+
+		mDecodeObjectMap.clear();
+		data->seek(end);
+
+		return rootObject;
+	}
+
+	void BinarySerializer::decodeObjects(const SPtr<DataStream>& data, size_t dataEnd)
+	{
+		for(auto iter = mDecodeObjectMap.begin(); iter != mDecodeObjectMap.end(); ++iter)
+		{
+			ObjectToDecode& objToDecode = iter->second;
+
+			if(objToDecode.isDecoded)
+				continue;
+
+			data->seek(objToDecode.offset);
+
+			objToDecode.decodeInProgress = true;
+			decodeEntry(data, dataEnd, objToDecode.object);
+			objToDecode.decodeInProgress = false;
+			objToDecode.isDecoded = true;
+		}
+
+		mDecodeObjectMap.clear();
+		data->seek(dataEnd);
+	}
+
+	SPtr<IReflectable> BinarySerializer::createDecodeObjects(const SPtr<DataStream>& data, size_t dataEnd)
+	{
 		SPtr<IReflectable> rootObject = nullptr;
 		do 
 		{
@@ -166,28 +395,25 @@ namespace ls
 			if(rootObject == nullptr)
 				rootObject = object;
 
-		} while (decodeEntry(data, end, nullptr));
-
-		// Now go through all of the objects and actually decode them
-		for(auto iter = mDecodeObjectMap.begin(); iter != mDecodeObjectMap.end(); ++iter)
-		{
-			ObjectToDecode& objToDecode = iter->second;
+		} while (decodeEntry(data, dataEnd, nullptr));
 
-			if(objToDecode.isDecoded)
-				continue;
+		return rootObject;
+	}
 
-			data->seek(objToDecode.offset);
+	void BinarySerializer::finalizeParallelObject(IReflectable* object, ParallelDecodeObject& parallelObject)
+	{
+		// Same order as decodeEntry() uses for objects decoded serially
+		for (auto iter = parallelObject.rttiInstances.rbegin(); iter != parallelObject.rttiInstances.rend(); ++iter)
+		{
+			RTTITypeBase* curRTTI = *iter;
 
-			objToDecode.decodeInProgress = true;
-			decodeEntry(data, end, objToDecode.object);
-			objToDecode.decodeInProgress = false;
-			objToDecode.isDecoded = true;
+			curRTTI->onDeserializationEnded(object, mContext);
+			parallelObject.alloc->destruct(curRTTI);
 		}
 
-		mDecodeObjectMap.clear();
-		data->seek(end);
-
-		return rootObject;
+		parallelObject.rttiInstances.clear();
+		parallelObject.finalizeInProgress = false;
+		parallelObject.isFinalized = true;
 	}
 
 	UINT8* BinarySerializer::encodeEntry(IReflectable* object, UINT32 objectId, UINT8* buffer, UINT32& bufferLength, 
@@ -427,8 +653,11 @@ namespace ls
 		return buffer;
 	}
 
-	bool BinarySerializer::decodeEntry(const SPtr<DataStream>& data, size_t dataEnd, const SPtr<IReflectable>& output)
+	bool BinarySerializer::decodeEntry(const SPtr<DataStream>& data, size_t dataEnd, const SPtr<IReflectable>& output,
+		ParallelDecodeObject* parallelObject, bool isParallelRoot)
 	{
+		FrameAlloc& alloc = parallelObject != nullptr ? *parallelObject->alloc : *mAlloc;
+
 		ObjectMetaData objectMetaData;
 		objectMetaData.objectMeta = 0;
 		objectMetaData.typeId = 0;
@@ -455,8 +684,49 @@ namespace ls
 
 		FrameVector<RTTITypeBase*> rttiInstances;
 
-		auto finalizeObject = [&rttiInstances, this](IReflectable* object)
+		// Releases the RTTI instances if decoding the fields throws. They are otherwise always released or handed over
+		// by finalizeObject() before returning.
+		struct RTTIInstancesGuard
 		{
+			FrameVector<RTTITypeBase*>& instances;
+			FrameAlloc& alloc;
+
+			~RTTIInstancesGuard()
+			{
+				for (auto& instance : instances)
+					alloc.destruct(instance);
+			}
+		} rttiInstancesGuard = { rttiInstances, alloc };
+
+		// Worker threads decoding in parallel don't have a MemStack, so they store temporary field values in their frame
+		// allocator instead, which the decoding task clears
+		auto allocFieldValue = [parallelObject](UINT32 size) -> void*
+		{
+			if (parallelObject != nullptr)
+				return gFrameAlloc().alloc(size);
+
+			return ls_stack_alloc(size);
+		};
+
+		auto freeFieldValue = [parallelObject](void* value)
+		{
+			if (parallelObject != nullptr)
+				gFrameAlloc().free((UINT8*)value);
+			else
+				ls_stack_free(value);
+		};
+
+		auto finalizeObject = [&rttiInstances, &alloc, parallelObject, isParallelRoot, this](IReflectable* object)
+		{
+			// Top-level objects decoded in parallel are finished in a serial pass, once all the objects are decoded
+			if (isParallelRoot)
+			{
+				parallelObject->rttiInstances.assign(rttiInstances.begin(), rttiInstances.end());
+				rttiInstances.clear();
+
+				return;
+			}
+
 			// Note: It would make sense to finish deserializing derived classes before base classes, but some code
 			// depends on the old functionality, so we'll keep it this way
 			for (auto iter = rttiInstances.rbegin(); iter != rttiInstances.rend(); ++iter)
@@ -464,7 +734,7 @@ namespace ls
 				RTTITypeBase* curRTTI = *iter;
 
 				curRTTI->onDeserializationEnded(object, mContext);
-				mAlloc->destruct(curRTTI);
+				alloc.destruct(curRTTI);
 			}
 
 			rttiInstances.clear();
@@ -473,7 +743,7 @@ namespace ls
 		RTTITypeBase* curRTTI = rtti;
 		while (curRTTI)
 		{
-			RTTITypeBase* rttiInstance = curRTTI->_clone(*mAlloc);
+			RTTITypeBase* rttiInstance = curRTTI->_clone(alloc);
 			rttiInstances.push_back(rttiInstance);
 
 			curRTTI = curRTTI->getBaseClass();
@@ -485,6 +755,7 @@ namespace ls
 
 		RTTITypeBase* rttiInstance = nullptr;
 		UINT32 rttiInstanceIdx = 0;
+		UINT32 nextFieldIdx = 0;
 		if(!rttiInstances.empty())
 			rttiInstance = rttiInstances[0];
 
@@ -524,6 +795,7 @@ namespace ls
 						rtti = nullptr;
 
 					rttiInstance = nullptr;
+					nextFieldIdx = 0;
 
 					if (rtti)
 					{
@@ -562,8 +834,9 @@ namespace ls
 
 			RTTIField* curGenericField = nullptr;
 
+			// Fields are encoded in the order they are registered in, so usually this is the field following the last one
 			if (rtti != nullptr)
-				curGenericField = rtti->findField(fieldId);
+				curGenericField = rtti->findField(fieldId, nextFieldIdx);
 
 			if (curGenericField != nullptr)
 			{
@@ -629,9 +902,15 @@ namespace ls
 							else
 							{
 								ObjectToDecode& objToDecode = findObj->second;
+								const bool isWeakRef = (curField->getFlags() & RTTI_Flag_WeakRef) != 0;
 
-								const bool needsDecoding = (curField->getFlags() & RTTI_Flag_WeakRef) == 0 && !objToDecode.isDecoded;
-								if (needsDecoding)
+								// Referenced objects are decoded by other tasks, so only record them for finalizing objects in order
+								if (parallelObject != nullptr)
+								{
+									if (!isWeakRef)
+										parallelObject->dependencies.push_back(childObjectId);
+								}
+								else if (!isWeakRef && !objToDecode.isDecoded)
 								{
 									if (objToDecode.decodeInProgress)
 									{
@@ -672,7 +951,7 @@ namespace ls
 						if(curField)
 							childObj = curField->newObject();
 
-						decodeEntry(data, dataEnd, childObj);
+						decodeEntry(data, dataEnd, childObj, parallelObject);
 
 						if (curField != nullptr)
 						{
@@ -700,11 +979,11 @@ namespace ls
 							// Note: Two data copies that can potentially be avoided:
 							//  - Copy from stream into a temporary buffer (use stream directly for decoding)
 							//  - Internally the field will do a value copy of the decoded object (ideally we decode directly into the destination)
-							void* fieldValue = ls_stack_alloc(typeSize);
+							void* fieldValue = allocFieldValue(typeSize);
 							data->read(fieldValue, typeSize);
 
 							curField->arrayElemFromBuffer(rttiInstance, output.get(), i, fieldValue);
-							ls_stack_free(fieldValue);
+							freeFieldValue(fieldValue);
 						}
 						else
 							data->skip(typeSize);
@@ -748,9 +1027,15 @@ namespace ls
 						else
 						{
 							ObjectToDecode& objToDecode = findObj->second;
+							const bool isWeakRef = (curField->getFlags() & RTTI_Flag_WeakRef) != 0;
 
-							const bool needsDecoding = (curField->getFlags() & RTTI_Flag_WeakRef) == 0 && !objToDecode.isDecoded;
-							if (needsDecoding)
+							// Referenced objects are decoded by other tasks, so only record them for finalizing objects in order
+							if (parallelObject != nullptr)
+							{
+								if (!isWeakRef)
+									parallelObject->dependencies.push_back(childObjectId);
+							}
+							else if (!isWeakRef && !objToDecode.isDecoded)
 							{
 								if (objToDecode.decodeInProgress)
 								{
@@ -789,7 +1074,7 @@ namespace ls
 					if (curField)
 						childObj = curField->newObject();
 
-					decodeEntry(data, dataEnd, childObj);
+					decodeEntry(data, dataEnd, childObj, parallelObject);
 
 					if (curField != nullptr)
 					{
@@ -815,11 +1100,11 @@ namespace ls
 						// Note: Two data copies that can potentially be avoided:
 						//  - Copy from stream into a temporary buffer (use stream directly for decoding)
 						//  - Internally the field will do a value copy of the decoded object (ideally we decode directly into the destination)
-						void* fieldValue = ls_stack_alloc(typeSize);
+						void* fieldValue = allocFieldValue(typeSize);
 						data->read(fieldValue, typeSize);
 
 						curField->fromBuffer(rttiInstance, output.get(), fieldValue);
-						ls_stack_free(fieldValue);
+						freeFieldValue(fieldValue);
 					}
 					else
 						data->skip(typeSize);
@@ -840,7 +1125,11 @@ namespace ls
 					// Data block data
 					if (curField != nullptr)
 					{
-						if (data->isFile()) // Allow streaming
+						// Reference the data directly if the stream allows it (e.g. memory mapped files)
+						SPtr<DataStream> view = data->readView(dataBlockSize);
+						if (view != nullptr)
+							curField->setValue(rttiInstance, output.get(), view, dataBlockSize);
+						else if (data->isFile()) // Allow streaming
 						{
 							const size_t dataBlockOffset = data->tell();
 							curField->setValue(rttiInstance, output.get(), data, dataBlockSize);
@@ -41,7 +41,10 @@ namespace ls
 		 * @param[in]	object					Object to encode into binary format.
 		 * @param[out]	buffer					Preallocated buffer where the data will be stored.
 		 * @param[in]	bufferLength			Length of the buffer, in bytes.
-		 * @param[out]	bytesWritten			Length of the data that was actually written to the buffer, in bytes.
+		 * @param[out]	bytesWritten			Total length of the encoded data, in bytes. Can be null if the caller counts
+		 *										the bytes passed to @p flushBufferCallback instead, which is required if the
+		 *										data can be larger than 4GB. Otherwise an exception is thrown for such data,
+		 *										as its length doesn't fit.
 		 * @param[in]	flushBufferCallback 	This callback will get called whenever the buffer gets full (Be careful to 
 		 *										check the provided @p bytesRead variable, as buffer might not be full 
 		 *										completely). User must then either create a new buffer or empty the existing 
@@ -68,7 +71,32 @@ namespace ls
 		 *							their deserialization callbacks. Can be used for controlling deserialization, 
 		 *							maintaining state or sharing information between objects during deserialization.
 		 */
-		SPtr<IReflectable> decode(const SPtr<DataStream>& data, UINT32 dataLength, SerializationContext* context = nullptr);
+		SPtr<IReflectable> decode(const SPtr<DataStream>& data, UINT64 dataLength, SerializationContext* context = nullptr);
+
+		/**
+		 * Decodes an object from binary data, same as decode(), but decodes the fields of all the objects stored in the
+		 * data in parallel using the TaskScheduler. Falls back to decode() if there are only a few objects, or if the 
+		 * scheduler isn't running.
+		 *
+		 * All objects are created up front, so pointer fields are assigned objects that might still be decoding on 
+		 * another thread. Once all objects are decoded, onDeserializationEnded() is called on them in a serial pass, 
+		 * with referenced objects finished before the objects referencing them (unless referenced through a weak
+		 * reference), same as in decode(). If decoding any of the objects throws, the first exception is rethrown once 
+		 * all the tasks are done.
+		 *
+		 * @note	Only use this for types whose deserialization callbacks and field setters can be called from multiple 
+		 *			threads at once, and whose pointer field setters only store the provided object without accessing its 
+		 *			data. The provided @p context must be thread safe as well.
+		 *
+		 * @param[in]	data  		Binary data to decode. Must support clone() so each task can read the data 
+		 *							independently.
+		 * @param[in]	dataLength	Length of the data in bytes.
+		 * @param[in]	context		Optional object that will be passed along to all serialized objects through
+		 *							their deserialization callbacks. Can be used for controlling deserialization, 
+		 *							maintaining state or sharing information between objects during deserialization.
+		 */
+		SPtr<IReflectable> decodeParallel(const SPtr<DataStream>& data, UINT64 dataLength, 
+			SerializationContext* context = nullptr);
 	private:
 		struct ObjectMetaData
 		{
@@ -98,12 +126,50 @@ namespace ls
 			size_t offset;
 		};
 
+		/** Top-level object decoded by decodeParallel(), whose deserialization is finished in a serial pass. */
+		struct ParallelDecodeObject
+		{
+			FrameAlloc* alloc = nullptr; /**< Allocator the RTTI instances were allocated from. */
+			Vector<RTTITypeBase*> rttiInstances; /**< RTTI instances still waiting for onDeserializationEnded(). */
+			Vector<UINT32> dependencies; /**< IDs of objects referenced through non-weak pointer fields. */
+			bool finalizeInProgress = false; // Used for error reporting circular references
+			bool isFinalized = false;
+		};
+
 		/** Encodes a single IReflectable object. */
 		UINT8* encodeEntry(IReflectable* object, UINT32 objectId, UINT8* buffer, UINT32& bufferLength, UINT32* bytesWritten,
 			std::function<UINT8*(UINT8* buffer, UINT32 bytesWritten, UINT32& newBufferSize)> flushBufferCallback, bool shallow);
 
-		/**	Decodes a single IReflectable object. */
-		bool decodeEntry(const SPtr<DataStream>& data, size_t dataLength, const SPtr<IReflectable>& output);
+		/**
+		 * Scans the data for all the objects it contains, creates their instances and registers them in
+		 * mDecodeObjectMap. Returns the root object.
+		 */
+		SPtr<IReflectable> createDecodeObjects(const SPtr<DataStream>& data, size_t dataEnd);
+
+		/** 
+		 * Decodes all the objects registered by createDecodeObjects() one after another, then clears them and moves the
+		 * read position to @p dataEnd.
+		 */
+		void decodeObjects(const SPtr<DataStream>& data, size_t dataEnd);
+
+		/**
+		 * Decodes a single IReflectable object.
+		 *
+		 * @param[in]	data			Stream to decode the data from.
+		 * @param[in]	dataLength		Offset in @p data at which the encoded data ends.
+		 * @param[in]	output			Object to decode the data into. If null, the data is skipped.
+		 * @param[in]	parallelObject	Top-level object being decoded by decodeParallel(), if any. Pointer fields are 
+		 *								then assigned without decoding the referenced objects, and RTTI instances are
+		 *								allocated from its allocator.
+		 * @param[in]	isParallelRoot	True if @p output is the top-level object itself, rather than a value embedded in
+		 *								it. Its RTTI instances are then stored in @p parallelObject instead of being 
+		 *								finalized.
+		 */
+		bool decodeEntry(const SPtr<DataStream>& data, size_t dataLength, const SPtr<IReflectable>& output,
+			ParallelDecodeObject* parallelObject = nullptr, bool isParallelRoot = false);
+
+		/** Calls onDeserializationEnded() on an object decoded by decodeParallel() and releases its RTTI instances. */
+		void finalizeParallelObject(IReflectable* object, ParallelDecodeObject& parallelObject);
 
 		/**	Helper method for encoding a complex object and copying its data to a buffer. */
 		UINT8* complexTypeToBuffer(IReflectable* object, UINT8* buffer, UINT32& bufferLength, UINT32* bytesWritten,
@@ -151,7 +217,7 @@ namespace ls
 		Vector<ObjectToEncode> mObjectsToEncode;
 		UnorderedMap<void*, UINT32> mObjectAddrToId;
 		UINT32 mLastUsedObjectId = 1;
-		UINT32 mTotalBytesWritten;
+		UINT64 mTotalBytesWritten;
 		FrameAlloc* mAlloc = nullptr;
 
 		SerializationContext* mContext = nullptr;
@@ -160,6 +226,15 @@ namespace ls
 		static constexpr const int NUM_ELEM_FIELD_SIZE = 4; // Size of the field storing number of array elements
 		static constexpr const int COMPLEX_TYPE_FIELD_SIZE = 4; // Size of the field storing the size of a child complex type
 		static constexpr const int DATA_BLOCK_TYPE_FIELD_SIZE = 4;
+
+		/** Minimum number of objects in the data for decodeParallel() to decode them in parallel. */
+		static constexpr const UINT32 MIN_PARALLEL_DECODE_OBJECTS = 64;
+
+		/** Number of objects decoded by a single task in decodeParallel(). */
+		static constexpr const UINT32 DECODE_OBJECTS_PER_TASK = 16;
+
+		/** Block size of the allocators holding RTTI instances of objects decoded in parallel. */
+		static constexpr const UINT32 DECODE_ALLOC_BLOCK_SIZE = 64 * 1024;
 	};
 
 	// TODO - Potential improvements:
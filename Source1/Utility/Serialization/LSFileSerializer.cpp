@@ -12,6 +12,19 @@ using namespace std::placeholders;
 
 namespace ls
 {
+	/** Identifies files written in the versioned format. Files without it are in the legacy format (version 1). */
+	static constexpr UINT32 FILE_MAGIC = 0x3153464C; // "LFS1"
+
+	/** Version of the format written by FileEncoder. */
+	static constexpr UINT32 FILE_VERSION = 2;
+
+	/** Header at the start of files in the versioned format. */
+	struct FileHeader
+	{
+		UINT32 magic;
+		UINT32 version;
+	};
+
 	FileEncoder::FileEncoder(const Path& fileLocation)
 	{
 		mWriteBuffer = (UINT8*)ls_alloc(WRITE_BUFFER_SIZE);
@@ -24,7 +37,14 @@ namespace ls
 		if (mOutputStream.fail())
 		{
 			LOGWRN("Failed to save file: \"" + fileLocation.toString() + "\". Error: " + strerror(errno) + ".");
+			return;
 		}
+
+		FileHeader header;
+		header.magic = FILE_MAGIC;
+		header.version = FILE_VERSION;
+
+		mOutputStream.write((const char*)&header, sizeof(header));
 	}
 
 	FileEncoder::~FileEncoder()
@@ -40,61 +60,118 @@ namespace ls
 		if (object == nullptr)
 			return;
 
-		UINT64 curPos = (UINT64)mOutputStream.tellp();
-		mOutputStream.seekp(sizeof(UINT32), std::ios_base::cur);
+		// Leave room for the size, which is only known once the object is encoded
+		std::ofstream::pos_type curPos = mOutputStream.tellp();
+		mOutputStream.seekp(sizeof(UINT64), std::ios_base::cur);
+
+		// Count the flushed bytes ourselves, as the serializer only reports 32-bit sizes
+		mObjectBytesWritten = 0;
 
 		BinarySerializer bs;
-		UINT32 totalBytesWritten = 0;
-		bs.encode(object, mWriteBuffer, WRITE_BUFFER_SIZE, &totalBytesWritten, 
+		bs.encode(object, mWriteBuffer, WRITE_BUFFER_SIZE, nullptr, 
 			std::bind(&FileEncoder::flushBuffer, this, _1, _2, _3), false, context);
 
+		std::ofstream::pos_type endPos = mOutputStream.tellp();
+
 		mOutputStream.seekp(curPos);
-		mOutputStream.write((char*)&totalBytesWritten, sizeof(totalBytesWritten));
-		mOutputStream.seekp(totalBytesWritten, std::ios_base::cur);
+		mOutputStream.write((const char*)&mObjectBytesWritten, sizeof(mObjectBytesWritten));
+		mOutputStream.seekp(endPos);
+
+		if (mOutputStream.fail())
+			LS_EXCEPT(InternalErrorException, "Failed to write the object size. The output stream must be seekable.");
 	}
 
 	UINT8* FileEncoder::flushBuffer(UINT8* bufferStart, UINT32 bytesWritten, UINT32& newBufferSize)
 	{
 		mOutputStream.write((const char*)bufferStart, bytesWritten);
+		mObjectBytesWritten += bytesWritten;
 
 		return bufferStart;
 	}
 
-	FileDecoder::FileDecoder(const Path& fileLocation)
+	FileDecoder::FileDecoder(const Path& fileLocation, bool memoryMapped)
 	{
-		mInputStream = FileSystem::openFile(fileLocation, true);
+		mInputStream = FileSystem::openFile(fileLocation, true, memoryMapped);
 
 		if (mInputStream == nullptr)
 			return;
 
-		if (mInputStream->size() > std::numeric_limits<UINT32>::max())
+		// Files without a header were written by the legacy encoder
+		mVersion = 1;
+
+		FileHeader header;
+		if (mInputStream->read(&header, sizeof(header)) == sizeof(header) && header.magic == FILE_MAGIC)
 		{
-			LS_EXCEPT(InternalErrorException,
-				"File size is larger that UINT32 can hold. Ask a programmer to use a bigger data type.");
+			if (header.version > FILE_VERSION)
+			{
+				LS_EXCEPT(InternalErrorException,
+					"Unsupported file version: " + toString(header.version) + ". Latest supported version is " + 
+					toString(FILE_VERSION) + ".");
+			}
+
+			mVersion = header.version;
 		}
+		else
+			mInputStream->seek(0);
 	}
 
-	SPtr<IReflectable> FileDecoder::decode(SerializationContext* context)
+	bool FileDecoder::hasMore() const
 	{
-		if (mInputStream->eof())
-			return nullptr;
+		// Compare against the size rather than checking for EOF, which is only reported once a read goes past the end
+		return mInputStream != nullptr && mInputStream->tell() < mInputStream->size();
+	}
 
-		UINT32 objectSize = 0;
-		mInputStream->read(&objectSize, sizeof(objectSize));
+	SPtr<IReflectable> FileDecoder::decode(SerializationContext* context, bool parallel)
+	{
+		UINT64 objectSize = 0;
+		if (!readObjectSize(objectSize))
+			return nullptr;
 
 		BinarySerializer bs;
-		SPtr<IReflectable> object = bs.decode(mInputStream, objectSize, context);
+		SPtr<IReflectable> object;
+		if (parallel)
+			object = bs.decodeParallel(mInputStream, objectSize, context);
+		else
+			object = bs.decode(mInputStream, objectSize, context);
 
 		return object;
 	}
 
 	void FileDecoder::skip()
 	{
-		if (mInputStream->eof())
+		UINT64 objectSize = 0;
+		if (!readObjectSize(objectSize))
 			return;
 
-		UINT32 objectSize = 0;
-		mInputStream->read(&objectSize, sizeof(objectSize));
-		mInputStream->skip(objectSize);
+		mInputStream->skip((size_t)objectSize);
+	}
+
+	bool FileDecoder::readObjectSize(UINT64& size)
+	{
+		if (!hasMore())
+			return false;
+
+		if (mVersion == 1)
+		{
+			UINT32 legacySize = 0;
+			if (mInputStream->read(&legacySize, sizeof(legacySize)) != sizeof(legacySize))
+				return false;
+
+			size = legacySize;
+		}
+		else
+		{
+			if (mInputStream->read(&size, sizeof(size)) != sizeof(size))
+				return false;
+		}
+
+		const UINT64 remaining = (UINT64)(mInputStream->size() - mInputStream->tell());
+		if (size > remaining)
+		{
+			LS_EXCEPT(InternalErrorException,
+				"Object size is larger than the remaining file data. The file is likely truncated or corrupt.");
+		}
+
+		return true;
 	}
 }
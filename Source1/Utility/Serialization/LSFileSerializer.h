@@ -10,7 +10,16 @@ namespace ls
 
 	struct SerializationContext;
 
-	/** Encodes the provided object to the specified file using the RTTI system. */
+	/**
+	 * Encodes the provided object to the specified file using the RTTI system. The file starts with a small header 
+	 * identifying the format version, followed by one record per encoded object. Each record is prefixed with the 64-bit 
+	 * size of the object data, so files and individual objects can be larger than 4GB.
+	 *
+	 * @note
+	 * The size prefix is written by seeking back once the object is encoded, so the output must be seekable. Records
+	 * aren't split into chunks, as FileDecoder decodes each record in place from the file stream (or the memory mapped
+	 * file). This requires the record data to be contiguous and its size to be known up front.
+	 */
 	class LS_UTILITY_EXPORT FileEncoder
 	{
 		public:
@@ -35,15 +44,34 @@ namespace ls
 
 		std::ofstream mOutputStream;
 		UINT8* mWriteBuffer = nullptr;
+		UINT64 mObjectBytesWritten = 0;
 
 		static const UINT32 WRITE_BUFFER_SIZE = 2048;
 	};
 
-	/** Decodes objects from the specified file using the RTTI system. */
+	/**
+	 * Decodes objects from the specified file using the RTTI system. Objects are read from the file one at a time as they
+	 * are decoded, so the entire file is never loaded into memory. Files written before the versioned format was 
+	 * introduced (with 32-bit object sizes and no header) are still supported.
+	 */
 	class LS_UTILITY_EXPORT FileDecoder
 	{
 	public:
-		FileDecoder(const Path& fileLocation);
+		/**
+		 * Opens the file for decoding.
+		 *
+		 * @param[in]	fileLocation	Path of the file to decode.
+		 * @param[in]	memoryMapped	If true the file is mapped into memory instead of being read through a file 
+		 *								stream. Data block fields of decoded objects then reference the mapped file 
+		 *								data directly, rather than receiving a copy.
+		 */
+		FileDecoder(const Path& fileLocation, bool memoryMapped = false);
+
+		/** Returns true if there are more objects in the file to decode. */
+		bool hasMore() const;
+
+		/** Returns the version of the format the file was written in. Files without a header report version 1. */
+		UINT32 getVersion() const { return mVersion; }
 
 		/**	
 		 * Deserializes an IReflectable object by reading the binary data at the provided file location. 
@@ -52,14 +80,21 @@ namespace ls
 		 *							their deserialization callbacks. Can be used for controlling deserialization, 
 		 *							maintaining state or sharing information between objects during 
 		 *							deserialization.
+		 * @param[in]	parallel	If true the objects stored in the record are decoded in parallel. See 
+		 *							BinarySerializer::decodeParallel() for the requirements this places on the decoded 
+		 *							types.
 		 */
-		SPtr<IReflectable> decode(SerializationContext* context = nullptr);
+		SPtr<IReflectable> decode(SerializationContext* context = nullptr, bool parallel = false);
 
 		/** Skips over than object in the file. Calling decode() will decode the next object. */
 		void skip();
 
 	private:
+		/** Reads the size prefix of the next object record. Returns false if there are no more objects in the file. */
+		bool readObjectSize(UINT64& size);
+
 		SPtr<DataStream> mInputStream;
+		UINT32 mVersion = 0;
 	};
 
 	/** @} */
@@ -9,48 +9,140 @@ using namespace std::placeholders;
 
 namespace ls
 {
-	UINT8* MemorySerializer::encode(IReflectable* object, UINT32& bytesWritten, 
-		std::function<void*(UINT32)> allocator, bool shallow, SerializationContext* context)
+	MemorySerializerBuffer::MemorySerializerBuffer(FrameAlloc* alloc)
+		:mAlloc(alloc)
+	{ }
+
+	MemorySerializerBuffer::~MemorySerializerBuffer()
 	{
-		using namespace std::placeholders;
+		release();
+	}
 
-		BinarySerializer bs;
+	void MemorySerializerBuffer::reserve(UINT32 capacity)
+	{
+		if(capacity <= mCapacity)
+			return;
+
+		UINT8* data;
+		if(mAlloc != nullptr)
+			data = mAlloc->alloc(capacity);
+		else
+			data = (UINT8*)ls_alloc(capacity);
+
+		if(mData != nullptr)
+		{
+			if(mSize > 0)
+				memcpy(data, mData, mSize);
+
+			if(mAlloc != nullptr)
+				mAlloc->free(mData);
+			else
+				ls_free(mData);
+		}
 
-		BufferPiece piece;
-		piece.buffer = (UINT8*)ls_alloc(WRITE_BUFFER_SIZE);
-		piece.size = 0;
+		mData = data;
+		mCapacity = capacity;
+	}
+
+	void MemorySerializerBuffer::shrinkToFit()
+	{
+		if(mSize == mCapacity)
+			return;
+
+		if(mSize == 0)
+		{
+			release();
+			return;
+		}
 
-		mBufferPieces.push_back(piece);
+		UINT8* data = mData;
+		UINT32 size = mSize;
 
-		bs.encode(object, piece.buffer, WRITE_BUFFER_SIZE, &bytesWritten, 
-			std::bind(&MemorySerializer::flushBuffer, this, _1, _2, _3), shallow, context);
+		mData = nullptr;
+		mSize = 0;
+		mCapacity = 0;
 
-		UINT8* resultBuffer;
-		if(allocator != nullptr)
-			resultBuffer = (UINT8*)allocator(bytesWritten);
+		reserve(size);
+		memcpy(mData, data, size);
+		mSize = size;
+
+		if(mAlloc != nullptr)
+			mAlloc->free(data);
 		else
-			resultBuffer = (UINT8*)ls_alloc(bytesWritten);
+			ls_free(data);
+	}
 
-		UINT32 offset = 0;
-		for(auto iter = mBufferPieces.begin(); iter != mBufferPieces.end(); ++iter)
+	void MemorySerializerBuffer::release()
+	{
+		if(mData != nullptr)
 		{
-			if(iter->size > 0)
-			{
-				memcpy(resultBuffer + offset, iter->buffer, iter->size);
-				offset += iter->size;
-			}
+			if(mAlloc != nullptr)
+				mAlloc->free(mData);
+			else
+				ls_free(mData);
 		}
 
-		for(auto iter = mBufferPieces.rbegin(); iter != mBufferPieces.rend(); ++iter)
+		mData = nullptr;
+		mSize = 0;
+		mCapacity = 0;
+	}
+
+	UINT8* MemorySerializerBuffer::detach()
+	{
+		assert(mAlloc == nullptr);
+
+		UINT8* data = mData;
+
+		mData = nullptr;
+		mSize = 0;
+		mCapacity = 0;
+
+		return data;
+	}
+
+	UINT8* MemorySerializer::encode(IReflectable* object, UINT32& bytesWritten, 
+		std::function<void*(UINT32)> allocator, bool shallow, SerializationContext* context)
+	{
+		MemorySerializerBuffer output;
+		bytesWritten = encode(object, output, shallow, context);
+
+		// Hand over the buffer we encoded into directly, unless the user wants the memory from elsewhere
+		if(allocator == nullptr)
 		{
-			ls_free(iter->buffer);
+			// The buffer grows geometrically, including on the final flush, so don't hand over a buffer mostly unused
+			if((output.getCapacity() - output.getSize()) > output.getSize() / 8)
+				output.shrinkToFit();
+
+			return output.detach();
 		}
 
-		mBufferPieces.clear();
+		UINT8* resultBuffer = (UINT8*)allocator(bytesWritten);
+		memcpy(resultBuffer, output.getData(), bytesWritten);
 
 		return resultBuffer;
 	}
 
+	UINT32 MemorySerializer::encode(IReflectable* object, MemorySerializerBuffer& output, bool shallow, 
+		SerializationContext* context)
+	{
+		if(output.mAlloc == &gFrameAlloc())
+		{
+			LS_EXCEPT(InvalidParametersException, 
+				"Output buffer cannot use the frame allocator of the encoding thread.");
+		}
+
+		output.clear();
+		output.reserve(WRITE_BUFFER_SIZE);
+
+		BinarySerializer bs;
+
+		UINT32 bytesWritten = 0;
+		bs.encode(object, output.mData, output.mCapacity, &bytesWritten, 
+			std::bind(&MemorySerializer::flushBuffer, std::ref(output), _2, _3), shallow, context);
+
+		return bytesWritten;
+	}
+
 	SPtr<IReflectable> MemorySerializer::decode(UINT8* buffer, UINT32 bufferSize, SerializationContext* context)
 	{
 		SPtr<MemoryDataStream> stream = ls_shared_ptr_new<MemoryDataStream>(buffer, bufferSize, false);
@@ -61,16 +153,24 @@ namespace ls
 		return object;
 	}
 
-	UINT8* MemorySerializer::flushBuffer(UINT8* bufferStart, UINT32 bytesWritten, UINT32& newBufferSize)
+	UINT8* MemorySerializer::flushBuffer(MemorySerializerBuffer& output, UINT32 bytesWritten, UINT32& newBufferSize)
 	{
-		mBufferPieces.back().size = bytesWritten;
+		// Everything written so far is final, the serializer continues writing right after it
+		output.mSize += bytesWritten;
 
-		BufferPiece piece;
-		piece.buffer = (UINT8*)ls_alloc(WRITE_BUFFER_SIZE);
-		piece.size = 0;
+		// Grow geometrically so the total amount of copying stays proportional to the size of the encoded data
+		if((output.mCapacity - output.mSize) < WRITE_BUFFER_SIZE)
+		{
+			UINT64 newCapacity = std::max((UINT64)output.mCapacity * 2, (UINT64)output.mSize + WRITE_BUFFER_SIZE);
+			newCapacity = std::min(newCapacity, (UINT64)std::numeric_limits<UINT32>::max());
 
-		mBufferPieces.push_back(piece);
+			if(newCapacity <= output.mSize)
+				return nullptr; // Out of addressable space, abort the encode
+
+			output.reserve((UINT32)newCapacity);
+		}
 
-		return piece.buffer;
+		newBufferSize = output.mCapacity - output.mSize;
+		return output.mData + output.mSize;
 	}
 }
@@ -10,15 +10,66 @@ namespace ls
 	 *  @{
 	 */
 
+	/**
+	 * Growable buffer that MemorySerializer can encode objects into. The buffer keeps its memory between encodes, so once
+	 * it has grown large enough, encoding into it performs no allocations.
+	 */
+	class LS_UTILITY_EXPORT MemorySerializerBuffer
+	{
+	public:
+		/**
+		 * Creates an empty buffer.
+		 *
+		 * @param[in]	alloc	Optional frame allocator to allocate the buffer memory from. If not specified the general 
+		 *						allocator is used. The buffer must be released before the frame allocator is cleared.
+		 *						Must not be the gFrameAlloc() of the thread doing the encoding, as the serializer 
+		 *						uses it for its temporary data.
+		 */
+		MemorySerializerBuffer(FrameAlloc* alloc = nullptr);
+		~MemorySerializerBuffer();
+
+		MemorySerializerBuffer(const MemorySerializerBuffer&) = delete;
+		MemorySerializerBuffer& operator=(const MemorySerializerBuffer&) = delete;
+
+		/** Ensures the buffer can hold at least @p capacity bytes without growing. */
+		void reserve(UINT32 capacity);
+
+		/** Reallocates the buffer memory so its capacity matches the size of its contents. */
+		void shrinkToFit();
+
+		/** Discards the contents of the buffer, but keeps its memory for later use. */
+		void clear() { mSize = 0; }
+
+		/** Discards the contents of the buffer and frees its memory. */
+		void release();
+
+		/** Returns the encoded data. Only valid until the next encode into the buffer. */
+		UINT8* getData() const { return mData; }
+
+		/** Returns the number of bytes of encoded data in the buffer. */
+		UINT32 getSize() const { return mSize; }
+
+		/** Returns the number of bytes the buffer can hold before it needs to grow. */
+		UINT32 getCapacity() const { return mCapacity; }
+
+	private:
+		friend class MemorySerializer;
+
+		/** 
+		 * Transfers ownership of the buffer memory to the caller and leaves the buffer empty. Only valid for buffers using
+		 * the general allocator.
+		 */
+		UINT8* detach();
+
+		FrameAlloc* mAlloc;
+		UINT8* mData = nullptr;
+		UINT32 mSize = 0;
+		UINT32 mCapacity = 0;
+	};
+
 	/**	Encodes/decodes an IReflectable object from/to memory. */
 	class LS_UTILITY_EXPORT MemorySerializer
 	{
-		struct BufferPiece
-		{
-			UINT8* buffer;
-			UINT32 size;
-		};
-
 	public:
 		MemorySerializer() = default;
 		~MemorySerializer() = default;
@@ -44,6 +95,27 @@ namespace ls
 		UINT8* encode(IReflectable* object, UINT32& bytesWritten, std::function<void*(UINT32)> allocator = nullptr, 
 			bool shallow = false, SerializationContext* context = nullptr);
 
+		/**
+		 * Parses the provided object, serializes all of its data as specified by its RTTIType and writes the data into
+		 * the provided buffer, replacing its previous contents. The data is written directly into @p output, which grows
+		 * as needed, so no intermediate copies are made.
+		 *
+		 * @param[in]	object			Object to encode.
+		 * @param[in]	output			Buffer to write the encoded data to. Reuse the same buffer for multiple encodes
+		 *								to avoid allocating memory on each one.
+		 * @param[in]	shallow			Determines how to handle referenced objects. If true then references will not be 
+		 *								encoded and will be set to null. If false then references will be encoded as well 
+		 *								and restored upon decoding.
+		 * @param[in]	context			Optional object that will be passed along to all serialized objects through
+		 *								their serialization callbacks. Can be used for controlling serialization, 
+		 *								maintaining state or sharing information between objects during 
+		 *								serialization.
+		 *
+		 * @return						Total number of bytes it took to encode the object.
+		 */
+		UINT32 encode(IReflectable* object, MemorySerializerBuffer& output, bool shallow = false, 
+			SerializationContext* context = nullptr);
+
 		/** 
 		 * Deserializes an IReflectable object by reading the binary data from the provided memory location. 
 		 *
@@ -57,10 +129,11 @@ namespace ls
 		SPtr<IReflectable> decode(UINT8* buffer, UINT32 bufferSize, SerializationContext* context = nullptr);
 
 	private:
-		Vector<BufferPiece> mBufferPieces;
-
-		/** Called by the binary serializer whenever the buffer gets full. */
-		UINT8* flushBuffer(UINT8* bufferStart, UINT32 bytesWritten, UINT32& newBufferSize);
+		/** 
+		 * Called by the binary serializer whenever the buffer gets full. Commits the written bytes to @p output and 
+		 * grows it if needed.
+		 */
+		static UINT8* flushBuffer(MemorySerializerBuffer& output, UINT32 bytesWritten, UINT32& newBufferSize);
 
 		/************************************************************************/
 		/* 								CONSTANTS	                     		*/
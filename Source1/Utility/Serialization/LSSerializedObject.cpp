@@ -5,6 +5,167 @@ namespace ls
 {
 	namespace detail
 	{
+		/** Size of the chunks data blocks are hashed in. Must be a multiple of 8. */
+		static constexpr UINT32 HASH_CHUNK_SIZE = 4096;
+
+		/** Hash value used for null children. */
+		static constexpr UINT64 NULL_HASH = 0x9E3779B97F4A7C15ULL;
+
+		/** Scrambles the bits of the provided value. */
+		static UINT64 mixHash(UINT64 value)
+		{
+			value += 0x9E3779B97F4A7C15ULL;
+			value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+			return value ^ (value >> 31);
+		}
+
+		/** 
+		 * Hashes a block of memory, continuing from the provided hash. Hashing a buffer in multiple parts yields the same
+		 * hash as hashing it at once, as long as all but the last part are sized in multiples of 8 bytes.
+		 */
+		static UINT64 hashBytes(const UINT8* data, UINT32 size, UINT64 hash)
+		{
+			for (; size >= 8; data += 8, size -= 8)
+			{
+				UINT64 word;
+				memcpy(&word, data, 8);
+
+				hash = mixHash(hash ^ word);
+			}
+
+			if (size > 0)
+			{
+				UINT64 word = 0;
+				memcpy(&word, data, size);
+
+				hash = mixHash(hash ^ word);
+			}
+
+			return hash;
+		}
+
+		/** 
+		 * Combines the hash of a keyed child into an accumulated hash. The result doesn't depend on the order in which
+		 * the children are combined, so unordered containers with equal contents hash equally.
+		 */
+		static void combineKeyedHash(UINT64& accumulator, UINT32 key, UINT64 childHash)
+		{
+			accumulator += mixHash(mixHash(key) ^ childHash);
+		}
+
+		/** 
+		 * Bump allocator holding all instances of a single encoded hierarchy. The first block is small and every following
+		 * block is twice as large as the previous one (up to MAX_BLOCK_SIZE), so small hierarchies don't reserve much
+		 * more memory than they use, while large ones still only need a few heap allocations.
+		 */
+		class SerializedArena
+		{
+			/** Header placed at the start of every block. */
+			struct alignas(16) Block
+			{
+				Block* next;
+			};
+
+		public:
+			SerializedArena() = default;
+			SerializedArena(const SerializedArena&) = delete;
+			SerializedArena& operator=(const SerializedArena&) = delete;
+
+			~SerializedArena()
+			{
+				while (mBlocks != nullptr)
+				{
+					Block* next = mBlocks->next;
+					ls_free(mBlocks);
+
+					mBlocks = next;
+				}
+			}
+
+			/** Allocates a piece of memory of the specified size, aligned to a 16 byte boundary. */
+			UINT8* alloc(UINT32 amount)
+			{
+				return allocAligned(amount, 16);
+			}
+
+			/** Allocates a piece of memory of the specified size, aligned to the specified power of two boundary. */
+			UINT8* allocAligned(UINT32 amount, UINT32 alignment)
+			{
+				UINT8* data = (UINT8*)(((UINT64)mPos + alignment - 1) & ~((UINT64)alignment - 1));
+				if (mPos == nullptr || (UINT64)(data - mPos) + amount > (UINT64)(mEnd - mPos))
+				{
+					allocBlock(amount + alignment);
+					data = (UINT8*)(((UINT64)mPos + alignment - 1) & ~((UINT64)alignment - 1));
+				}
+
+				mPos = data + amount;
+				return data;
+			}
+
+		private:
+			/** Allocates a new block with room for at least @p amount bytes, and makes it the current block. */
+			void allocBlock(UINT32 amount)
+			{
+				const UINT32 blockSize = std::max(mNextBlockSize, amount);
+				mNextBlockSize = std::min(mNextBlockSize * 2, MAX_BLOCK_SIZE);
+
+				Block* block = (Block*)ls_alloc(sizeof(Block) + blockSize);
+				block->next = mBlocks;
+				mBlocks = block;
+
+				mPos = (UINT8*)block + sizeof(Block);
+				mEnd = mPos + blockSize;
+			}
+
+			/** Size of the first block, in bytes. */
+			static constexpr UINT32 INITIAL_BLOCK_SIZE = 512;
+
+			/** Largest size blocks grow to, in bytes. Larger allocations still get a block of their own size. */
+			static constexpr UINT32 MAX_BLOCK_SIZE = 64 * 1024;
+
+			Block* mBlocks = nullptr;
+			UINT8* mPos = nullptr;
+			UINT8* mEnd = nullptr;
+			UINT32 mNextBlockSize = INITIAL_BLOCK_SIZE;
+		};
+
+		/** 
+		 * Allocator for the standard library that allocates from a shared arena. Every allocation keeps a reference to the
+		 * arena, so the arena memory is released all at once when the last object allocated from it is destroyed.
+		 */
+		template <class T>
+		class StdArenaAlloc
+		{
+		public:
+			typedef T value_type;
+
+			StdArenaAlloc(const SPtr<SerializedArena>& arena) noexcept
+				:mArena(arena)
+			{ }
+
+			template<class U> StdArenaAlloc(const StdArenaAlloc<U>& alloc) noexcept
+				:mArena(alloc.mArena)
+			{ }
+
+			template<class U> bool operator==(const StdArenaAlloc<U>& rhs) const noexcept { return mArena == rhs.mArena; }
+			template<class U> bool operator!=(const StdArenaAlloc<U>& rhs) const noexcept { return mArena != rhs.mArena; }
+
+			/** Allocate but don't initialize number elements of type T. */
+			T* allocate(const size_t num) const
+			{
+				return (T*)mArena->allocAligned((UINT32)(num * sizeof(T)), (UINT32)alignof(T));
+			}
+
+			/** 
+			 * Deallocate storage p of deleted elements. Memory is only reclaimed once the whole arena is released. The arena
+			 * isn't notified, as instances of a hierarchy may be released from different threads.
+			 */
+			void deallocate(T* p, size_t num) const noexcept { }
+
+			SPtr<SerializedArena> mArena;
+		};
+
 		/** Helper class for performing SerializedObject <-> IReflectable encoding & decoding. */
 		class LS_UTILITY_EXPORT IntermediateSerializer
 		{
@@ -38,9 +199,17 @@ namespace ls
 			/** Encodes a single IReflectable object. */
 			SPtr<SerializedObject> encodeEntry(IReflectable* object, bool shallow);
 
+			/** Creates a new serialized instance in the arena of the hierarchy being encoded. */
+			template<class T>
+			SPtr<T> newInstance()
+			{
+				return std::allocate_shared<T>(StdArenaAlloc<T>(mArena));
+			}
+
 			UnorderedMap<const SerializedObject*, ObjectToDecode> mObjectMap;
 			SerializationContext* mContext = nullptr;
 			FrameAlloc* mAlloc = nullptr;
+			SPtr<SerializedArena> mArena;
 		};
 
 		IntermediateSerializer::IntermediateSerializer()
@@ -93,7 +262,13 @@ namespace ls
 		{
 			mContext = context;
 
-			return encodeEntry(object, shallow);
+			// All instances in the hierarchy share a single arena, which they keep alive until the last one is destroyed
+			mArena = ls_shared_ptr_new<SerializedArena>();
+
+			SPtr<SerializedObject> output = encodeEntry(object, shallow);
+			mArena = nullptr;
+
+			return output;
 		}
 
 		void IntermediateSerializer::decodeEntry(const SPtr<IReflectable>& object, const SerializedObject* serializableObject)
@@ -354,7 +529,7 @@ namespace ls
 				}
 			};
 
-			SPtr<SerializedObject> output = ls_shared_ptr_new<SerializedObject>();
+			SPtr<SerializedObject> output = newInstance<SerializedObject>();
 
 			// If an object has base classes, we need to iterate through all of them
 			do
@@ -369,6 +544,8 @@ namespace ls
 				subObject.typeId = rtti->getRTTIId();
 
 				const UINT32 numFields = rtti->getNumFields();
+				subObject.entries.reserve(numFields);
+
 				for (UINT32 i = 0; i < numFields; i++)
 				{
 					SPtr<SerializedInstance> serializedEntry;
@@ -378,8 +555,9 @@ namespace ls
 					{
 						const UINT32 arrayNumElems = curGenericField->getArraySize(rttiInstance, object);
 
-						const SPtr<SerializedArray> serializedArray = ls_shared_ptr_new<SerializedArray>();
+						const SPtr<SerializedArray> serializedArray = newInstance<SerializedArray>();
 						serializedArray->numElements = arrayNumElems;
+						serializedArray->entries.reserve(arrayNumElems);
 
 						serializedEntry = serializedArray;
 
@@ -441,9 +619,9 @@ namespace ls
 								else
 									typeSize = curField->getTypeSize();
 
-								const auto serializedField = ls_shared_ptr_new<SerializedField>();
-								serializedField->value = (UINT8*)ls_alloc(typeSize);
-								serializedField->ownsMemory = true;
+								const auto serializedField = newInstance<SerializedField>();
+								serializedField->value = mArena->alloc(typeSize);
+								serializedField->ownsMemory = false;
 								serializedField->size = typeSize;
 
 								curField->arrayElemToBuffer(rttiInstance, object, arrIdx, serializedField->value);
@@ -500,9 +678,9 @@ namespace ls
 							else
 								typeSize = curField->getTypeSize();
 
-							const auto serializedField = ls_shared_ptr_new<SerializedField>();
-							serializedField->value = (UINT8*)ls_alloc(typeSize);
-							serializedField->ownsMemory = true;
+							const auto serializedField = newInstance<SerializedField>();
+							serializedField->value = mArena->alloc(typeSize);
+							serializedField->ownsMemory = false;
 							serializedField->size = typeSize;
 
 							curField->toBuffer(rttiInstance, object, serializedField->value);
@@ -518,12 +696,17 @@ namespace ls
 							UINT32 dataBlockSize = 0;
 							SPtr<DataStream> blockStream = curField->getValue(rttiInstance, object, dataBlockSize);
 
-							auto dataBlockBuffer = (UINT8*)ls_alloc(dataBlockSize);
-							blockStream->read(dataBlockBuffer, dataBlockSize);
+							// Reference the data directly if the stream allows it (e.g. memory mapped files)
+							SPtr<DataStream> stream = blockStream->readView(dataBlockSize);
+							if (stream == nullptr)
+							{
+								auto dataBlockBuffer = (UINT8*)ls_alloc(dataBlockSize);
+								blockStream->read(dataBlockBuffer, dataBlockSize);
 
-							SPtr<DataStream> stream = ls_shared_ptr_new<MemoryDataStream>(dataBlockBuffer, dataBlockSize);
+								stream = ls_shared_ptr_new<MemoryDataStream>(dataBlockBuffer, dataBlockSize);
+							}
 
-							SPtr<SerializedDataBlock> serializedDataBlock = ls_shared_ptr_new<SerializedDataBlock>();
+							SPtr<SerializedDataBlock> serializedDataBlock = newInstance<SerializedDataBlock>();
 							serializedDataBlock->stream = stream;
 							serializedDataBlock->offset = 0;
 
@@ -556,6 +739,110 @@ namespace ls
 		}
 	}
 
+	bool SerializedInstance::getHash(UINT64& hash) const
+	{
+		if (mHashState == HashState::Dirty)
+		{
+			mHashState = HashState::InProgress;
+
+			bool cyclic = false;
+			mHash = calculateHash(cyclic);
+			mHashState = cyclic ? HashState::Cyclic : HashState::Valid;
+		}
+		else if (mHashState == HashState::InProgress)
+			return false; // Reached through one of our own children
+
+		hash = mHash;
+		return mHashState == HashState::Valid;
+	}
+
+	UINT64 SerializedInstance::getChildHash(const SPtr<SerializedInstance>& child, bool& cyclic)
+	{
+		if (child == nullptr)
+			return detail::NULL_HASH;
+
+		UINT64 hash = 0;
+		if (!child->getHash(hash))
+			cyclic = true;
+
+		return hash;
+	}
+
+	void SerializedInstance::copyHash(const SerializedInstance& other)
+	{
+		// Hashes that are being calculated or are unusable would need to be calculated anew for the copy
+		if (other.mHashState != HashState::Valid)
+			return;
+
+		mHash = other.mHash;
+		mHashState = HashState::Valid;
+	}
+
+	UINT64 SerializedObject::calculateHash(bool& cyclic) const
+	{
+		UINT64 hash = detail::mixHash(TID_SerializedObject);
+		for (auto& subObject : subObjects)
+		{
+			UINT64 entriesHash = 0;
+			for (auto& entryPair : subObject.entries)
+			{
+				UINT64 childHash = getChildHash(entryPair.second.serialized, cyclic);
+				detail::combineKeyedHash(entriesHash, entryPair.first, childHash);
+			}
+
+			hash = detail::mixHash(hash ^ subObject.typeId);
+			hash = detail::mixHash(hash ^ entriesHash);
+		}
+
+		return hash;
+	}
+
+	UINT64 SerializedField::calculateHash(bool& cyclic) const
+	{
+		UINT64 hash = detail::mixHash(TID_SerializedField ^ ((UINT64)size << 32));
+		return detail::hashBytes(value, size, hash);
+	}
+
+	UINT64 SerializedDataBlock::calculateHash(bool& cyclic) const
+	{
+		UINT64 hash = detail::mixHash(TID_SerializedDataBlock ^ ((UINT64)size << 32));
+		if (size == 0)
+			return hash;
+
+		if (!stream->isFile())
+		{
+			SPtr<MemoryDataStream> memStream = std::static_pointer_cast<MemoryDataStream>(stream);
+			return detail::hashBytes(memStream->getPtr() + offset, size, hash);
+		}
+
+		UINT8 chunk[detail::HASH_CHUNK_SIZE];
+		stream->seek(offset);
+
+		for (UINT32 remaining = size; remaining > 0;)
+		{
+			UINT32 chunkSize = std::min(remaining, detail::HASH_CHUNK_SIZE);
+			stream->read(chunk, chunkSize);
+
+			hash = detail::hashBytes(chunk, chunkSize, hash);
+			remaining -= chunkSize;
+		}
+
+		return hash;
+	}
+
+	UINT64 SerializedArray::calculateHash(bool& cyclic) const
+	{
+		UINT64 entriesHash = 0;
+		for (auto& entryPair : entries)
+		{
+			UINT64 childHash = getChildHash(entryPair.second.serialized, cyclic);
+			detail::combineKeyedHash(entriesHash, entryPair.first, childHash);
+		}
+
+		UINT64 hash = detail::mixHash(TID_SerializedArray ^ ((UINT64)numElements << 32));
+		return detail::mixHash(hash ^ entriesHash);
+	}
+
 	SPtr<SerializedObject> SerializedObject::create(IReflectable& obj, bool shallow, SerializationContext* context)
 	{
 		detail::IntermediateSerializer is;
@@ -578,6 +865,7 @@ namespace ls
 		for (auto& subObject : subObjects)
 		{
 			copy->subObjects[i].typeId = subObject.typeId;
+			copy->subObjects[i].entries.reserve(subObject.entries.size());
 
 			for (auto& entryPair : subObject.entries)
 			{
@@ -592,6 +880,7 @@ namespace ls
 			i++;
 		}
 
+		copy->copyHash(*this);
 		return copy;
 	}
 
@@ -612,6 +901,7 @@ namespace ls
 			copy->ownsMemory = false;
 		}
 
+		copy->copyHash(*this);
 		return copy;
 	}
 
@@ -637,6 +927,7 @@ namespace ls
 			copy->offset = offset;
 		}
 
+		copy->copyHash(*this);
 		return copy;
 	}
 
@@ -644,6 +935,7 @@ namespace ls
 	{
 		SPtr<SerializedArray> copy = ls_shared_ptr_new<SerializedArray>();
 		copy->numElements = numElements;
+		copy->entries.reserve(entries.size());
 
 		for (auto& entryPair : entries)
 		{
@@ -653,6 +945,7 @@ namespace ls
 			copy->entries[entryPair.first] = entry;
 		}
 
+		copy->copyHash(*this);
 		return copy;
 	}
 
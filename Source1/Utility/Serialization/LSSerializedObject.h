@@ -26,6 +26,50 @@ namespace ls
 		 */
 		virtual SPtr<SerializedInstance> clone(bool cloneData = true) = 0;
 
+		/**
+		 * Returns a hash of the contents of this instance and all of its children. Instances with equal hashes have equal
+		 * contents, which allows unchanged hierarchies to be compared in constant time. The hash is calculated on first
+		 * request and cached, and parents build their hash from the cached hashes of their children.
+		 *
+		 * @param[out]	hash	Hash of the instance contents.
+		 * @return				False if the hash cannot be used for comparison because the instance references itself, 
+		 *						either directly or through its children.
+		 *
+		 * @note	Not thread safe. If the instance is modified after its hash was calculated, invalidateHash() must be
+		 *			called on it and on all instances referencing it.
+		 */
+		bool getHash(UINT64& hash) const;
+
+		/** Discards the cached hash, so it is re-calculated on the next call to getHash(). */
+		void invalidateHash() { mHashState = HashState::Dirty; }
+
+	protected:
+		/** 
+		 * Calculates the hash of the contents of this instance. Implementations should retrieve the hashes of their 
+		 * children through getChildHash().
+		 *
+		 * @param[out]	cyclic	Set to true if the instance references itself, making the hash unusable for comparison.
+		 */
+		virtual UINT64 calculateHash(bool& cyclic) const = 0;
+
+		/** Returns the hash of a child instance. @p cyclic is set to true if the child hash cannot be used. */
+		static UINT64 getChildHash(const SPtr<SerializedInstance>& child, bool& cyclic);
+
+		/** Copies the cached hash from another instance with the same contents. */
+		void copyHash(const SerializedInstance& other);
+
+	private:
+		enum class HashState : UINT8
+		{
+			Dirty,
+			InProgress,
+			Valid,
+			Cyclic
+		};
+
+		mutable UINT64 mHash = 0;
+		mutable HashState mHashState = HashState::Dirty;
+
 		/************************************************************************/
 		/* 								RTTI		                     		*/
 		/************************************************************************/
@@ -103,12 +147,20 @@ namespace ls
 		 *							maintaining state or sharing information between objects during 
 		 *							deserialization.
 		 * @return					Serialized version of @p obj.
+		 *
+		 * @note	All instances in the returned hierarchy, and the field data they contain, are allocated from a single
+		 *			memory region which is released once the last of them is destroyed. Holding on to any one instance
+		 *			therefore keeps the memory of the entire hierarchy alive. Clone the instance to avoid this.
 		 */
 		static SPtr<SerializedObject> create(IReflectable& obj, bool shallow = false, 
 			SerializationContext* context = nullptr);
 
 		Vector<SerializedSubObject> subObjects;
 
+	protected:
+		/** @copydoc SerializedInstance::calculateHash */
+		UINT64 calculateHash(bool& cyclic) const override;
+
 		/************************************************************************/
 		/* 								RTTI		                     		*/
 		/************************************************************************/
@@ -136,6 +188,10 @@ namespace ls
 		UINT32 size = 0;
 		bool ownsMemory = false;
 
+	protected:
+		/** @copydoc SerializedInstance::calculateHash */
+		UINT64 calculateHash(bool& cyclic) const override;
+
 		/************************************************************************/
 		/* 								RTTI		                     		*/
 		/************************************************************************/
@@ -157,6 +213,10 @@ namespace ls
 		UINT32 offset = 0;
 		UINT32 size = 0;
 
+	protected:
+		/** @copydoc SerializedInstance::calculateHash */
+		UINT64 calculateHash(bool& cyclic) const override;
+
 		/************************************************************************/
 		/* 								RTTI		                     		*/
 		/************************************************************************/
@@ -194,6 +254,10 @@ namespace ls
 		UnorderedMap<UINT32, SerializedArrayEntry> entries;
 		UINT32 numElements = 0;
 
+	protected:
+		/** @copydoc SerializedInstance::calculateHash */
+		UINT64 calculateHash(bool& cyclic) const override;
+
 		/************************************************************************/
 		/* 								RTTI		                     		*/
 		/************************************************************************/
@@ -8,6 +8,8 @@
 #include "Math/LSVector4.h"
 #include "Math/LSVector2I.h"
 #include "Error/LSException.h"
+#include "Math/LSSIMD.h"
+#include "General/LSBitwise.h"
 
 namespace ls 
 {
@@ -42,26 +44,130 @@ namespace ls
 			str.erase(0, str.find_first_not_of(delims)); // trim left
 	}
 
-	Vector<String> StringUtil::split(const String& str, const String& delims, unsigned int maxSplits)
+	Vector<String> StringUtil::split(StringView str, StringView delims, unsigned int maxSplits)
 	{
 		return splitInternal<char>(str, delims, maxSplits);
 	}
 
-	Vector<WString> StringUtil::split(const WString& str, const WString& delims, unsigned int maxSplits)
+	Vector<WString> StringUtil::split(WStringView str, WStringView delims, unsigned int maxSplits)
 	{
 		return splitInternal<wchar_t>(str, delims, maxSplits);
 	}
 
-	Vector<String> StringUtil::tokenise(const String& str, const String& singleDelims, const String& doubleDelims, unsigned int maxSplits)
+	Vector<String> StringUtil::tokenise(StringView str, StringView singleDelims, StringView doubleDelims, unsigned int maxSplits)
 	{
 		return tokeniseInternal<char>(str, singleDelims, doubleDelims, maxSplits);
 	}
 
-	Vector<WString> StringUtil::tokenise(const WString& str, const WString& singleDelims, const WString& doubleDelims, unsigned int maxSplits)
+	Vector<WString> StringUtil::tokenise(WStringView str, WStringView singleDelims, WStringView doubleDelims, unsigned int maxSplits)
 	{
 		return tokeniseInternal<wchar_t>(str, singleDelims, doubleDelims, maxSplits);
 	}
 
+	/** 
+	 * Maximum number of characters findFirstOf() will compare against using SIMD instructions. Larger sets of characters
+	 * are searched for using a lookup table.
+	 */
+	static constexpr size_t MAX_SIMD_SEARCH_CHARS = 8;
+
+	size_t StringUtil::findFirstOf(StringView str, StringView chars, size_t start)
+	{
+		if (start >= str.size() || chars.empty())
+			return StringView::npos;
+
+		const char* const data = str.data();
+		const size_t size = str.size();
+
+		if (chars.size() == 1)
+		{
+			const void* found = memchr(data + start, chars[0], size - start);
+			return found != nullptr ? (size_t)((const char*)found - data) : StringView::npos;
+		}
+
+		size_t i = start;
+		if (chars.size() <= MAX_SIMD_SEARCH_CHARS)
+		{
+			// Compare 16 characters at once against each of the searched for characters
+			simd::uint8<16> splatChars[MAX_SIMD_SEARCH_CHARS];
+			for (size_t j = 0; j < chars.size(); j++)
+				splatChars[j] = simd::splat((UINT8)chars[j]);
+
+			for (; i + 16 <= size; i += 16)
+			{
+				const simd::uint8<16> block = simd::load_u(data + i);
+
+				simd::mask_int8<16> matches = simd::cmp_eq(block, splatChars[0]);
+				for (size_t j = 1; j < chars.size(); j++)
+					matches = simd::bit_or(matches, simd::cmp_eq(block, splatChars[j]));
+
+				const UINT32 mask = simd::extract_bits_any(simd::uint8<16>(matches));
+				if (mask != 0)
+					return i + Bitwise::leastSignificantBit(mask);
+			}
+
+			// Remaining characters are searched for one by one below
+			for (; i < size; i++)
+			{
+				if (chars.find(data[i]) != StringView::npos)
+					return i;
+			}
+
+			return StringView::npos;
+		}
+
+		bool isSearched[256] = { };
+		for (char entry : chars)
+			isSearched[(UINT8)entry] = true;
+
+		for (; i < size; i++)
+		{
+			if (isSearched[(UINT8)data[i]])
+				return i;
+		}
+
+		return StringView::npos;
+	}
+
+	size_t StringUtil::findFirstOf(WStringView str, WStringView chars, size_t start)
+	{
+		return str.find_first_of(chars, start);
+	}
+
+	size_t StringUtil::findFirstNotOf(StringView str, StringView chars, size_t start)
+	{
+		if (start >= str.size())
+			return StringView::npos;
+
+		// Usually called to skip a few delimiters, in which case building a lookup table costs more than the search
+		if (chars.size() <= MAX_SIMD_SEARCH_CHARS)
+		{
+			for (size_t i = start; i < str.size(); i++)
+			{
+				if (chars.find(str[i]) == StringView::npos)
+					return i;
+			}
+
+			return StringView::npos;
+		}
+
+		bool isSearched[256] = { };
+		for (char entry : chars)
+			isSearched[(UINT8)entry] = true;
+
+		for (size_t i = start; i < str.size(); i++)
+		{
+			if (!isSearched[(UINT8)str[i]])
+				return i;
+		}
+
+		return StringView::npos;
+	}
+
+	size_t StringUtil::findFirstNotOf(WStringView str, WStringView chars, size_t start)
+	{
+		return str.find_first_not_of(chars, start);
+	}
+
 	void StringUtil::toLowerCase(String& str)
 	{
 		std::transform(str.begin(), str.end(), str.begin(), tolower);
@@ -82,42 +188,42 @@ namespace ls
 		std::transform(str.begin(), str.end(), str.begin(), toupper);
 	}
 
-	bool StringUtil::startsWith(const String& str, const String& pattern, bool lowerCase)
+	bool StringUtil::startsWith(StringView str, StringView pattern, bool lowerCase)
 	{
 		return startsWithInternal<char>(str, pattern, lowerCase);
 	}
 
-	bool StringUtil::startsWith(const WString& str, const WString& pattern, bool lowerCase)
+	bool StringUtil::startsWith(WStringView str, WStringView pattern, bool lowerCase)
 	{
 		return startsWithInternal<wchar_t>(str, pattern, lowerCase);
 	}
 
-	bool StringUtil::endsWith(const String& str, const String& pattern, bool lowerCase)
+	bool StringUtil::endsWith(StringView str, StringView pattern, bool lowerCase)
 	{
 		return endsWithInternal<char>(str, pattern, lowerCase);
 	}
 
-	bool StringUtil::endsWith(const WString& str, const WString& pattern, bool lowerCase)
+	bool StringUtil::endsWith(WStringView str, WStringView pattern, bool lowerCase)
 	{
 		return endsWithInternal<wchar_t>(str, pattern, lowerCase);
 	}
 
-	bool StringUtil::match(const String& str, const String& pattern, bool caseSensitive)
+	bool StringUtil::match(StringView str, StringView pattern, bool caseSensitive)
 	{
 		return matchInternal<char>(str, pattern, caseSensitive);
 	}
 
-	bool StringUtil::match(const WString& str, const WString& pattern, bool caseSensitive)
+	bool StringUtil::match(WStringView str, WStringView pattern, bool caseSensitive)
 	{
 		return matchInternal<wchar_t>(str, pattern, caseSensitive);
 	}
 
-	const String StringUtil::replaceAll(const String& source, const String& replaceWhat, const String& replaceWithWhat)
+	const String StringUtil::replaceAll(StringView source, StringView replaceWhat, StringView replaceWithWhat)
 	{
 		return replaceAllInternal<char>(source, replaceWhat, replaceWithWhat);
 	}
 
-	const WString StringUtil::replaceAll(const WString& source, const WString& replaceWhat, const WString& replaceWithWhat)
+	const WString StringUtil::replaceAll(WStringView source, WStringView replaceWhat, WStringView replaceWithWhat)
 	{
 		return replaceAllInternal<wchar_t>(source, replaceWhat, replaceWithWhat);
 	}
@@ -4,6 +4,7 @@
 #include "Math/LSRadian.h"
 
 #include <string>
+#include <string_view>
 
 namespace ls
 {
@@ -43,6 +44,16 @@ namespace ls
 	/** Wide string stream used for primarily for constructing UTF-32 strings. */
 	using U32StringStream = BasicStringStream<char32_t>;
 
+	/** Non-owning view of a sequence of characters, such as a part of a BasicString. */
+	template <typename T>
+	using BasicStringView = std::basic_string_view<T>;
+
+	/** View of a narrow string. */
+	using StringView = BasicStringView<char>;
+
+	/** View of a wide string. */
+	using WStringView = BasicStringView<wchar_t>;
+
 	/** Equivalent to String, except it avoids any dynamic allocations until the number of elements exceeds @p Count. */
 	template <int Count> 
 	using SmallString = std::basic_string <char, std::char_traits<char>, StdAlloc<char>>; // TODO: Currently equivalent to String, need to implement the allocator
@@ -58,7 +69,25 @@ namespace ls
 	 *  @{
 	 */
 
-	/** Utility class for manipulating Strings. */
+	template <class T> class BasicStringSplitRange;
+	template <class T> class BasicStringTokenRange;
+
+	/** Range over the substrings of a narrow string, see StringUtil::splitView(). */
+	using StringSplitRange = BasicStringSplitRange<char>;
+
+	/** Range over the substrings of a wide string, see StringUtil::splitView(). */
+	using WStringSplitRange = BasicStringSplitRange<wchar_t>;
+
+	/** Range over the tokens of a narrow string, see StringUtil::tokeniseView(). */
+	using StringTokenRange = BasicStringTokenRange<char>;
+
+	/** Range over the tokens of a wide string, see StringUtil::tokeniseView(). */
+	using WStringTokenRange = BasicStringTokenRange<wchar_t>;
+
+	/** 
+	 * Utility class for manipulating Strings. Methods that only read strings accept views, so they can be called on
+	 * Strings, character arrays and parts of other strings without allocating.
+	 */
 	class LS_UTILITY_EXPORT StringUtil
 	{
 	public:
@@ -83,10 +112,24 @@ namespace ls
 		 * @param[in]	maxSplits	(optional) The maximum number of splits to perform (0 for unlimited splits). If this
 		 *							parameters is > 0, the splitting process will stop after this many splits, left to right.
 		 */
-		static Vector<String> split(const String& str, const String& delims = "\t\n ", unsigned int maxSplits = 0);
+		static Vector<String> split(StringView str, StringView delims = "\t\n ", unsigned int maxSplits = 0);
 
-		/** @copydoc StringUtil::split(const String&, const String&, unsigned int) */
-		static Vector<WString> split(const WString& str, const WString& delims = L"\t\n ", unsigned int maxSplits = 0);
+		/** @copydoc StringUtil::split(StringView, StringView, unsigned int) */
+		static Vector<WString> split(WStringView str, WStringView delims = L"\t\n ", unsigned int maxSplits = 0);
+
+		/**
+		 * Returns a range over the same substrings split() returns, without allocating. Substrings are found as the 
+		 * range is iterated, and are returned as views into @p str, which must outlive the range.
+		 *
+		 * @code
+		 * for (StringView part : StringUtil::splitView(path, "/"))
+		 *     ...
+		 * @endcode
+		 */
+		static StringSplitRange splitView(StringView str, StringView delims = "\t\n ", unsigned int maxSplits = 0);
+
+		/** @copydoc StringUtil::splitView(StringView, StringView, unsigned int) */
+		static WStringSplitRange splitView(WStringView str, WStringView delims = L"\t\n ", unsigned int maxSplits = 0);
 
 		/**
 		 * Returns a vector of strings containing all the substrings delimited by the provided delimiter characters, or the 
@@ -101,12 +144,42 @@ namespace ls
 		 *								If this parameters is > 0, the splitting process will stop after this many splits, 
 		 *								left to right.
 		 */
-		static Vector<String> tokenise(const String& str, const String& delims = "\t\n ", 
-			const String& doubleDelims = "\"", unsigned int maxSplits = 0);
+		static Vector<String> tokenise(StringView str, StringView delims = "\t\n ", StringView doubleDelims = "\"", 
+			unsigned int maxSplits = 0);
+
+		/** @copydoc StringUtil::tokenise(StringView, StringView, StringView, unsigned int) */
+		static Vector<WString> tokenise(WStringView str, WStringView delims = L"\t\n ", 
+			WStringView doubleDelims = L"\"", unsigned int maxSplits = 0);
+
+		/** 
+		 * Returns a range over the same tokens tokenise() returns, without allocating. Tokens are found as the range is
+		 * iterated, and are returned as views into @p str, which must outlive the range.
+		 */
+		static StringTokenRange tokeniseView(StringView str, StringView delims = "\t\n ", 
+			StringView doubleDelims = "\"", unsigned int maxSplits = 0);
 
-		/** @copydoc StringUtil::tokenise(const String&, const String&, const String&, unsigned int) */
-		static Vector<WString> tokenise(const WString& str, const WString& delims = L"\t\n ", 
-			const WString& doubleDelims = L"\"", unsigned int maxSplits = 0);
+		/** @copydoc StringUtil::tokeniseView(StringView, StringView, StringView, unsigned int) */
+		static WStringTokenRange tokeniseView(WStringView str, WStringView delims = L"\t\n ", 
+			WStringView doubleDelims = L"\"", unsigned int maxSplits = 0);
+
+		/**
+		 * Returns the position of the first character in @p str, at or after @p start, that matches any of the 
+		 * characters in @p chars. Returns StringView::npos if there is no such character. Uses SIMD instructions when
+		 * searching for a small number of characters.
+		 */
+		static size_t findFirstOf(StringView str, StringView chars, size_t start = 0);
+
+		/** @copydoc StringUtil::findFirstOf(StringView, StringView, size_t) */
+		static size_t findFirstOf(WStringView str, WStringView chars, size_t start = 0);
+
+		/**
+		 * Returns the position of the first character in @p str, at or after @p start, that doesn't match any of the
+		 * characters in @p chars. Returns StringView::npos if there is no such character.
+		 */
+		static size_t findFirstNotOf(StringView str, StringView chars, size_t start = 0);
+
+		/** @copydoc StringUtil::findFirstNotOf(StringView, StringView, size_t) */
+		static size_t findFirstNotOf(WStringView str, WStringView chars, size_t start = 0);
 
 		/** Converts all the characters in the string to lower case. Does not handle UTF8 encoded strings. */
 		static void toLowerCase(String& str);
@@ -128,10 +201,10 @@ namespace ls
 		 * @param[in]	lowerCase	(optional) If true, the start of the string will be lower cased before comparison, and 
 		 *							the pattern should also be in lower case.
 		 */
-		static bool startsWith(const String& str, const String& pattern, bool lowerCase = true);
+		static bool startsWith(StringView str, StringView pattern, bool lowerCase = true);
 
-		/** @copydoc startsWith(const String&, const String&, bool) */
-		static bool startsWith(const WString& str, const WString& pattern, bool lowerCase = true);
+		/** @copydoc startsWith(StringView, StringView, bool) */
+		static bool startsWith(WStringView str, WStringView pattern, bool lowerCase = true);
 
 		/**
 		 * Returns whether the string end with the pattern passed in.
@@ -141,10 +214,10 @@ namespace ls
 		 * @param[in]	lowerCase	(optional) If true, the start of the string will be lower cased before comparison, and 
 		 *							the pattern should also be in lower case.
 		 */
-		static bool endsWith(const String& str, const String& pattern, bool lowerCase = true);
+		static bool endsWith(StringView str, StringView pattern, bool lowerCase = true);
 
-		/** @copydoc endsWith(const String&, const String&, bool) */
-		static bool endsWith(const WString& str, const WString& pattern, bool lowerCase = true);
+		/** @copydoc endsWith(StringView, StringView, bool) */
+		static bool endsWith(WStringView str, WStringView pattern, bool lowerCase = true);
 
 		/**
 		 * Returns true if the string matches the provided pattern. Pattern may use a "*" wildcard for matching any 
@@ -154,10 +227,10 @@ namespace ls
 		 * @param[in]	pattern		 	Patterns to look for.
 		 * @param[in]	caseSensitive	(optional) Should the match be case sensitive or not.
 		 */
-		static bool match(const String& str, const String& pattern, bool caseSensitive = true);
+		static bool match(StringView str, StringView pattern, bool caseSensitive = true);
 
-		/** @copydoc match(const String&, const String&, bool) */
-		static bool match(const WString& str, const WString& pattern, bool caseSensitive = true);
+		/** @copydoc match(StringView, StringView, bool) */
+		static bool match(WStringView str, WStringView pattern, bool caseSensitive = true);
 
 		/**
 		 * Replace all instances of a substring with a another substring.
@@ -168,10 +241,10 @@ namespace ls
 		 *
 		 * @return	An updated string with the substrings replaced.
 		 */
-		static const String replaceAll(const String& source, const String& replaceWhat, const String& replaceWithWhat);
+		static const String replaceAll(StringView source, StringView replaceWhat, StringView replaceWithWhat);
 
-		/** @copydoc replaceAll(const String&, const String&, const String&) */
-		static const WString replaceAll(const WString& source, const WString& replaceWhat, const WString& replaceWithWhat);
+		/** @copydoc replaceAll(StringView, StringView, StringView) */
+		static const WString replaceAll(WStringView source, WStringView replaceWhat, WStringView replaceWithWhat);
 
 		/**
 		 * Compares two strings. Returns 0 if the two compare equal, <0 if the value of the left string is lower than of 
@@ -182,20 +255,15 @@ namespace ls
 		 * @param[in]	caseSensitive	If true the comparison will consider uppercase and lowercase characters different.
 		 *								Note that case conversion does not handle UTF8 strings.
 		 */
-		template <class T>
-		static int compare(const BasicString<T>& lhs, const BasicString<T>& rhs, bool caseSensitive = true)
+		static int compare(StringView lhs, StringView rhs, bool caseSensitive = true)
 		{
-			if (caseSensitive)
-				return (int)lhs.compare(rhs);
-
-			int size = (int)std::min(lhs.size(), rhs.size());
-			for (int i = 0; i < size; i++)
-			{
-				if (toupper(lhs[i]) < toupper(rhs[i])) return -1;
-				if (toupper(lhs[i]) > toupper(rhs[i])) return 1;
-			}
+			return compareInternal<char>(lhs, rhs, caseSensitive);
+		}
 
-			return (lhs.size() < rhs.size() ? -1 : (lhs.size() == rhs.size() ? 0 : 1));
+		/** @copydoc compare(StringView, StringView, bool) */
+		static int compare(WStringView lhs, WStringView rhs, bool caseSensitive = true)
+		{
+			return compareInternal<wchar_t>(lhs, rhs, caseSensitive);
 		}
 
 		/** @copydoc StringFormat::format */
@@ -220,189 +288,120 @@ namespace ls
 
 	private:
 		template <class T>
-		static Vector<BasicString<T>> splitInternal(const BasicString<T>& str, const BasicString<T>& delims, unsigned int maxSplits)
+		static Vector<BasicString<T>> splitInternal(BasicStringView<T> str, BasicStringView<T> delims, unsigned int maxSplits)
 		{
 			Vector<BasicString<T>> ret;
 			// Pre-allocate some space for performance
 			ret.reserve(maxSplits ? maxSplits+1 : 10);    // 10 is guessed capacity for most case
 
-			unsigned int numSplits = 0;
-
-			// Use STL methods 
-			size_t start, pos;
-			start = 0;
-			do 
-			{
-				pos = str.find_first_of(delims, start);
-				if (pos == start)
-				{
-					// Do nothing
-					start = pos + 1;
-				}
-				else if (pos == BasicString<T>::npos || (maxSplits && numSplits == maxSplits))
-				{
-					// Copy the rest of the string
-					ret.push_back(str.substr(start));
-					break;
-				}
-				else
-				{
-					// Copy up to delimiter
-					ret.push_back(str.substr(start, pos - start));
-					start = pos + 1;
-				}
-				// parse up to next real data
-				start = str.find_first_not_of(delims, start);
-				++numSplits;
-
-			} while (pos != BasicString<T>::npos);
+			for (auto& entry : BasicStringSplitRange<T>(str, delims, maxSplits))
+				ret.emplace_back(entry);
 
 			return ret;
 		}
 
 		template <class T>
-		static Vector<BasicString<T>> tokeniseInternal(const BasicString<T>& str, const BasicString<T>& singleDelims, 
-			const BasicString<T>& doubleDelims, unsigned int maxSplits)
+		static Vector<BasicString<T>> tokeniseInternal(BasicStringView<T> str, BasicStringView<T> singleDelims, 
+			BasicStringView<T> doubleDelims, unsigned int maxSplits)
 		{
 			Vector<BasicString<T>> ret;
 			// Pre-allocate some space for performance
 			ret.reserve(maxSplits ? maxSplits + 1 : 10);    // 10 is guessed capacity for most case
 
-			unsigned int numSplits = 0;
-			BasicString<T> delims = singleDelims + doubleDelims;
-
-			// Use STL methods 
-			size_t start, pos;
-			T curDoubleDelim = 0;
-			start = 0;
-			do 
-			{
-				if (curDoubleDelim != 0)
-				{
-					pos = str.find(curDoubleDelim, start);
-				}
-				else
-				{
-					pos = str.find_first_of(delims, start);
-				}
-
-				if (pos == start)
-				{
-					T curDelim = str.at(pos);
-					if (doubleDelims.find_first_of(curDelim) != BasicString<T>::npos)
-					{
-						curDoubleDelim = curDelim;
-					}
-					// Do nothing
-					start = pos + 1;
-				}
-				else if (pos == BasicString<T>::npos || (maxSplits && numSplits == maxSplits))
-				{
-					if (curDoubleDelim != 0)
-					{
-						//Missing closer. Warn or throw exception?
-					}
-					// Copy the rest of the string
-					ret.push_back( str.substr(start) );
-					break;
-				}
-				else
-				{
-					if (curDoubleDelim != 0)
-					{
-						curDoubleDelim = 0;
-					}
-
-					// Copy up to delimiter
-					ret.push_back( str.substr(start, pos - start) );
-					start = pos + 1;
-				}
-				if (curDoubleDelim == 0)
-				{
-					// parse up to next real data
-					start = str.find_first_not_of(singleDelims, start);
-				}
-
-				++numSplits;
-
-			} while (pos != BasicString<T>::npos);
+			for (auto& entry : BasicStringTokenRange<T>(str, singleDelims, doubleDelims, maxSplits))
+				ret.emplace_back(entry);
 
 			return ret;
 		}
 
 		template <class T>
-		static bool startsWithInternal(const BasicString<T>& str, const BasicString<T>& pattern, bool lowerCase)
+		static bool startsWithInternal(BasicStringView<T> str, BasicStringView<T> pattern, bool lowerCase)
 		{
 			size_t thisLen = str.length();
 			size_t patternLen = pattern.length();
 			if (thisLen < patternLen || patternLen == 0)
 				return false;
 
-			BasicString<T> startOfThis = str.substr(0, patternLen);
-			if (lowerCase)
-				StringUtil::toLowerCase(startOfThis);
-
-			return (startOfThis == pattern);
+			return equalsInternal(str.substr(0, patternLen), pattern, lowerCase);
 		}
 
 		template <class T>
-		static bool endsWithInternal(const BasicString<T>& str, const BasicString<T>& pattern, bool lowerCase)
+		static bool endsWithInternal(BasicStringView<T> str, BasicStringView<T> pattern, bool lowerCase)
 		{
 			size_t thisLen = str.length();
 			size_t patternLen = pattern.length();
 			if (thisLen < patternLen || patternLen == 0)
 				return false;
 
-			BasicString<T> endOfThis = str.substr(thisLen - patternLen, patternLen);
-			if (lowerCase)
-				StringUtil::toLowerCase(endOfThis);
-
-			return (endOfThis == pattern);
+			return equalsInternal(str.substr(thisLen - patternLen, patternLen), pattern, lowerCase);
 		}
 
+		/** 
+		 * Checks if two strings of the same length are equal. If @p lowerCase is true characters of @p str are lower
+		 * cased before being compared.
+		 */
 		template <class T>
-		static bool matchInternal(const BasicString<T>& str, const BasicString<T>& pattern, bool caseSensitive)
+		static bool equalsInternal(BasicStringView<T> str, BasicStringView<T> pattern, bool lowerCase)
 		{
-			BasicString<T> tmpStr = str;
-			BasicString<T> tmpPattern = pattern;
-			if (!caseSensitive)
+			if (!lowerCase)
+				return str == pattern;
+
+			for (size_t i = 0; i < str.length(); i++)
 			{
-				StringUtil::toLowerCase(tmpStr);
-				StringUtil::toLowerCase(tmpPattern);
+				if ((T)tolower(str[i]) != pattern[i])
+					return false;
 			}
 
-			typename BasicString<T>::const_iterator strIt = tmpStr.begin();
-			typename BasicString<T>::const_iterator patIt = tmpPattern.begin();
-			typename BasicString<T>::const_iterator lastWildCardIt = tmpPattern.end();
-			while (strIt != tmpStr.end() && patIt != tmpPattern.end())
+			return true;
+		}
+
+		template <class T>
+		static bool matchInternal(BasicStringView<T> str, BasicStringView<T> pattern, bool caseSensitive)
+		{
+			// Characters are lower cased as they're compared, instead of lower casing copies of both strings
+			if (caseSensitive)
+				return matchInternal(str, pattern, [](T value) { return value; });
+			else
+				return matchInternal(str, pattern, [](T value) { return (T)tolower(value); });
+		}
+
+		/** Matches @p str against @p pattern, after transforming the characters of both using @p getChar. */
+		template <class T, class GetChar>
+		static bool matchInternal(BasicStringView<T> str, BasicStringView<T> pattern, GetChar getChar)
+		{
+			size_t strIdx = 0;
+			size_t patIdx = 0;
+			size_t lastWildCardIdx = pattern.length();
+			while (strIdx != str.length() && patIdx != pattern.length())
 			{
-				if (*patIt == '*')
+				if (pattern[patIdx] == '*')
 				{
-					lastWildCardIt = patIt;
+					lastWildCardIdx = patIdx;
 					// Skip over looking for next character
-					++patIt;
-					if (patIt == tmpPattern.end())
+					++patIdx;
+					if (patIdx == pattern.length())
 					{
 						// Skip right to the end since * matches the entire rest of the string
-						strIt = tmpStr.end();
+						strIdx = str.length();
 					}
 					else
 					{
 						// scan until we find next pattern character
-						while(strIt != tmpStr.end() && *strIt != *patIt)
-							++strIt;
+						const T patChar = getChar(pattern[patIdx]);
+						while(strIdx != str.length() && getChar(str[strIdx]) != patChar)
+							++strIdx;
 					}
 				}
 				else
 				{
-					if (*patIt != *strIt)
+					if (getChar(pattern[patIdx]) != getChar(str[strIdx]))
 					{
-						if (lastWildCardIt != tmpPattern.end())
+						if (lastWildCardIdx != pattern.length())
 						{
 							// The last wildcard can match this incorrect sequence
 							// rewind pattern to wildcard and keep searching
-							patIt = lastWildCardIt;
-							lastWildCardIt = tmpPattern.end();
+							patIdx = lastWildCardIdx;
+							lastWildCardIdx = pattern.length();
 						}
 						else
 						{
@@ -412,37 +411,359 @@ namespace ls
 					}
 					else
 					{
-						++patIt;
-						++strIt;
+						++patIdx;
+						++strIdx;
 					}
 				}
 
 			}
 
 			// If we reached the end of both the pattern and the string, we succeeded
-			if (patIt == tmpPattern.end() && strIt == tmpStr.end())
+			if (patIdx == pattern.length() && strIdx == str.length())
 				return true;
 			else
 				return false;
 		}
 
 		template <class T>
-		static BasicString<T> replaceAllInternal(const BasicString<T>& source, 
-			const BasicString<T>& replaceWhat, const BasicString<T>& replaceWithWhat)
+		static BasicString<T> replaceAllInternal(BasicStringView<T> source, 
+			BasicStringView<T> replaceWhat, BasicStringView<T> replaceWithWhat)
 		{
-			BasicString<T> result = source;
-			typename BasicString<T>::size_type pos = 0;
+			if (replaceWhat.empty())
+				return BasicString<T>(source);
+
+			// Build the result in a single pass, rather than replacing in place and moving the rest of the string
+			BasicString<T> result;
+			result.reserve(source.size());
+
+			size_t start = 0;
 			while(1)
 			{
-				pos = result.find(replaceWhat,pos);
-				if (pos == BasicString<T>::npos) break;
-				result.replace(pos,replaceWhat.size(), replaceWithWhat);
-				pos += replaceWithWhat.size();
+				size_t pos = source.find(replaceWhat, start);
+				if (pos == BasicStringView<T>::npos) break;
+
+				result.append(source.data() + start, pos - start);
+				result.append(replaceWithWhat.data(), replaceWithWhat.size());
+				start = pos + replaceWhat.size();
 			}
+
+			result.append(source.data() + start, source.size() - start);
 			return result;
 		}
+
+		template <class T>
+		static int compareInternal(BasicStringView<T> lhs, BasicStringView<T> rhs, bool caseSensitive)
+		{
+			if (caseSensitive)
+				return (int)lhs.compare(rhs);
+
+			int size = (int)std::min(lhs.size(), rhs.size());
+			for (int i = 0; i < size; i++)
+			{
+				if (toupper(lhs[i]) < toupper(rhs[i])) return -1;
+				if (toupper(lhs[i]) > toupper(rhs[i])) return 1;
+			}
+
+			return (lhs.size() < rhs.size() ? -1 : (lhs.size() == rhs.size() ? 0 : 1));
+		}
+	};
+
+	/**
+	 * Range over the substrings of a string delimited by a set of delimiter characters, as returned by 
+	 * StringUtil::splitView(). Yields the same substrings as StringUtil::split(), as views into the original string.
+	 */
+	template <class T>
+	class BasicStringSplitRange
+	{
+	public:
+		/** Iterator over the substrings. Finds the next substring when incremented. */
+		class Iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = BasicStringView<T>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const value_type*;
+			using reference = const value_type&;
+
+			Iterator() = default;
+
+			Iterator(const BasicStringSplitRange* range)
+				:mRange(range)
+			{
+				++(*this);
+			}
+
+			reference operator*() const { return mValue; }
+			pointer operator->() const { return &mValue; }
+
+			Iterator& operator++()
+			{
+				if (!mRange->next(mStart, mNumSplits, mFinished, mValue))
+					mRange = nullptr;
+
+				return *this;
+			}
+
+			Iterator operator++(int)
+			{
+				Iterator copy = *this;
+				++(*this);
+
+				return copy;
+			}
+
+			bool operator==(const Iterator& rhs) const
+			{
+				return mRange == rhs.mRange && (mRange == nullptr || mValue.data() == rhs.mValue.data());
+			}
+
+			bool operator!=(const Iterator& rhs) const { return !(*this == rhs); }
+
+		private:
+			const BasicStringSplitRange* mRange = nullptr;
+			size_t mStart = 0;
+			unsigned int mNumSplits = 0;
+			bool mFinished = false;
+			value_type mValue;
+		};
+
+		/** @copydoc StringUtil::splitView(StringView, StringView, unsigned int) */
+		BasicStringSplitRange(BasicStringView<T> str, BasicStringView<T> delims, unsigned int maxSplits = 0)
+			:mStr(str), mDelims(delims), mMaxSplits(maxSplits)
+		{ }
+
+		Iterator begin() const { return Iterator(this); }
+		Iterator end() const { return Iterator(); }
+
+	private:
+		/** Finds the substring following the provided search state. Returns false if there are no more substrings. */
+		bool next(size_t& start, unsigned int& numSplits, bool& finished, BasicStringView<T>& output) const
+		{
+			constexpr size_t npos = BasicStringView<T>::npos;
+
+			while (!finished)
+			{
+				const size_t pos = StringUtil::findFirstOf(mStr, mDelims, start);
+
+				bool found = false;
+				if (pos == start)
+				{
+					// Do nothing
+					start = pos + 1;
+				}
+				else if (pos == npos || (mMaxSplits && numSplits == mMaxSplits))
+				{
+					// Copy the rest of the string
+					output = mStr.substr(start);
+					finished = true;
+
+					return true;
+				}
+				else
+				{
+					// Copy up to delimiter
+					output = mStr.substr(start, pos - start);
+					start = pos + 1;
+					found = true;
+				}
+
+				// parse up to next real data
+				start = StringUtil::findFirstNotOf(mStr, mDelims, start);
+				++numSplits;
+
+				if (pos == npos)
+					finished = true;
+
+				if (found)
+					return true;
+			}
+
+			return false;
+		}
+
+		BasicStringView<T> mStr;
+		BasicStringView<T> mDelims;
+		unsigned int mMaxSplits;
+	};
+
+	/**
+	 * Range over the tokens of a string delimited by a set of delimiter characters, as returned by 
+	 * StringUtil::tokeniseView(). Yields the same tokens as StringUtil::tokenise(), as views into the original string.
+	 */
+	template <class T>
+	class BasicStringTokenRange
+	{
+	public:
+		/** Iterator over the tokens. Finds the next token when incremented. */
+		class Iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = BasicStringView<T>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const value_type*;
+			using reference = const value_type&;
+
+			Iterator() = default;
+
+			Iterator(const BasicStringTokenRange* range)
+				:mRange(range)
+			{
+				++(*this);
+			}
+
+			reference operator*() const { return mValue; }
+			pointer operator->() const { return &mValue; }
+
+			Iterator& operator++()
+			{
+				if (!mRange->next(mStart, mNumSplits, mCurDoubleDelim, mFinished, mValue))
+					mRange = nullptr;
+
+				return *this;
+			}
+
+			Iterator operator++(int)
+			{
+				Iterator copy = *this;
+				++(*this);
+
+				return copy;
+			}
+
+			bool operator==(const Iterator& rhs) const
+			{
+				return mRange == rhs.mRange && (mRange == nullptr || mValue.data() == rhs.mValue.data());
+			}
+
+			bool operator!=(const Iterator& rhs) const { return !(*this == rhs); }
+
+		private:
+			const BasicStringTokenRange* mRange = nullptr;
+			size_t mStart = 0;
+			unsigned int mNumSplits = 0;
+			T mCurDoubleDelim = 0;
+			bool mFinished = false;
+			value_type mValue;
+		};
+
+		/** @copydoc StringUtil::tokeniseView(StringView, StringView, StringView, unsigned int) */
+		BasicStringTokenRange(BasicStringView<T> str, BasicStringView<T> singleDelims, BasicStringView<T> doubleDelims,
+			unsigned int maxSplits = 0)
+			:mStr(str), mSingleDelims(singleDelims), mDoubleDelims(doubleDelims), mMaxSplits(maxSplits)
+		{ }
+
+		Iterator begin() const { return Iterator(this); }
+		Iterator end() const { return Iterator(); }
+
+	private:
+		/** Finds the token following the provided search state. Returns false if there are no more tokens. */
+		bool next(size_t& start, unsigned int& numSplits, T& curDoubleDelim, bool& finished, 
+			BasicStringView<T>& output) const
+		{
+			constexpr size_t npos = BasicStringView<T>::npos;
+
+			while (!finished)
+			{
+				// Ran out of characters after skipping delimiters
+				if (start == npos)
+				{
+					finished = true;
+					break;
+				}
+
+				size_t pos;
+				if (curDoubleDelim != 0)
+					pos = mStr.find(curDoubleDelim, start);
+				else
+				{
+					pos = std::min(StringUtil::findFirstOf(mStr, mSingleDelims, start), 
+						StringUtil::findFirstOf(mStr, mDoubleDelims, start));
+				}
+
+				bool found = false;
+				if (pos == start)
+				{
+					T curDelim = mStr[pos];
+					if (mDoubleDelims.find(curDelim) != npos)
+					{
+						curDoubleDelim = curDelim;
+					}
+					// Do nothing
+					start = pos + 1;
+				}
+				else if (pos == npos || (mMaxSplits && numSplits == mMaxSplits))
+				{
+					if (curDoubleDelim != 0)
+					{
+						//Missing closer. Warn or throw exception?
+					}
+					// Copy the rest of the string
+					output = mStr.substr(start);
+					finished = true;
+
+					return true;
+				}
+				else
+				{
+					if (curDoubleDelim != 0)
+					{
+						curDoubleDelim = 0;
+					}
+
+					// Copy up to delimiter
+					output = mStr.substr(start, pos - start);
+					start = pos + 1;
+					found = true;
+				}
+
+				if (curDoubleDelim == 0)
+				{
+					// parse up to next real data
+					start = StringUtil::findFirstNotOf(mStr, mSingleDelims, start);
+				}
+
+				++numSplits;
+
+				if (pos == npos)
+					finished = true;
+
+				if (found)
+					return true;
+			}
+
+			return false;
+		}
+
+		BasicStringView<T> mStr;
+		BasicStringView<T> mSingleDelims;
+		BasicStringView<T> mDoubleDelims;
+		unsigned int mMaxSplits;
 	};
 
+	inline StringSplitRange StringUtil::splitView(StringView str, StringView delims, unsigned int maxSplits)
+	{
+		return StringSplitRange(str, delims, maxSplits);
+	}
+
+	inline WStringSplitRange StringUtil::splitView(WStringView str, WStringView delims, unsigned int maxSplits)
+	{
+		return WStringSplitRange(str, delims, maxSplits);
+	}
+
+	inline StringTokenRange StringUtil::tokeniseView(StringView str, StringView delims, StringView doubleDelims, 
+		unsigned int maxSplits)
+	{
+		return StringTokenRange(str, delims, doubleDelims, maxSplits);
+	}
+
+	inline WStringTokenRange StringUtil::tokeniseView(WStringView str, WStringView delims, WStringView doubleDelims, 
+		unsigned int maxSplits)
+	{
+		return WStringTokenRange(str, delims, doubleDelims, maxSplits);
+	}
+
 	/** Converts a narrow string to a wide string. */
 	LS_UTILITY_EXPORT WString toWString(const String& source);
 
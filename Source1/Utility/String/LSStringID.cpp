@@ -1,139 +1,258 @@
 #include "String/LSStringID.h"
+#include <thread>
 
 namespace ls
 {
-	const StringID StringID::NONE;
+	/** Open addressing hash table of interned strings, using linear probing. */
+	struct StringID::Table
+	{
+		UINT32 size;
+		std::atomic<UINT32> count;
 
-	volatile StringID::InitStatics StringID::mInitStatics = StringID::InitStatics();
+		/** Table this table's entries are being moved to, or null if the table isn't full yet. */
+		std::atomic<Table*> next;
 
-	StringID::InternalData* StringID::mStringHashTable[HASH_TABLE_SIZE];
-	StringID::InternalData* StringID::mChunks[MAX_CHUNK_COUNT];
+		/** True once all entries were moved to the next table, and it can be inserted into. */
+		std::atomic<bool> migrated;
 
-	UINT32 StringID::mNextId = 0;
-	UINT32 StringID::mNumChunks = 0;
-	SpinLock StringID::mSync;
+		/** Returns the array of @p size slots following the table header. */
+		std::atomic<InternalData*>* slots() { return (std::atomic<InternalData*>*)(this + 1); }
+	};
 
-	StringID::InitStatics::InitStatics()
+	/** Block of memory entries are allocated from. The entry data follows the structure. */
+	struct StringID::Chunk
 	{
-		ScopedSpinLock lock(mSync);
+		UINT32 size;
+		std::atomic<UINT32> used;
+
+		/** Returns the start of the memory entries are allocated from. */
+		UINT8* data() { return (UINT8*)(this + 1); }
+	};
+
+	const StringID StringID::NONE;
 
-		memset(mStringHashTable, 0, sizeof(mStringHashTable));
-		memset(mChunks, 0, sizeof(mChunks));
+	std::atomic<StringID::Table*> StringID::mTable{nullptr};
+	std::atomic<StringID::Chunk*> StringID::mChunk{nullptr};
+	std::atomic<UINT32> StringID::mNextId{0};
 
-		mChunks[0] = (InternalData*)ls_alloc(sizeof(InternalData) * ELEMENTS_PER_CHUNK);
-		memset(mChunks[0], 0, sizeof(InternalData) * ELEMENTS_PER_CHUNK);
+	// Placed in empty slots of tables being moved to a larger table, so no new entries are added to them
+	StringID::InternalData StringID::mMovedMarker;
 
-		mNumChunks++;
+	void StringID::construct(const char* name, UINT32 length, UINT64 hash)
+	{
+		Table* table = getTable();
+
+		mData = find(table, name, length, hash);
+		if (mData == nullptr)
+			mData = insert(table, name, length, hash);
 	}
 
-	template<class T>
-	void StringID::construct(T const& name)
+	StringID::Table* StringID::getTable()
 	{
-		assert(StringIDUtil<T>::size(name) <= STRING_SIZE);
+		Table* table = mTable.load(std::memory_order_acquire);
+		if (table != nullptr)
+			return table;
+
+		Table* newTable = createTable(INITIAL_TABLE_SIZE);
+		if (mTable.compare_exchange_strong(table, newTable, std::memory_order_acq_rel, std::memory_order_acquire))
+			return newTable;
+
+		// Another thread created the table first
+		ls_free(newTable);
+		return table;
+	}
 
-		UINT32 hash = calcHash(name) & (sizeof(mStringHashTable) / sizeof(mStringHashTable[0]) - 1);
-		InternalData* existingEntry = mStringHashTable[hash];
-		
-		while (existingEntry != nullptr)
+	StringID::InternalData* StringID::find(Table* table, const char* name, UINT32 length, UINT64 hash)
+	{
+		for (; table != nullptr; table = table->next.load(std::memory_order_acquire))
 		{
-			if (StringIDUtil<T>::compare(name, existingEntry->chars))
+			std::atomic<InternalData*>* slots = table->slots();
+			const UINT32 mask = table->size - 1;
+
+			UINT32 idx = (UINT32)hash & mask;
+			for (UINT32 i = 0; i < table->size; i++)
 			{
-				mData = existingEntry;
-				return;
-			}
+				InternalData* entry = slots[idx].load(std::memory_order_acquire);
 
-			existingEntry = existingEntry->next;
+				// Entries are never removed, so the entry can't be further along
+				if (entry == nullptr || entry == &mMovedMarker)
+					break;
+
+				if (entry->hash == hash && entry->length == length && memcmp(entry->chars(), name, length) == 0)
+					return entry;
+
+				idx = (idx + 1) & mask;
+			}
 		}
 
-		ScopedSpinLock lock(mSync);
+		return nullptr;
+	}
 
-		// Search for the value again in case other thread just added it
-		existingEntry = mStringHashTable[hash];
-		InternalData* lastEntry = nullptr;
-		while (existingEntry != nullptr)
+	StringID::InternalData* StringID::insert(Table* table, const char* name, UINT32 length, UINT64 hash)
+	{
+		InternalData* newEntry = nullptr;
+		while (true)
 		{
-			if (StringIDUtil<T>::compare(name, existingEntry->chars))
+			// Insert into the newest table, once it contains all the entries of the previous ones
+			for (Table* next = table->next.load(std::memory_order_acquire); next != nullptr;
+				next = table->next.load(std::memory_order_acquire))
 			{
-				mData = existingEntry;
-				return;
+				while (!table->migrated.load(std::memory_order_acquire))
+					std::this_thread::yield();
+
+				table = next;
 			}
 
-			lastEntry = existingEntry;
-			existingEntry = existingEntry->next;
-		}
+			std::atomic<InternalData*>* slots = table->slots();
+			const UINT32 mask = table->size - 1;
 
-		mData = allocEntry();
-		StringIDUtil<T>::copy(name, mData->chars);
+			UINT32 idx = (UINT32)hash & mask;
+			for (UINT32 i = 0; i < table->size; i++)
+			{
+				InternalData* entry = slots[idx].load(std::memory_order_acquire);
+				if (entry == nullptr)
+				{
+					if (newEntry == nullptr)
+						newEntry = allocEntry(name, length, hash);
 
-		if (lastEntry == nullptr)
-			mStringHashTable[hash] = mData;
-		else
-			lastEntry->next = mData;
-	}
+					if (slots[idx].compare_exchange_strong(entry, newEntry, std::memory_order_acq_rel,
+						std::memory_order_acquire))
+					{
+						const UINT32 count = table->count.fetch_add(1, std::memory_order_relaxed) + 1;
+						if (count > (table->size / 4) * 3)
+							grow(table);
 
-	template<class T>
-	UINT32 StringID::calcHash(T const& input)
-	{
-		UINT32 size = StringIDUtil<T>::size(input);
+						return newEntry;
+					}
 
-		UINT32 hash = 0;
-		for (UINT32 i = 0; i < size; i++)
-			hash = hash * 101 + input[i];
+					// Another thread filled the slot first, check if it added the same string
+				}
 
-		return hash;
+				if (entry == &mMovedMarker)
+					break;
+
+				if (entry->hash == hash && entry->length == length && memcmp(entry->chars(), name, length) == 0)
+				{
+					// The memory of the unused entry remains allocated, along with its ID
+					return entry;
+				}
+
+				idx = (idx + 1) & mask;
+			}
+
+			// Table is being moved, or is full (in which case it's moved now)
+			grow(table);
+		}
 	}
 
-	StringID::InternalData* StringID::allocEntry()
+	void StringID::grow(Table* table)
 	{
-		UINT32 chunkIdx = mNextId / ELEMENTS_PER_CHUNK;
+		if (table->next.load(std::memory_order_acquire) != nullptr)
+			return;
 
-		assert(chunkIdx < MAX_CHUNK_COUNT);
-		assert(chunkIdx <= mNumChunks); // Can only increment sequentially
+		Table* newTable = createTable(table->size * 2);
 
-		if (chunkIdx >= mNumChunks)
+		Table* expected = nullptr;
+		if (!table->next.compare_exchange_strong(expected, newTable, std::memory_order_acq_rel, std::memory_order_acquire))
 		{
-			mChunks[chunkIdx] = (InternalData*)ls_alloc(sizeof(InternalData) * ELEMENTS_PER_CHUNK);
-			memset(mChunks[chunkIdx], 0, sizeof(InternalData) * ELEMENTS_PER_CHUNK);
-
-			mNumChunks++;
+			// Another thread is already moving the table
+			ls_free(newTable);
+			return;
 		}
 
-		InternalData* chunk = mChunks[chunkIdx];
-		UINT32 chunkSpecificIndex = mNextId % ELEMENTS_PER_CHUNK;
+		// Lookups keep reading the old table while its entries are moved, and continue in the new table after
+		std::atomic<InternalData*>* slots = table->slots();
+		std::atomic<InternalData*>* newSlots = newTable->slots();
+		const UINT32 newMask = newTable->size - 1;
+
+		for (UINT32 i = 0; i < table->size; i++)
+		{
+			InternalData* entry = nullptr;
+			if (slots[i].compare_exchange_strong(entry, &mMovedMarker, std::memory_order_acq_rel,
+				std::memory_order_acquire))
+			{
+				continue;
+			}
 
-		InternalData* newEntry = &chunk[chunkSpecificIndex];
-		newEntry->id = mNextId++;
-		newEntry->next = nullptr;
+			// No other thread can insert into the new table until it's migrated, and each entry is unique. The entry is 
+			// released, so lookups that only find it in the new table also see its contents.
+			UINT32 idx = (UINT32)entry->hash & newMask;
+			while (newSlots[idx].load(std::memory_order_relaxed) != nullptr)
+				idx = (idx + 1) & newMask;
 
-		return newEntry;
+			newSlots[idx].store(entry, std::memory_order_release);
+			newTable->count.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		table->migrated.store(true, std::memory_order_release);
+
+		// Start new lookups from the new table. The old table stays allocated, as other threads might still be reading it.
+		mTable.compare_exchange_strong(table, newTable, std::memory_order_acq_rel, std::memory_order_relaxed);
 	}
 
-	template<>
-	class StringID::StringIDUtil<const char*>
+	StringID::Table* StringID::createTable(UINT32 size)
 	{
-	public:
-		static UINT32 size(const char* const& input) { return (UINT32)strlen(input); }
-		static void copy(const char* const& input, char* dest) { memcpy(dest, input, strlen(input) + 1); }
-		static bool compare(const char* const& a, char* b) { return strcmp(a, b) == 0; }
-	};
+		Table* table = (Table*)ls_alloc(sizeof(Table) + sizeof(std::atomic<InternalData*>) * size);
+		table->size = size;
+		new (&table->count) std::atomic<UINT32>(0);
+		new (&table->next) std::atomic<Table*>(nullptr);
+		new (&table->migrated) std::atomic<bool>(false);
+
+		std::atomic<InternalData*>* slots = table->slots();
+		for (UINT32 i = 0; i < size; i++)
+			new (&slots[i]) std::atomic<InternalData*>(nullptr);
+
+		return table;
+	}
 
-	template<>
-	class StringID::StringIDUtil <String>
+	StringID::InternalData* StringID::allocEntry(const char* name, UINT32 length, UINT64 hash)
 	{
-	public:
-		static UINT32 size(String const& input) { return (UINT32)input.length(); }
-		static void copy(String const& input, char* dest)
-		{ 
-			UINT32 len = (UINT32)input.length();
-			input.copy(dest, len);
-			dest[len] = '\0';
+		const UINT32 size = (sizeof(InternalData) + length + 1 + 7) & ~7U;
+
+		InternalData* entry;
+		if (size > CHUNK_SIZE / 4)
+		{
+			// Long strings get their own allocation, so they don't waste the rest of a chunk
+			entry = (InternalData*)ls_alloc(size);
 		}
-		static bool compare(String const& a, char* b) { return a.compare(b) == 0; }
-	};
+		else
+		{
+			Chunk* chunk = mChunk.load(std::memory_order_acquire);
+			while (true)
+			{
+				if (chunk != nullptr)
+				{
+					const UINT32 offset = chunk->used.fetch_add(size, std::memory_order_relaxed);
+					if ((offset + size) <= chunk->size)
+					{
+						entry = (InternalData*)(chunk->data() + offset);
+						break;
+					}
+				}
+
+				Chunk* newChunk = (Chunk*)ls_alloc(sizeof(Chunk) + CHUNK_SIZE);
+				newChunk->size = CHUNK_SIZE;
+				new (&newChunk->used) std::atomic<UINT32>(size);
 
-	template LS_UTILITY_EXPORT void StringID::construct(const char* const&);
-	template LS_UTILITY_EXPORT void StringID::construct(String const&);
-	
-	template LS_UTILITY_EXPORT UINT32 StringID::calcHash(const char* const&);
-	template LS_UTILITY_EXPORT UINT32 StringID::calcHash(String const&);
+				if (mChunk.compare_exchange_strong(chunk, newChunk, std::memory_order_acq_rel, std::memory_order_acquire))
+				{
+					entry = (InternalData*)newChunk->data();
+					break;
+				}
+
+				// Another thread replaced the chunk first, allocate from its chunk instead
+				ls_free(newChunk);
+			}
+		}
+
+		entry->hash = hash;
+		entry->id = mNextId.fetch_add(1, std::memory_order_relaxed);
+		entry->length = length;
+
+		char* chars = (char*)entry->chars();
+		memcpy(chars, name, length);
+		chars[length] = '\0';
+
+		return entry;
+	}
 }
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "Prerequisites/LSPrerequisitesUtil.h"
-#include "Thread/LSSpinLock.h"
+#include <atomic>
 
 namespace ls
 {
@@ -17,56 +17,62 @@ namespace ls
 	 * Essentially a unique ID is generated for each string and then the ID is used for comparisons as if you were using 
 	 * an integer or an enum.
 	 * @note
+	 * Strings are interned in a global open addressing hash table that grows as needed. Lookups never block, and
+	 * inserts only wait while the table is being moved to a larger one. The strings themselves are stored in chunks of
+	 * memory that are never released, and can be of any length.
+	 * @note
 	 * Thread safe.
 	 */
 	class LS_UTILITY_EXPORT StringID
 	{
-		static constexpr const int HASH_TABLE_SIZE = 4096;
-		static constexpr const int MAX_CHUNK_COUNT = 50;
-		static constexpr const int ELEMENTS_PER_CHUNK = 256;
-		static constexpr const int STRING_SIZE = 256;
-
-		/** Helper class that performs string actions on both null terminated character arrays and standard strings. */
-		template<class T>
-		class StringIDUtil
-		{
-		public:
-			static UINT32 size(T const& input) { return 0; }
-			static void copy(T const& input, char* dest) { }
-			static bool compare(T const& a, char* b) { return 0; }
-		};
+		static constexpr UINT32 INITIAL_TABLE_SIZE = 4096;
+		static constexpr UINT32 CHUNK_SIZE = 64 * 1024;
 
-		/**	Internal data that is shared by all instances for a specific string. */
+		/**	Internal data that is shared by all instances for a specific string. The characters follow the structure. */
 		struct InternalData
 		{
+			UINT64 hash;
 			UINT32 id;
-			InternalData* next;
-			char chars[STRING_SIZE];
+			UINT32 length;
+
+			/** Returns the null-terminated characters of the string. */
+			const char* chars() const { return (const char*)(this + 1); }
 		};
 
-		/**	Performs initialization of static members as soon as the library is loaded. */
-		struct InitStatics
+		struct Table;
+		struct Chunk;
+
+	public:
+		/** String with a pre-calculated hash. Allows string literals to be hashed at compile time, see LS_SID. */
+		struct HashedName
 		{
-			InitStatics();
+			const char* name;
+			UINT32 length;
+			UINT64 hash;
 		};
 
-	public:
 		StringID() = default;
 
 		StringID(const char* name)
 		{
-			construct(name);
+			const UINT32 length = (UINT32)strlen(name);
+			construct(name, length, calcHash(name, length));
 		}
 
 		StringID(const String& name)
 		{
-			construct(name);
+			construct(name.data(), (UINT32)name.size(), calcHash(name.data(), (UINT32)name.size()));
 		}
 
-		template<int N>
-		StringID(const char name[N])
+		/** Creates a string id from the first @p length characters of @p name, which doesn't need to be null-terminated. */
+		StringID(const char* name, UINT32 length)
 		{
-			construct((const char*)name);
+			construct(name, length, calcHash(name, length));
+		}
+
+		explicit StringID(const HashedName& name)
+		{
+			construct(name.name, name.length, name.hash);
 		}
 
 		/**	Compare to string ids for equality. Uses fast integer comparison. */
@@ -93,40 +99,82 @@ namespace ls
 			if (mData == nullptr)
 				return "";
 
-			return mData->chars;
+			return mData->chars();
 		}
 
+		/** Returns the number of characters in the name of the string id. */
+		UINT32 size() const { return mData ? mData->length : 0; }
+
 		/** Returns the unique identifier of the string. */
 		UINT32 id() const { return mData ? mData->id : -1; }
 
+		/** 
+		 * Calculates the hash used for interning the provided string. Usable in constant expressions, so the hashes of
+		 * string literals can be calculated at compile time.
+		 */
+		static constexpr UINT64 calcHash(const char* name, UINT32 length)
+		{
+			// FNV-1a
+			UINT64 hash = 0xcbf29ce484222325ULL;
+			for (UINT32 i = 0; i < length; i++)
+			{
+				hash ^= (UINT8)name[i];
+				hash *= 0x100000001b3ULL;
+			}
+
+			// Mix the upper bits into the lower bits used for table indices
+			hash ^= hash >> 33;
+			hash *= 0xff51afd7ed558ccdULL;
+			hash ^= hash >> 33;
+			hash *= 0xc4ceb9fe1a85ec53ULL;
+			hash ^= hash >> 33;
+
+			return hash;
+		}
+
 		static const StringID NONE;
 
 	private:
-		/**Constructs a StringID object in a way that works for pointers to character arrays and standard strings. */
-		template<class T>
-		void construct(T const& name);
+		/** Finds the existing entry for the string, or creates a new one. */
+		void construct(const char* name, UINT32 length, UINT64 hash);
+
+		/** Returns the table new lookups start in, creating it if it doesn't exist yet. */
+		static Table* getTable();
 
-		/**	Calculates a hash value for the provided null-terminated string. */
-		template<class T>
-		UINT32 calcHash(T const& input);
+		/** Looks up the entry for the string in the provided table, and the tables that replaced it. */
+		static InternalData* find(Table* table, const char* name, UINT32 length, UINT64 hash);
 
-		/**
-		 * Allocates a new string entry and assigns it a unique ID. Optionally expands the chunks buffer if the new entry 
-		 * doesn't fit.
+		/** 
+		 * Adds an entry for the string to the newest table, unless another thread added one first, in which case that
+		 * entry is returned instead.
 		 */
-		InternalData* allocEntry();
+		static InternalData* insert(Table* table, const char* name, UINT32 length, UINT64 hash);
 
-		InternalData* mData = nullptr;
+		/** Moves all entries of the table to a new table twice its size, unless another thread already started to. */
+		static void grow(Table* table);
 
-		static volatile InitStatics mInitStatics;
-		static InternalData* mStringHashTable[HASH_TABLE_SIZE];
-		static InternalData* mChunks[MAX_CHUNK_COUNT];
+		/** Creates an empty table with the provided number of slots. Must be a power of two. */
+		static Table* createTable(UINT32 size);
 
-		static UINT32 mNextId;
-		static UINT32 mNumChunks;
-		static SpinLock mSync;
+		/** Allocates an entry containing the string from the chunk memory, and assigns it a unique ID. */
+		static InternalData* allocEntry(const char* name, UINT32 length, UINT64 hash);
+
+		InternalData* mData = nullptr;
+
+		static std::atomic<Table*> mTable;
+		static std::atomic<Chunk*> mChunk;
+		static std::atomic<UINT32> mNextId;
+		static InternalData mMovedMarker;
 	};
 
+/** 
+ * Creates a StringID from a string literal, calculating the hash of the literal at compile time. Faster than 
+ * constructing the StringID from the literal directly.
+ */
+#define LS_SID(literal)																				\
+	ls::StringID(ls::StringID::HashedName{ (literal), (ls::UINT32)(sizeof(literal) - 1),			\
+		std::integral_constant<ls::UINT64, ls::StringID::calcHash((literal), sizeof(literal) - 1)>::value })
+
 	/** @cond SPECIALIZATIONS */
 
 	template<> struct RTTIPlainType <StringID>
@@ -163,13 +211,7 @@ namespace ls
 			if (!empty)
 			{
 				UINT32 length = (size - sizeof(UINT32) - sizeof(bool)) / sizeof(char);
-
-				auto name = (char*)ls_stack_alloc(length + 1);
-				memcpy(name, memory, length);
-				name[length] = '\0';
-
-				data = StringID(name);
-				ls_stack_free(name);
+				data = StringID(memory, length);
 			}
 
 			return size;
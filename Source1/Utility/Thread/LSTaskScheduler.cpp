@@ -1,13 +1,21 @@
 #include "Thread/LSTaskScheduler.h"
 #include "Thread/LSThreadPool.h"
+#include "Math/LSMath.h"
+#include "Logger/LSLogger.h"
 
 namespace ls
 {
+	void TaskGraphNode::addDependency(SPtr<TaskGraphNode> dependency)
+	{
+		if(dependency != nullptr)
+			mDependencies.push_back(std::move(dependency));
+	}
+
 	Task::Task(const PrivatelyConstruct& dummy, const String& name, std::function<void()> taskWorker,
 		TaskPriority priority, SPtr<Task> dependency)
-		: mName(name), mPriority(priority), mTaskWorker(std::move(taskWorker)), mTaskDependency(std::move(dependency))
+		: TaskGraphNode(false), mName(name), mPriority(priority), mTaskWorker(std::move(taskWorker))
 	{
-
+		addDependency(std::move(dependency));
 	}
 
 	SPtr<Task> Task::create(const String& name, std::function<void()> taskWorker, TaskPriority priority, 
@@ -16,6 +24,16 @@ namespace ls
 		return ls_shared_ptr_new<Task>(PrivatelyConstruct(), name, std::move(taskWorker), priority, std::move(dependency));
 	}
 
+	SPtr<Task> Task::create(const String& name, std::function<void()> taskWorker,
+		const Vector<SPtr<TaskGraphNode>>& dependencies, TaskPriority priority)
+	{
+		SPtr<Task> task = ls_shared_ptr_new<Task>(PrivatelyConstruct(), name, std::move(taskWorker), priority, nullptr);
+		for(auto& dependency : dependencies)
+			task->addDependency(dependency);
+
+		return task;
+	}
+
 	bool Task::isComplete() const
 	{
 		return mState == 2;
@@ -39,12 +57,23 @@ namespace ls
 
 	TaskGroup::TaskGroup(const PrivatelyConstruct& dummy, String name, std::function<void(UINT32)> taskWorker, 
 		UINT32 count, TaskPriority priority, SPtr<Task> dependency)
-		: mName(std::move(name)), mCount(count), mPriority(priority), mTaskWorker(std::move(taskWorker))
-		, mTaskDependency(std::move(dependency))
+		: TaskGraphNode(true), mName(std::move(name)), mCount(count), mPriority(priority)
 	{
+		mRangeWorker = [worker = std::move(taskWorker)](UINT32 begin, UINT32 end)
+		{
+			for(UINT32 i = begin; i < end; i++)
+				worker(i);
+		};
 
+		addDependency(std::move(dependency));
 	}
 
+	TaskGroup::TaskGroup(const PrivatelyConstruct& dummy, String name, std::function<void(UINT32, UINT32)> rangeWorker,
+		UINT32 begin, UINT32 end, UINT32 grain, TaskPriority priority)
+		: TaskGraphNode(true), mName(std::move(name)), mBegin(begin), mCount(end > begin ? end - begin : 0)
+		, mGrain(std::max(grain, 1U)), mPriority(priority), mRangeWorker(std::move(rangeWorker))
+	{ }
+
 	SPtr<TaskGroup> TaskGroup::create(String name, std::function<void(UINT32)> taskWorker, UINT32 count, 
 		TaskPriority priority, SPtr<Task> dependency)
 	{
@@ -52,9 +81,33 @@ namespace ls
 			std::move(dependency));
 	}
 
+	SPtr<TaskGroup> TaskGroup::create(String name, std::function<void(UINT32)> taskWorker, UINT32 count,
+		const Vector<SPtr<TaskGraphNode>>& dependencies, TaskPriority priority)
+	{
+		SPtr<TaskGroup> taskGroup = ls_shared_ptr_new<TaskGroup>(PrivatelyConstruct(), std::move(name),
+			std::move(taskWorker), count, priority, nullptr);
+
+		for(auto& dependency : dependencies)
+			taskGroup->addDependency(dependency);
+
+		return taskGroup;
+	}
+
+	SPtr<TaskGroup> TaskGroup::createRange(String name, std::function<void(UINT32, UINT32)> rangeWorker, UINT32 begin,
+		UINT32 end, UINT32 grain, TaskPriority priority)
+	{
+		return ls_shared_ptr_new<TaskGroup>(PrivatelyConstruct(), std::move(name), std::move(rangeWorker), begin, end,
+			grain, priority);
+	}
+
 	bool TaskGroup::isComplete() const
 	{
-		return mNumRemainingTasks == 0;
+		return mNumRemainingTasks == 0 && !mCanceled;
+	}
+
+	bool TaskGroup::isCanceled() const
+	{
+		return mCanceled;
 	}
 
 	void TaskGroup::wait()
@@ -63,22 +116,98 @@ namespace ls
 			mParent->waitUntilComplete(this);
 	}
 
-	TaskScheduler::TaskScheduler()
-		:mTaskQueue(&TaskScheduler::taskCompare)
+	LS_THREADLOCAL TaskScheduler::Worker* TaskScheduler::sCurrentWorker = nullptr;
+	LS_THREADLOCAL TaskScheduler* TaskScheduler::sExecutingScheduler = nullptr;
+
+	bool TaskGroup::claimRange(UINT32 numWorkers, UINT32& begin, UINT32& end)
+	{
+		UINT32 current = mNextItem.load(std::memory_order_relaxed);
+		while(current < mCount)
+		{
+			// Hand out large chunks while there is a lot of work left, and smaller ones towards the end so the workers
+			// finish at roughly the same time
+			UINT32 remaining = mCount - current;
+			UINT32 size = std::min(std::max(mGrain, remaining / (numWorkers * 2)), remaining);
+
+			if(mNextItem.compare_exchange_weak(current, current + size, std::memory_order_relaxed))
+			{
+				begin = current;
+				end = current + size;
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	TaskScheduler::TaskScheduler(TaskSchedulerMode mode)
+		:mMode(mode), mTaskQueue(&TaskScheduler::taskCompare)
 	{
 		mMaxActiveTasks = LS_THREAD_HARDWARE_CONCURRENCY;
 
-		mTaskSchedulerThread = ThreadPool::instance().run("TaskScheduler", std::bind(&TaskScheduler::runMain, this));
+		if(mMode == TaskSchedulerMode::WorkStealing)
+		{
+			UINT32 numWorkers = std::min(mMaxActiveTasks.load(), MAX_WORKERS);
+			for(UINT32 i = 0; i < numWorkers; i++)
+				spawnWorker();
+
+			if(mMaxActiveTasks > MAX_WORKERS)
+			{
+				LOGWRN("Task scheduler is limited to " + toString(MAX_WORKERS) + " worker threads in work stealing mode, "
+					"but " + toString(mMaxActiveTasks.load()) + " were requested.");
+			}
+		}
+		else
+			mTaskSchedulerThread = ThreadPool::instance().run("TaskScheduler", std::bind(&TaskScheduler::runMain, this));
 	}
 
 	TaskScheduler::~TaskScheduler()
 	{
-		// Wait until all tasks complete
+		if(mMode == TaskSchedulerMode::WorkStealing)
+		{
+			// Workers, including parked ones, keep executing tasks until the queues are empty and then exit
+			{
+				Lock lock(mWorkerMutex);
+				mShutdown = true;
+			}
+
+			mWorkerSleepCond.notify_all();
+			mWorkerParkCond.notify_all();
+
+			UINT32 numWorkers = mNumWorkers.load();
+			for(UINT32 i = 0; i < numWorkers; i++)
+				mWorkers[i]->thread.blockUntilComplete();
+
+			// Execute anything that was queued after the last worker exited, so no one waiting on a task is left hanging
+			while(Task* task = findTask(nullptr))
+				executeQueuedTask(task);
+
+			for(UINT32 i = 0; i < numWorkers; i++)
+			{
+				ls_delete(mWorkers[i]);
+				mWorkers[i] = nullptr;
+			}
+
+			return;
+		}
+
+		// Wait until all tasks complete, including the ones still queued
 		{
 			Lock activeTaskLock(mReadyMutex);
 
-			while (mActiveTasks.size() > 0)
+			while (mActiveTasks.size() > 0 || !mTaskQueue.empty())
 			{
+				if (mActiveTasks.empty())
+				{
+					// Workers might have been removed, so execute the remaining tasks on this thread
+					activeTaskLock.unlock();
+
+					executeNextTask();
+					activeTaskLock.lock();
+					continue;
+				}
+
 				SPtr<Task> task = mActiveTasks[0];
 				activeTaskLock.unlock();
 
@@ -101,50 +230,266 @@ namespace ls
 
 	void TaskScheduler::addTask(SPtr<Task> task)
 	{
-		Lock lock(mReadyMutex);
-
 		assert(task->mState != 1 && "Task is already executing, it cannot be executed again until it finishes.");
 
+		queueTask(std::move(task));
+	}
+
+	void TaskScheduler::addTaskGroup(const SPtr<TaskGroup>& taskGroup)
+	{
+		taskGroup->mParent = this;
+		taskGroup->mNextItem = 0;
+		taskGroup->mNumRemainingTasks = taskGroup->mCount;
+		taskGroup->mCanceled = false; // Reset state in case the group is getting re-queued
+
+		scheduleNode(taskGroup);
+	}
+
+	void TaskScheduler::queueTask(SPtr<Task> task)
+	{
 		task->mParent = this;
 		task->mTaskId = mNextTaskId++;
 		task->mState.store(0); // Reset state in case the task is getting re-queued
 
-		mCheckTasks = true;
-		mTaskQueue.insert(std::move(task));
+		scheduleNode(task);
+	}
+
+	void TaskScheduler::scheduleNode(const SPtr<TaskGraphNode>& node)
+	{
+		{
+			// Re-open the node in case it is getting re-queued
+			ScopedSpinLock lock(node->mSuccessorLock);
+			node->mSuccessorsClosed = false;
+		}
+
+		// One extra count so the node can't be released by a dependency while we're still registering with the others
+		node->mNumPendingDependencies = (UINT32)node->mDependencies.size() + 1;
+
+		bool dependencyCanceled = false;
+		for(auto& dependency : node->mDependencies)
+		{
+			bool registered;
+			{
+				ScopedSpinLock lock(dependency->mSuccessorLock);
+
+				registered = !dependency->mSuccessorsClosed;
+				if(registered)
+					dependency->mSuccessors.push_back(node);
+			}
+
+			if(!registered)
+			{
+				if(isNodeCanceled(dependency.get()))
+					dependencyCanceled = true;
+
+				node->mNumPendingDependencies--;
+			}
+		}
+
+		if(dependencyCanceled)
+			cancelNode(node.get());
+
+		if(--node->mNumPendingDependencies == 0)
+			releaseNode(node);
+	}
 
-		// Wake main scheduler thread
+	void TaskScheduler::releaseNode(const SPtr<TaskGraphNode>& node)
+	{
+		if(node->mIsGroup)
+		{
+			SPtr<TaskGroup> taskGroup = std::static_pointer_cast<TaskGroup>(node);
+
+			// Skip all the items, but still complete the group so anyone waiting on it, or depending on it, is released
+			if(taskGroup->isCanceled())
+			{
+				completeNode(taskGroup.get(), true);
+				notifyWaiters();
+
+				return;
+			}
+
+			queueTaskGroupItems(taskGroup);
+			return;
+		}
+
+		SPtr<Task> task = std::static_pointer_cast<Task>(node);
+		if(mMode == TaskSchedulerMode::WorkStealing)
+		{
+			pushReadyTask(std::move(task));
+			return;
+		}
+
+		{
+			Lock lock(mReadyMutex);
+
+			mCheckTasks = true;
+			mTaskQueue.insert(std::move(task));
+			mNumQueuedTasks++;
+		}
+
+		// Wake main scheduler thread, and anyone waiting that might help out
 		mTaskReadyCond.notify_one();
+		notifyWaiters();
 	}
 
-	void TaskScheduler::addTaskGroup(const SPtr<TaskGroup>& taskGroup)
+	void TaskScheduler::queueTaskGroupItems(const SPtr<TaskGroup>& taskGroup)
 	{
-		Lock lock(mReadyMutex);
+		if(taskGroup->mCount == 0)
+		{
+			completeNode(taskGroup.get(), false);
+			return;
+		}
+
+		// One task per worker is enough, as each task keeps claiming chunks until the group runs out of items
+		UINT32 numChunks = Math::divideAndRoundUp(taskGroup->mCount, taskGroup->mGrain);
+		UINT32 numTasks = std::min(std::max(mMaxActiveTasks.load(), 1U), numChunks);
 
-		for(UINT32 i = 0; i < taskGroup->mCount; i++)
+		Vector<SPtr<Task>> tasks;
+		tasks.reserve(numTasks);
+
+		for(UINT32 i = 0; i < numTasks; i++)
 		{
-			const auto worker = [i, taskGroup] 
-			{ 
-				taskGroup->mTaskWorker(i); 
-				--taskGroup->mNumRemainingTasks;
-			};
+			SPtr<Task> task = Task::create(taskGroup->mName, [this, taskGroup]() { runTaskGroupChunks(taskGroup); },
+				taskGroup->mPriority);
 
-			SPtr<Task> task = Task::create(taskGroup->mName, worker, taskGroup->mPriority, taskGroup->mTaskDependency);
 			task->mParent = this;
 			task->mTaskId = mNextTaskId++;
-			task->mState.store(0); // Reset state in case the task is getting re-queued
 
-			mCheckTasks = true;
-			mTaskQueue.insert(std::move(task));
+			tasks.push_back(std::move(task));
 		}
 
-		taskGroup->mParent = this;
+		if(mMode == TaskSchedulerMode::WorkStealing)
+		{
+			for(auto& task : tasks)
+				pushReadyTask(std::move(task));
+
+			return;
+		}
+
+		{
+			Lock lock(mReadyMutex);
+
+			for(auto& task : tasks)
+				mTaskQueue.insert(std::move(task));
+
+			mNumQueuedTasks += (UINT32)tasks.size();
+			mCheckTasks = true;
+		}
 
-		// Wake main scheduler thread
+		// Wake main scheduler thread, and anyone waiting that might help out
 		mTaskReadyCond.notify_one();
+		notifyWaiters();
+	}
+
+	void TaskScheduler::runTaskGroupChunks(const SPtr<TaskGroup>& taskGroup)
+	{
+		UINT32 numWorkers = std::max(mMaxActiveTasks.load(), 1U);
+
+		UINT32 begin, end;
+		while(taskGroup->claimRange(numWorkers, begin, end))
+		{
+			taskGroup->mRangeWorker(taskGroup->mBegin + begin, taskGroup->mBegin + end);
+
+			if((taskGroup->mNumRemainingTasks -= end - begin) == 0)
+				completeNode(taskGroup.get(), false);
+		}
+	}
+
+	void TaskScheduler::parallelFor(UINT32 begin, UINT32 end, UINT32 grain, std::function<void(UINT32, UINT32)> worker,
+		TaskPriority priority)
+	{
+		if(begin >= end)
+			return;
+
+		// Aim for a few chunks per thread, so that faster threads can pick up the slack of the slower ones
+		if(grain == 0)
+			grain = std::max((end - begin) / (std::max(mMaxActiveTasks.load(), 1U) * 8), 1U);
+
+		// Not worth distributing
+		if(end - begin <= grain)
+		{
+			worker(begin, end);
+			return;
+		}
+
+		SPtr<TaskGroup> taskGroup = TaskGroup::createRange("ParallelFor", std::move(worker), begin, end, grain, priority);
+		addTaskGroup(taskGroup);
+
+		// Process chunks on this thread as well, instead of just blocking
+		runTaskGroupChunks(taskGroup);
+		taskGroup->wait();
+	}
+
+	void TaskScheduler::completeNode(TaskGraphNode* node, bool canceled)
+	{
+		Vector<SPtr<TaskGraphNode>> successors;
+		{
+			ScopedSpinLock lock(node->mSuccessorLock);
+
+			node->mSuccessorsClosed = true;
+			std::swap(successors, node->mSuccessors);
+		}
+
+		for(auto& successor : successors)
+		{
+			// A task or a task group can't complete if something it depends on never ran
+			if(canceled)
+				cancelNode(successor.get());
+
+			if(--successor->mNumPendingDependencies == 0)
+				releaseNode(successor);
+		}
+
+		// Wake up anyone waiting on the successors we have just canceled
+		if(canceled && !successors.empty())
+			notifyWaiters();
+	}
+
+	bool TaskScheduler::isNodeCanceled(const TaskGraphNode* node)
+	{
+		if(node->mIsGroup)
+			return static_cast<const TaskGroup*>(node)->isCanceled();
+
+		return static_cast<const Task*>(node)->isCanceled();
+	}
+
+	void TaskScheduler::cancelNode(TaskGraphNode* node)
+	{
+		if(node->mIsGroup)
+			static_cast<TaskGroup*>(node)->mCanceled = true;
+		else
+			static_cast<Task*>(node)->cancel();
 	}
 
 	void TaskScheduler::addWorker()
 	{
+		if(mMode == TaskSchedulerMode::WorkStealing)
+		{
+			bool limitReached = false;
+			{
+				Lock lock(mWorkerMutex);
+
+				mMaxActiveTasks++;
+				if(mMaxActiveTasks > mNumWorkers)
+				{
+					if(mNumWorkers < MAX_WORKERS)
+						spawnWorker();
+					else
+						limitReached = true;
+				}
+			}
+
+			mWorkerParkCond.notify_all();
+
+			if(limitReached)
+			{
+				LOGWRN("Task scheduler is limited to " + toString(MAX_WORKERS) + " worker threads in work stealing mode, "
+					"the added worker won't execute any tasks.");
+			}
+
+			return;
+		}
+
 		Lock lock(mReadyMutex);
 
 		mMaxActiveTasks++;
@@ -155,6 +500,20 @@ namespace ls
 
 	void TaskScheduler::removeWorker()
 	{
+		if(mMode == TaskSchedulerMode::WorkStealing)
+		{
+			{
+				Lock lock(mWorkerMutex);
+
+				if(mMaxActiveTasks > 0)
+					mMaxActiveTasks--;
+			}
+
+			// Let sleeping workers know they might need to park
+			mWorkerSleepCond.notify_all();
+			return;
+		}
+
 		Lock lock(mReadyMutex);
 
 		if(mMaxActiveTasks > 0)
@@ -163,11 +522,13 @@ namespace ls
 
 	void TaskScheduler::runMain()
 	{
+		Vector<SPtr<Task>> canceledTasks;
+
 		while(true)
 		{
 			Lock lock(mReadyMutex);
 
-			while((!mCheckTasks || (UINT32)mActiveTasks.size() >= mMaxActiveTasks) && !mShutdown)
+			while((!mCheckTasks || !hasFreeTaskSlot()) && !mShutdown)
 				mTaskReadyCond.wait(lock);
 
 			mCheckTasks = false;
@@ -175,38 +536,51 @@ namespace ls
 			if(mShutdown)
 				break;
 
+			// Only tasks whose dependencies have completed are ever in the queue
 			for(auto iter = mTaskQueue.begin(); iter != mTaskQueue.end();)
 			{
-				if ((UINT32)mActiveTasks.size() >= mMaxActiveTasks)
-					break;	
+				if (!hasFreeTaskSlot())
+					break;
 
 				SPtr<Task> curTask = *iter;
+				iter = mTaskQueue.erase(iter);
+				mNumQueuedTasks--;
 
 				if(curTask->isCanceled())
 				{
-					iter = mTaskQueue.erase(iter);
-					continue;
-				}
-
-				if(curTask->mTaskDependency != nullptr && !curTask->mTaskDependency->isComplete())
-				{
-					++iter;
+					canceledTasks.push_back(std::move(curTask));
 					continue;
 				}
 
-				iter = mTaskQueue.erase(iter);
-
 				curTask->mState.store(1);
 				mActiveTasks.push_back(curTask);
 
-				ThreadPool::instance().run(curTask->mName, std::bind(&TaskScheduler::runTask, this, curTask));
+				ThreadPool::instance().run(curTask->mName, std::bind(&TaskScheduler::runTask, this, curTask, false));
 			}
+
+			lock.unlock();
+
+			// Tasks depending on canceled tasks get canceled as well. Must happen outside of the lock, as it might queue them.
+			for(auto& task : canceledTasks)
+				completeNode(task.get(), true);
+
+			canceledTasks.clear();
 		}
 	}
 
-	void TaskScheduler::runTask(SPtr<Task> task)
+	void TaskScheduler::runTask(SPtr<Task> task, bool nested)
 	{
+		TaskScheduler* prevExecutingScheduler = sExecutingScheduler;
+		sExecutingScheduler = this;
+
 		task->mTaskWorker();
+		task->mState.store(2);
+
+		sExecutingScheduler = prevExecutingScheduler;
+
+		// Queue any tasks for which this was the last remaining dependency. Done while the task still counts as active,
+		// so the scheduler can't observe a moment where neither the task nor its successors are pending.
+		completeNode(task.get(), false);
 
 		{
 			Lock lock(mReadyMutex);
@@ -214,51 +588,317 @@ namespace ls
 			auto findIter = std::find(mActiveTasks.begin(), mActiveTasks.end(), task);
 			if (findIter != mActiveTasks.end())
 				mActiveTasks.erase(findIter);
+
+			if (nested)
+				mNumNestedTasks--;
 		}
 
+		notifyWaiters();
+
+		// Wake the main scheduler thread in case there are other tasks waiting
+		{
+			Lock lock(mReadyMutex);
+
+			mCheckTasks = true;
+			mTaskReadyCond.notify_one();
+		}
+	}
+
+	void TaskScheduler::waitUntilComplete(const Task* task)
+	{
+		helpUntilComplete([task]() { return task->isComplete() || task->isCanceled(); });
+	}
+
+	void TaskScheduler::waitUntilComplete(const TaskGroup* taskGroup)
+	{
+		helpUntilComplete([taskGroup]() { return taskGroup->isComplete() || taskGroup->isCanceled(); });
+	}
+
+	void TaskScheduler::helpUntilComplete(const std::function<bool()>& isComplete)
+	{
+		while(!isComplete())
 		{
+			// Execute other queued tasks instead of blocking, which also covers the tasks we're waiting on
+			if(executeNextTask())
+				continue;
+
 			Lock lock(mCompleteMutex);
-			task->mState.store(2);
 
-			mTaskCompleteCond.notify_all();
+			// Announce the wait before checking for work, so a concurrently queued task can't miss waking us
+			mNumWaiters++;
+
+			while(!isComplete() && mNumQueuedTasks == 0)
+				mTaskCompleteCond.wait(lock);
+
+			mNumWaiters--;
 		}
+	}
+
+	bool TaskScheduler::executeNextTask()
+	{
+		if(mMode == TaskSchedulerMode::WorkStealing)
+		{
+			Worker* worker = sCurrentWorker;
+			if(worker != nullptr && worker->owner != this)
+				worker = nullptr;
+
+			Task* task = findTask(worker);
+			if(task == nullptr)
+				return false;
 
-		// Wake the main scheduler thread in case there are other tasks waiting or this task was someone's dependency
+			executeQueuedTask(task);
+			return true;
+		}
+
+		// If this thread is blocked inside one of our tasks, that task already occupies a slot
+		bool nested = sExecutingScheduler == this;
+
+		SPtr<Task> task;
+		Vector<SPtr<Task>> canceledTasks;
 		{
 			Lock lock(mReadyMutex);
 
-			mCheckTasks = true;
-			mTaskReadyCond.notify_one();
+			while(!mTaskQueue.empty())
+			{
+				SPtr<Task> curTask = *mTaskQueue.begin();
+				mTaskQueue.erase(mTaskQueue.begin());
+				mNumQueuedTasks--;
+
+				if(curTask->isCanceled())
+				{
+					canceledTasks.push_back(std::move(curTask));
+					continue;
+				}
+
+				// Runs in place of the blocked thread. If the thread was executing one of our tasks it runs in that task's
+				// slot, otherwise it takes a slot of its own like a dispatched task would.
+				curTask->mState.store(1);
+				mActiveTasks.push_back(curTask);
+
+				if(nested)
+					mNumNestedTasks++;
+
+				task = std::move(curTask);
+				break;
+			}
 		}
+
+		for(auto& canceledTask : canceledTasks)
+			completeNode(canceledTask.get(), true);
+
+		if(task == nullptr)
+			return !canceledTasks.empty();
+
+		runTask(std::move(task), nested);
+		return true;
 	}
 
-	void TaskScheduler::waitUntilComplete(const Task* task)
+	void TaskScheduler::spawnWorker()
+	{
+		UINT32 index = mNumWorkers.load();
+
+		Worker* worker = ls_new<Worker>();
+		worker->owner = this;
+		worker->index = index;
+		worker->randomState = index + 1;
+
+		// Publish the worker before it becomes visible to stealers
+		mWorkers[index] = worker;
+		mNumWorkers.store(index + 1);
+
+		worker->thread = ThreadPool::instance().run("TaskWorker", std::bind(&TaskScheduler::runWorker, this, worker));
+	}
+
+	void TaskScheduler::runWorker(Worker* worker)
+	{
+		sCurrentWorker = worker;
+
+		while(true)
+		{
+			// Parked workers help drain the queues on shutdown, as there might be no active ones left
+			Task* task = nullptr;
+			if(worker->index < mMaxActiveTasks || mShutdown)
+				task = findTask(worker);
+
+			if(task != nullptr)
+			{
+				executeQueuedTask(task);
+				continue;
+			}
+
+			if(!waitForWork(worker))
+				break;
+		}
+
+		sCurrentWorker = nullptr;
+	}
+
+	void TaskScheduler::pushReadyTask(SPtr<Task> task)
+	{
+		UINT32 lane = getPriorityLane(task->mPriority);
+
+		// The queues only store raw pointers, so the task keeps itself alive until it is popped
+		Task* queuedTask = task.get();
+		queuedTask->mQueuedRef = std::move(task);
+
+		// Count the task before it is visible, so consumers never observe a negative count
+		mNumQueuedTasks++;
+
+		Worker* worker = sCurrentWorker;
+		if(worker != nullptr && worker->owner == this)
+			worker->queues[lane].push(queuedTask);
+		else
+		{
+			InjectionQueue& queue = mInjectionQueues[lane];
+
+			ScopedSpinLock lock(queue.lock);
+			queue.tasks.push_back(queuedTask);
+			queue.numTasks++;
+		}
+
+		wakeWorker();
+		notifyWaiters();
+	}
+
+	Task* TaskScheduler::findTask(Worker* worker)
+	{
+		for(UINT32 lane = 0; lane < NUM_PRIORITY_LANES; lane++)
+		{
+			Task* task = nullptr;
+			if(worker != nullptr && worker->queues[lane].pop(task))
+				return task;
+
+			// Prefer tasks spawned by other workers over new external work, as those are more likely to be blocking
+			// someone
+			task = stealTask(worker, lane);
+			if(task != nullptr)
+				return task;
+
+			InjectionQueue& queue = mInjectionQueues[lane];
+			if(queue.numTasks > 0)
+			{
+				ScopedSpinLock lock(queue.lock);
+				if(!queue.tasks.empty())
+				{
+					task = queue.tasks.front();
+					queue.tasks.pop_front();
+					queue.numTasks--;
+
+					return task;
+				}
+			}
+		}
+
+		return nullptr;
+	}
+
+	Task* TaskScheduler::stealTask(Worker* thief, UINT32 lane)
+	{
+		UINT32 numWorkers = mNumWorkers.load();
+		if(numWorkers == 0)
+			return nullptr;
+
+		// Start at a random victim so that thieves don't all contend on the same queue
+		UINT32 start = 0;
+		if(thief != nullptr)
+		{
+			UINT32& state = thief->randomState;
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+
+			start = state % numWorkers;
+		}
+
+		for(UINT32 i = 0; i < numWorkers; i++)
+		{
+			Worker* victim = mWorkers[(start + i) % numWorkers];
+			if(victim == thief)
+				continue;
+
+			Task* task = nullptr;
+			if(victim->queues[lane].steal(task))
+				return task;
+		}
+
+		return nullptr;
+	}
+
+	void TaskScheduler::executeQueuedTask(Task* queuedTask)
 	{
+		mNumQueuedTasks--;
+
+		SPtr<Task> task = std::move(queuedTask->mQueuedRef);
 		if(task->isCanceled())
+		{
+			completeNode(task.get(), true);
 			return;
+		}
 
+		task->mState.store(1);
+		task->mTaskWorker();
+		task->mState.store(2);
+
+		completeNode(task.get(), false);
+		notifyWaiters();
+	}
+
+	bool TaskScheduler::waitForWork(Worker* worker)
+	{
+		Lock lock(mWorkerMutex);
+
+		while(true)
 		{
-			Lock lock(mCompleteMutex);
+			if(mShutdown)
+			{
+				// Keep going until the queues are drained
+				return mNumQueuedTasks > 0;
+			}
 
-			while(!task->isComplete())
+			if(worker->index >= mMaxActiveTasks)
 			{
-				addWorker();
-				mTaskCompleteCond.wait(lock);
-				removeWorker();
+				// Pass on any wake up meant for active workers, since this one won't be taking the work
+				if(mNumQueuedTasks > 0 && mNumSleepingWorkers > 0)
+					mWorkerSleepCond.notify_one();
+
+				mWorkerParkCond.wait(lock);
+				continue;
+			}
+
+			// Announce the sleep before checking for work, so a concurrent wakeWorker() call can't miss us
+			mNumSleepingWorkers++;
+			if(mNumQueuedTasks > 0)
+			{
+				mNumSleepingWorkers--;
+				return true;
 			}
+
+			mWorkerSleepCond.wait(lock);
+			mNumSleepingWorkers--;
 		}
 	}
 
-	void TaskScheduler::waitUntilComplete(const TaskGroup* taskGroup)
+	void TaskScheduler::wakeWorker()
 	{
+		if(mNumSleepingWorkers == 0)
+			return;
+
+		Lock lock(mWorkerMutex);
+		mWorkerSleepCond.notify_one();
+	}
+
+	void TaskScheduler::notifyWaiters()
+	{
+		if(mNumWaiters == 0)
+			return;
+
 		Lock lock(mCompleteMutex);
+		mTaskCompleteCond.notify_all();
+	}
 
-		while (taskGroup->mNumRemainingTasks > 0)
-		{
-			addWorker();
-			mTaskCompleteCond.wait(lock);
-			removeWorker();
-		}
+	bool TaskScheduler::hasFreeTaskSlot() const
+	{
+		return (UINT32)mActiveTasks.size() - mNumNestedTasks < mMaxActiveTasks;
 	}
 
 	bool TaskScheduler::taskCompare(const SPtr<Task>& lhs, const SPtr<Task>& rhs)
@@ -270,4 +910,10 @@ namespace ls
 		// Otherwise we go by smaller id, as that task was queued earlier than the other
 		return lhs->mTaskId < rhs->mTaskId;
 	}
-}
+
+	UINT32 TaskScheduler::getPriorityLane(TaskPriority priority)
+	{
+		INT32 lane = (INT32)TaskPriority::VeryHigh - (INT32)priority;
+		return (UINT32)Math::clamp(lane, 0, (INT32)NUM_PRIORITY_LANES - 1);
+	}
+}
\ No newline at end of file
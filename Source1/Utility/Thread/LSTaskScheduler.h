@@ -3,6 +3,7 @@
 #include "Prerequisites/LSPrerequisitesUtil.h"
 #include "General/LSModule.h"
 #include "Thread/LSThreadPool.h"
+#include "Thread/LSWorkStealingQueue.h"
 
 namespace ls
 {
@@ -21,12 +22,59 @@ namespace ls
 		VeryHigh = 102
 	};
 
+	/** Determines how does the TaskScheduler distribute queued tasks between threads. */
+	enum class TaskSchedulerMode
+	{
+		/**
+		 * Tasks are stored in a single priority sorted queue, from which a dispatcher thread hands them out to ThreadPool
+		 * threads. Best suited for a small number of coarse tasks.
+		 */
+		GlobalQueue,
+		/**
+		 * Each persistent worker thread owns a set of lock-free queues (one per priority) it pushes to and pops from,
+		 * while idle workers steal tasks from other workers. Best suited for a large number of small tasks.
+		 */
+		WorkStealing
+	};
+
+	/**
+	 * Part of Task and TaskGroup that links them into a dependency graph. A node may depend on any number of other nodes
+	 * and will be queued for execution as soon as the last of them completes, by the thread that completed it.
+	 *
+	 * @note	Thread safe.
+	 */
+	class LS_UTILITY_EXPORT TaskGraphNode
+	{
+	public:
+		virtual ~TaskGraphNode() = default;
+
+		/**
+		 * Registers a task or a task group that must complete before this node is allowed to execute. Must be called
+		 * before the node is queued in the TaskScheduler.
+		 */
+		void addDependency(SPtr<TaskGraphNode> dependency);
+
+	protected:
+		friend class TaskScheduler;
+
+		TaskGraphNode(bool isGroup)
+			:mIsGroup(isGroup)
+		{ }
+
+		Vector<SPtr<TaskGraphNode>> mDependencies;
+		Vector<SPtr<TaskGraphNode>> mSuccessors;
+		std::atomic<UINT32> mNumPendingDependencies{0};
+		bool mSuccessorsClosed = false; /**< Set once the node completes, no further successors may register. */
+		bool mIsGroup;
+		SpinLock mSuccessorLock;
+	};
+
 	/**
 	 * Represents a single task that may be queued in the TaskScheduler.
 	 *
 	 * @note	Thread safe.
 	 */
-	class LS_UTILITY_EXPORT Task
+	class LS_UTILITY_EXPORT Task : public TaskGraphNode
 	{
 		struct PrivatelyConstruct {};
 
@@ -46,6 +94,18 @@ namespace ls
 		static SPtr<Task> create(const String& name, std::function<void()> taskWorker, 
 			TaskPriority priority = TaskPriority::Normal, SPtr<Task> dependency = nullptr);
 
+		/**
+		 * Creates a new task that depends on multiple other tasks or task groups. Task should be provided to
+		 * TaskScheduler in order for it to start.
+		 *
+		 * @param[in]	name			Name you can use to more easily identify the task.
+		 * @param[in]	taskWorker		Worker method that does all of the work in the task.
+		 * @param[in]	dependencies	Tasks or task groups that must all complete before this task is executed.
+		 * @param[in]	priority  		(optional) Higher priority means the tasks will be executed sooner.
+		 */
+		static SPtr<Task> create(const String& name, std::function<void()> taskWorker,
+			const Vector<SPtr<TaskGraphNode>>& dependencies, TaskPriority priority = TaskPriority::Normal);
+
 		/** Returns true if the task has completed. */
 		bool isComplete() const;
 
@@ -55,11 +115,14 @@ namespace ls
 		/**
 		 * Blocks the current thread until the task has completed.
 		 *
-		 * @note	While waiting adds a new worker thread, so that the blocking threads core can be utilized.
+		 * @note	While waiting the current thread executes other queued tasks, so that its core can be utilized.
 		 */
 		void wait();
 
-		/** Cancels the task and removes it from the TaskSchedulers queue. */
+		/**
+		 * Cancels the task and removes it from the TaskSchedulers queue. Any tasks or task groups depending on this task
+		 * will be canceled as well.
+		 */
 		void cancel();
 
 	private:
@@ -69,18 +132,25 @@ namespace ls
 		TaskPriority mPriority;
 		UINT32 mTaskId = 0;
 		std::function<void()> mTaskWorker;
-		SPtr<Task> mTaskDependency;
 		std::atomic<UINT32> mState{0}; /**< 0 - Inactive, 1 - In progress, 2 - Completed, 3 - Canceled */
 
 		TaskScheduler* mParent = nullptr;
+		SPtr<Task> mQueuedRef; /**< Keeps the task alive while it is referenced from a work stealing queue. */
 	};
 
 	/**
 	 * Represents a group of tasks that may be queued in the TaskScheduler to be processed in parallel.
 	 *
-	 * @note	Thread safe.
+	 * @note
+	 * Thread safe.
+	 * @note
+	 * Items in the group aren't queued individually. Instead the scheduler queues one task per worker, each of which
+	 * keeps claiming contiguous ranges of items until none are left. Ranges start large and get smaller as the group
+	 * nears completion, so workers finish at roughly the same time.
+	 * @note
+	 * If any of the group's dependencies is canceled, the group is canceled as well and none of its items are executed.
 	 */
-	class LS_UTILITY_EXPORT TaskGroup
+	class LS_UTILITY_EXPORT TaskGroup : public TaskGraphNode
 	{
 		struct PrivatelyConstruct {};
 
@@ -88,13 +158,16 @@ namespace ls
 		TaskGroup(const PrivatelyConstruct& dummy, String name, std::function<void(UINT32)> taskWorker, UINT32 count,
 			TaskPriority priority, SPtr<Task> dependency);
 
+		TaskGroup(const PrivatelyConstruct& dummy, String name, std::function<void(UINT32, UINT32)> rangeWorker,
+			UINT32 begin, UINT32 end, UINT32 grain, TaskPriority priority);
+
 		/**
 		 * Creates a new task group. Task group should be provided to TaskScheduler in order for it to start.
 		 *
 		 * @param[in]	name		Name you can use to more easily identify the tasks in the group.
 		 * @param[in]	taskWorker	Worker method that will get called for each item in the group. Each call will receive
 		 *							a sequential index of the item in the group.
-		 * @param[in]	count		Number of items in the task group. Each item will be processed in a worker thread.
+		 * @param[in]	count		Number of items in the task group. Items will be processed in worker threads.
 		 * @param[in]	priority  	(optional) Higher priority means the tasks will be executed sooner.
 		 * @param[in]	dependency	(optional) Task dependency if one exists. If provided the task will
 		 * 							not be executed until its dependency is complete.
@@ -102,25 +175,71 @@ namespace ls
 		static SPtr<TaskGroup> create(String name, std::function<void(UINT32)> taskWorker, UINT32 count,
 			TaskPriority priority = TaskPriority::Normal, SPtr<Task> dependency = nullptr);
 
+		/**
+		 * Creates a new task group that depends on multiple other tasks or task groups. Task group should be provided to
+		 * TaskScheduler in order for it to start.
+		 *
+		 * @param[in]	name			Name you can use to more easily identify the tasks in the group.
+		 * @param[in]	taskWorker		Worker method that will get called for each item in the group. Each call will
+		 *								receive a sequential index of the item in the group.
+		 * @param[in]	count			Number of items in the task group. Items will be processed in worker threads.
+		 * @param[in]	dependencies	Tasks or task groups that must all complete before any item in the group is
+		 *								executed.
+		 * @param[in]	priority  		(optional) Higher priority means the tasks will be executed sooner.
+		 */
+		static SPtr<TaskGroup> create(String name, std::function<void(UINT32)> taskWorker, UINT32 count,
+			const Vector<SPtr<TaskGraphNode>>& dependencies, TaskPriority priority = TaskPriority::Normal);
+
+		/**
+		 * Creates a new task group that processes a range of indices in contiguous chunks. Task group should be provided
+		 * to TaskScheduler in order for it to start.
+		 *
+		 * @param[in]	name			Name you can use to more easily identify the tasks in the group.
+		 * @param[in]	rangeWorker		Worker method that will get called for each chunk of the range. Receives the
+		 *								first index in the chunk and one past the last index in the chunk.
+		 * @param[in]	begin			First index in the range.
+		 * @param[in]	end				One past the last index in the range.
+		 * @param[in]	grain			(optional) Minimum number of indices in a single chunk. Zero to pick one
+		 *								automatically.
+		 * @param[in]	priority  		(optional) Higher priority means the tasks will be executed sooner.
+		 */
+		static SPtr<TaskGroup> createRange(String name, std::function<void(UINT32, UINT32)> rangeWorker, UINT32 begin,
+			UINT32 end, UINT32 grain = 0, TaskPriority priority = TaskPriority::Normal);
+
 		/** Returns true if all the tasks in the group have completed. */
 		bool isComplete() const;
 
+		/** Returns true if the group has been canceled because one of its dependencies was canceled. */
+		bool isCanceled() const;
+
 		/**
-		 * Blocks the current thread until all tasks in the group have completed.
+		 * Blocks the current thread until all tasks in the group have completed, or the group has been canceled.
 		 *
-		 * @note	While waiting adds a new worker thread, so that the blocking threads core can be utilized.
+		 * @note	While waiting the current thread executes other queued tasks, so that its core can be utilized.
 		 */
 		void wait();
 
 	private:
 		friend class TaskScheduler;
 
+		/**
+		 * Claims the next chunk of unprocessed items. Returns false if all items have already been claimed.
+		 *
+		 * @param[in]	numWorkers	Number of threads processing the group, used for determining the chunk size.
+		 * @param[out]	begin		Index of the first claimed item, relative to the start of the group.
+		 * @param[out]	end			One past the index of the last claimed item, relative to the start of the group.
+		 */
+		bool claimRange(UINT32 numWorkers, UINT32& begin, UINT32& end);
+
 		String mName;
+		UINT32 mBegin = 0;
 		UINT32 mCount;
+		UINT32 mGrain = 1;
 		TaskPriority mPriority;
-		std::function<void(UINT32)> mTaskWorker;
-		SPtr<Task> mTaskDependency;
-		std::atomic<UINT32> mNumRemainingTasks{mCount};
+		std::function<void(UINT32, UINT32)> mRangeWorker;
+		std::atomic<UINT32> mNextItem{0};
+		std::atomic<UINT32> mNumRemainingTasks{mCount}; /**< Number of items not yet processed. */
+		std::atomic<bool> mCanceled{false};
 
 		TaskScheduler* mParent = nullptr;
 	};
@@ -132,9 +251,9 @@ namespace ls
 	 * @note
 	 * Thread safe.
 	 * @note
-	 * This type of task scheduler uses a global queue and is best used for coarse granularity of tasks. (Number of tasks
-	 * in the order of hundreds. Higher number of tasks might require different queuing and locking mechanism, potentially
-	 * at the cost of flexibility.)
+	 * By default the task scheduler uses a global queue which is best used for coarse granularity of tasks (number of
+	 * tasks in the order of hundreds). For a higher number of tasks use TaskSchedulerMode::WorkStealing, which trades
+	 * strict priority ordering for per-worker queues that don't require locking.
 	 * @note
 	 * By default the task scheduler will create as many threads as there are physical CPU cores. You may add or remove
 	 * threads using addWorker()/removeWorker() methods.
@@ -142,7 +261,14 @@ namespace ls
 	class LS_UTILITY_EXPORT TaskScheduler : public Module<TaskScheduler>
 	{
 	public:
-		TaskScheduler();
+		/**
+		 * Constructs a new task scheduler.
+		 *
+		 * @param[in]	mode	Determines how are the queued tasks distributed between threads.
+		 */
+		TaskScheduler(TaskSchedulerMode mode = TaskSchedulerMode::GlobalQueue);
+
+		/** Executes all the queued tasks, including ones queued while shutting down, and stops the worker threads. */
 		~TaskScheduler();
 
 		/** Queues a new task. */
@@ -159,37 +285,182 @@ namespace ls
 
 		/** Returns the maximum available worker threads (maximum number of tasks that can be executed simultaneously). */
 		UINT32 getNumWorkers() const { return mMaxActiveTasks; }
+
+		/** Returns the mode that determines how are tasks distributed between threads. */
+		TaskSchedulerMode getMode() const { return mMode; }
+
+		/**
+		 * Processes the range [@p begin, @p end) in parallel and blocks until the whole range is processed. The range is
+		 * split into contiguous chunks which are distributed between the worker threads and the calling thread.
+		 *
+		 * @param[in]	begin		First index in the range.
+		 * @param[in]	end			One past the last index in the range.
+		 * @param[in]	grain		Minimum number of indices in a single chunk. Zero to pick one automatically.
+		 * @param[in]	worker		Method called for each chunk, receiving the first index in the chunk and one past the
+		 *							last index in the chunk.
+		 * @param[in]	priority	(optional) Higher priority means the chunks will be executed sooner.
+		 */
+		void parallelFor(UINT32 begin, UINT32 end, UINT32 grain, std::function<void(UINT32, UINT32)> worker,
+			TaskPriority priority = TaskPriority::Normal);
 	protected:
 		friend class Task;
 		friend class TaskGroup;
 
+		/** Number of separate queues each work stealing worker has, one for each TaskPriority. */
+		static constexpr UINT32 NUM_PRIORITY_LANES = 5;
+
+		/** 
+		 * Maximum number of persistent worker threads when running in TaskSchedulerMode::WorkStealing. Workers added past
+		 * this limit are ignored, with a warning.
+		 */
+		static constexpr UINT32 MAX_WORKERS = 64;
+
+		/** Persistent worker thread used in TaskSchedulerMode::WorkStealing, along with the queues it owns. */
+		struct Worker
+		{
+			WorkStealingQueue<Task*> queues[NUM_PRIORITY_LANES];
+			TaskScheduler* owner = nullptr;
+			HThread thread;
+			UINT32 index = 0;
+			UINT32 randomState = 1;
+		};
+
+		/** Queue that receives tasks submitted from threads that aren't work stealing workers. */
+		struct InjectionQueue
+		{
+			SpinLock lock;
+			Deque<Task*> tasks;
+			std::atomic<UINT32> numTasks{0};
+		};
+
+		/** Queues a task, or defers it until its dependencies complete. */
+		void queueTask(SPtr<Task> task);
+
+		/**
+		 * Registers the node with all of its dependencies and queues it if they have all already completed. Otherwise
+		 * the node is queued by whichever dependency completes last.
+		 */
+		void scheduleNode(const SPtr<TaskGraphNode>& node);
+
+		/** Queues a node whose dependencies have all completed. */
+		void releaseNode(const SPtr<TaskGraphNode>& node);
+
+		/** Queues the tasks that process the items of a task group. */
+		void queueTaskGroupItems(const SPtr<TaskGroup>& taskGroup);
+
+		/** Keeps processing chunks of items from the task group until there are none left. */
+		void runTaskGroupChunks(const SPtr<TaskGroup>& taskGroup);
+
+		/**
+		 * Notifies all successors of a node that has just completed (or has been canceled), queuing the ones that have
+		 * no other pending dependencies.
+		 */
+		void completeNode(TaskGraphNode* node, bool canceled);
+
+		/** Returns true if the task or task group has been canceled. */
+		static bool isNodeCanceled(const TaskGraphNode* node);
+
+		/** Cancels a task or a task group, so it completes without executing once its dependencies complete. */
+		static void cancelNode(TaskGraphNode* node);
+
 		/**	Main task scheduler method that dispatches tasks to other threads. */
 		void runMain();
 
-		/**	Worker method that runs a single task. */
-		void runTask(SPtr<Task> task);
+		/**
+		 * Worker method that runs a single task. @p nested should be true if the task is executed by a thread blocked
+		 * inside another active task of this scheduler.
+		 */
+		void runTask(SPtr<Task> task, bool nested);
 
 		/**	Blocks the calling thread until the specified task has completed. */
 		void waitUntilComplete(const Task* task);
 
-		/**	Blocks the calling thread until all the tasks in the provided task group have completed. */
+		/**	Blocks the calling thread until all the tasks in the provided task group have completed, or it is canceled. */
 		void waitUntilComplete(const TaskGroup* taskGroup);
 
+		/**
+		 * Executes queued tasks on the calling thread until the provided condition is met, only blocking when there are
+		 * no queued tasks left.
+		 */
+		void helpUntilComplete(const std::function<bool()>& isComplete);
+
+		/** Executes a single queued task on the calling thread. Returns false if there were no queued tasks. */
+		bool executeNextTask();
+
+		/** 
+		 * Checks if another task can be dispatched in TaskSchedulerMode::GlobalQueue, without exceeding the maximum number
+		 * of active tasks. Must be called with mReadyMutex locked.
+		 */
+		bool hasFreeTaskSlot() const;
+
 		/**	Method used for sorting tasks. */
 		static bool taskCompare(const SPtr<Task>& lhs, const SPtr<Task>& rhs);
 
+		/** Maps a task priority to the index of the work stealing queue it belongs to. Lower index is higher priority. */
+		static UINT32 getPriorityLane(TaskPriority priority);
+
+		/** Main loop of a persistent work stealing worker. */
+		void runWorker(Worker* worker);
+
+		/** Creates and starts a new persistent work stealing worker. */
+		void spawnWorker();
+
+		/** Pushes a task whose dependencies are complete to the current worker's queue or the injection queue. */
+		void pushReadyTask(SPtr<Task> task);
+
+		/**
+		 * Finds the next task to execute, looking at the local queue of the provided worker first, then stealing from
+		 * other workers and finally looking at the injection queue. Returns null if there is no work.
+		 */
+		Task* findTask(Worker* worker);
+
+		/** Attempts to steal a task of the specified priority lane from any worker other than @p thief. */
+		Task* stealTask(Worker* thief, UINT32 lane);
+
+		/** Executes a task retrieved from one of the work stealing queues. */
+		void executeQueuedTask(Task* task);
+
+		/**
+		 * Blocks the worker until new work is queued. Returns false if the scheduler is shutting down and the worker
+		 * should exit.
+		 */
+		bool waitForWork(Worker* worker);
+
+		/** Wakes up an idle work stealing worker, if there is one. */
+		void wakeWorker();
+
+		/** Notifies threads blocked in waitUntilComplete() that a task has finished or that new tasks were queued. */
+		void notifyWaiters();
+
+		TaskSchedulerMode mMode;
 		HThread mTaskSchedulerThread;
 		Set<SPtr<Task>, std::function<bool(const SPtr<Task>&, const SPtr<Task>&)>> mTaskQueue;
 		Vector<SPtr<Task>> mActiveTasks;
-		UINT32 mMaxActiveTasks = 0;
-		UINT32 mNextTaskId = 0;
-		bool mShutdown = false;
+		UINT32 mNumNestedTasks = 0; /**< Active tasks executed by threads blocked inside other active tasks. */
+		std::atomic<UINT32> mMaxActiveTasks{0};
+		std::atomic<UINT32> mNextTaskId{0};
+		std::atomic<bool> mShutdown{false};
 		bool mCheckTasks = false;
 
 		Mutex mReadyMutex;
 		Mutex mCompleteMutex;
 		Signal mTaskReadyCond;
 		Signal mTaskCompleteCond;
+		std::atomic<UINT32> mNumWaiters{0};
+		std::atomic<UINT32> mNumQueuedTasks{0};
+
+		// Work stealing
+		Worker* mWorkers[MAX_WORKERS] = {};
+		std::atomic<UINT32> mNumWorkers{0};
+		InjectionQueue mInjectionQueues[NUM_PRIORITY_LANES];
+		std::atomic<UINT32> mNumSleepingWorkers{0};
+
+		Mutex mWorkerMutex;
+		Signal mWorkerSleepCond;
+		Signal mWorkerParkCond;
+
+		static LS_THREADLOCAL Worker* sCurrentWorker;
+		static LS_THREADLOCAL TaskScheduler* sExecutingScheduler; /**< Scheduler whose task the current thread executes. */
 	};
 
 	/** @} */
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "Prerequisites/LSPrerequisitesUtil.h"
+
+namespace ls
+{
+	/** @addtogroup Internal-Utility
+	 *  @{
+	 */
+
+	/** @addtogroup Threading-Internal
+	 *  @{
+	 */
+
+	/**
+	 * Lock-free double ended queue used for work stealing (Chase-Lev). A single owner thread pushes and pops elements
+	 * from the bottom of the queue, while any number of other threads may steal elements from the top.
+	 *
+	 * @tparam	T	Type of the stored elements. Must be trivially copyable (normally a pointer).
+	 *
+	 * @note
+	 * Thread safe, as long as push() and pop() are only ever called from the thread owning the queue.
+	 * @note
+	 * Internal buffer grows as needed. Old buffers are kept alive until the queue is destroyed, as a concurrent stealer
+	 * might still be reading from them.
+	 */
+	template<class T>
+	class WorkStealingQueue
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Work stealing queue elements must be trivially copyable.");
+
+		/** Circular buffer holding the queue elements. Capacity is always a power of two. */
+		struct Buffer
+		{
+			Buffer(INT64 capacity, Buffer* previous)
+				: capacity(capacity), mask(capacity - 1), previous(previous)
+			{
+				elements = (std::atomic<T>*)ls_alloc(sizeof(std::atomic<T>) * (size_t)capacity);
+
+				for (INT64 i = 0; i < capacity; i++)
+					new (&elements[i]) std::atomic<T>();
+			}
+
+			~Buffer()
+			{
+				ls_free(elements);
+			}
+
+			T get(INT64 idx) const { return elements[idx & mask].load(std::memory_order_relaxed); }
+			void put(INT64 idx, T value) { elements[idx & mask].store(value, std::memory_order_relaxed); }
+
+			INT64 capacity;
+			INT64 mask;
+			std::atomic<T>* elements;
+			Buffer* previous;
+		};
+
+	public:
+		/** Constructs a new queue with enough initial room for @p capacity elements. Capacity must be a power of two. */
+		explicit WorkStealingQueue(UINT32 capacity = 256)
+		{
+			assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+
+			mBuffer.store(ls_new<Buffer>((INT64)capacity, nullptr), std::memory_order_relaxed);
+		}
+
+		~WorkStealingQueue()
+		{
+			Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+			while (buffer != nullptr)
+			{
+				Buffer* previous = buffer->previous;
+				ls_delete(buffer);
+
+				buffer = previous;
+			}
+		}
+
+		WorkStealingQueue(const WorkStealingQueue&) = delete;
+		WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+		/** Pushes a new element to the bottom of the queue. Must only be called from the owner thread. */
+		void push(T value)
+		{
+			INT64 bottom = mBottom.load(std::memory_order_relaxed);
+			INT64 top = mTop.load(std::memory_order_acquire);
+			Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+
+			if (bottom - top > buffer->capacity - 1)
+				buffer = grow(buffer, bottom, top);
+
+			buffer->put(bottom, value);
+
+			std::atomic_thread_fence(std::memory_order_release);
+			mBottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Pops an element from the bottom of the queue (last in, first out). Must only be called from the owner thread.
+		 *
+		 * @param[out]	value	Popped element, if any.
+		 * @return				True if an element was popped, false if the queue was empty.
+		 */
+		bool pop(T& value)
+		{
+			INT64 bottom = mBottom.load(std::memory_order_relaxed) - 1;
+			Buffer* buffer = mBuffer.load(std::memory_order_relaxed);
+			mBottom.store(bottom, std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			INT64 top = mTop.load(std::memory_order_relaxed);
+
+			if (top > bottom)
+			{
+				// Empty
+				mBottom.store(bottom + 1, std::memory_order_relaxed);
+				return false;
+			}
+
+			value = buffer->get(bottom);
+			if (top == bottom)
+			{
+				// Last element, race against the stealers for it
+				bool won = mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+					std::memory_order_relaxed);
+
+				mBottom.store(bottom + 1, std::memory_order_relaxed);
+				return won;
+			}
+
+			return true;
+		}
+
+		/**
+		 * Steals an element from the top of the queue (first in, first out). May be called from any thread.
+		 *
+		 * @param[out]	value	Stolen element, if any.
+		 * @return				True if an element was stolen. False if the queue was empty or if another thread won the
+		 *						race for the element.
+		 */
+		bool steal(T& value)
+		{
+			INT64 top = mTop.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			INT64 bottom = mBottom.load(std::memory_order_acquire);
+
+			if (top >= bottom)
+				return false;
+
+			Buffer* buffer = mBuffer.load(std::memory_order_acquire);
+			T stolen = buffer->get(top);
+
+			if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return false;
+
+			value = stolen;
+			return true;
+		}
+
+		/** Returns true if the queue appears empty. Result might be out of date by the time it is returned. */
+		bool isEmpty() const
+		{
+			INT64 bottom = mBottom.load(std::memory_order_relaxed);
+			INT64 top = mTop.load(std::memory_order_relaxed);
+
+			return top >= bottom;
+		}
+
+	private:
+		/** Creates a buffer with twice the capacity of the current one and copies over the live elements. */
+		Buffer* grow(Buffer* buffer, INT64 bottom, INT64 top)
+		{
+			Buffer* newBuffer = ls_new<Buffer>(buffer->capacity * 2, buffer);
+			for (INT64 i = top; i < bottom; i++)
+				newBuffer->put(i, buffer->get(i));
+
+			mBuffer.store(newBuffer, std::memory_order_release);
+			return newBuffer;
+		}
+
+		alignas(64) std::atomic<INT64> mTop{0};
+		alignas(64) std::atomic<INT64> mBottom{0};
+		std::atomic<Buffer*> mBuffer{nullptr};
+	};
+
+	/** @} */
+	/** @} */
+}